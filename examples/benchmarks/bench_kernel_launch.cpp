@@ -0,0 +1,103 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Measures a launch of an empty kernel on 1..N 1x1 tile groups, from
+// hb_mc_kernel_enqueue() until hb_mc_device_tile_groups_execute()
+// returns, then on square grids of up to BENCH_GRID_DIM_MAX^2 1x1 tile
+// groups, which run in waves once the grid outgrows the mesh.
+
+#include "bench_kernel_launch.hpp"
+
+static int run(hb_mc_device_t *device, bench_json_t *json)
+{
+        hb_mc_dimension_t tg_dim = { .x = 1, .y = 1 };
+        uint32_t max_tgs = hb_mc_dimension_to_length(device->mesh->dim);
+        uint32_t cuda_argv[1];
+
+        for (uint32_t tgs = 1; tgs <= max_tgs; tgs <<= 1) {
+                bench_sample_t s, total = {};
+                hb_mc_dimension_t grid_dim = { .x = tgs, .y = 1 };
+
+                for (int it = 0; it < BENCH_ITERATIONS; it++) {
+                        BSG_CUDA_CALL(bench_start(device->mc, &s));
+                        BSG_CUDA_CALL(hb_mc_kernel_enqueue(device, grid_dim, tg_dim, "kernel_empty", 0, cuda_argv));
+                        BSG_CUDA_CALL(hb_mc_device_tile_groups_execute(device));
+                        BSG_CUDA_CALL(bench_stop(device->mc, &s, &total));
+                }
+
+                bench_json_result(json, "kernel_launch", "tile_groups", tgs, BENCH_ITERATIONS, &total);
+        }
+
+        for (uint32_t dim = 1; dim <= BENCH_GRID_DIM_MAX; dim <<= 1) {
+                bench_sample_t s, total = {};
+                hb_mc_dimension_t grid_dim = { .x = dim, .y = dim };
+
+                for (int it = 0; it < BENCH_ITERATIONS; it++) {
+                        BSG_CUDA_CALL(bench_start(device->mc, &s));
+                        BSG_CUDA_CALL(hb_mc_kernel_enqueue(device, grid_dim, tg_dim, "kernel_empty", 0, cuda_argv));
+                        BSG_CUDA_CALL(hb_mc_device_tile_groups_execute(device));
+                        BSG_CUDA_CALL(bench_stop(device->mc, &s, &total));
+                }
+
+                bench_json_result(json, "kernel_launch_grid", "tile_groups", dim * dim, BENCH_ITERATIONS, &total);
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+int bench_kernel_launch(int argc, char **argv)
+{
+        int rc, err;
+        hb_mc_device_t device;
+        bench_json_t json;
+        struct arguments_path args = {NULL, NULL};
+
+        argp_parse(&argp_path, argc, argv, 0, 0, &args);
+
+        BSG_CUDA_CALL(hb_mc_device_init(&device, args.name, 0));
+        BSG_CUDA_CALL(hb_mc_device_program_init(&device, args.path, ALLOC_NAME, 0));
+
+        rc = bench_json_open(&json, args.name, device.mc);
+        if (rc == HB_MC_SUCCESS) {
+                rc = run(&device, &json);
+                bench_json_close(&json);
+        }
+
+        err = hb_mc_device_finish(&device);
+        return rc != HB_MC_SUCCESS ? rc : err;
+}
+
+#ifdef VCS
+int vcs_main(int argc, char ** argv) {
+#else
+int main(int argc, char ** argv) {
+#endif
+        bsg_pr_test_info("bench_kernel_launch Benchmark\n");
+        int rc = bench_kernel_launch(argc, argv);
+        bsg_pr_test_pass_fail(rc == HB_MC_SUCCESS);
+        return rc;
+}
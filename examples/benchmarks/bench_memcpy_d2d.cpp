@@ -0,0 +1,109 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Measures HB_MC_MEMCPY_DEVICE_TO_DEVICE copies at swept sizes, against
+// the same copy staged through the host with a read and a write.
+
+#include "bench_memcpy_d2d.hpp"
+#include <vector>
+
+static int run(hb_mc_device_t *device, bench_json_t *json)
+{
+        hb_mc_eva_t src, dst;
+        std::vector<uint8_t> wr(BENCH_SIZE_MAX), rd(BENCH_SIZE_MAX);
+
+        for (size_t i = 0; i < wr.size(); i++)
+                wr[i] = i;
+
+        BSG_CUDA_CALL(hb_mc_device_malloc(device, BENCH_SIZE_MAX, &src));
+        BSG_CUDA_CALL(hb_mc_device_malloc(device, BENCH_SIZE_MAX, &dst));
+        BSG_CUDA_CALL(hb_mc_device_memcpy_to_device(device, src, wr.data(), BENCH_SIZE_MAX));
+
+        for (size_t sz = BENCH_SIZE_MIN; sz <= BENCH_SIZE_MAX; sz <<= 1) {
+                bench_sample_t s, dtod = {}, staged = {};
+
+                for (int it = 0; it < BENCH_ITERATIONS; it++) {
+                        BSG_CUDA_CALL(hb_mc_device_memset(device, &dst, 0, sz));
+
+                        BSG_CUDA_CALL(bench_start(device->mc, &s));
+                        BSG_CUDA_CALL(hb_mc_device_memcpy(device, (void *) ((intptr_t) dst),
+                                                          (void *) ((intptr_t) src), sz,
+                                                          HB_MC_MEMCPY_DEVICE_TO_DEVICE));
+                        BSG_CUDA_CALL(bench_stop(device->mc, &s, &dtod));
+
+                        BSG_CUDA_CALL(hb_mc_device_memcpy_to_host(device, rd.data(), dst, sz));
+                        if (memcmp(wr.data(), rd.data(), sz)) {
+                                bsg_pr_test_err("Data mismatch after %zu byte copy\n", sz);
+                                return HB_MC_FAIL;
+                        }
+
+                        BSG_CUDA_CALL(bench_start(device->mc, &s));
+                        BSG_CUDA_CALL(hb_mc_device_memcpy_to_host(device, rd.data(), src, sz));
+                        BSG_CUDA_CALL(hb_mc_device_memcpy_to_device(device, dst, rd.data(), sz));
+                        BSG_CUDA_CALL(bench_stop(device->mc, &s, &staged));
+                }
+
+                bench_json_result(json, "memcpy_device_to_device", "bytes", sz, BENCH_ITERATIONS, &dtod);
+                bench_json_result(json, "memcpy_staged_through_host", "bytes", sz, BENCH_ITERATIONS, &staged);
+        }
+
+        BSG_CUDA_CALL(hb_mc_device_free(device, dst));
+        return hb_mc_device_free(device, src);
+}
+
+int bench_memcpy_d2d(int argc, char **argv)
+{
+        int rc, err;
+        hb_mc_device_t device;
+        bench_json_t json;
+        struct arguments_path args = {NULL, NULL};
+
+        argp_parse(&argp_path, argc, argv, 0, 0, &args);
+
+        BSG_CUDA_CALL(hb_mc_device_init(&device, args.name, 0));
+        BSG_CUDA_CALL(hb_mc_device_program_init(&device, args.path, ALLOC_NAME, 0));
+
+        rc = bench_json_open(&json, args.name, device.mc);
+        if (rc == HB_MC_SUCCESS) {
+                rc = run(&device, &json);
+                bench_json_close(&json);
+        }
+
+        err = hb_mc_device_finish(&device);
+        return rc != HB_MC_SUCCESS ? rc : err;
+}
+
+#ifdef VCS
+int vcs_main(int argc, char ** argv) {
+#else
+int main(int argc, char ** argv) {
+#endif
+        bsg_pr_test_info("bench_memcpy_d2d Benchmark\n");
+        int rc = bench_memcpy_d2d(argc, argv);
+        bsg_pr_test_pass_fail(rc == HB_MC_SUCCESS);
+        return rc;
+}
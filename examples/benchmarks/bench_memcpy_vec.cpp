@@ -0,0 +1,131 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Measures hb_mc_device_memcpy_vec on many small buffers, swept by
+// buffer count, against one hb_mc_device_memcpy call per buffer.
+
+#include "bench_memcpy_vec.hpp"
+#include <algorithm>
+#include <vector>
+
+#define SEGMENT_SZ      64
+#define SEGMENTS_MAX    256
+
+static int run(hb_mc_device_t *device, bench_json_t *json)
+{
+        hb_mc_eva_t base;
+        std::vector<uint32_t> wr(SEGMENTS_MAX * SEGMENT_SZ / sizeof(uint32_t));
+        std::vector<uint32_t> rd(wr.size());
+        std::vector<hb_mc_iovec_t> wr_iov(SEGMENTS_MAX), rd_iov(SEGMENTS_MAX);
+
+        for (size_t i = 0; i < wr.size(); i++)
+                wr[i] = i;
+
+        // every other segment, so no two buffers are contiguous on the device
+        BSG_CUDA_CALL(hb_mc_device_malloc(device, 2 * SEGMENTS_MAX * SEGMENT_SZ, &base));
+
+        for (size_t i = 0; i < SEGMENTS_MAX; i++) {
+                hb_mc_eva_t eva = base + 2 * i * SEGMENT_SZ;
+                size_t off = i * SEGMENT_SZ / sizeof(uint32_t);
+                wr_iov[i] = { eva, &wr[off], SEGMENT_SZ };
+                rd_iov[i] = { eva, &rd[off], SEGMENT_SZ };
+        }
+
+        for (size_t n = 1; n <= SEGMENTS_MAX; n <<= 1) {
+                bench_sample_t s, to_vec = {}, to_each = {}, from_vec = {}, from_each = {};
+
+                for (int it = 0; it < BENCH_ITERATIONS; it++) {
+                        BSG_CUDA_CALL(bench_start(device->mc, &s));
+                        BSG_CUDA_CALL(hb_mc_device_memcpy_vec(device, wr_iov.data(), n,
+                                                              HB_MC_MEMCPY_TO_DEVICE));
+                        BSG_CUDA_CALL(bench_stop(device->mc, &s, &to_vec));
+
+                        std::fill(rd.begin(), rd.end(), 0);
+                        BSG_CUDA_CALL(bench_start(device->mc, &s));
+                        BSG_CUDA_CALL(hb_mc_device_memcpy_vec(device, rd_iov.data(), n,
+                                                              HB_MC_MEMCPY_TO_HOST));
+                        BSG_CUDA_CALL(bench_stop(device->mc, &s, &from_vec));
+
+                        if (memcmp(wr.data(), rd.data(), n * SEGMENT_SZ)) {
+                                bsg_pr_test_err("Data mismatch after %zu buffer copy\n", n);
+                                return HB_MC_FAIL;
+                        }
+
+                        BSG_CUDA_CALL(bench_start(device->mc, &s));
+                        for (size_t i = 0; i < n; i++)
+                                BSG_CUDA_CALL(hb_mc_device_memcpy_to_device(device, wr_iov[i].eva,
+                                                                            wr_iov[i].data, SEGMENT_SZ));
+                        BSG_CUDA_CALL(bench_stop(device->mc, &s, &to_each));
+
+                        BSG_CUDA_CALL(bench_start(device->mc, &s));
+                        for (size_t i = 0; i < n; i++)
+                                BSG_CUDA_CALL(hb_mc_device_memcpy_to_host(device, rd_iov[i].data,
+                                                                          rd_iov[i].eva, SEGMENT_SZ));
+                        BSG_CUDA_CALL(bench_stop(device->mc, &s, &from_each));
+                }
+
+                bench_json_result(json, "memcpy_vec_to_device", "buffers", n, BENCH_ITERATIONS, &to_vec);
+                bench_json_result(json, "memcpy_each_to_device", "buffers", n, BENCH_ITERATIONS, &to_each);
+                bench_json_result(json, "memcpy_vec_to_host", "buffers", n, BENCH_ITERATIONS, &from_vec);
+                bench_json_result(json, "memcpy_each_to_host", "buffers", n, BENCH_ITERATIONS, &from_each);
+        }
+
+        return hb_mc_device_free(device, base);
+}
+
+int bench_memcpy_vec(int argc, char **argv)
+{
+        int rc, err;
+        hb_mc_device_t device;
+        bench_json_t json;
+        struct arguments_path args = {NULL, NULL};
+
+        argp_parse(&argp_path, argc, argv, 0, 0, &args);
+
+        BSG_CUDA_CALL(hb_mc_device_init(&device, args.name, 0));
+        BSG_CUDA_CALL(hb_mc_device_program_init(&device, args.path, ALLOC_NAME, 0));
+
+        rc = bench_json_open(&json, args.name, device.mc);
+        if (rc == HB_MC_SUCCESS) {
+                rc = run(&device, &json);
+                bench_json_close(&json);
+        }
+
+        err = hb_mc_device_finish(&device);
+        return rc != HB_MC_SUCCESS ? rc : err;
+}
+
+#ifdef VCS
+int vcs_main(int argc, char ** argv) {
+#else
+int main(int argc, char ** argv) {
+#endif
+        bsg_pr_test_info("bench_memcpy_vec Benchmark\n");
+        int rc = bench_memcpy_vec(argc, argv);
+        bsg_pr_test_pass_fail(rc == HB_MC_SUCCESS);
+        return rc;
+}
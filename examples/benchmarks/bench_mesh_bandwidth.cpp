@@ -0,0 +1,99 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Measures packet-based DRAM bandwidth over the mesh using
+// hb_mc_manycore_write_mem() and hb_mc_manycore_read_mem().
+
+#include "bench_mesh_bandwidth.hpp"
+#include <vector>
+
+static int run(hb_mc_manycore_t *mc, bench_json_t *json)
+{
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        hb_mc_npa_t npa = hb_mc_npa(hb_mc_config_get_dram_coordinate(cfg, 0), 0);
+        std::vector<uint32_t> wr(BENCH_SIZE_MAX / sizeof(uint32_t));
+        std::vector<uint32_t> rd(wr.size());
+
+        for (size_t i = 0; i < wr.size(); i++)
+                wr[i] = i;
+
+        for (size_t sz = BENCH_SIZE_MIN; sz <= BENCH_SIZE_MAX; sz <<= 1) {
+                bench_sample_t s, write = {}, read = {};
+
+                for (int it = 0; it < BENCH_ITERATIONS; it++) {
+                        BSG_CUDA_CALL(bench_start(mc, &s));
+                        BSG_CUDA_CALL(hb_mc_manycore_write_mem(mc, &npa, wr.data(), sz));
+                        BSG_CUDA_CALL(bench_stop(mc, &s, &write));
+
+                        BSG_CUDA_CALL(bench_start(mc, &s));
+                        BSG_CUDA_CALL(hb_mc_manycore_read_mem(mc, &npa, rd.data(), sz));
+                        BSG_CUDA_CALL(bench_stop(mc, &s, &read));
+
+                        if (memcmp(wr.data(), rd.data(), sz)) {
+                                bsg_pr_test_err("Data mismatch after %zu byte transfer\n", sz);
+                                return HB_MC_FAIL;
+                        }
+                }
+
+                bench_json_result(json, "write_mem", "bytes", sz, BENCH_ITERATIONS, &write);
+                bench_json_result(json, "read_mem", "bytes", sz, BENCH_ITERATIONS, &read);
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+int bench_mesh_bandwidth(int argc, char **argv)
+{
+        int rc;
+        hb_mc_manycore_t mc = {0};
+        bench_json_t json;
+        struct arguments_path args = {NULL, NULL};
+
+        argp_parse(&argp_path, argc, argv, 0, 0, &args);
+
+        BSG_CUDA_CALL(hb_mc_manycore_init(&mc, args.name, 0));
+
+        rc = bench_json_open(&json, args.name, &mc);
+        if (rc == HB_MC_SUCCESS) {
+                rc = run(&mc, &json);
+                bench_json_close(&json);
+        }
+
+        hb_mc_manycore_exit(&mc);
+        return rc;
+}
+
+#ifdef VCS
+int vcs_main(int argc, char ** argv) {
+#else
+int main(int argc, char ** argv) {
+#endif
+        bsg_pr_test_info("bench_mesh_bandwidth Benchmark\n");
+        int rc = bench_mesh_bandwidth(argc, argv);
+        bsg_pr_test_pass_fail(rc == HB_MC_SUCCESS);
+        return rc;
+}
@@ -0,0 +1,131 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Measures hb_mc_device_program_init(): freezing the tiles, loading
+// the binary onto every tile and into DRAM, and setting the
+// configuration symbols. The swept parameter is the binary size.
+//
+// Also measures hb_mc_loader_load() of generated binaries whose DRAM
+// segment is swept in size, once as data and once as zero fill, to
+// show the cost of loading large-data programs into DRAM.
+
+#include "bench_program_load.hpp"
+
+#define DRAM_TEXT_EVA 0x80000000
+#define DRAM_TEXT_SZ  64
+#define DRAM_DATA_EVA 0x80001000
+
+/* An executable with a little program text and a DRAM segment of #sz bytes */
+static std::vector<unsigned char> make_dram_binary(size_t sz, bool zero_fill)
+{
+        const test_binary_segment_t segs[] = {
+                { PF_R | PF_X, DRAM_TEXT_EVA, DRAM_TEXT_SZ, DRAM_TEXT_SZ },
+                { PF_R | PF_W, DRAM_DATA_EVA, static_cast<Elf32_Word>(zero_fill ? 0 : sz),
+                  static_cast<Elf32_Word>(sz) },
+        };
+
+        return test_binary_make(segs, 2, NULL, 0);
+}
+
+/* load binaries with a growing DRAM segment onto the origin tile */
+static int run_dram(hb_mc_device_t *device, bench_json_t *json)
+{
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(device->mc);
+        hb_mc_coordinate_t origin = hb_mc_config_get_origin_vcore(cfg);
+
+        for (int zero_fill = 0; zero_fill < 2; zero_fill++) {
+                for (size_t sz = BENCH_SIZE_MIN; sz <= BENCH_SIZE_MAX; sz <<= 1) {
+                        std::vector<unsigned char> bin = make_dram_binary(sz, zero_fill);
+                        bench_sample_t s, total = {};
+
+                        for (int it = 0; it < BENCH_ITERATIONS; it++) {
+                                BSG_CUDA_CALL(bench_start(device->mc, &s));
+                                BSG_CUDA_CALL(hb_mc_loader_load(bin.data(), bin.size(), device->mc,
+                                                                &default_map, &origin, 1));
+                                BSG_CUDA_CALL(bench_stop(device->mc, &s, &total));
+                        }
+
+                        bench_json_result(json, zero_fill ? "loader_load_dram_zeros" : "loader_load_dram_data",
+                                          "bytes", sz, BENCH_ITERATIONS, &total);
+                }
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+int bench_program_load(int argc, char **argv)
+{
+        int rc = HB_MC_SUCCESS;
+        bench_json_t json = {};
+        bench_sample_t s, total = {};
+        size_t bin_size = 0;
+        struct arguments_path args = {NULL, NULL};
+
+        argp_parse(&argp_path, argc, argv, 0, 0, &args);
+
+        for (int it = 0; it < BENCH_ITERATIONS; it++) {
+                hb_mc_device_t device;
+
+                BSG_CUDA_CALL(hb_mc_device_init(&device, args.name, 0));
+
+                BSG_CUDA_CALL(bench_start(device.mc, &s));
+                BSG_CUDA_CALL(hb_mc_device_program_init(&device, args.path, ALLOC_NAME, 0));
+                BSG_CUDA_CALL(bench_stop(device.mc, &s, &total));
+                bin_size = device.program->bin_size;
+
+                // The machine description is the same for every iteration
+                if (it == 0)
+                        rc = bench_json_open(&json, args.name, device.mc);
+
+                BSG_CUDA_CALL(hb_mc_device_finish(&device));
+                if (rc != HB_MC_SUCCESS)
+                        return rc;
+        }
+
+        bench_json_result(&json, "program_init", "binary_bytes", bin_size, BENCH_ITERATIONS, &total);
+
+        // DRAM must be set up by a program before anything is loaded into it
+        hb_mc_device_t device;
+        BSG_CUDA_CALL(hb_mc_device_init(&device, args.name, 0));
+        BSG_CUDA_CALL(hb_mc_device_program_init(&device, args.path, ALLOC_NAME, 0));
+        rc = run_dram(&device, &json);
+        bench_json_close(&json);
+
+        int err = hb_mc_device_finish(&device);
+        return rc != HB_MC_SUCCESS ? rc : err;
+}
+
+#ifdef VCS
+int vcs_main(int argc, char ** argv) {
+#else
+int main(int argc, char ** argv) {
+#endif
+        bsg_pr_test_info("bench_program_load Benchmark\n");
+        int rc = bench_program_load(argc, argv);
+        bsg_pr_test_pass_fail(rc == HB_MC_SUCCESS);
+        return rc;
+}
@@ -0,0 +1,119 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Measures whole-cache victim cache maintenance:
+// hb_mc_manycore_flush_vcache() after dirtying a swept number of bytes,
+// and hb_mc_manycore_invalidate_vcache()/validate_vcache(), which touch
+// every tag of every cache. Run `make vcache-multiverse` to compare machines.
+
+#include "bench_vcache_flush.hpp"
+#include <vector>
+
+static int run(hb_mc_manycore_t *mc, bench_json_t *json)
+{
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        hb_mc_npa_t npa = hb_mc_npa(hb_mc_config_get_dram_coordinate(cfg, 0), 0);
+        std::vector<uint32_t> wr(BENCH_SIZE_MAX / sizeof(uint32_t));
+        bench_sample_t s, total = {};
+
+        // Flushing clean caches is the floor for every flush
+        for (int it = 0; it < BENCH_ITERATIONS; it++) {
+                BSG_CUDA_CALL(hb_mc_manycore_flush_vcache(mc));
+                BSG_CUDA_CALL(bench_start(mc, &s));
+                BSG_CUDA_CALL(hb_mc_manycore_flush_vcache(mc));
+                BSG_CUDA_CALL(bench_stop(mc, &s, &total));
+        }
+        bench_json_result(json, "flush_vcache", "dirty_bytes", 0, BENCH_ITERATIONS, &total);
+
+        for (size_t sz = BENCH_SIZE_MIN; sz <= BENCH_SIZE_MAX; sz <<= 1) {
+                total = {};
+                for (int it = 0; it < BENCH_ITERATIONS; it++) {
+                        BSG_CUDA_CALL(hb_mc_manycore_write_mem(mc, &npa, wr.data(), sz));
+                        BSG_CUDA_CALL(bench_start(mc, &s));
+                        BSG_CUDA_CALL(hb_mc_manycore_flush_vcache(mc));
+                        BSG_CUDA_CALL(bench_stop(mc, &s, &total));
+                }
+                bench_json_result(json, "flush_vcache", "dirty_bytes", sz, BENCH_ITERATIONS, &total);
+        }
+
+        size_t tags = static_cast<size_t>(hb_mc_vcache_num_ways(mc))
+                * hb_mc_vcache_num_sets(mc)
+                * hb_mc_vcache_num_caches(mc);
+
+        total = {};
+        for (int it = 0; it < BENCH_ITERATIONS; it++) {
+                BSG_CUDA_CALL(bench_start(mc, &s));
+                BSG_CUDA_CALL(hb_mc_manycore_invalidate_vcache(mc));
+                BSG_CUDA_CALL(bench_stop(mc, &s, &total));
+        }
+        bench_json_result(json, "invalidate_vcache", "tags", tags, BENCH_ITERATIONS, &total);
+
+        // Validating tags is only meaningful without DRAM
+        if (!hb_mc_manycore_dram_is_enabled(mc)) {
+                total = {};
+                for (int it = 0; it < BENCH_ITERATIONS; it++) {
+                        BSG_CUDA_CALL(bench_start(mc, &s));
+                        BSG_CUDA_CALL(hb_mc_manycore_validate_vcache(mc));
+                        BSG_CUDA_CALL(bench_stop(mc, &s, &total));
+                }
+                bench_json_result(json, "validate_vcache", "tags", tags, BENCH_ITERATIONS, &total);
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+int bench_vcache_flush(int argc, char **argv)
+{
+        int rc;
+        hb_mc_manycore_t mc = {0};
+        bench_json_t json;
+        struct arguments_path args = {NULL, NULL};
+
+        argp_parse(&argp_path, argc, argv, 0, 0, &args);
+
+        BSG_CUDA_CALL(hb_mc_manycore_init(&mc, args.name, 0));
+
+        rc = bench_json_open(&json, args.name, &mc);
+        if (rc == HB_MC_SUCCESS) {
+                rc = run(&mc, &json);
+                bench_json_close(&json);
+        }
+
+        hb_mc_manycore_exit(&mc);
+        return rc;
+}
+
+#ifdef VCS
+int vcs_main(int argc, char ** argv) {
+#else
+int main(int argc, char ** argv) {
+#endif
+        bsg_pr_test_info("bench_vcache_flush Benchmark\n");
+        int rc = bench_vcache_flush(argc, argv);
+        bsg_pr_test_pass_fail(rc == HB_MC_SUCCESS);
+        return rc;
+}
@@ -0,0 +1,188 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef __BENCHMARKS_HPP
+#define __BENCHMARKS_HPP
+
+// Helpers shared by the host runtime benchmarks. Each benchmark sweeps
+// a parameter (usually a transfer size), and records the average host
+// time (ns) and device time (cycles) of an operation in
+// <test_name>.json so that results can be compared between library
+// versions and machines.
+
+#include <bsg_manycore.h>
+#include <bsg_manycore_tile.h>
+#include <bsg_manycore_loader.h>
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_cuda.h>
+#include <bsg_manycore_printing.h>
+
+#include <cinttypes>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+#include "../cl_manycore_regression.h"
+
+#define ALLOC_NAME "default_allocator"
+
+// Number of times each measurement is repeated. Results are averaged.
+#ifndef BENCH_ITERATIONS
+#define BENCH_ITERATIONS 3
+#endif
+
+// Range of the transfer size sweep, in bytes. Both are powers of two.
+#ifndef BENCH_SIZE_MIN
+#define BENCH_SIZE_MIN 4
+#endif
+
+#ifndef BENCH_SIZE_MAX
+#define BENCH_SIZE_MAX (1 << 14)
+#endif
+
+typedef struct {
+        uint64_t ns;
+        uint64_t cycles;
+} bench_sample_t;
+
+typedef struct {
+        FILE *f;
+        bool first;
+} bench_json_t;
+
+static inline uint64_t bench_host_ns()
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * Start a measurement
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[out] s      A sample to start
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+static inline int bench_start(hb_mc_manycore_t *mc, bench_sample_t *s)
+{
+        int err = hb_mc_manycore_get_cycle(mc, &s->cycles);
+        s->ns = bench_host_ns();
+        return err;
+}
+
+/**
+ * Stop a measurement and accumulate the elapsed time into a total
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  s      A sample started with bench_start()
+ * @param[out] total  Accumulated time
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+static inline int bench_stop(hb_mc_manycore_t *mc, const bench_sample_t *s, bench_sample_t *total)
+{
+        uint64_t ns = bench_host_ns(), cycles;
+        int err = hb_mc_manycore_get_cycle(mc, &cycles);
+        total->ns += ns - s->ns;
+        total->cycles += cycles - s->cycles;
+        return err;
+}
+
+/**
+ * Open <name>.json and write the machine description
+ * @param[out] json   A JSON writer
+ * @param[in]  name   Name of the benchmark
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+static inline int bench_json_open(bench_json_t *json, const char *name, hb_mc_manycore_t *mc)
+{
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        hb_mc_dimension_t dim = hb_mc_config_get_dimension_vcore(cfg);
+        std::string path = std::string(name) + ".json";
+
+        json->f = fopen(path.c_str(), "w");
+        if (!json->f) {
+                bsg_pr_test_err("Failed to open %s\n", path.c_str());
+                return HB_MC_FAIL;
+        }
+        json->first = true;
+
+        fprintf(json->f, "{\n");
+        fprintf(json->f, "  \"benchmark\": \"%s\",\n", name);
+        fprintf(json->f, "  \"machine\": {\n");
+        fprintf(json->f, "    \"dim_x\": %" PRIu32 ",\n", hb_mc_dimension_get_x(dim));
+        fprintf(json->f, "    \"dim_y\": %" PRIu32 ",\n", hb_mc_dimension_get_y(dim));
+        fprintf(json->f, "    \"vcache_ways\": %" PRIu32 ",\n", hb_mc_config_get_vcache_ways(cfg));
+        fprintf(json->f, "    \"vcache_sets\": %" PRIu32 ",\n", hb_mc_config_get_vcache_sets(cfg));
+        fprintf(json->f, "    \"vcache_block_words\": %" PRIu32 ",\n", hb_mc_config_get_vcache_block_words(cfg));
+        fprintf(json->f, "    \"dram_channels\": %" PRIu32 ",\n", hb_mc_config_get_dram_channels(cfg));
+        fprintf(json->f, "    \"supports_dma\": %s,\n",
+                hb_mc_manycore_supports_dma_write(mc) && hb_mc_manycore_supports_dma_read(mc) ?
+                "true" : "false");
+        fprintf(json->f, "    \"githash_basejump\": \"%08" PRIx32 "\",\n", hb_mc_config_get_githash_basejump(cfg));
+        fprintf(json->f, "    \"githash_manycore\": \"%08" PRIx32 "\",\n", hb_mc_config_get_githash_manycore(cfg));
+        fprintf(json->f, "    \"githash_f1\": \"%08" PRIx32 "\"\n", hb_mc_config_get_githash_f1(cfg));
+        fprintf(json->f, "  },\n");
+        fprintf(json->f, "  \"results\": [");
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Record a result. Times are averaged over #iterations.
+ * @param[in]  json        A JSON writer opened with bench_json_open()
+ * @param[in]  op          Name of the measured operation
+ * @param[in]  unit        Unit of #size (e.g. bytes)
+ * @param[in]  size        Value of the swept parameter
+ * @param[in]  iterations  Number of iterations accumulated in #total
+ * @param[in]  total       Accumulated time
+ */
+static inline void bench_json_result(bench_json_t *json, const char *op, const char *unit,
+                                     uint64_t size, unsigned iterations, const bench_sample_t *total)
+{
+        uint64_t ns = total->ns / iterations;
+        uint64_t cycles = total->cycles / iterations;
+
+        fprintf(json->f, "%s\n    {\"op\": \"%s\", \"unit\": \"%s\", \"size\": %" PRIu64
+                ", \"iterations\": %u, \"host_ns\": %" PRIu64 ", \"device_cycles\": %" PRIu64 "}",
+                json->first ? "" : ",", op, unit, size, iterations, ns, cycles);
+        json->first = false;
+
+        bsg_pr_test_info("%s: %" PRIu64 " %s: %" PRIu64 " ns, %" PRIu64 " cycles\n",
+                         op, size, unit, ns, cycles);
+}
+
+/**
+ * Terminate and close a JSON file opened with bench_json_open()
+ * @param[in]  json   A JSON writer
+ */
+static inline void bench_json_close(bench_json_t *json)
+{
+        fprintf(json->f, "\n  ]\n}\n");
+        fclose(json->f);
+        json->f = NULL;
+}
+
+#endif // __BENCHMARKS_HPP
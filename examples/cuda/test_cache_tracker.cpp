@@ -0,0 +1,195 @@
+// Copyright (c) 2019, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "test_cache_tracker.hpp"
+#include <bsg_manycore_cache_tracker.h>
+#include <vector>
+
+#define ALLOC_NAME "default_allocator"
+#define CUDA_CALL(expr)                                                 \
+        {                                                               \
+                int __err;                                              \
+                __err = expr;                                           \
+                if (__err != HB_MC_SUCCESS) {                           \
+                        bsg_pr_err("'%s' failed: %s\n", #expr, hb_mc_strerror(__err)); \
+                        return __err;                                   \
+                }                                                       \
+        }
+
+/*!
+ * Mixes DMA with mesh and kernel accesses to the same buffers, so that
+ * the device's cache tracker elides or narrows the cache maintenance of
+ * every DMA, and checks the data that comes back. The tracker checks
+ * each operation it elides as well (BSG_MANYCORE_CACHE_VERIFY=1).
+ * The last steps touch more lines than the tracker keeps ranges for
+ * (HB_MC_CACHE_TRACKER_MAX_RANGES), so it falls back to whole-cache
+ * operations.
+ * This tests uses the software/spmd/bsg_cuda_lite_runtime/vec_add/ Manycore binary in the BSG Manycore bitbucket repository.
+*/
+
+static int check(const char *what, const uint32_t *got, const uint32_t *expected, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+                if (got[i] != expected[i]) {
+                        bsg_pr_err(BSG_RED("Mismatch: ") "%s[%zu]: 0x%08" PRIx32
+                                   "\t Expected: 0x%08" PRIx32 "\n",
+                                   what, i, got[i], expected[i]);
+                        return HB_MC_FAIL;
+                }
+        }
+        return HB_MC_SUCCESS;
+}
+
+int kernel_cache_tracker (int argc, char **argv) {
+        char *bin_path, *test_name;
+        struct arguments_path args = {NULL, NULL};
+
+        argp_parse (&argp_path, argc, argv, 0, 0, &args);
+        bin_path = args.path;
+        test_name = args.name;
+
+        bsg_pr_test_info("Running DMA mixed with mesh and kernel writes on one 2x2 tile group.\n");
+
+        srand(static_cast<unsigned>(time(0)));
+
+        /* The tracker reads this when the device is initialized */
+        setenv(HB_MC_CACHE_TRACKER_VERIFY_ENV, "1", 1);
+
+        hb_mc_dimension_t tg_dim = { .x = 2, .y = 2};
+        hb_mc_device_t device;
+        CUDA_CALL(hb_mc_device_init_custom_dimensions(&device, test_name, 0, tg_dim));
+
+        /* if DMA is not supported just return SUCCESS */
+        if (!hb_mc_manycore_supports_dma_write(device.mc)
+            || !hb_mc_manycore_supports_dma_read(device.mc)) {
+                bsg_pr_test_info("DMA not supported for this machine: returning success\n");
+                return HB_MC_SUCCESS;
+        }
+
+        CUDA_CALL(hb_mc_device_program_init(&device, bin_path, ALLOC_NAME, 0));
+
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(device.mc);
+        const uint32_t line_words = hb_mc_config_get_vcache_block_words(cfg);
+
+        constexpr uint32_t N = 4096;
+        constexpr size_t vsize = N * sizeof(uint32_t);
+        /* one word in every other line, so that no two lines merge into one range */
+        const uint32_t X_lines = 2 * (HB_MC_CACHE_TRACKER_MAX_RANGES + 1);
+        const uint32_t X_words = X_lines * line_words;
+        const size_t xsize = X_words * sizeof(uint32_t);
+
+        eva_t A_device, B_device, C_device, X_device;
+        CUDA_CALL(hb_mc_device_malloc(&device, vsize, &A_device));
+        CUDA_CALL(hb_mc_device_malloc(&device, vsize, &B_device));
+        CUDA_CALL(hb_mc_device_malloc(&device, vsize, &C_device));
+        CUDA_CALL(hb_mc_device_malloc(&device, xsize, &X_device));
+
+        std::vector<uint32_t> A_host(N), B_host(N), C_host(N), C_expected(N), A_back(N);
+        for (uint32_t i = 0; i < N; i++) {
+                A_host[i] = rand() & 0xFFFF;
+                B_host[i] = rand() & 0xFFFF;
+                C_expected[i] = A_host[i] + B_host[i];
+        }
+
+        /* DMA to the device, a kernel writes C, DMA C back */
+        hb_mc_dma_htod_t htod_jobs [] = {
+                { .d_addr = A_device, .h_addr = A_host.data(), .size = vsize },
+                { .d_addr = B_device, .h_addr = B_host.data(), .size = vsize },
+        };
+        CUDA_CALL(hb_mc_device_dma_to_device(&device, htod_jobs, 2));
+
+        hb_mc_dimension_t grid_dim = { .x = 1, .y = 1};
+        uint32_t cuda_argv[5] = {A_device, B_device, C_device, N, N};
+        CUDA_CALL(hb_mc_kernel_enqueue (&device, grid_dim, tg_dim, "kernel_vec_add", 5, cuda_argv));
+        CUDA_CALL(hb_mc_device_tile_groups_execute(&device));
+
+        hb_mc_dma_dtoh_t dtoh_C = { .d_addr = C_device, .h_addr = C_host.data(), .size = vsize };
+        CUDA_CALL(hb_mc_device_dma_to_host(&device, &dtoh_C, 1));
+        CUDA_CALL(check("C after the kernel", C_host.data(), C_expected.data(), N));
+
+        /* A mesh write leaves dirty lines in the middle of A; DMA A back */
+        uint32_t patch[5];
+        const uint32_t patch_at = 3 * line_words + 1;   // not line aligned
+        for (uint32_t i = 0; i < 5; i++)
+                A_host[patch_at + i] = patch[i] = rand();
+        CUDA_CALL(hb_mc_device_memcpy_to_device(&device, A_device + patch_at * sizeof(uint32_t),
+                                                patch, sizeof(patch)));
+
+        hb_mc_dma_dtoh_t dtoh_A = { .d_addr = A_device, .h_addr = A_back.data(), .size = vsize };
+        CUDA_CALL(hb_mc_device_dma_to_host(&device, &dtoh_A, 1));
+        CUDA_CALL(check("A after a mesh write", A_back.data(), A_host.data(), N));
+
+        /* The patched lines are cached; DMA new data over them and read them over the mesh */
+        for (uint32_t i = 0; i < N; i++)
+                A_host[i] = rand();
+        CUDA_CALL(hb_mc_device_dma_to_device(&device, htod_jobs, 1));
+        CUDA_CALL(hb_mc_device_memcpy_to_host(&device, patch, A_device + patch_at * sizeof(uint32_t),
+                                              sizeof(patch)));
+        CUDA_CALL(check("A over the mesh after a DMA", patch, &A_host[patch_at], 5));
+
+        /* Dirty more lines than the tracker has ranges for, then DMA X back */
+        std::vector<uint32_t> X_host(X_words, 0), X_back(X_words);
+        hb_mc_dma_htod_t htod_X = { .d_addr = X_device, .h_addr = X_host.data(), .size = xsize };
+        CUDA_CALL(hb_mc_device_dma_to_device(&device, &htod_X, 1));
+
+        for (uint32_t l = 0; l < X_lines; l += 2) {
+                uint32_t w = l * line_words + l % line_words;
+                X_host[w] = rand();
+                CUDA_CALL(hb_mc_device_memcpy_to_device(&device, X_device + w * sizeof(uint32_t),
+                                                        &X_host[w], sizeof(uint32_t)));
+        }
+
+        hb_mc_dma_dtoh_t dtoh_X = { .d_addr = X_device, .h_addr = X_back.data(), .size = xsize };
+        CUDA_CALL(hb_mc_device_dma_to_host(&device, &dtoh_X, 1));
+        CUDA_CALL(check("X after mesh writes", X_back.data(), X_host.data(), X_words));
+
+        /* Every written line is cached; DMA new data over X and read each over the mesh */
+        for (uint32_t i = 0; i < X_words; i++)
+                X_host[i] = rand();
+        CUDA_CALL(hb_mc_device_dma_to_device(&device, &htod_X, 1));
+
+        for (uint32_t l = 0; l < X_lines; l += 2) {
+                uint32_t w = l * line_words + l % line_words, got;
+                CUDA_CALL(hb_mc_device_memcpy_to_host(&device, &got, X_device + w * sizeof(uint32_t),
+                                                      sizeof(uint32_t)));
+                CUDA_CALL(check("X over the mesh after a DMA", &got, &X_host[w], 1));
+        }
+
+        CUDA_CALL(hb_mc_device_finish(&device));
+
+        return HB_MC_SUCCESS;
+}
+
+#ifdef VCS
+int vcs_main(int argc, char ** argv) {
+#else
+int main(int argc, char ** argv) {
+#endif
+        bsg_pr_test_info("test_cache_tracker Regression Test\n");
+        int rc = kernel_cache_tracker(argc, argv);
+        bsg_pr_test_pass_fail(rc == HB_MC_SUCCESS);
+        return rc;
+}
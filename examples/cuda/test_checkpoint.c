@@ -0,0 +1,272 @@
+// Copyright (c) 2019, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "test_checkpoint.h"
+
+#define ALLOC_NAME "default_allocator"
+#define CHECKPOINT_PATH "test_checkpoint.ckpt"
+
+/*!
+ * Saves a checkpoint after loading A and B onto the device, overwrites A,
+ * then initializes a second device from the checkpoint. A and B must read
+ * back as they were saved, new allocations must not overlap them, and the
+ * restored program must still run vector addition.
+ * This tests uses the software/spmd/bsg_cuda_lite_runtime/vec_add/ Manycore binary in the BSG Manycore bitbucket repository.
+ * The machine must be built with BSG_VERILATOR_SAVABLE=1; otherwise the test passes without checking.
+*/
+
+#define N 1024
+
+
+static int checkpoint_save (char *bin_path, char *test_name,
+                            uint32_t *A_host, uint32_t *B_host,
+                            eva_t *A_device, eva_t *B_device) {
+        int rc;
+
+        /*****************************************************************************************************************
+        * Initialize device, load binary and copy A & B onto device DRAM.
+        ******************************************************************************************************************/
+        hb_mc_device_t device;
+        rc = hb_mc_device_init(&device, test_name, 0);
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_err("failed to initialize device.\n");
+                return rc;
+        }
+
+        rc = hb_mc_device_program_init(&device, bin_path, ALLOC_NAME, 0);
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_err("failed to initialize program.\n");
+                return rc;
+        }
+
+        rc = hb_mc_device_malloc(&device, N * sizeof(uint32_t), A_device);
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_err("failed to allocate memory on device.\n");
+                return rc;
+        }
+
+        rc = hb_mc_device_malloc(&device, N * sizeof(uint32_t), B_device);
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_err("failed to allocate memory on device.\n");
+                return rc;
+        }
+
+        rc = hb_mc_device_memcpy (&device, (void *) ((intptr_t) *A_device), A_host, N * sizeof(uint32_t), HB_MC_MEMCPY_TO_DEVICE);
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_err("failed to copy memory to device.\n");
+                return rc;
+        }
+
+        rc = hb_mc_device_memcpy (&device, (void *) ((intptr_t) *B_device), B_host, N * sizeof(uint32_t), HB_MC_MEMCPY_TO_DEVICE);
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_err("failed to copy memory to device.\n");
+                return rc;
+        }
+
+
+        /*****************************************************************************************************************
+        * Save the checkpoint, then overwrite A so that only a restore brings it back.
+        ******************************************************************************************************************/
+        rc = hb_mc_device_checkpoint_save(&device, CHECKPOINT_PATH);
+        if (rc != HB_MC_SUCCESS) {
+                if (rc != HB_MC_NOIMPL)
+                        bsg_pr_err("failed to save checkpoint.\n");
+                hb_mc_device_finish(&device);
+                return rc;
+        }
+
+        rc = hb_mc_device_memset(&device, A_device, 0, N * sizeof(uint32_t));
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_err("failed to set memory on device.\n");
+                return rc;
+        }
+
+        rc = hb_mc_device_finish(&device);
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_err("failed to de-initialize device.\n");
+                return rc;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+
+static int checkpoint_restore (char *bin_path, char *test_name,
+                               uint32_t *A_host, uint32_t *B_host,
+                               eva_t A_device, eva_t B_device) {
+        int rc;
+
+        /*****************************************************************************************************************
+        * Initialize a new device from the checkpoint instead of loading the binary.
+        ******************************************************************************************************************/
+        hb_mc_device_t device;
+        rc = hb_mc_device_init(&device, test_name, 0);
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_err("failed to initialize device.\n");
+                return rc;
+        }
+
+        rc = hb_mc_device_program_init_checkpoint(&device, CHECKPOINT_PATH, bin_path, ALLOC_NAME, 0);
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_err("failed to initialize program from checkpoint.\n");
+                return rc;
+        }
+
+
+        /*****************************************************************************************************************
+        * A & B must hold the values they had when the checkpoint was saved.
+        ******************************************************************************************************************/
+        uint32_t A_restored[N], B_restored[N];
+        rc = hb_mc_device_memcpy (&device, A_restored, (void *) ((intptr_t) A_device), N * sizeof(uint32_t), HB_MC_MEMCPY_TO_HOST);
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_err("failed to copy memory from device.\n");
+                return rc;
+        }
+
+        rc = hb_mc_device_memcpy (&device, B_restored, (void *) ((intptr_t) B_device), N * sizeof(uint32_t), HB_MC_MEMCPY_TO_HOST);
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_err("failed to copy memory from device.\n");
+                return rc;
+        }
+
+        int mismatch = 0;
+        for (int i = 0; i < N; i++) {
+                if (A_restored[i] != A_host[i] || B_restored[i] != B_host[i]) {
+                        bsg_pr_err(BSG_RED("Mismatch: ") "A[%d] = 0x%08" PRIx32 ", B[%d] = 0x%08" PRIx32 "\t Expected: 0x%08" PRIx32 ", 0x%08" PRIx32 "\n",
+                                   i, A_restored[i], i, B_restored[i], A_host[i], B_host[i]);
+                        mismatch = 1;
+                }
+        }
+
+
+        /*****************************************************************************************************************
+        * The allocator must still know that A & B are in use.
+        ******************************************************************************************************************/
+        eva_t C_device;
+        rc = hb_mc_device_malloc(&device, N * sizeof(uint32_t), &C_device);
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_err("failed to allocate memory on device.\n");
+                return rc;
+        }
+
+        eva_t end = C_device + N * sizeof(uint32_t);
+        if ((C_device < A_device + N * sizeof(uint32_t) && end > A_device)
+            || (C_device < B_device + N * sizeof(uint32_t) && end > B_device)) {
+                bsg_pr_err(BSG_RED("Mismatch: ") "C at 0x%08" PRIx32 " overlaps A at 0x%08" PRIx32 " or B at 0x%08" PRIx32 "\n",
+                           C_device, A_device, B_device);
+                mismatch = 1;
+        }
+
+
+        /*****************************************************************************************************************
+        * The restored program must still run: C = A + B.
+        ******************************************************************************************************************/
+        uint32_t block_size_x = N;
+        hb_mc_dimension_t tg_dim = { .x = 2, .y = 2};
+        hb_mc_dimension_t grid_dim = { .x = 1, .y = 1};
+        uint32_t cuda_argv[5] = {A_device, B_device, C_device, N, block_size_x};
+
+        rc = hb_mc_kernel_enqueue (&device, grid_dim, tg_dim, "kernel_vec_add", 5, cuda_argv);
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_err("failed to initialize grid.\n");
+                return rc;
+        }
+
+        rc = hb_mc_device_tile_groups_execute(&device);
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_err("failed to execute tile groups.\n");
+                return rc;
+        }
+
+        uint32_t C_host[N];
+        rc = hb_mc_device_memcpy (&device, C_host, (void *) ((intptr_t) C_device), N * sizeof(uint32_t), HB_MC_MEMCPY_TO_HOST);
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_err("failed to copy memory from device.\n");
+                return rc;
+        }
+
+        for (int i = 0; i < N; i++) {
+                if (A_host[i] + B_host[i] != C_host[i]) {
+                        bsg_pr_err(BSG_RED("Mismatch: ") "C[%d]:  0x%08" PRIx32 " + 0x%08" PRIx32 " = 0x%08" PRIx32 "\n",
+                                   i, A_host[i], B_host[i], C_host[i]);
+                        mismatch = 1;
+                }
+        }
+
+        rc = hb_mc_device_finish(&device);
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_err("failed to de-initialize device.\n");
+                return rc;
+        }
+
+        return mismatch ? HB_MC_FAIL : HB_MC_SUCCESS;
+}
+
+
+int kernel_checkpoint (int argc, char **argv) {
+        int rc;
+        char *bin_path, *test_name;
+        struct arguments_path args = {NULL, NULL};
+
+        argp_parse (&argp_path, argc, argv, 0, 0, &args);
+        bin_path = args.path;
+        test_name = args.name;
+
+        bsg_pr_test_info("Running the CUDA Checkpoint test on one 2x2 tile group.\n\n");
+
+        srand(time(NULL));
+
+        uint32_t A_host[N], B_host[N];
+        for (int i = 0; i < N; i++) {
+                A_host[i] = rand() & 0xFFFF;
+                B_host[i] = rand() & 0xFFFF;
+        }
+
+        eva_t A_device, B_device;
+        rc = checkpoint_save(bin_path, test_name, A_host, B_host, &A_device, &B_device);
+        if (rc == HB_MC_NOIMPL) {
+                bsg_pr_test_info("Checkpoints are not supported on this machine; "
+                                 "build it with BSG_VERILATOR_SAVABLE=1 to run this test.\n");
+                return HB_MC_SUCCESS;
+        } else if (rc != HB_MC_SUCCESS) {
+                return rc;
+        }
+
+        return checkpoint_restore(bin_path, test_name, A_host, B_host, A_device, B_device);
+}
+
+#ifdef VCS
+int vcs_main(int argc, char ** argv) {
+#else
+int main(int argc, char ** argv) {
+#endif
+        bsg_pr_test_info("test_checkpoint Regression Test\n");
+        int rc = kernel_checkpoint(argc, argv);
+        bsg_pr_test_pass_fail(rc == HB_MC_SUCCESS);
+        return rc;
+}
+
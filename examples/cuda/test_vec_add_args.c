@@ -0,0 +1,324 @@
+// Copyright (c) 2019, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "test_vec_add_args.h"
+
+#define ALLOC_NAME "default_allocator"
+
+/*!
+ * Runs the vector addition on one 2x2 tile group, with the kernel arguments
+ * passed through a typed argument list (hb_mc_kernel_args_t) instead of an
+ * argv array. The two trailing scalars are pushed as one struct by value,
+ * which the RV32 calling convention passes the same way as two int
+ * arguments, so the kernel signature is unchanged.
+ * A second launch passes the inputs themselves in the argument block: A
+ * through hb_mc_kernel_args_push_struct_ptr(), and B as a struct larger
+ * than 8 bytes, which hb_mc_kernel_args_push_struct() passes by reference.
+ * Both arrive in the kernel as pointers to the copies, so C is only
+ * correct if the copies reached the device intact.
+ * This tests uses the software/spmd/bsg_cuda_lite_runtime/vec_add/ Manycore binary in the BSG Manycore bitbucket repository.  
+*/
+
+typedef struct {
+        uint32_t N;
+        uint32_t block_size_x;
+} vec_add_size_t;
+
+#define VEC_ARG_N 16
+
+typedef struct {
+        uint32_t v[VEC_ARG_N];
+} vec_arg_t;
+
+void host_vec_add (uint32_t *A, uint32_t *B, uint32_t *C, int N) { 
+        for (int i = 0; i < N; i ++) { 
+                C[i] = A[i] + B[i];
+        }
+        return;
+}
+
+
+int kernel_vec_add_args (int argc, char **argv) {
+        int rc;
+        char *bin_path, *test_name;
+        struct arguments_path args = {NULL, NULL};
+
+        argp_parse (&argp_path, argc, argv, 0, 0, &args);
+        bin_path = args.path;
+        test_name = args.name;
+
+        bsg_pr_test_info("Running the CUDA Vector Addition Kernel with typed arguments on one 2x2 tile group.\n\n");
+
+        srand(time(NULL)); 
+
+        /*****************************************************************************************************************
+        * Define path to binary.
+        * Initialize device, load binary and unfreeze tiles.
+        ******************************************************************************************************************/
+        hb_mc_device_t device;
+        rc = hb_mc_device_init(&device, test_name, 0);
+        if (rc != HB_MC_SUCCESS) { 
+                bsg_pr_err("failed to initialize device.\n");
+                return rc;
+        }
+
+        rc = hb_mc_device_program_init(&device, bin_path, ALLOC_NAME, 0);
+        if (rc != HB_MC_SUCCESS) { 
+                bsg_pr_err("failed to initialize program.\n");
+                return rc;
+        }
+
+        /*****************************************************************************************************************
+        * Allocate memory on the device for A, B and C.
+        ******************************************************************************************************************/
+        uint32_t N = 1024;
+
+        eva_t A_device, B_device, C_device; 
+        rc = hb_mc_device_malloc(&device, N * sizeof(uint32_t), &A_device); /* allocate A[N] on the device */
+        if (rc != HB_MC_SUCCESS) { 
+                bsg_pr_err("failed to allocate memory on device.\n");
+                return rc;
+        }
+
+        rc = hb_mc_device_malloc(&device, N * sizeof(uint32_t), &B_device); /* allocate B[N] on the device */
+        if (rc != HB_MC_SUCCESS) { 
+                bsg_pr_err("failed to allocate memory on device.\n");
+                return rc;
+        }
+
+        rc = hb_mc_device_malloc(&device, N * sizeof(uint32_t), &C_device); /* allocate C[N] on the device */
+        if (rc != HB_MC_SUCCESS) { 
+                bsg_pr_err("failed to allocate memory on device.\n");
+                return rc;
+        }
+
+        /*****************************************************************************************************************
+        * Allocate memory on the host for A & B and initialize with random values.
+        ******************************************************************************************************************/
+        uint32_t A_host[N]; /* allocate A[N] on the host */ 
+        uint32_t B_host[N]; /* allocate B[N] on the host */
+        for (int i = 0; i < N; i++) { /* fill A with arbitrary data */
+                A_host[i] = rand() & 0xFFFF;
+                B_host[i] = rand() & 0xFFFF;
+        }
+
+        /*****************************************************************************************************************
+        * Copy A & B from host onto device DRAM.
+        ******************************************************************************************************************/
+        void *dst = (void *) ((intptr_t) A_device);
+        void *src = (void *) &A_host[0];
+        rc = hb_mc_device_memcpy (&device, dst, src, N * sizeof(uint32_t), HB_MC_MEMCPY_TO_DEVICE); /* Copy A to the device  */ 
+        if (rc != HB_MC_SUCCESS) { 
+                bsg_pr_err("failed to copy memory to device.\n");
+                return rc;
+        }
+
+        dst = (void *) ((intptr_t) B_device);
+        src = (void *) &B_host[0];
+        rc = hb_mc_device_memcpy (&device, dst, src, N * sizeof(uint32_t), HB_MC_MEMCPY_TO_DEVICE); /* Copy B to the device */ 
+        if (rc != HB_MC_SUCCESS) { 
+                bsg_pr_err("failed to copy memory to device.\n");
+                return rc;
+        }
+
+        /*****************************************************************************************************************
+        * Define tg_dim_x/y: number of tiles in each tile group
+        * Define grid_dim_x/y: number of tile groups
+        ******************************************************************************************************************/
+        hb_mc_dimension_t tg_dim = { .x = 2, .y = 2}; 
+
+        hb_mc_dimension_t grid_dim = { .x = 1, .y = 1}; 
+
+        /*****************************************************************************************************************
+        * Build the typed list of input arguments for kernel.
+        ******************************************************************************************************************/
+        vec_add_size_t size = { .N = N, .block_size_x = N };
+
+        hb_mc_kernel_args_t cuda_args;
+        rc = hb_mc_kernel_args_init(&cuda_args);
+        if (rc != HB_MC_SUCCESS) { 
+                bsg_pr_err("failed to initialize kernel arguments.\n");
+                return rc;
+        }
+
+        if ((rc = hb_mc_kernel_args_push_ptr(&cuda_args, A_device)) != HB_MC_SUCCESS
+            || (rc = hb_mc_kernel_args_push_ptr(&cuda_args, B_device)) != HB_MC_SUCCESS
+            || (rc = hb_mc_kernel_args_push_ptr(&cuda_args, C_device)) != HB_MC_SUCCESS
+            || (rc = hb_mc_kernel_args_push_struct(&cuda_args, &size, sizeof(size))) != HB_MC_SUCCESS) {
+                bsg_pr_err("failed to push kernel arguments.\n");
+                return rc;
+        }
+
+        if (cuda_args.argc != 5) {
+                bsg_pr_err("expected 5 argument words, got %" PRIu32 ".\n", cuda_args.argc);
+                return HB_MC_FAIL;
+        }
+
+        /*****************************************************************************************************************
+        * Enquque grid of tile groups, pass in grid and tile group dimensions, kernel name and argument list
+        ******************************************************************************************************************/
+        rc = hb_mc_kernel_enqueue_args (&device, grid_dim, tg_dim, "kernel_vec_add", &cuda_args);
+        if (rc != HB_MC_SUCCESS) { 
+                bsg_pr_err("failed to initialize grid.\n");
+                return rc;
+        }
+
+        rc = hb_mc_kernel_args_exit(&cuda_args);
+        if (rc != HB_MC_SUCCESS) { 
+                bsg_pr_err("failed to free kernel arguments.\n");
+                return rc;
+        }
+
+        /*****************************************************************************************************************
+        * Launch and execute all tile groups on device and wait for all to finish. 
+        ******************************************************************************************************************/
+        rc = hb_mc_device_tile_groups_execute(&device);
+        if (rc != HB_MC_SUCCESS) { 
+                bsg_pr_err("failed to execute tile groups.\n");
+                return rc;
+        }
+
+        /*****************************************************************************************************************
+        * Copy result matrix back from device DRAM into host memory. 
+        ******************************************************************************************************************/
+        uint32_t C_host[N];
+        src = (void *) ((intptr_t) C_device);
+        dst = (void *) &C_host[0];
+        rc = hb_mc_device_memcpy (&device, (void *) dst, src, N * sizeof(uint32_t), HB_MC_MEMCPY_TO_HOST); /* copy C to the host */
+        if (rc != HB_MC_SUCCESS) { 
+                bsg_pr_err("failed to copy memory from device.\n");
+                return rc;
+        }
+
+        /*****************************************************************************************************************
+        * Launch again with A and B copied into the argument block: A as a struct pointer, B as a struct by value.
+        ******************************************************************************************************************/
+        vec_arg_t A_arg, B_arg;
+        for (int i = 0; i < VEC_ARG_N; i++) {
+                A_arg.v[i] = rand() & 0xFFFF;
+                B_arg.v[i] = rand() & 0xFFFF;
+        }
+        vec_add_size_t arg_size = { .N = VEC_ARG_N, .block_size_x = VEC_ARG_N };
+
+        rc = hb_mc_kernel_args_init(&cuda_args);
+        if (rc != HB_MC_SUCCESS) { 
+                bsg_pr_err("failed to initialize kernel arguments.\n");
+                return rc;
+        }
+
+        if ((rc = hb_mc_kernel_args_push_struct_ptr(&cuda_args, &A_arg, sizeof(A_arg))) != HB_MC_SUCCESS
+            || (rc = hb_mc_kernel_args_push_struct(&cuda_args, &B_arg, sizeof(B_arg))) != HB_MC_SUCCESS
+            || (rc = hb_mc_kernel_args_push_ptr(&cuda_args, C_device)) != HB_MC_SUCCESS
+            || (rc = hb_mc_kernel_args_push_struct(&cuda_args, &arg_size, sizeof(arg_size))) != HB_MC_SUCCESS) {
+                bsg_pr_err("failed to push kernel arguments.\n");
+                return rc;
+        }
+
+        if (cuda_args.argc != 5 || cuda_args.nrefs != 2) {
+                bsg_pr_err("expected 5 argument words with 2 references, got %" PRIu32 " with %" PRIu32 ".\n",
+                           cuda_args.argc, cuda_args.nrefs);
+                return HB_MC_FAIL;
+        }
+
+        rc = hb_mc_kernel_enqueue_args (&device, grid_dim, tg_dim, "kernel_vec_add", &cuda_args);
+        if (rc != HB_MC_SUCCESS) { 
+                bsg_pr_err("failed to initialize grid.\n");
+                return rc;
+        }
+
+        rc = hb_mc_kernel_args_exit(&cuda_args);
+        if (rc != HB_MC_SUCCESS) { 
+                bsg_pr_err("failed to free kernel arguments.\n");
+                return rc;
+        }
+
+        rc = hb_mc_device_tile_groups_execute(&device);
+        if (rc != HB_MC_SUCCESS) { 
+                bsg_pr_err("failed to execute tile groups.\n");
+                return rc;
+        }
+
+        uint32_t C_arg[VEC_ARG_N];
+        src = (void *) ((intptr_t) C_device);
+        dst = (void *) &C_arg[0];
+        rc = hb_mc_device_memcpy (&device, (void *) dst, src, VEC_ARG_N * sizeof(uint32_t), HB_MC_MEMCPY_TO_HOST);
+        if (rc != HB_MC_SUCCESS) { 
+                bsg_pr_err("failed to copy memory from device.\n");
+                return rc;
+        }
+
+        /*****************************************************************************************************************
+        * Freeze the tiles and memory manager cleanup. 
+        ******************************************************************************************************************/
+        rc = hb_mc_device_finish(&device); 
+        if (rc != HB_MC_SUCCESS) { 
+                bsg_pr_err("failed to de-initialize device.\n");
+                return rc;
+        }
+
+        /*****************************************************************************************************************
+        * Calculate the expected result using host code and compare the results. 
+        ******************************************************************************************************************/
+        uint32_t C_expected[N]; 
+        host_vec_add (A_host, B_host, C_expected, N); 
+
+        int mismatch = 0; 
+        for (int i = 0; i < N; i++) {
+                if (C_expected[i] != C_host[i]) {
+                        bsg_pr_err(BSG_RED("Mismatch: ") "C[%d]:  0x%08" PRIx32 " + 0x%08" PRIx32 " = 0x%08" PRIx32 "\t Expected: 0x%08" PRIx32 "\n", i , A_host[i], B_host[i], C_host[i], C_expected[i]);
+                        mismatch = 1;
+                }
+        } 
+
+        uint32_t C_arg_expected[VEC_ARG_N];
+        host_vec_add (A_arg.v, B_arg.v, C_arg_expected, VEC_ARG_N);
+
+        for (int i = 0; i < VEC_ARG_N; i++) {
+                if (C_arg_expected[i] != C_arg[i]) {
+                        bsg_pr_err(BSG_RED("Mismatch: ") "struct arguments: C[%d]:  0x%08" PRIx32 " + 0x%08" PRIx32 " = 0x%08" PRIx32 "\t Expected: 0x%08" PRIx32 "\n", i , A_arg.v[i], B_arg.v[i], C_arg[i], C_arg_expected[i]);
+                        mismatch = 1;
+                }
+        }
+
+        if (mismatch) { 
+                return HB_MC_FAIL;
+        }
+        return HB_MC_SUCCESS;
+}
+
+#ifdef VCS
+int vcs_main(int argc, char ** argv) {
+#else
+int main(int argc, char ** argv) {
+#endif
+        bsg_pr_test_info("test_vec_add_args Regression Test\n");
+        int rc = kernel_vec_add_args(argc, argv);
+        bsg_pr_test_pass_fail(rc == HB_MC_SUCCESS);
+        return rc;
+}
+
+
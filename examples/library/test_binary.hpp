@@ -0,0 +1,241 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Generated RISC-V executables and the fixtures that check how they
+// were loaded, shared by the loader tests and benchmarks.
+
+#ifndef __TEST_BINARY_HPP
+#define __TEST_BINARY_HPP
+#include <bsg_manycore.h>
+#include <bsg_manycore_config.h>
+#include <bsg_manycore_coordinate.h>
+#include <bsg_manycore_eva.h>
+#include <bsg_manycore_loader.h>
+#include <bsg_manycore_printing.h>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+#include <elf.h>
+#include <string>
+#include <vector>
+#include "../cl_manycore_regression.h"
+
+#ifndef EM_RISCV
+#define EM_RISCV 243
+#endif
+
+/* A loadable segment: #file_sz random bytes followed by zeros up to #mem_sz */
+typedef struct test_binary_segment {
+        Elf32_Word flags;
+        Elf32_Addr eva;
+        Elf32_Word file_sz;
+        Elf32_Word mem_sz;
+} test_binary_segment_t;
+
+typedef struct test_binary_symbol {
+        const char *name;
+        Elf32_Addr eva;
+} test_binary_symbol_t;
+
+static inline size_t test_binary_align(size_t off)
+{
+        return (off + 3) & ~static_cast<size_t>(3);
+}
+
+/**
+ * Build a RISC-V executable.
+ * @param[in]  segs   Loadable segments, in file order
+ * @param[in]  nsegs  The number of segments in #segs
+ * @param[in]  syms   Symbols; a name may be defined more than once
+ * @param[in]  nsyms  The number of symbols in #syms. With none, the binary has no section headers.
+ * @return the binary
+ */
+static inline std::vector<unsigned char> test_binary_make(const test_binary_segment_t *segs, size_t nsegs,
+                                                          const test_binary_symbol_t *syms, size_t nsyms)
+{
+        Elf32_Ehdr ehdr = {};
+        std::vector<Elf32_Phdr> phdr(nsegs);
+        std::vector<Elf32_Sym> sym(nsyms + 1);
+        Elf32_Shdr shdr[3] = {};
+        std::string strtab(1, '\0');
+
+        size_t off_phdr = sizeof(ehdr);
+        size_t off = off_phdr + nsegs * sizeof(Elf32_Phdr);
+
+        for (size_t i = 0; i < nsegs; i++) {
+                phdr[i].p_type = PT_LOAD;
+                phdr[i].p_flags = segs[i].flags;
+                phdr[i].p_offset = off;
+                phdr[i].p_paddr = phdr[i].p_vaddr = segs[i].eva;
+                phdr[i].p_filesz = segs[i].file_sz;
+                phdr[i].p_memsz = segs[i].mem_sz;
+                off += segs[i].file_sz;
+        }
+
+        for (size_t i = 0; i < nsyms; i++) {
+                sym[i + 1].st_name = strtab.size();
+                sym[i + 1].st_value = syms[i].eva;
+                strtab.append(syms[i].name);
+                strtab.push_back('\0');
+        }
+
+        size_t off_syms = test_binary_align(off);
+        size_t off_strs = off_syms + sym.size() * sizeof(Elf32_Sym);
+        size_t off_shdr = test_binary_align(off_strs + strtab.size());
+
+        memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+        ehdr.e_ident[EI_CLASS] = ELFCLASS32;
+        ehdr.e_ident[EI_DATA] = ELFDATA2LSB;
+        ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+        ehdr.e_type = ET_EXEC;
+        ehdr.e_machine = EM_RISCV;
+        ehdr.e_version = EV_CURRENT;
+        ehdr.e_phoff = off_phdr;
+        ehdr.e_ehsize = sizeof(ehdr);
+        ehdr.e_phentsize = sizeof(Elf32_Phdr);
+        ehdr.e_phnum = nsegs;
+
+        if (nsyms > 0) {
+                ehdr.e_shoff = off_shdr;
+                ehdr.e_shentsize = sizeof(Elf32_Shdr);
+                ehdr.e_shnum = 3;
+
+                shdr[1].sh_type = SHT_SYMTAB;
+                shdr[1].sh_offset = off_syms;
+                shdr[1].sh_size = sym.size() * sizeof(Elf32_Sym);
+                shdr[1].sh_entsize = sizeof(Elf32_Sym);
+                shdr[1].sh_link = 2;
+                shdr[2].sh_type = SHT_STRTAB;
+                shdr[2].sh_offset = off_strs;
+                shdr[2].sh_size = strtab.size();
+        }
+
+        std::vector<unsigned char> bin(nsyms > 0 ? off_shdr + sizeof(shdr) : off);
+        memcpy(&bin[0], &ehdr, sizeof(ehdr));
+        if (nsegs > 0)
+                memcpy(&bin[off_phdr], phdr.data(), nsegs * sizeof(Elf32_Phdr));
+        for (size_t i = off_phdr + nsegs * sizeof(Elf32_Phdr); i < off; i++)
+                bin[i] = rand();
+        if (nsyms > 0) {
+                memcpy(&bin[off_syms], sym.data(), sym.size() * sizeof(Elf32_Sym));
+                memcpy(&bin[off_strs], strtab.data(), strtab.size());
+                memcpy(&bin[off_shdr], shdr, sizeof(shdr));
+        }
+        return bin;
+}
+
+/**
+ * Get the file contents of a segment of a binary built with test_binary_make().
+ * @param[in]  bin    A binary
+ * @param[in]  i      Index of the segment
+ * @return the first byte of the segment in #bin
+ */
+static inline const unsigned char *test_binary_segment_data(const std::vector<unsigned char> &bin, size_t i)
+{
+        Elf32_Ehdr ehdr;
+        Elf32_Phdr phdr;
+
+        memcpy(&ehdr, bin.data(), sizeof(ehdr));
+        memcpy(&phdr, &bin[ehdr.e_phoff + i * sizeof(Elf32_Phdr)], sizeof(phdr));
+        return &bin[phdr.p_offset];
+}
+
+/* compare what was read back with a segment's data followed by zeros */
+static inline bool test_binary_segment_matches(const unsigned char *rd, const unsigned char *data,
+                                               size_t file_sz, size_t mem_sz)
+{
+        for (size_t i = 0; i < mem_sz; i++) {
+                unsigned char expect = i < file_sz ? data[i] : 0;
+                if (rd[i] != expect)
+                        return false;
+        }
+        return true;
+}
+
+/* Two sets of two tiles, in the first two rows of vcores */
+typedef struct test_binary_tile_sets {
+        hb_mc_coordinate_t set0[2];
+        hb_mc_coordinate_t set1[2];
+        hb_mc_loader_tile_set_t sets[2];
+} test_binary_tile_sets_t;
+
+static inline void test_binary_tile_sets_init(const hb_mc_config_t *cfg, test_binary_tile_sets_t *t)
+{
+        hb_mc_idx_t x = hb_mc_config_get_vcore_base_x(cfg);
+        hb_mc_idx_t y = hb_mc_config_get_vcore_base_y(cfg);
+
+        t->set0[0] = hb_mc_coordinate(x, y);
+        t->set0[1] = hb_mc_coordinate(x+1, y);
+        t->set1[0] = hb_mc_coordinate(x, y+1);
+        t->set1[1] = hb_mc_coordinate(x+1, y+1);
+        t->sets[0].tiles = t->set0;
+        t->sets[0].ntiles = 2;
+        t->sets[1].tiles = t->set1;
+        t->sets[1].ntiles = 2;
+}
+
+/**
+ * Check that every segment of a binary was loaded onto every tile of a set of tile sets.
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  t      The tile sets the binary was loaded onto
+ * @param[in]  segs   The segments the binary was built with
+ * @param[in]  nsegs  The number of segments in #segs
+ * @param[in]  bin    The binary
+ * @return HB_MC_SUCCESS if every segment reads back. HB_MC_FAIL otherwise.
+ *
+ * Each segment is read through the tile's own EVA map: DMEM segments
+ * must be in every tile, and DRAM segments shared by all of them.
+ */
+static inline int test_binary_check_loaded(hb_mc_manycore_t *mc, const test_binary_tile_sets_t *t,
+                                           const test_binary_segment_t *segs, size_t nsegs,
+                                           const std::vector<unsigned char> &bin)
+{
+        for (const hb_mc_loader_tile_set_t &set : t->sets) {
+                for (uint32_t i = 0; i < set.ntiles; i++) {
+                        for (size_t s = 0; s < nsegs; s++) {
+                                std::vector<unsigned char> rd(segs[s].mem_sz);
+                                hb_mc_eva_t eva = segs[s].eva;
+                                int err = hb_mc_manycore_eva_read(mc, &default_map, &set.tiles[i],
+                                                                  &eva, rd.data(), rd.size());
+                                if (err != HB_MC_SUCCESS
+                                    || !test_binary_segment_matches(rd.data(), test_binary_segment_data(bin, s),
+                                                                    segs[s].file_sz, segs[s].mem_sz)) {
+                                        bsg_pr_test_err("Tile (%d, %d): segment at 0x%08" PRIx32
+                                                        " was not loaded\n",
+                                                        hb_mc_coordinate_get_x(set.tiles[i]),
+                                                        hb_mc_coordinate_get_y(set.tiles[i]),
+                                                        segs[s].eva);
+                                        return HB_MC_FAIL;
+                                }
+                        }
+                }
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+#endif // __TEST_BINARY_HPP
@@ -0,0 +1,144 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Writes a binary branch trace with interleaved records from several
+// tiles, spanning multiple chunks, and checks that it reads back.
+
+#include "test_branch_trace.hpp"
+#include <cstdlib>
+#include <unistd.h>
+#include <vector>
+
+#define NUM_TILES   5
+#define NUM_RECORDS (3 * HB_MC_BRANCH_TRACE_CHUNK_RECORDS + 17)
+
+int test_branch_trace()
+{
+        std::vector<hb_mc_branch_trace_record_t> expect[NUM_TILES];
+        hb_mc_branch_trace_writer_t *writer;
+        hb_mc_branch_trace_reader_t *reader;
+        hb_mc_branch_trace_record_t record;
+        char path[] = "/tmp/test_branch_trace.XXXXXX";
+        uint64_t cycle = 0;
+        size_t next[NUM_TILES] = {0};
+        int r = HB_MC_FAIL;
+        int err;
+
+        int fd = mkstemp(path);
+        if (fd < 0) {
+                bsg_pr_test_err("Failed to create a temporary file\n");
+                return HB_MC_FAIL;
+        }
+        close(fd);
+
+        err = hb_mc_branch_trace_writer_open(path, &writer);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_test_err("Failed to open writer: %s\n", hb_mc_strerror(err));
+                goto cleanup;
+        }
+
+        srand(0);
+        for (int i = 0; i < NUM_RECORDS; i++) {
+                int t = rand() % NUM_TILES;
+                cycle += rand() % 100;
+                record.cycle = cycle;
+                record.x = t;
+                record.y = 2 + t / 2;
+                // mostly nearby PCs, with an occasional far jump
+                record.data = (rand() % 8 == 0) ? rand() : 0x1000 + 4 * (rand() % 64) + (rand() & 1);
+                expect[t].push_back(record);
+
+                err = hb_mc_branch_trace_writer_append(writer, &record);
+                if (err != HB_MC_SUCCESS) {
+                        bsg_pr_test_err("Failed to append record %d: %s\n", i, hb_mc_strerror(err));
+                        hb_mc_branch_trace_writer_close(writer);
+                        goto cleanup;
+                }
+        }
+
+        err = hb_mc_branch_trace_writer_close(writer);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_test_err("Failed to close writer: %s\n", hb_mc_strerror(err));
+                goto cleanup;
+        }
+
+        err = hb_mc_branch_trace_reader_open(path, &reader);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_test_err("Failed to open reader: %s\n", hb_mc_strerror(err));
+                goto cleanup;
+        }
+
+        // records of each tile come back in order
+        while ((err = hb_mc_branch_trace_reader_next(reader, &record)) == HB_MC_SUCCESS) {
+                int t = record.x;
+                if (t >= NUM_TILES || next[t] >= expect[t].size()) {
+                        bsg_pr_test_err("Unexpected record for tile (%d, %d)\n", record.x, record.y);
+                        goto close;
+                }
+
+                const hb_mc_branch_trace_record_t &e = expect[t][next[t]++];
+                if (record.cycle != e.cycle || record.y != e.y || record.data != e.data) {
+                        bsg_pr_test_err("Tile %d record %zu: read (%" PRIu64 ", %d, %d, 0x%08" PRIx32 "), "
+                                        "expected (%" PRIu64 ", %d, %d, 0x%08" PRIx32 ")\n",
+                                        t, next[t] - 1,
+                                        record.cycle, record.x, record.y, record.data,
+                                        e.cycle, e.x, e.y, e.data);
+                        goto close;
+                }
+        }
+
+        if (err != HB_MC_NOTFOUND) {
+                bsg_pr_test_err("Failed to read trace: %s\n", hb_mc_strerror(err));
+                goto close;
+        }
+
+        for (int t = 0; t < NUM_TILES; t++) {
+                if (next[t] != expect[t].size()) {
+                        bsg_pr_test_err("Tile %d: read %zu records, expected %zu\n",
+                                        t, next[t], expect[t].size());
+                        goto close;
+                }
+        }
+
+        r = HB_MC_SUCCESS;
+close:
+        hb_mc_branch_trace_reader_close(reader);
+cleanup:
+        unlink(path);
+        return r;
+}
+
+#ifdef VCS
+int vcs_main(int argc, char ** argv) {
+#else
+int main(int argc, char ** argv) {
+#endif
+
+        bsg_pr_test_info("test_branch_trace Regression Test \n");
+        int rc = test_branch_trace();
+        bsg_pr_test_pass_fail(rc == HB_MC_SUCCESS);
+        return rc;
+}
@@ -0,0 +1,193 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore.h>
+#include <bsg_manycore_npa.h>
+#include <bsg_manycore_printing.h>
+#include <cinttypes>
+#include <cstring>
+#include <vector>
+#include "test_dma_map.hpp"
+
+#define TEST_NAME "test_dma_map"
+
+/* Larger than any granule that a memory system keeps together in host memory */
+#define NUM_WORDS 1024
+
+/*
+ * Write through a mapping and read back over the mesh, then write over
+ * the mesh and read back through the mapping.
+ */
+static int test_round_trip(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, size_t words)
+{
+        size_t sz = words * sizeof(uint32_t);
+        std::vector<uint32_t> expect(words), got(words);
+        void *ptr;
+        int err;
+
+        err = hb_mc_manycore_dma_map(mc, npa, sz, &ptr);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to map %zu bytes: %s\n",
+                           __func__, sz, hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        for (auto &w : expect)
+                w = rand();
+
+        memcpy(ptr, expect.data(), sz);
+
+        err = hb_mc_manycore_vcache_invalidate_npa_range(mc, npa, sz);
+        if (err == HB_MC_SUCCESS)
+                err = hb_mc_manycore_read_mem(mc, npa, got.data(), sz);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to read back over the mesh: %s\n",
+                           __func__, hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        for (size_t i = 0; i < words; i++) {
+                if (got[i] != expect[i]) {
+                        bsg_pr_err("%s: word %zu written through the mapping: read 0x%08" PRIx32
+                                   ", expected 0x%08" PRIx32 "\n",
+                                   __func__, i, got[i], expect[i]);
+                        return HB_MC_FAIL;
+                }
+        }
+
+        for (auto &w : expect)
+                w = rand();
+
+        err = hb_mc_manycore_write_mem(mc, npa, expect.data(), sz);
+        if (err == HB_MC_SUCCESS)
+                err = hb_mc_manycore_vcache_flush_npa_range(mc, npa, sz);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to write over the mesh: %s\n",
+                           __func__, hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        memcpy(got.data(), ptr, sz);
+        for (size_t i = 0; i < words; i++) {
+                if (got[i] != expect[i]) {
+                        bsg_pr_err("%s: word %zu read through the mapping: read 0x%08" PRIx32
+                                   ", expected 0x%08" PRIx32 "\n",
+                                   __func__, i, got[i], expect[i]);
+                        return HB_MC_FAIL;
+                }
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+int test_dma_map() {
+        hb_mc_manycore_t manycore = {0}, *mc = &manycore;
+
+        srand(0xD3A);
+
+        /********/
+        /* INIT */
+        /********/
+        int err = hb_mc_manycore_init(mc, TEST_NAME, 0);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to initialize manycore: %s\n",
+                           __func__, hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        int r = HB_MC_FAIL;
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        hb_mc_coordinate_t dram = hb_mc_config_get_dram_coordinate(cfg, 0);
+        hb_mc_npa_t npa = hb_mc_npa(dram, DRAM_BASE);
+        void *ptr;
+
+        if (!hb_mc_manycore_supports_dma_read(mc) || !hb_mc_manycore_supports_dma_write(mc)) {
+                bsg_pr_test_info("%s: DMA is not supported; skipping\n", __func__);
+                r = HB_MC_SUCCESS;
+                goto cleanup;
+        }
+
+        /* a single word never crosses a granule */
+        if (test_round_trip(mc, &npa, 1) != HB_MC_SUCCESS)
+                goto cleanup;
+
+        /*
+         * A range that crosses a granule is either mapped correctly, or,
+         * where the memory system permutes addresses, refused.
+         */
+        err = hb_mc_manycore_dma_map(mc, &npa, NUM_WORDS * sizeof(uint32_t), &ptr);
+        if (err == HB_MC_INVALID && hb_mc_config_memsys_id(cfg) == HB_MC_MEMSYS_ID_DRAMSIM3) {
+                bsg_pr_test_info("%s: range crossing a granule refused\n", __func__);
+        } else if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to map %zu bytes: %s\n",
+                           __func__, NUM_WORDS * sizeof(uint32_t), hb_mc_strerror(err));
+                goto cleanup;
+        } else if (test_round_trip(mc, &npa, NUM_WORDS) != HB_MC_SUCCESS) {
+                goto cleanup;
+        }
+
+        /*
+         * A range that runs past the end of a bank continues into another
+         * bank (or past the backing store) and must be refused. Check the
+         * first bank and the last, which ends the backing store.
+         */
+        for (hb_mc_idx_t i : {(hb_mc_idx_t)0, (hb_mc_idx_t)(hb_mc_config_get_num_dram_coordinates(cfg) - 1)}) {
+                hb_mc_npa_t end = hb_mc_npa(hb_mc_config_get_dram_coordinate(cfg, i),
+                                            hb_mc_config_get_dram_bank_size(cfg) - sizeof(uint32_t));
+                err = hb_mc_manycore_dma_map(mc, &end, 2 * sizeof(uint32_t), &ptr);
+                if (err != HB_MC_INVALID) {
+                        bsg_pr_err("%s: mapping across the end of bank %" PRIu32 " returned '%s', "
+                                   "expected '%s'\n", __func__, (uint32_t)i, hb_mc_strerror(err),
+                                   hb_mc_strerror(HB_MC_INVALID));
+                        goto cleanup;
+                }
+
+                /* the last word of the bank alone is fine */
+                if (test_round_trip(mc, &end, 1) != HB_MC_SUCCESS)
+                        goto cleanup;
+        }
+
+        r = HB_MC_SUCCESS;
+        /*******/
+        /* END */
+        /*******/
+cleanup:
+        hb_mc_manycore_exit(mc);
+        return r;
+}
+
+#ifdef VCS
+int vcs_main(int argc, char ** argv) {
+#else
+int main(int argc, char ** argv) {
+#endif
+
+        bsg_pr_test_info(TEST_NAME " Regression Test \n");
+        int rc = test_dma_map();
+        bsg_pr_test_pass_fail(rc == HB_MC_SUCCESS);
+        return rc;
+}
@@ -0,0 +1,204 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore.h>
+#include <bsg_manycore_npa.h>
+#include <bsg_manycore_printing.h>
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <vector>
+#include "test_dma_segments.hpp"
+
+#define TEST_NAME "test_dma_segments"
+
+/* Larger than the threshold at which segment lists are copied by several threads (1 MiB) */
+#define LARGE_BYTES (3 << 19)
+
+/*
+ * Write a list of segments, read it back into a second buffer, and
+ * check both the host copy and, over the mesh, the first, middle and
+ * last word of each segment. Each segment's sz must be a multiple of
+ * a word; host is an offset into the test buffers.
+ */
+static int test_round_trip(hb_mc_manycore_t *mc, const char *name,
+                           const std::vector<hb_mc_dma_segment_t> &plan)
+{
+        size_t bytes = 0;
+        for (const hb_mc_dma_segment_t &seg : plan)
+                bytes += seg.sz;
+
+        std::vector<uint32_t> src(bytes / sizeof(uint32_t)), dst(src.size());
+        std::vector<hb_mc_dma_segment_t> wr(plan), rd(plan);
+        for (auto &w : src)
+                w = rand();
+
+        for (size_t i = 0; i < plan.size(); i++) {
+                size_t off = reinterpret_cast<uintptr_t>(plan[i].host);
+                wr[i].host = reinterpret_cast<unsigned char *>(src.data()) + off;
+                rd[i].host = reinterpret_cast<unsigned char *>(dst.data()) + off;
+        }
+
+        bsg_pr_test_info("%s: %zu segments, %zu bytes\n", name, plan.size(), bytes);
+
+        int err = hb_mc_manycore_dma_write_segments_no_cache_ainv(mc, wr.data(), wr.size());
+        if (err == HB_MC_SUCCESS)
+                err = hb_mc_manycore_dma_read_segments_no_cache_afl(mc, rd.data(), rd.size());
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: %s: DMA failed: %s\n", __func__, name, hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        for (size_t i = 0; i < src.size(); i++) {
+                if (dst[i] != src[i]) {
+                        bsg_pr_err("%s: %s: word %zu read back as 0x%08" PRIx32
+                                   ", expected 0x%08" PRIx32 "\n",
+                                   __func__, name, i, dst[i], src[i]);
+                        return HB_MC_FAIL;
+                }
+        }
+
+        /* a transfer that only agrees with itself could still land at the wrong address */
+        for (const hb_mc_dma_segment_t &seg : wr) {
+                size_t words = seg.sz / sizeof(uint32_t);
+                for (size_t w : {(size_t)0, words / 2, words - 1}) {
+                        hb_mc_npa_t npa = hb_mc_npa(hb_mc_npa_get_xy(&seg.npa),
+                                                    hb_mc_npa_get_epa(&seg.npa) + w * sizeof(uint32_t));
+                        uint32_t expect = reinterpret_cast<const uint32_t *>(seg.host)[w], got;
+
+                        err = hb_mc_manycore_vcache_invalidate_npa_range(mc, &npa, sizeof(uint32_t));
+                        if (err == HB_MC_SUCCESS)
+                                err = hb_mc_manycore_read32(mc, &npa, &got);
+                        if (err != HB_MC_SUCCESS) {
+                                bsg_pr_err("%s: %s: failed to read over the mesh: %s\n",
+                                           __func__, name, hb_mc_strerror(err));
+                                return HB_MC_FAIL;
+                        }
+
+                        if (got != expect) {
+                                char npa_str[256];
+                                bsg_pr_err("%s: %s: %s read over the mesh as 0x%08" PRIx32
+                                           ", expected 0x%08" PRIx32 "\n", __func__, name,
+                                           hb_mc_npa_to_string(&npa, npa_str, sizeof(npa_str)),
+                                           got, expect);
+                                return HB_MC_FAIL;
+                        }
+                }
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/* append a segment of sz bytes at epa of a victim cache */
+static void plan_segment(std::vector<hb_mc_dma_segment_t> &plan, size_t &offset,
+                         const hb_mc_config_t *cfg, hb_mc_idx_t cache, hb_mc_epa_t epa, size_t sz)
+{
+        hb_mc_dma_segment_t seg;
+        seg.npa = hb_mc_npa(hb_mc_config_get_dram_coordinate(cfg, cache), epa);
+        seg.host = reinterpret_cast<void *>(offset);
+        seg.sz = sz;
+        plan.push_back(seg);
+        offset += sz;
+}
+
+int test_dma_segments() {
+        hb_mc_manycore_t manycore = {0}, *mc = &manycore;
+
+        srand(0xD3A5);
+
+        /********/
+        /* INIT */
+        /********/
+        int err = hb_mc_manycore_init(mc, TEST_NAME, 0);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to initialize manycore: %s\n",
+                           __func__, hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        int r = HB_MC_FAIL;
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        hb_mc_idx_t caches = hb_mc_config_get_num_dram_coordinates(cfg);
+        size_t room = hb_mc_config_get_dram_bank_size(cfg) - DRAM_BASE - 16 * sizeof(uint32_t);
+        std::vector<hb_mc_dma_segment_t> plan;
+        size_t offset;
+
+        if (!hb_mc_manycore_supports_dma_read(mc) || !hb_mc_manycore_supports_dma_write(mc)) {
+                bsg_pr_test_info("%s: DMA is not supported; skipping\n", __func__);
+                r = HB_MC_SUCCESS;
+                goto cleanup;
+        }
+
+        /*
+         * One segment in every victim cache, so the transfer spans every
+         * channel. The lengths differ by a few words, so the points where
+         * the plan is divided among threads fall inside segments.
+         */
+        offset = 0;
+        for (hb_mc_idx_t i = 0; i < caches; i++) {
+                size_t sz = (LARGE_BYTES / caches) & ~(sizeof(uint32_t) - 1);
+                sz = std::min(sz + 3 * i * sizeof(uint32_t), room);
+                plan_segment(plan, offset, cfg, i, DRAM_BASE, sz);
+        }
+
+        if (test_round_trip(mc, "every channel", plan) != HB_MC_SUCCESS)
+                goto cleanup;
+
+        /*
+         * A single segment that every split point falls inside, starting
+         * at an odd word so that no run is line aligned, behind one word
+         * in another cache.
+         */
+        plan.clear();
+        offset = 0;
+        plan_segment(plan, offset, cfg, caches - 1, DRAM_BASE + 4 * sizeof(uint32_t), sizeof(uint32_t));
+        plan_segment(plan, offset, cfg, 0, DRAM_BASE + 3 * sizeof(uint32_t),
+                     std::min<size_t>(LARGE_BYTES, room));
+
+        if (test_round_trip(mc, "one large segment", plan) != HB_MC_SUCCESS)
+                goto cleanup;
+
+        r = HB_MC_SUCCESS;
+        /*******/
+        /* END */
+        /*******/
+cleanup:
+        hb_mc_manycore_exit(mc);
+        return r;
+}
+
+#ifdef VCS
+int vcs_main(int argc, char ** argv) {
+#else
+int main(int argc, char ** argv) {
+#endif
+
+        bsg_pr_test_info(TEST_NAME " Regression Test \n");
+        int rc = test_dma_segments();
+        bsg_pr_test_pass_fail(rc == HB_MC_SUCCESS);
+        return rc;
+}
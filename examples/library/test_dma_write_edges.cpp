@@ -0,0 +1,202 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore.h>
+#include <bsg_manycore_npa.h>
+#include <bsg_manycore_printing.h>
+#include <cinttypes>
+#include <vector>
+#include "test_dma_write_edges.hpp"
+
+#define TEST_NAME "test_dma_write_edges"
+
+/* values in DRAM, in the cache, and written by DMA */
+#define OLD(i)   (0x0A000000 | (i))
+#define DIRTY(i) (0x0B000000 | (i))
+#define NEW(i)   (0x0C000000 | (i))
+
+/*
+ * Leave LINES lines at DRAM_BASE dirty in the cache: DRAM holds OLD
+ * and the cache holds DIRTY.
+ */
+static int dirty_lines(hb_mc_manycore_t *mc, const hb_mc_npa_t *base, size_t words)
+{
+        std::vector<uint32_t> old(words), dirty(words);
+        for (size_t i = 0; i < words; i++) {
+                old[i] = OLD(i);
+                dirty[i] = DIRTY(i);
+        }
+
+        int err = hb_mc_manycore_dma_write(mc, base, old.data(), words * sizeof(uint32_t));
+        if (err == HB_MC_SUCCESS)
+                err = hb_mc_manycore_write_mem(mc, base, dirty.data(), words * sizeof(uint32_t));
+        if (err != HB_MC_SUCCESS)
+                bsg_pr_err("%s: failed to dirty the test lines: %s\n",
+                           __func__, hb_mc_strerror(err));
+        return err;
+}
+
+/*
+ * Read the lines back over the mesh. Words in [lo[k], hi[k]) for some
+ * range k were written by DMA; every other word must have kept the
+ * value that was dirty in the cache.
+ */
+static int check_lines(hb_mc_manycore_t *mc, const char *name, const hb_mc_npa_t *base, size_t words,
+                       const size_t *lo, const size_t *hi, size_t ranges)
+{
+        std::vector<uint32_t> got(words);
+
+        int err = hb_mc_manycore_read_mem(mc, base, got.data(), words * sizeof(uint32_t));
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: %s: failed to read over the mesh: %s\n",
+                           __func__, name, hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        for (size_t i = 0; i < words; i++) {
+                uint32_t expect = DIRTY(i);
+                for (size_t k = 0; k < ranges; k++)
+                        if (i >= lo[k] && i < hi[k])
+                                expect = NEW(i);
+
+                if (got[i] != expect) {
+                        bsg_pr_err("%s: %s: word %zu read back as 0x%08" PRIx32
+                                   ", expected 0x%08" PRIx32 "\n",
+                                   __func__, name, i, got[i], expect);
+                        return HB_MC_FAIL;
+                }
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+int test_dma_write_edges() {
+        hb_mc_manycore_t manycore = {0}, *mc = &manycore;
+
+        /********/
+        /* INIT */
+        /********/
+        int err = hb_mc_manycore_init(mc, TEST_NAME, 0);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to initialize manycore: %s\n",
+                           __func__, hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        int r = HB_MC_FAIL;
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        size_t line_words = hb_mc_config_get_vcache_block_size(cfg) / sizeof(uint32_t);
+        size_t words = LINES * line_words;
+        hb_mc_npa_t base = hb_mc_npa(hb_mc_config_get_dram_coordinate(cfg, 0), DRAM_BASE);
+        std::vector<uint32_t> data(words);
+        std::vector<hb_mc_dma_segment_t> segs;
+
+        for (size_t i = 0; i < words; i++)
+                data[i] = NEW(i);
+
+        if (!hb_mc_manycore_supports_dma_write(mc)) {
+                bsg_pr_test_info("%s: DMA is not supported; skipping\n", __func__);
+                r = HB_MC_SUCCESS;
+                goto cleanup;
+        }
+
+        /*
+         * One range that starts three words into the first line and
+         * ends two words before the end of the last, so both of its
+         * edge lines hold dirty bytes outside it.
+         */
+        {
+                size_t lo[] = {3}, hi[] = {words - 2};
+                hb_mc_npa_t npa = hb_mc_npa(hb_mc_npa_get_xy(&base),
+                                            hb_mc_npa_get_epa(&base) + lo[0] * sizeof(uint32_t));
+
+                bsg_pr_test_info("%s: words [%zu, %zu) of %zu\n", __func__, lo[0], hi[0], words);
+
+                if (dirty_lines(mc, &base, words) != HB_MC_SUCCESS)
+                        goto cleanup;
+
+                err = hb_mc_manycore_dma_write(mc, &npa, &data[lo[0]], (hi[0] - lo[0]) * sizeof(uint32_t));
+                if (err != HB_MC_SUCCESS) {
+                        bsg_pr_err("%s: DMA write failed: %s\n", __func__, hb_mc_strerror(err));
+                        goto cleanup;
+                }
+
+                if (check_lines(mc, "hb_mc_manycore_dma_write", &base, words, lo, hi, 1) != HB_MC_SUCCESS)
+                        goto cleanup;
+        }
+
+        /*
+         * Two segments: one inside the first line, and one that starts
+         * and ends in the middle of the next two lines.
+         */
+        {
+                size_t lo[] = {1, line_words + 3}, hi[] = {line_words - 1, 2 * line_words + 2};
+
+                for (size_t k = 0; k < 2; k++) {
+                        hb_mc_dma_segment_t seg;
+                        seg.npa = hb_mc_npa(hb_mc_npa_get_xy(&base),
+                                            hb_mc_npa_get_epa(&base) + lo[k] * sizeof(uint32_t));
+                        seg.host = &data[lo[k]];
+                        seg.sz = (hi[k] - lo[k]) * sizeof(uint32_t);
+                        segs.push_back(seg);
+                        bsg_pr_test_info("%s: segment %zu: words [%zu, %zu) of %zu\n",
+                                         __func__, k, lo[k], hi[k], words);
+                }
+
+                if (dirty_lines(mc, &base, words) != HB_MC_SUCCESS)
+                        goto cleanup;
+
+                err = hb_mc_manycore_dma_write_segments(mc, segs.data(), segs.size());
+                if (err != HB_MC_SUCCESS) {
+                        bsg_pr_err("%s: DMA write failed: %s\n", __func__, hb_mc_strerror(err));
+                        goto cleanup;
+                }
+
+                if (check_lines(mc, "hb_mc_manycore_dma_write_segments", &base, words, lo, hi, 2) != HB_MC_SUCCESS)
+                        goto cleanup;
+        }
+
+        r = HB_MC_SUCCESS;
+        /*******/
+        /* END */
+        /*******/
+cleanup:
+        hb_mc_manycore_exit(mc);
+        return r;
+}
+
+#ifdef VCS
+int vcs_main(int argc, char ** argv) {
+#else
+int main(int argc, char ** argv) {
+#endif
+
+        bsg_pr_test_info(TEST_NAME " Regression Test \n");
+        int rc = test_dma_write_edges();
+        bsg_pr_test_pass_fail(rc == HB_MC_SUCCESS);
+        return rc;
+}
@@ -0,0 +1,242 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Lowers a small RISC-V executable into a load image for this machine,
+// opens it as a program image, loads it onto two tile sets, and checks
+// its symbols, what was loaded, and that other machines are rejected.
+
+#include "test_load_image.hpp"
+#include <cstddef>
+#include <unistd.h>
+#include <vector>
+
+#define TEST_NAME "test_load_image"
+
+#define TEXT_EVA     0x80000000
+#define DATA_EVA     0x1000
+
+/* An executable with program text in DRAM and data in DMEM, each with
+ * a zero-filled tail, and symbols for the start of each. */
+static const test_binary_segment_t segments[] = {
+        { PF_R | PF_X, TEXT_EVA, 64, 128 },
+        { PF_R | PF_W, DATA_EVA, 32,  96 },
+};
+
+static const test_binary_symbol_t symbols[] = {
+        { "main",    TEXT_EVA },
+        { "__bsg_x", DATA_EVA },
+};
+
+/* lower the binary to a file */
+static int lower_binary(hb_mc_manycore_t *mc, const std::vector<unsigned char> &bin,
+                        const char *path)
+{
+        static const char *cfg_syms[] = { "__bsg_x" };
+        static const char *missing_syms[] = { "__bsg_x", "missing" };
+        hb_mc_program_image_t *program;
+        int err;
+
+        err = hb_mc_program_image_from_buffer(bin.data(), bin.size(), &program);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_test_err("Failed to open the binary: %s\n", hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        // every configuration symbol must be defined
+        err = hb_mc_load_image_lower(program, mc, &default_map, missing_syms, 2, path);
+        if (err != HB_MC_NOTFOUND) {
+                bsg_pr_test_err("Lowered a binary missing a configuration symbol: %s\n",
+                                hb_mc_strerror(err));
+                hb_mc_program_image_release(program);
+                return HB_MC_FAIL;
+        }
+
+        err = hb_mc_load_image_lower(program, mc, &default_map, cfg_syms, 1, path);
+        hb_mc_program_image_release(program);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_test_err("Failed to lower the binary: %s\n", hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/* check the symbols of a load image */
+static int check_symbols(const hb_mc_program_image_t *image)
+{
+        static const char *cfg_syms[] = { "__bsg_x" };
+        static const char *other_syms[] = { "main" };
+        hb_mc_eva_t eva;
+        int err;
+
+        err = hb_mc_program_image_symbol_to_eva(image, "main", &eva);
+        if (err != HB_MC_SUCCESS || eva != TEXT_EVA) {
+                bsg_pr_test_err("main: got 0x%08" PRIx32 " (%s)\n", eva, hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        err = hb_mc_program_image_symbol_to_eva(image, "missing", &eva);
+        if (err != HB_MC_NOTFOUND) {
+                bsg_pr_test_err("Lookup of a missing symbol returned %s\n", hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        const hb_mc_load_image_t *load_image = hb_mc_program_image_get_load_image(image);
+        err = hb_mc_load_image_get_cfg_symbols(load_image, cfg_syms, 1, &eva);
+        if (err != HB_MC_SUCCESS || eva != DATA_EVA) {
+                bsg_pr_test_err("__bsg_x: got 0x%08" PRIx32 " (%s)\n", eva, hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        // the image only answers for the configuration symbols it was lowered with
+        err = hb_mc_load_image_get_cfg_symbols(load_image, other_syms, 1, &eva);
+        if (err != HB_MC_NOTFOUND) {
+                bsg_pr_test_err("Resolved configuration symbols the image was not lowered with\n");
+                return HB_MC_FAIL;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+int test_load_image_load(hb_mc_manycore_t *mc, const char *path)
+{
+        // fields of the header that another machine may differ in
+        static const struct {
+                const char *name;
+                size_t off;
+        } fields[] = {
+                { "manycore githash", offsetof(hb_mc_load_image_header_t, manycore) },
+                { "vcore width",      offsetof(hb_mc_load_image_header_t, dim_x) },
+                { "network height",   offsetof(hb_mc_load_image_header_t, net_y) },
+                { "DRAM high Y",      offsetof(hb_mc_load_image_header_t, dram_high_y) },
+                { "vcache sets",      offsetof(hb_mc_load_image_header_t, vcache_sets) },
+        };
+        test_binary_tile_sets_t t;
+        hb_mc_program_image_t *image = NULL, *other = NULL;
+        int r = HB_MC_FAIL;
+        int err;
+
+        test_binary_tile_sets_init(hb_mc_manycore_get_config(mc), &t);
+
+        std::vector<unsigned char> bin = test_binary_make(segments, 2, symbols, 2);
+
+        if (lower_binary(mc, bin, path) != HB_MC_SUCCESS)
+                return HB_MC_FAIL;
+
+        err = hb_mc_program_image_open(path, &image);
+        if (err != HB_MC_SUCCESS || !hb_mc_program_image_get_load_image(image)) {
+                bsg_pr_test_err("Failed to open the load image: %s\n", hb_mc_strerror(err));
+                goto cleanup;
+        }
+
+        if (check_symbols(image) != HB_MC_SUCCESS)
+                goto cleanup;
+
+        err = hb_mc_loader_load_image(hb_mc_program_image_get_load_image(image),
+                                      mc, &default_map, t.sets, 2);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_test_err("Failed to load the load image: %s\n", hb_mc_strerror(err));
+                goto cleanup;
+        }
+
+        // every tile got its own copy of the data segment, and shares the text segment in DRAM
+        if (test_binary_check_loaded(mc, &t, segments, 2, bin) != HB_MC_SUCCESS)
+                goto cleanup;
+
+        // an image lowered for another build or geometry of the machine is rejected
+        for (const auto &field : fields) {
+                const unsigned char *img = hb_mc_program_image_get_data(image);
+                std::vector<unsigned char> copy(img, img + hb_mc_program_image_get_size(image));
+                copy[field.off] ^= 1;
+
+                err = hb_mc_program_image_from_buffer(copy.data(), copy.size(), &other);
+                if (err != HB_MC_SUCCESS) {
+                        bsg_pr_test_err("Failed to open a copy of the load image: %s\n",
+                                        hb_mc_strerror(err));
+                        goto cleanup;
+                }
+
+                err = hb_mc_loader_load_image(hb_mc_program_image_get_load_image(other),
+                                              mc, &default_map, t.sets, 2);
+                if (err != HB_MC_INVALID) {
+                        bsg_pr_test_err("Loaded an image lowered for another %s: %s\n",
+                                        field.name, hb_mc_strerror(err));
+                        goto cleanup;
+                }
+
+                hb_mc_program_image_release(other);
+                other = NULL;
+        }
+
+        r = HB_MC_SUCCESS;
+cleanup:
+        hb_mc_program_image_release(other);
+        hb_mc_program_image_release(image);
+        return r;
+}
+
+int test_load_image()
+{
+        hb_mc_manycore_t manycore = {0}, *mc = &manycore;
+        char path[] = "/tmp/test_load_image.XXXXXX";
+        int err, r;
+
+        srand(0x10AD);
+
+        int fd = mkstemp(path);
+        if (fd < 0) {
+                bsg_pr_test_err("Failed to create a temporary file\n");
+                return HB_MC_FAIL;
+        }
+        close(fd);
+
+        err = hb_mc_manycore_init(mc, TEST_NAME, 0);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to initialize manycore: %s\n",
+                           __func__, hb_mc_strerror(err));
+                unlink(path);
+                return HB_MC_FAIL;
+        }
+
+        r = test_load_image_load(mc, path);
+
+        hb_mc_manycore_exit(mc);
+        unlink(path);
+        return r;
+}
+
+#ifdef VCS
+int vcs_main(int argc, char ** argv) {
+#else
+int main(int argc, char ** argv) {
+#endif
+
+        bsg_pr_test_info(TEST_NAME " Regression Test \n");
+        int rc = test_load_image();
+        bsg_pr_test_pass_fail(rc == HB_MC_SUCCESS);
+        return rc;
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Plans a small RISC-V executable once, loads it onto two tile sets,
+// and reads back each tile's DMEM and the shared DRAM segment.
+
+#include "test_loader_plan.hpp"
+#include <vector>
+
+#define TEST_NAME "test_loader_plan"
+
+#define TEXT_EVA     0x80000000
+#define DATA_EVA     0x1000
+
+/* An executable with program text in DRAM and data in DMEM, each with a zero-filled tail */
+static const test_binary_segment_t segments[] = {
+        { PF_R | PF_X, TEXT_EVA, 64, 128 },
+        { PF_R | PF_W, DATA_EVA, 32,  96 },
+};
+
+int test_loader_plan_load(hb_mc_manycore_t *mc)
+{
+        test_binary_tile_sets_t t;
+        hb_mc_loader_plan_t *plan;
+        int err;
+
+        test_binary_tile_sets_init(hb_mc_manycore_get_config(mc), &t);
+
+        // a binary with no program text cannot be planned
+        test_binary_segment_t no_text[] = { segments[0], segments[1] };
+        no_text[0].flags = PF_R;
+        std::vector<unsigned char> bin = test_binary_make(no_text, 2, NULL, 0);
+        err = hb_mc_loader_plan_create(bin.data(), bin.size(), mc, &plan);
+        if (err != HB_MC_INVALID) {
+                bsg_pr_test_err("Planned a binary with no program text: %s\n", hb_mc_strerror(err));
+                if (err == HB_MC_SUCCESS)
+                        hb_mc_loader_plan_destroy(plan);
+                return HB_MC_FAIL;
+        }
+
+        bin = test_binary_make(segments, 2, NULL, 0);
+        err = hb_mc_loader_plan_create(bin.data(), bin.size(), mc, &plan);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_test_err("Failed to plan the binary: %s\n", hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        err = hb_mc_loader_plan_load(plan, mc, &default_map, t.sets, 2);
+        hb_mc_loader_plan_destroy(plan);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_test_err("Failed to load the binary: %s\n", hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        // every tile got its own copy of the data segment, and shares the text segment in DRAM
+        return test_binary_check_loaded(mc, &t, segments, 2, bin);
+}
+
+int test_loader_plan()
+{
+        hb_mc_manycore_t manycore = {0}, *mc = &manycore;
+        int err, r;
+
+        srand(0x10AD);
+
+        err = hb_mc_manycore_init(mc, TEST_NAME, 0);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to initialize manycore: %s\n",
+                           __func__, hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        r = test_loader_plan_load(mc);
+
+        hb_mc_manycore_exit(mc);
+        return r;
+}
+
+#ifdef VCS
+int vcs_main(int argc, char ** argv) {
+#else
+int main(int argc, char ** argv) {
+#endif
+
+        bsg_pr_test_info(TEST_NAME " Regression Test \n");
+        int rc = test_loader_plan();
+        bsg_pr_test_pass_fail(rc == HB_MC_SUCCESS);
+        return rc;
+}
@@ -0,0 +1,137 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore.h>
+#include <bsg_manycore_npa.h>
+#include <bsg_manycore_printing.h>
+#include <cinttypes>
+#include "test_manycore_amo.hpp"
+
+#define TEST_NAME "test_manycore_amo"
+
+#define NUM_ADDS 64
+
+/* apply one atomic and check both the old value it returns and the value it leaves */
+static int test_amo(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, const char *name,
+                    int (*amo)(hb_mc_manycore_t *, const hb_mc_npa_t *, uint32_t, uint32_t *),
+                    uint32_t operand, uint32_t expect_old, uint32_t expect_new)
+{
+        uint32_t old, now;
+        int err;
+
+        err = amo(mc, npa, operand, &old);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: %s failed: %s\n", __func__, name, hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        err = hb_mc_manycore_read32(mc, npa, &now);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to read back after %s: %s\n",
+                           __func__, name, hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        if (old != expect_old || now != expect_new) {
+                bsg_pr_err("%s: %s 0x%08" PRIx32 ": returned 0x%08" PRIx32 " and left 0x%08" PRIx32
+                           ", expected 0x%08" PRIx32 " and 0x%08" PRIx32 "\n",
+                           __func__, name, operand, old, now, expect_old, expect_new);
+                return HB_MC_FAIL;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+int test_manycore_amo() {
+        hb_mc_manycore_t manycore = {0}, *mc = &manycore;
+
+        srand(0xA70);
+
+        /********/
+        /* INIT */
+        /********/
+        int err = hb_mc_manycore_init(mc, TEST_NAME, 0);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to initialize manycore: %s\n",
+                           __func__, hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        int r = HB_MC_FAIL;
+        const hb_mc_config_t *config = hb_mc_manycore_get_config(mc);
+        hb_mc_coordinate_t dram = hb_mc_config_get_dram_coordinate(config, 0);
+        hb_mc_npa_t npa = hb_mc_npa(dram, DRAM_BASE);
+        uint32_t v = rand(), operand;
+
+        err = hb_mc_manycore_write32(mc, &npa, v);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to write to DRAM: %s\n",
+                           __func__, hb_mc_strerror(err));
+                goto cleanup;
+        }
+
+        /* a work counter: each add returns the count before it */
+        for (int i = 0; i < NUM_ADDS; i++) {
+                if (test_amo(mc, &npa, "add", hb_mc_manycore_amo_add, 1, v, v + 1) != HB_MC_SUCCESS)
+                        goto cleanup;
+                v++;
+        }
+
+        operand = rand();
+        if (test_amo(mc, &npa, "swap", hb_mc_manycore_amo_swap, operand, v, operand) != HB_MC_SUCCESS)
+                goto cleanup;
+        v = operand;
+
+        operand = rand();
+        if (test_amo(mc, &npa, "or", hb_mc_manycore_amo_or, operand, v, v | operand) != HB_MC_SUCCESS)
+                goto cleanup;
+        v |= operand;
+
+        operand = rand();
+        if (test_amo(mc, &npa, "and", hb_mc_manycore_amo_and, operand, v, v & operand) != HB_MC_SUCCESS)
+                goto cleanup;
+
+        r = HB_MC_SUCCESS;
+        /*******/
+        /* END */
+        /*******/
+cleanup:
+        hb_mc_manycore_exit(mc);
+        return r;
+}
+
+#ifdef VCS
+int vcs_main(int argc, char ** argv) {
+#else
+int main(int argc, char ** argv) {
+#endif
+
+        bsg_pr_test_info(TEST_NAME " Regression Test \n");
+        int rc = test_manycore_amo();
+        bsg_pr_test_pass_fail(rc == HB_MC_SUCCESS);
+        return rc;
+}
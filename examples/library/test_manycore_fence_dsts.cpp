@@ -0,0 +1,251 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore.h>
+#include <bsg_manycore_npa.h>
+#include <bsg_manycore_printing.h>
+#include <cinttypes>
+#include <vector>
+#include "test_manycore_fence_dsts.hpp"
+
+#define TEST_NAME "test_manycore_fence_dsts"
+
+#define NUM_WORDS 32
+
+/* send stores without a fence; hb_mc_manycore_write32() does not fence */
+static int write_words(hb_mc_manycore_t *mc, const hb_mc_npa_t *base, const std::vector<uint32_t> &words)
+{
+        for (size_t i = 0; i < words.size(); i++) {
+                hb_mc_npa_t npa = *base;
+                hb_mc_npa_set_epa(&npa, hb_mc_npa_get_epa(base) + i * sizeof(uint32_t));
+                int err = hb_mc_manycore_write32(mc, &npa, words[i]);
+                if (err != HB_MC_SUCCESS) {
+                        bsg_pr_err("%s: failed to write: %s\n", __func__, hb_mc_strerror(err));
+                        return err;
+                }
+        }
+        return HB_MC_SUCCESS;
+}
+
+static int check_words(hb_mc_manycore_t *mc, const hb_mc_npa_t *base, const std::vector<uint32_t> &words)
+{
+        std::vector<uint32_t> read(words.size());
+        int err = hb_mc_manycore_read_mem(mc, base, read.data(), read.size() * sizeof(uint32_t));
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to read back: %s\n", __func__, hb_mc_strerror(err));
+                return err;
+        }
+
+        for (size_t i = 0; i < words.size(); i++) {
+                if (read[i] != words[i]) {
+                        bsg_pr_err("%s: word %zu: read 0x%08" PRIx32 ", wrote 0x%08" PRIx32 "\n",
+                                   __func__, i, read[i], words[i]);
+                        return HB_MC_FAIL;
+                }
+        }
+        return HB_MC_SUCCESS;
+}
+
+/* check how many requests were sent since *sent, and update it */
+static int check_sent(hb_mc_manycore_t *mc, uint64_t *sent, uint64_t expected, const char *what)
+{
+        uint64_t now;
+        int err = hb_mc_manycore_get_requests_sent(mc, &now);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to get the requests sent: %s\n", __func__, hb_mc_strerror(err));
+                return err;
+        }
+
+        if (now - *sent != expected) {
+                bsg_pr_err("%s: %s sent %" PRIu64 " requests, expected %" PRIu64 "\n",
+                           __func__, what, now - *sent, expected);
+                return HB_MC_FAIL;
+        }
+
+        *sent = now;
+        return HB_MC_SUCCESS;
+}
+
+static int check_fenced(hb_mc_manycore_t *mc, const hb_mc_coordinate_t *dst, int expected, const char *what)
+{
+        int fenced;
+        int err = hb_mc_manycore_dst_is_fenced(mc, dst, &fenced);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to check the destination: %s\n", __func__, hb_mc_strerror(err));
+                return err;
+        }
+
+        if (fenced != expected) {
+                bsg_pr_err("%s: destination (%" PRIu32 ", %" PRIu32 ") is %sfenced after %s\n", __func__,
+                           (uint32_t)hb_mc_coordinate_get_x(*dst), (uint32_t)hb_mc_coordinate_get_y(*dst),
+                           fenced ? "" : "not ", what);
+                return HB_MC_FAIL;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+int test_manycore_fence_dsts() {
+        hb_mc_manycore_t manycore = {0}, *mc = &manycore;
+
+        srand(0xFE7C);
+
+        /********/
+        /* INIT */
+        /********/
+        int err = hb_mc_manycore_init(mc, TEST_NAME, 0);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to initialize manycore: %s\n",
+                           __func__, hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        int r = HB_MC_FAIL;
+        const hb_mc_config_t *config = hb_mc_manycore_get_config(mc);
+        hb_mc_coordinate_t dsts [] = {
+                hb_mc_config_get_dram_coordinate(config, 0),
+                hb_mc_coordinate(hb_mc_config_get_vcore_base_x(config),
+                                 hb_mc_config_get_vcore_base_y(config)),
+        };
+        hb_mc_coordinate_t idle = hb_mc_config_get_dram_coordinate(config, 1);
+        /* another tile, sent stores that the partial fence leaves alone */
+        hb_mc_coordinate_t other = hb_mc_coordinate(hb_mc_config_get_vcore_base_x(config) + 1,
+                                                    hb_mc_config_get_vcore_base_y(config));
+        hb_mc_npa_t dram = hb_mc_npa(dsts[0], DRAM_BASE);
+        hb_mc_npa_t dmem = hb_mc_npa(dsts[1], DMEM_BASE);
+        hb_mc_npa_t other_dmem = hb_mc_npa(other, DMEM_BASE);
+        std::vector<uint32_t> dram_words(NUM_WORDS), dmem_words(NUM_WORDS), other_words(NUM_WORDS);
+        uint64_t sent = 0;
+
+        for (int i = 0; i < NUM_WORDS; i++) {
+                dram_words[i] = rand();
+                dmem_words[i] = rand();
+                other_words[i] = rand();
+        }
+
+        /* count requests from here on */
+        err = hb_mc_manycore_get_requests_sent(mc, &sent);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to get the requests sent: %s\n", __func__, hb_mc_strerror(err));
+                goto cleanup;
+        }
+
+        /* nothing is in flight: this needs no hardware access */
+        err = hb_mc_manycore_host_request_fence_dsts(mc, dsts, 2, -1);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: idle fence failed: %s\n", __func__, hb_mc_strerror(err));
+                goto cleanup;
+        }
+
+        if (check_sent(mc, &sent, 0, "an idle fence") != HB_MC_SUCCESS)
+                goto cleanup;
+
+        if (write_words(mc, &dram, dram_words) != HB_MC_SUCCESS
+            || write_words(mc, &dmem, dmem_words) != HB_MC_SUCCESS
+            || write_words(mc, &other_dmem, other_words) != HB_MC_SUCCESS
+            || check_sent(mc, &sent, 3 * NUM_WORDS, "the stores") != HB_MC_SUCCESS)
+                goto cleanup;
+
+        if (check_fenced(mc, &dsts[0], 0, "the stores") != HB_MC_SUCCESS
+            || check_fenced(mc, &dsts[1], 0, "the stores") != HB_MC_SUCCESS
+            || check_fenced(mc, &other, 0, "the stores") != HB_MC_SUCCESS)
+                goto cleanup;
+
+        /* a destination that was sent nothing is already fenced */
+        err = hb_mc_manycore_host_request_fence_dsts(mc, &idle, 1, -1);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: fence of an idle destination failed: %s\n",
+                           __func__, hb_mc_strerror(err));
+                goto cleanup;
+        }
+
+        if (check_sent(mc, &sent, 0, "a fence of an idle destination") != HB_MC_SUCCESS
+            || check_fenced(mc, &dsts[0], 0, "a fence of another destination") != HB_MC_SUCCESS)
+                goto cleanup;
+
+        /*
+         * Fence the stores to DRAM and DMEM by probing both destinations:
+         * exactly one load each, and the third destination stays unfenced
+         * (a full fence would have fenced it too).
+         */
+        err = hb_mc_manycore_host_request_fence_dsts(mc, dsts, 2, -1);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: partial fence failed: %s\n", __func__, hb_mc_strerror(err));
+                goto cleanup;
+        }
+
+        if (check_sent(mc, &sent, 2, "a partial fence") != HB_MC_SUCCESS
+            || check_fenced(mc, &dsts[0], 1, "a partial fence") != HB_MC_SUCCESS
+            || check_fenced(mc, &dsts[1], 1, "a partial fence") != HB_MC_SUCCESS
+            || check_fenced(mc, &other, 0, "a partial fence") != HB_MC_SUCCESS)
+                goto cleanup;
+
+        /* fenced destinations need no more probes */
+        err = hb_mc_manycore_host_request_fence_dsts(mc, dsts, 2, -1);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: repeated partial fence failed: %s\n", __func__, hb_mc_strerror(err));
+                goto cleanup;
+        }
+
+        if (check_sent(mc, &sent, 0, "a repeated partial fence") != HB_MC_SUCCESS)
+                goto cleanup;
+
+        if (check_words(mc, &dram, dram_words) != HB_MC_SUCCESS
+            || check_words(mc, &dmem, dmem_words) != HB_MC_SUCCESS)
+                goto cleanup;
+
+        /* the probes do not stand in for a full fence */
+        err = hb_mc_manycore_host_request_fence(mc, -1);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: full fence failed: %s\n", __func__, hb_mc_strerror(err));
+                goto cleanup;
+        }
+
+        if (check_fenced(mc, &other, 1, "a full fence") != HB_MC_SUCCESS
+            || check_words(mc, &other_dmem, other_words) != HB_MC_SUCCESS)
+                goto cleanup;
+
+        r = HB_MC_SUCCESS;
+        /*******/
+        /* END */
+        /*******/
+cleanup:
+        hb_mc_manycore_exit(mc);
+        return r;
+}
+
+#ifdef VCS
+int vcs_main(int argc, char ** argv) {
+#else
+int main(int argc, char ** argv) {
+#endif
+
+        bsg_pr_test_info(TEST_NAME " Regression Test \n");
+        int rc = test_manycore_fence_dsts();
+        bsg_pr_test_pass_fail(rc == HB_MC_SUCCESS);
+        return rc;
+}
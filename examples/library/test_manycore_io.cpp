@@ -0,0 +1,176 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore.h>
+#include <bsg_manycore_io.h>
+#include <bsg_manycore_npa.h>
+#include <bsg_manycore_printing.h>
+#include <atomic>
+#include <cinttypes>
+#include <thread>
+#include <vector>
+#include "test_manycore_io.hpp"
+
+#define TEST_NAME "test_manycore_io"
+
+#define NUM_THREADS 4
+#define WORDS_PER_THREAD 32
+#define ROUNDS 4
+
+/* each thread owns a slice of DMEM on the first tile */
+static hb_mc_npa_t slice_npa(hb_mc_manycore_t *mc, int thread)
+{
+        return hb_mc_npa_from_x_y(hb_mc_config_get_vcore_base_x(hb_mc_manycore_get_config(mc)),
+                                  hb_mc_config_get_vcore_base_y(hb_mc_manycore_get_config(mc)),
+                                  DMEM_BASE + thread * WORDS_PER_THREAD * sizeof(uint32_t));
+}
+
+/* runs on the I/O thread: read the first word of each slice directly */
+static int read_first_words(hb_mc_manycore_t *mc, void *arg)
+{
+        uint32_t *words = static_cast<uint32_t*>(arg);
+        for (int t = 0; t < NUM_THREADS; t++) {
+                hb_mc_npa_t npa = slice_npa(mc, t);
+                int err = hb_mc_manycore_read32(mc, &npa, &words[t]);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+        }
+        return HB_MC_SUCCESS;
+}
+
+static void writer_reader(hb_mc_manycore_t *mc, hb_mc_io_t *io, int thread,
+                          std::atomic<int> *failures)
+{
+        std::vector<uint32_t> wr(WORDS_PER_THREAD), rd(WORDS_PER_THREAD);
+        hb_mc_npa_t npa = slice_npa(mc, thread);
+
+        for (int round = 0; round < ROUNDS; round++) {
+                hb_mc_io_future_t *write_done, *read_done;
+
+                for (int i = 0; i < WORDS_PER_THREAD; i++)
+                        wr[i] = (thread << 24) | (round << 16) | i;
+
+                if (hb_mc_io_write_mem(io, &npa, wr.data(), wr.size() * sizeof(uint32_t),
+                                       &write_done) != HB_MC_SUCCESS ||
+                    hb_mc_io_read_mem(io, &npa, rd.data(), rd.size() * sizeof(uint32_t),
+                                      &read_done) != HB_MC_SUCCESS) {
+                        bsg_pr_err("thread %d: failed to submit commands\n", thread);
+                        (*failures)++;
+                        return;
+                }
+
+                int write_err = hb_mc_io_future_wait(write_done);
+                int read_err = hb_mc_io_future_wait(read_done);
+                if (write_err != HB_MC_SUCCESS || read_err != HB_MC_SUCCESS) {
+                        bsg_pr_err("thread %d: write: %s, read: %s\n", thread,
+                                   hb_mc_strerror(write_err), hb_mc_strerror(read_err));
+                        (*failures)++;
+                        return;
+                }
+
+                /* commands run in submission order, so the read sees the write */
+                if (rd != wr) {
+                        bsg_pr_err("thread %d: round %d: data mismatch\n", thread, round);
+                        (*failures)++;
+                        return;
+                }
+        }
+}
+
+int test_manycore_io() {
+        hb_mc_manycore_t manycore = {0}, *mc = &manycore;
+        hb_mc_io_t *io;
+        std::atomic<int> failures(0);
+        uint32_t first_words[NUM_THREADS];
+        int err, r = HB_MC_FAIL;
+
+        /********/
+        /* INIT */
+        /********/
+        err = hb_mc_manycore_init(mc, TEST_NAME, 0);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to initialize manycore: %s\n",
+                           __func__, hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        err = hb_mc_io_init(mc, &io);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to start I/O thread: %s\n",
+                           __func__, hb_mc_strerror(err));
+                goto cleanup;
+        }
+
+        {
+                std::vector<std::thread> threads;
+                for (int t = 0; t < NUM_THREADS; t++)
+                        threads.emplace_back(writer_reader, mc, io, t, &failures);
+                for (auto &thread : threads)
+                        thread.join();
+        }
+
+        {
+                hb_mc_io_future_t *done;
+                err = hb_mc_io_call(io, read_first_words, first_words, &done);
+                if (err == HB_MC_SUCCESS)
+                        err = hb_mc_io_future_wait(done);
+        }
+
+        hb_mc_io_exit(io);
+
+        if (failures != 0 || err != HB_MC_SUCCESS)
+                goto cleanup;
+
+        for (int t = 0; t < NUM_THREADS; t++) {
+                uint32_t expect = (t << 24) | ((ROUNDS - 1) << 16);
+                if (first_words[t] != expect) {
+                        bsg_pr_err("%s: slice %d: read 0x%08" PRIx32 ", expected 0x%08" PRIx32 "\n",
+                                   __func__, t, first_words[t], expect);
+                        goto cleanup;
+                }
+        }
+
+        r = HB_MC_SUCCESS;
+        /*******/
+        /* END */
+        /*******/
+cleanup:
+        hb_mc_manycore_exit(mc);
+        return r;
+}
+
+#ifdef VCS
+int vcs_main(int argc, char ** argv) {
+#else
+int main(int argc, char ** argv) {
+#endif
+
+        bsg_pr_test_info(TEST_NAME " Regression Test \n");
+        int rc = test_manycore_io();
+        bsg_pr_test_pass_fail(rc == HB_MC_SUCCESS);
+        return rc;
+}
@@ -0,0 +1,207 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore.h>
+#include <bsg_manycore_npa.h>
+#include <bsg_manycore_printing.h>
+#include <cinttypes>
+#include <vector>
+#include "test_manycore_read_async.hpp"
+
+#define TEST_NAME "test_manycore_read_async"
+
+#define NUM_WORDS 256
+
+static hb_mc_npa_t word_npa(hb_mc_manycore_t *mc, size_t i)
+{
+        return hb_mc_npa_from_x_y(hb_mc_config_get_vcore_base_x(hb_mc_manycore_get_config(mc)),
+                                  hb_mc_config_get_vcore_base_y(hb_mc_manycore_get_config(mc)),
+                                  DMEM_BASE + i * sizeof(uint32_t));
+}
+
+/* keep as many reads in flight as the pool allows, interleaving synchronous reads */
+static int test_read_async(hb_mc_manycore_t *mc, const std::vector<uint32_t> &expect)
+{
+        std::vector<hb_mc_read_token_t> tokens;
+        std::vector<size_t> token_to_i;
+        size_t rqst_i = 0, rsp_i = 0;
+        int err;
+
+        while (rsp_i < expect.size()) {
+                while (rqst_i < expect.size()) {
+                        hb_mc_npa_t npa = word_npa(mc, rqst_i);
+                        hb_mc_read_token_t token;
+                        err = hb_mc_manycore_read_async(mc, &npa, sizeof(uint32_t), &token);
+                        if (err == HB_MC_BUSY)
+                                break;
+                        if (err != HB_MC_SUCCESS) {
+                                bsg_pr_err("%s: failed to start read: %s\n",
+                                           __func__, hb_mc_strerror(err));
+                                return HB_MC_FAIL;
+                        }
+                        tokens.push_back(token);
+                        token_to_i.push_back(rqst_i++);
+                }
+
+                if (tokens.empty())
+                        continue;
+
+                /* a synchronous read must not consume the responses of outstanding reads */
+                if (tokens.size() > 1) {
+                        size_t i = token_to_i[0];
+                        hb_mc_npa_t npa = word_npa(mc, i);
+                        uint32_t read_data;
+                        err = hb_mc_manycore_read32(mc, &npa, &read_data);
+                        if (err == HB_MC_SUCCESS && read_data != expect[i]) {
+                                bsg_pr_err("%s: read32 of word %zu: read 0x%08" PRIx32
+                                           ", expected 0x%08" PRIx32 "\n",
+                                           __func__, i, read_data, expect[i]);
+                                return HB_MC_FAIL;
+                        } else if (err != HB_MC_SUCCESS && err != HB_MC_BUSY) {
+                                bsg_pr_err("%s: read32 failed: %s\n",
+                                           __func__, hb_mc_strerror(err));
+                                return HB_MC_FAIL;
+                        }
+                }
+
+                size_t k;
+                uint32_t read_data;
+                err = hb_mc_manycore_read_wait_any(mc, tokens.data(), tokens.size(), &k, &read_data);
+                if (err != HB_MC_SUCCESS) {
+                        bsg_pr_err("%s: failed to wait on reads: %s\n",
+                                   __func__, hb_mc_strerror(err));
+                        return HB_MC_FAIL;
+                }
+
+                size_t i = token_to_i[k];
+                if (read_data != expect[i]) {
+                        bsg_pr_err("%s: word %zu: read 0x%08" PRIx32 ", expected 0x%08" PRIx32 "\n",
+                                   __func__, i, read_data, expect[i]);
+                        return HB_MC_FAIL;
+                }
+                rsp_i++;
+
+                tokens[k] = tokens.back();
+                tokens.pop_back();
+                token_to_i[k] = token_to_i.back();
+                token_to_i.pop_back();
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/* start a handful of sub-word reads and wait on all of them at once */
+static int test_read_wait_all(hb_mc_manycore_t *mc, const std::vector<uint32_t> &expect)
+{
+        hb_mc_read_token_t tokens[4];
+        uint32_t read_data[4];
+        int err;
+
+        for (size_t b = 0; b < 4; b++) {
+                hb_mc_npa_t npa = word_npa(mc, 0);
+                hb_mc_npa_set_epa(&npa, hb_mc_npa_get_epa(&npa) + b);
+                err = hb_mc_manycore_read_async(mc, &npa, sizeof(uint8_t), &tokens[b]);
+                if (err != HB_MC_SUCCESS) {
+                        bsg_pr_err("%s: failed to start read: %s\n",
+                                   __func__, hb_mc_strerror(err));
+                        return HB_MC_FAIL;
+                }
+        }
+
+        err = hb_mc_manycore_read_wait_all(mc, tokens, 4, read_data);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to wait on reads: %s\n",
+                           __func__, hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        for (size_t b = 0; b < 4; b++) {
+                uint32_t byte = (expect[0] >> (8 * b)) & 0xFF;
+                if (read_data[b] != byte) {
+                        bsg_pr_err("%s: byte %zu: read 0x%02" PRIx32 ", expected 0x%02" PRIx32 "\n",
+                                   __func__, b, read_data[b], byte);
+                        return HB_MC_FAIL;
+                }
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+int test_manycore_read_async() {
+        hb_mc_manycore_t manycore = {0}, *mc = &manycore;
+        std::vector<uint32_t> expect(NUM_WORDS);
+
+        srand(0xBEEF);
+
+        /********/
+        /* INIT */
+        /********/
+        int err = hb_mc_manycore_init(mc, TEST_NAME, 0);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to initialize manycore: %s\n",
+                           __func__, hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        int r = HB_MC_FAIL;
+        hb_mc_npa_t npa = word_npa(mc, 0);
+
+        for (auto &w : expect)
+                w = rand();
+
+        err = hb_mc_manycore_write_mem(mc, &npa, expect.data(), expect.size() * sizeof(uint32_t));
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to write to manycore DMEM: %s\n",
+                           __func__, hb_mc_strerror(err));
+                goto cleanup;
+        }
+
+        if (test_read_async(mc, expect) != HB_MC_SUCCESS)
+                goto cleanup;
+        if (test_read_wait_all(mc, expect) != HB_MC_SUCCESS)
+                goto cleanup;
+
+        r = HB_MC_SUCCESS;
+        /*******/
+        /* END */
+        /*******/
+cleanup:
+        hb_mc_manycore_exit(mc);
+        return r;
+}
+
+#ifdef VCS
+int vcs_main(int argc, char ** argv) {
+#else
+int main(int argc, char ** argv) {
+#endif
+
+        bsg_pr_test_info(TEST_NAME " Regression Test \n");
+        int rc = test_manycore_read_async();
+        bsg_pr_test_pass_fail(rc == HB_MC_SUCCESS);
+        return rc;
+}
@@ -0,0 +1,134 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Checks the batch packet encoder and decoder against packets built
+// field by field with the accessor functions.
+
+#include "test_packet_batch.hpp"
+#include <cstring>
+#include <cstdlib>
+
+#define NUM_PACKETS 37
+
+static int test_encode(hb_mc_packet_op_t op, uint8_t op_ex, const uint32_t *data)
+{
+        hb_mc_packet_t batch[NUM_PACKETS] __attribute__((aligned(16)));
+        hb_mc_packet_t expect[NUM_PACKETS] __attribute__((aligned(16)));
+        hb_mc_coordinate_t src = hb_mc_coordinate(0, 1);
+        hb_mc_npa_t base = hb_mc_npa_from_x_y(3, 9, 0x1234);
+        hb_mc_epa_t stride = 8;
+        int err;
+
+        err = hb_mc_request_packet_batch_encode(batch, src, &base, stride,
+                                                data, NUM_PACKETS, op, op_ex);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_test_err("Failed to encode batch: %s\n", hb_mc_strerror(err));
+                return err;
+        }
+
+        for (int i = 0; i < NUM_PACKETS; i++) {
+                hb_mc_request_packet_t *pkt = &expect[i].request;
+                memset(pkt, 0, sizeof(*pkt));
+                hb_mc_request_packet_set_x_dst(pkt, hb_mc_npa_get_x(&base));
+                hb_mc_request_packet_set_y_dst(pkt, hb_mc_npa_get_y(&base));
+                hb_mc_request_packet_set_x_src(pkt, hb_mc_coordinate_get_x(src));
+                hb_mc_request_packet_set_y_src(pkt, hb_mc_coordinate_get_y(src));
+                hb_mc_request_packet_set_data(pkt, data ? data[i] : 0);
+                hb_mc_request_packet_set_mask(pkt, static_cast<hb_mc_packet_mask_t>(op_ex));
+                hb_mc_request_packet_set_op(pkt, op);
+                hb_mc_request_packet_set_epa(pkt, hb_mc_npa_get_epa(&base) + i * stride);
+        }
+
+        for (int i = 0; i < NUM_PACKETS; i++) {
+                if (memcmp(&batch[i], &expect[i], sizeof(hb_mc_packet_t))) {
+                        bsg_pr_test_err("Packet %d differs from the expected packet\n", i);
+                        return HB_MC_FAIL;
+                }
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+static int test_decode(const uint32_t *data)
+{
+        hb_mc_packet_t batch[NUM_PACKETS] __attribute__((aligned(16)));
+        uint32_t decoded[NUM_PACKETS];
+        uint8_t ids[NUM_PACKETS];
+
+        memset(batch, 0, sizeof(batch));
+        for (int i = 0; i < NUM_PACKETS; i++) {
+                batch[i].response.x_dst = 0;
+                batch[i].response.y_dst = 1;
+                batch[i].response.load_id = 7 * i;
+                batch[i].response.data = data[i];
+        }
+
+        hb_mc_response_packet_batch_decode(batch, NUM_PACKETS, decoded, ids);
+
+        for (int i = 0; i < NUM_PACKETS; i++) {
+                if (decoded[i] != data[i] || ids[i] != static_cast<uint8_t>(7 * i)) {
+                        bsg_pr_test_err("Response %d decoded as (0x%08" PRIx32 ", %u), "
+                                        "expected (0x%08" PRIx32 ", %u)\n",
+                                        i, decoded[i], ids[i], data[i], static_cast<uint8_t>(7 * i));
+                        return HB_MC_FAIL;
+                }
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+int test_packet_batch()
+{
+        uint32_t data[NUM_PACKETS];
+        int err;
+
+        srand(0);
+        for (int i = 0; i < NUM_PACKETS; i++)
+                data[i] = rand();
+
+        err = test_encode(HB_MC_PACKET_OP_REMOTE_STORE, HB_MC_PACKET_REQUEST_MASK_WORD, data);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        err = test_encode(HB_MC_PACKET_OP_REMOTE_LOAD, HB_MC_PACKET_REQUEST_MASK_WORD, NULL);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        return test_decode(data);
+}
+
+#ifdef VCS
+int vcs_main(int argc, char ** argv) {
+#else
+int main(int argc, char ** argv) {
+#endif
+
+        bsg_pr_test_info("test_packet_batch Regression Test \n");
+        int rc = test_packet_batch();
+        bsg_pr_test_pass_fail(rc == HB_MC_SUCCESS);
+        return rc;
+}
@@ -0,0 +1,175 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Builds a small RISC-V executable, opens it as a program image, and
+// checks its segments, symbols and sharing.
+
+#include "test_program_image.hpp"
+#include <cstring>
+#include <unistd.h>
+#include <vector>
+
+#define TEXT_EVA 0x80000000
+#define DATA_EVA 0x1000
+
+/* An executable with a text segment, a data segment with a .bss tail,
+ * and a symbol table in which "main" is defined twice. */
+static const test_binary_segment_t segments[] = {
+        { PF_R | PF_X, TEXT_EVA, 16, 16 },
+        { PF_R | PF_W, DATA_EVA,  8, 64 },
+};
+
+static const test_binary_symbol_t symbols[] = {
+        { "main",               TEXT_EVA + 4 },
+        { "_bsg_data_end_addr", DATA_EVA + 64 },
+        { "main",               TEXT_EVA + 8 },
+};
+
+static int check_image(const hb_mc_program_image_t *image, const std::vector<unsigned char> &bin)
+{
+        const hb_mc_program_segment_t *segs;
+        hb_mc_eva_t eva;
+        size_t n;
+        int err;
+
+        if (hb_mc_program_image_get_size(image) != bin.size()
+            || memcmp(hb_mc_program_image_get_data(image), bin.data(), bin.size())) {
+                bsg_pr_test_err("Image contents differ from the binary\n");
+                return HB_MC_FAIL;
+        }
+
+        hb_mc_program_image_get_segments(image, &segs, &n);
+        if (n != 2
+            || segs[0].eva != TEXT_EVA || segs[0].file_sz != 16 || segs[0].mem_sz != 16
+            || !(segs[0].flags & PF_X) || memcmp(segs[0].data, test_binary_segment_data(bin, 0), 16)
+            || segs[1].eva != DATA_EVA || segs[1].file_sz != 8 || segs[1].mem_sz != 64
+            || memcmp(segs[1].data, test_binary_segment_data(bin, 1), 8)) {
+                bsg_pr_test_err("Segments were not indexed correctly\n");
+                return HB_MC_FAIL;
+        }
+
+        // the first definition of a name wins
+        err = hb_mc_program_image_symbol_to_eva(image, "main", &eva);
+        if (err != HB_MC_SUCCESS || eva != TEXT_EVA + 4) {
+                bsg_pr_test_err("main: got 0x%08" PRIx32 " (%s)\n", eva, hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        err = hb_mc_program_image_symbol_to_eva(image, "_bsg_data_end_addr", &eva);
+        if (err != HB_MC_SUCCESS || eva != DATA_EVA + 64) {
+                bsg_pr_test_err("_bsg_data_end_addr: got 0x%08" PRIx32 " (%s)\n", eva, hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        err = hb_mc_program_image_symbol_to_eva(image, "missing", &eva);
+        if (err != HB_MC_NOTFOUND) {
+                bsg_pr_test_err("Lookup of a missing symbol returned %s\n", hb_mc_strerror(err));
+                return HB_MC_FAIL;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+int test_program_image()
+{
+        std::vector<unsigned char> bin = test_binary_make(segments, 2, symbols, 3);
+        hb_mc_program_image_t *a = NULL, *b = NULL, *c = NULL;
+        char path[] = "/tmp/test_program_image.XXXXXX";
+        int r = HB_MC_FAIL;
+        int err;
+
+        int fd = mkstemp(path);
+        if (fd < 0) {
+                bsg_pr_test_err("Failed to create a temporary file\n");
+                return HB_MC_FAIL;
+        }
+        if (write(fd, bin.data(), bin.size()) != (ssize_t)bin.size()) {
+                bsg_pr_test_err("Failed to write the binary\n");
+                close(fd);
+                goto cleanup;
+        }
+        close(fd);
+
+        err = hb_mc_program_image_open(path, &a);
+        if (err != HB_MC_SUCCESS || check_image(a, bin) != HB_MC_SUCCESS) {
+                bsg_pr_test_err("Failed to open the binary: %s\n", hb_mc_strerror(err));
+                goto cleanup;
+        }
+
+        // opening the file again shares the image
+        err = hb_mc_program_image_open(path, &b);
+        if (err != HB_MC_SUCCESS || b != a) {
+                bsg_pr_test_err("Reopening the binary did not share its image\n");
+                goto cleanup;
+        }
+
+        err = hb_mc_program_image_from_buffer(bin.data(), bin.size(), &c);
+        if (err != HB_MC_SUCCESS || c == a || check_image(c, bin) != HB_MC_SUCCESS) {
+                bsg_pr_test_err("Failed to create an image from a buffer: %s\n", hb_mc_strerror(err));
+                goto cleanup;
+        }
+        hb_mc_program_image_release(c);
+        c = NULL;
+
+        // other machines are rejected
+        bin[offsetof(Elf32_Ehdr, e_machine)] = EM_386;
+        err = hb_mc_program_image_from_buffer(bin.data(), bin.size(), &c);
+        if (err != HB_MC_INVALID) {
+                bsg_pr_test_err("A non RISC-V binary was accepted\n");
+                goto cleanup;
+        }
+        c = NULL;
+
+        // truncated binaries are rejected
+        bin[offsetof(Elf32_Ehdr, e_machine)] = EM_RISCV;
+        err = hb_mc_program_image_from_buffer(bin.data(), bin.size() / 2, &c);
+        if (err != HB_MC_INVALID) {
+                bsg_pr_test_err("A truncated binary was accepted\n");
+                goto cleanup;
+        }
+        c = NULL;
+
+        r = HB_MC_SUCCESS;
+cleanup:
+        hb_mc_program_image_release(c);
+        hb_mc_program_image_release(b);
+        hb_mc_program_image_release(a);
+        unlink(path);
+        return r;
+}
+
+#ifdef VCS
+int vcs_main(int argc, char ** argv) {
+#else
+int main(int argc, char ** argv) {
+#endif
+
+        bsg_pr_test_info("test_program_image Regression Test \n");
+        int rc = test_program_image();
+        bsg_pr_test_pass_fail(rc == HB_MC_SUCCESS);
+        return rc;
+}
@@ -0,0 +1,69 @@
+# Copyright (c) 2019, University of Washington All rights reserved.
+# 
+# Redistribution and use in source and binary forms, with or without modification,
+# are permitted provided that the following conditions are met:
+# 
+# Redistributions of source code must retain the above copyright notice, this list
+# of conditions and the following disclaimer.
+# 
+# Redistributions in binary form must reproduce the above copyright notice, this
+# list of conditions and the following disclaimer in the documentation and/or
+# other materials provided with the distribution.
+# 
+# Neither the name of the copyright holder nor the names of its contributors may
+# be used to endorse or promote products derived from this software without
+# specific prior written permission.
+# 
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+# ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+# WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+# ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+# (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+# LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+# ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# Runs the CUDA-Lite vector addition kernel from Python through the
+# hammerblade extension module. Host data lives in array.array objects,
+# which are handed to the device through the buffer protocol (NumPy
+# arrays and torch CPU tensors work the same way).
+#
+# Usage: test_hammerblade.py <path to vec_add main.riscv>
+
+import array
+import random
+import sys
+
+import hammerblade as hb
+
+N = 1024
+
+device = hb.device_init("test_hammerblade")
+device.program_init(sys.argv[1])
+
+A = array.array('I', (random.getrandbits(16) for _ in range(N)))
+B = array.array('I', (random.getrandbits(16) for _ in range(N)))
+C = array.array('I', bytes(4 * N))
+
+A_device = device.malloc(4 * N)
+B_device = device.malloc(4 * N)
+C_device = device.malloc(4 * N)
+
+device.memcpy(A_device, A, hb.MEMCPY_TO_DEVICE)
+device.memcpy(B_device, B, hb.MEMCPY_TO_DEVICE)
+
+device.kernel_enqueue((1, 1), (2, 2), "kernel_vec_add",
+                      [A_device, B_device, C_device, N, N])
+device.execute()
+
+device.memcpy(C, C_device, hb.MEMCPY_TO_HOST)
+
+mismatches = sum(1 for a, b, c in zip(A, B, C) if a + b != c)
+device.finish()
+
+if mismatches:
+    sys.exit("{} of {} results are wrong".format(mismatches, N))
+
+print("Vector addition of {} elements passed".format(N))
@@ -34,6 +34,7 @@
 #include <bsg_manycore_responder.h>
 #include <bsg_manycore_epa.h>
 #include <bsg_manycore_vcache.h>
+#include <bsg_manycore_packet_batch.h>
 
 #include <cinttypes>
 #include <cstdint>
@@ -43,11 +44,15 @@
 #include <climits>
 #include <cstdbool>
 #include <cassert>
+#include <unistd.h>
 
 #include <type_traits>
-#include <stack>
 #include <queue>
+#include <string>
 #include <vector>
+#include <unordered_map>
+#include <new>
+#include <algorithm>
 
 #define array_size(x)                           \
         (sizeof(x)/sizeof(x[0]))
@@ -80,6 +85,147 @@ static int hb_mc_manycore_get_remote_load_cap(hb_mc_manycore_t *mc, unsigned *ca
         return HB_MC_SUCCESS;
 }
 
+/*
+ * Host-side ledger of request credits.
+ *
+ * Every request the host sends holds an endpoint credit until its
+ * destination answers it. Loads and atomics are answered with a
+ * response that reaches the host, so once every such response has
+ * been received their credits are known to be back. Stores and cache
+ * operations are answered inside the endpoint; only a fence shows that
+ * they have completed.
+ *
+ * Requests are numbered in the order they are sent. A fence over
+ * requests that are all known to be complete needs no hardware access.
+ */
+typedef struct hb_mc_manycore_dst_credits {
+        uint64_t last_store; //!< number of the last store or cache operation sent here
+        uint64_t last_load;  //!< number of the last load or atomic sent here
+        uint64_t fenced;     //!< requests sent here up to this number are complete
+        hb_mc_epa_t probe;   //!< EPA that a load may read to order behind last_store
+        bool probe_valid;    //!< is #probe usable?
+} hb_mc_manycore_dst_credits_t;
+
+typedef struct hb_mc_manycore_credits {
+        uint64_t sent;       //!< requests sent
+        uint64_t fenced;     //!< all requests up to this number are complete
+        uint64_t drained;    //!< all loads up to this number have been answered
+        uint64_t last_store; //!< number of the last store or cache operation
+        uint64_t last_load;  //!< number of the last load or atomic
+        size_t   awaiting;   //!< loads and atomics awaiting a response
+        std::unordered_map<uint32_t, hb_mc_manycore_dst_credits_t> dsts;
+        uint32_t last_key;                      //!< key of #last_dst
+        hb_mc_manycore_dst_credits_t *last_dst; //!< most recently used destination
+} hb_mc_manycore_credits_t;
+
+/* destinations probed by one partial fence before a full fence is cheaper */
+#define HB_MC_MANYCORE_FENCE_PROBES_MAX 16
+
+static hb_mc_manycore_credits_t *hb_mc_manycore_get_credits(hb_mc_manycore_t *mc)
+{
+        return static_cast<hb_mc_manycore_credits_t*>(mc->credits);
+}
+
+static int hb_mc_manycore_init_credits(hb_mc_manycore_t *mc)
+{
+        hb_mc_manycore_credits_t *credits = new (std::nothrow) hb_mc_manycore_credits_t();
+        if (credits == nullptr)
+                return HB_MC_NOMEM;
+
+        mc->credits = credits;
+        return HB_MC_SUCCESS;
+}
+
+static void hb_mc_manycore_cleanup_credits(hb_mc_manycore_t *mc)
+{
+        delete hb_mc_manycore_get_credits(mc);
+        mc->credits = nullptr;
+}
+
+/* forget every request sent so far: none of them can be in flight */
+static void hb_mc_manycore_reset_credits(hb_mc_manycore_t *mc)
+{
+        hb_mc_manycore_credits_t *credits = hb_mc_manycore_get_credits(mc);
+
+        credits->fenced = credits->drained = credits->sent;
+        credits->awaiting = 0;
+        credits->dsts.clear();
+        credits->last_dst = nullptr;
+}
+
+static uint32_t hb_mc_manycore_dst_key(hb_mc_idx_t x, hb_mc_idx_t y)
+{
+        return (static_cast<uint32_t>(x) << 16) | static_cast<uint32_t>(y);
+}
+
+static hb_mc_manycore_dst_credits_t *hb_mc_manycore_get_dst_credits(hb_mc_manycore_credits_t *credits,
+                                                                   hb_mc_idx_t x, hb_mc_idx_t y)
+{
+        uint32_t key = hb_mc_manycore_dst_key(x, y);
+
+        // bulk transfers send long runs of requests to one destination
+        if (credits->last_dst == nullptr || credits->last_key != key) {
+                credits->last_dst = &credits->dsts[key];
+                credits->last_key = key;
+        }
+
+        return credits->last_dst;
+}
+
+/* record a request that has been handed to the platform */
+static void hb_mc_manycore_credits_sent(hb_mc_manycore_t *mc, const hb_mc_request_packet_t *request)
+{
+        hb_mc_manycore_credits_t *credits = hb_mc_manycore_get_credits(mc);
+        hb_mc_manycore_dst_credits_t *dst =
+                hb_mc_manycore_get_dst_credits(credits,
+                                               hb_mc_request_packet_get_x_dst(request),
+                                               hb_mc_request_packet_get_y_dst(request));
+        uint64_t seq = ++credits->sent;
+
+        switch (hb_mc_request_packet_get_op(request)) {
+        case HB_MC_PACKET_OP_REMOTE_LOAD:
+        case HB_MC_PACKET_OP_REMOTE_AMO:
+                credits->awaiting++;
+                credits->last_load = dst->last_load = seq;
+                break;
+        case HB_MC_PACKET_OP_REMOTE_STORE:
+                credits->last_store = dst->last_store = seq;
+                dst->probe = hb_mc_request_packet_get_epa(request) & ~static_cast<hb_mc_epa_t>(0x3);
+                dst->probe_valid = true;
+                break;
+        default:
+                // a load cannot safely follow a cache operation
+                credits->last_store = dst->last_store = seq;
+                dst->probe_valid = false;
+                break;
+        }
+}
+
+/* record a response to a load or atomic */
+static void hb_mc_manycore_credits_answered(hb_mc_manycore_t *mc)
+{
+        hb_mc_manycore_credits_t *credits = hb_mc_manycore_get_credits(mc);
+
+        if (credits->awaiting > 0 && --credits->awaiting == 0)
+                credits->drained = credits->sent;
+}
+
+/* have all requests sent to a destination completed? */
+static bool hb_mc_manycore_dst_is_quiet(const hb_mc_manycore_credits_t *credits,
+                                        const hb_mc_manycore_dst_credits_t *dst)
+{
+        uint64_t fenced = std::max(credits->fenced, dst->fenced);
+        return dst->last_store <= fenced
+                && dst->last_load <= std::max(fenced, credits->drained);
+}
+
+/* have all requests completed? */
+static bool hb_mc_manycore_is_quiet(const hb_mc_manycore_credits_t *credits)
+{
+        return credits->last_store <= credits->fenced
+                && credits->last_load <= std::max(credits->fenced, credits->drained);
+}
+
 /**
  * Stall until the all requests (and responses to the host) have reached their destination.
  * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
@@ -88,7 +234,142 @@ static int hb_mc_manycore_get_remote_load_cap(hb_mc_manycore_t *mc, unsigned *ca
  */
 int hb_mc_manycore_host_request_fence(hb_mc_manycore_t *mc, long timeout)
 {
-        return hb_mc_platform_fence(mc, timeout);
+        hb_mc_manycore_credits_t *credits = hb_mc_manycore_get_credits(mc);
+        int err;
+
+        if (hb_mc_manycore_is_quiet(credits))
+                return HB_MC_SUCCESS;
+
+        err = hb_mc_platform_fence(mc, timeout);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        credits->fenced = credits->sent;
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Stall until all requests to a set of destinations have reached them.
+ * @param[in]  mc      A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  dsts    The destinations to fence
+ * @param[in]  n       The number of destinations in #dsts
+ * @param[in]  timeout A timeout counter. Unused - set to -1 to wait forever.
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ *
+ * The network and the endpoints keep requests from the host to one
+ * destination in order, so a load that follows the last store to a
+ * destination is answered only once that store has completed. Stores
+ * to DRAM and to tile data memory are fenced by loading from the
+ * address last stored to. Any other destination with outstanding
+ * requests falls back to a fence of every request.
+ */
+int hb_mc_manycore_host_request_fence_dsts(hb_mc_manycore_t *mc,
+                                           const hb_mc_coordinate_t *dsts,
+                                           size_t n,
+                                           long timeout)
+{
+        hb_mc_manycore_credits_t *credits = hb_mc_manycore_get_credits(mc);
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        hb_mc_manycore_dst_credits_t *probed[HB_MC_MANYCORE_FENCE_PROBES_MAX];
+        hb_mc_npa_t npas[HB_MC_MANYCORE_FENCE_PROBES_MAX];
+        hb_mc_read_token_t tokens[HB_MC_MANYCORE_FENCE_PROBES_MAX];
+        uint32_t data[HB_MC_MANYCORE_FENCE_PROBES_MAX];
+        size_t n_probes = 0, n_issued;
+        uint64_t seq;
+        int err;
+
+        if (timeout != -1) {
+                manycore_pr_err(mc, "%s: Only a timeout value of -1 is supported\n",
+                                __func__);
+                return HB_MC_NOIMPL;
+        }
+
+        if (hb_mc_manycore_is_quiet(credits))
+                return HB_MC_SUCCESS;
+
+        for (size_t i = 0; i < n; i++) {
+                hb_mc_manycore_dst_credits_t *dst =
+                        hb_mc_manycore_get_dst_credits(credits,
+                                                       hb_mc_coordinate_get_x(dsts[i]),
+                                                       hb_mc_coordinate_get_y(dsts[i]));
+
+                if (hb_mc_manycore_dst_is_quiet(credits, dst)
+                    || std::find(probed, probed + n_probes, dst) != probed + n_probes)
+                        continue;
+
+                bool probe_ok = dst->probe_valid
+                        && (hb_mc_config_coordinate_is_dram(cfg, dsts[i])
+                            || (dst->probe >= HB_MC_TILE_EPA_DMEM_BASE
+                                && dst->probe < HB_MC_TILE_EPA_DMEM_BASE
+                                + hb_mc_tile_get_size_dmem(mc, &dsts[i])));
+
+                if (!probe_ok || n_probes == HB_MC_MANYCORE_FENCE_PROBES_MAX)
+                        return hb_mc_manycore_host_request_fence(mc, timeout);
+
+                npas[n_probes] = hb_mc_epa_to_npa(dsts[i], dst->probe);
+                probed[n_probes++] = dst;
+        }
+
+        if (n_probes == 0)
+                return HB_MC_SUCCESS;
+
+        for (n_issued = 0; n_issued < n_probes; n_issued++) {
+                err = hb_mc_manycore_read_async(mc, &npas[n_issued], sizeof(uint32_t),
+                                                &tokens[n_issued]);
+                if (err != HB_MC_SUCCESS)
+                        break;
+        }
+
+        // every probe is ordered behind the requests sent before it
+        seq = credits->sent;
+
+        // a probe's destination is quiet once its load is answered
+        int wait_err = hb_mc_manycore_read_wait_all(mc, tokens, n_issued, data);
+        if (wait_err != HB_MC_SUCCESS)
+                return wait_err;
+
+        // the reads already in flight held every load ID
+        if (err == HB_MC_BUSY)
+                return hb_mc_manycore_host_request_fence(mc, timeout);
+
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        for (size_t i = 0; i < n_probes; i++)
+                probed[i]->fenced = seq;
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Get the number of requests that the host has sent
+ * @param[in]  mc      A manycore instance initialized with hb_mc_manycore_init()
+ * @param[out] sent    Set to the number of requests sent
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_get_requests_sent(hb_mc_manycore_t *mc, uint64_t *sent)
+{
+        *sent = hb_mc_manycore_get_credits(mc)->sent;
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Check whether every request sent to a destination is known to have completed
+ * @param[in]  mc      A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  dst     The destination to check
+ * @param[out] fenced  Set to one if no request to #dst can be in flight. Zero otherwise.
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_dst_is_fenced(hb_mc_manycore_t *mc, const hb_mc_coordinate_t *dst,
+                                 int *fenced)
+{
+        const hb_mc_manycore_credits_t *credits = hb_mc_manycore_get_credits(mc);
+
+        // a destination that was never sent anything has no entry
+        auto it = credits->dsts.find(hb_mc_manycore_dst_key(hb_mc_coordinate_get_x(*dst),
+                                                            hb_mc_coordinate_get_y(*dst)));
+        *fenced = it == credits->dsts.end() || hb_mc_manycore_dst_is_quiet(credits, &it->second);
+        return HB_MC_SUCCESS;
 }
 
 ///////////////////
@@ -96,19 +377,160 @@ int hb_mc_manycore_host_request_fence(hb_mc_manycore_t *mc, long timeout)
 ///////////////////
 
 
+/*
+ * The ROM can be cached on disk by pointing BSG_MANYCORE_ROM_CACHE at a
+ * directory. Cache files are keyed by the words that identify a
+ * hardware build (version, build timestamp and githashes), so on a hit
+ * only those words are read from the device.
+ */
+#define HB_MC_ROM_CACHE_ENV   "BSG_MANYCORE_ROM_CACHE"
+#define HB_MC_ROM_CACHE_MAGIC 0x4d4f5248 // "HROM"
+
+static const hb_mc_config_id_t hb_mc_rom_cache_key_ids [] = {
+        HB_MC_CONFIG_VERSION,
+        HB_MC_CONFIG_TIMESTAMP,
+        HB_MC_CONFIG_REPO_BASEJUMP_HASH,
+        HB_MC_CONFIG_REPO_MANYCORE_HASH,
+        HB_MC_CONFIG_REPO_F1_HASH,
+};
+
+typedef struct hb_mc_rom_cache_header {
+        uint32_t magic;
+        uint32_t words;
+        hb_mc_config_raw_t key[array_size(hb_mc_rom_cache_key_ids)];
+        uint32_t checksum;
+} hb_mc_rom_cache_header_t;
+
+/* FNV-1a over the cached ROM words */
+static uint32_t hb_mc_rom_cache_checksum(const hb_mc_config_raw_t config[HB_MC_CONFIG_MAX])
+{
+        uint32_t sum = 2166136261u;
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(config);
+        for (size_t i = 0; i < sizeof(hb_mc_config_raw_t) * HB_MC_CONFIG_MAX; i++) {
+                sum ^= p[i];
+                sum *= 16777619u;
+        }
+        return sum;
+}
+
+/* read the ROM words that key the cache */
+static int hb_mc_rom_cache_get_key(hb_mc_manycore_t *mc,
+                                   hb_mc_config_raw_t key[array_size(hb_mc_rom_cache_key_ids)])
+{
+        int err;
+        for (size_t i = 0; i < array_size(hb_mc_rom_cache_key_ids); i++) {
+                err = hb_mc_platform_get_config_at(mc, hb_mc_rom_cache_key_ids[i], &key[i]);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+        }
+        return HB_MC_SUCCESS;
+}
+
+/* format the path of the cache file for a key */
+static void hb_mc_rom_cache_get_path(const char *dir,
+                                     const hb_mc_config_raw_t key[array_size(hb_mc_rom_cache_key_ids)],
+                                     char *path, size_t sz)
+{
+        snprintf(path, sz, "%s/rom_%08" PRIx32 "_%08" PRIx32 "_%08" PRIx32
+                 "_%08" PRIx32 "_%08" PRIx32 ".bin",
+                 dir, key[0], key[1], key[2], key[3], key[4]);
+}
+
+/* load a cached ROM, failing unless it is complete and matches the key */
+static int hb_mc_rom_cache_load(const char *path,
+                                const hb_mc_config_raw_t key[array_size(hb_mc_rom_cache_key_ids)],
+                                hb_mc_config_raw_t config[HB_MC_CONFIG_MAX])
+{
+        hb_mc_rom_cache_header_t hdr;
+        FILE *f = fopen(path, "rb");
+        int r = HB_MC_FAIL;
+
+        if (!f)
+                return HB_MC_NOTFOUND;
+
+        if (fread(&hdr, sizeof(hdr), 1, f) != 1)
+                goto done;
+
+        if (hdr.magic != HB_MC_ROM_CACHE_MAGIC || hdr.words != HB_MC_CONFIG_MAX
+            || memcmp(hdr.key, key, sizeof(hdr.key)) != 0)
+                goto done;
+
+        if (fread(config, sizeof(hb_mc_config_raw_t), HB_MC_CONFIG_MAX, f) != HB_MC_CONFIG_MAX)
+                goto done;
+
+        if (hdr.checksum != hb_mc_rom_cache_checksum(config))
+                goto done;
+
+        // The key words must also agree with the cached ROM itself
+        for (size_t i = 0; i < array_size(hb_mc_rom_cache_key_ids); i++)
+                if (config[hb_mc_rom_cache_key_ids[i]] != key[i])
+                        goto done;
+
+        r = HB_MC_SUCCESS;
+done:
+        fclose(f);
+        return r;
+}
+
+/* write a cached ROM; the rename makes the file appear atomically */
+static int hb_mc_rom_cache_store(const char *path,
+                                 const hb_mc_config_raw_t key[array_size(hb_mc_rom_cache_key_ids)],
+                                 const hb_mc_config_raw_t config[HB_MC_CONFIG_MAX])
+{
+        hb_mc_rom_cache_header_t hdr;
+        char tmp[PATH_MAX];
+        FILE *f;
+        bool ok;
+
+        hdr.magic = HB_MC_ROM_CACHE_MAGIC;
+        hdr.words = HB_MC_CONFIG_MAX;
+        memcpy(hdr.key, key, sizeof(hdr.key));
+        hdr.checksum = hb_mc_rom_cache_checksum(config);
+
+        snprintf(tmp, sizeof(tmp), "%s.%ld", path, (long)getpid());
+        f = fopen(tmp, "wb");
+        if (!f)
+                return HB_MC_FAIL;
+
+        ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1
+                && fwrite(config, sizeof(hb_mc_config_raw_t), HB_MC_CONFIG_MAX, f) == HB_MC_CONFIG_MAX;
+        ok = (fclose(f) == 0) && ok;
+
+        if (!ok || rename(tmp, path) != 0) {
+                remove(tmp);
+                return HB_MC_FAIL;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
 /* initialize configuration */
 static int hb_mc_manycore_init_config(hb_mc_manycore_t *mc)
 {
         int err;
-        uintptr_t addr;
-        int idx;
         hb_mc_config_raw_t config[HB_MC_CONFIG_MAX];
+        hb_mc_config_raw_t key[array_size(hb_mc_rom_cache_key_ids)];
+        const char *dir = getenv(HB_MC_ROM_CACHE_ENV);
+        char path[PATH_MAX];
+        bool cached = false;
 
-        for (idx = HB_MC_CONFIG_MIN; idx < HB_MC_CONFIG_MAX; idx++) {
-                err = hb_mc_platform_get_config_at(mc, idx, &config[idx]);
+        if (dir && *dir) {
+                err = hb_mc_rom_cache_get_key(mc, key);
                 if (err != HB_MC_SUCCESS){
                         manycore_pr_err(mc, "%s: Failed to read configuration"
-                                        " index %d\n", __func__, idx);
+                                        " key\n", __func__);
+                        return err;
+                }
+
+                hb_mc_rom_cache_get_path(dir, key, path, sizeof(path));
+                cached = hb_mc_rom_cache_load(path, key, config) == HB_MC_SUCCESS;
+        }
+
+        if (!cached) {
+                err = hb_mc_platform_get_config(mc, config);
+                if (err != HB_MC_SUCCESS){
+                        manycore_pr_err(mc, "%s: Failed to read configuration\n",
+                                        __func__);
                         return err;
                 }
         }
@@ -121,11 +543,69 @@ static int hb_mc_manycore_init_config(hb_mc_manycore_t *mc)
                 return err;
         }
 
-        manycore_pr_dbg(mc, "Initialized configuration from ROM\n");
+        if (dir && *dir && !cached) {
+                if (hb_mc_rom_cache_store(path, key, config) != HB_MC_SUCCESS)
+                        manycore_pr_warn(mc, "%s: Failed to write ROM cache %s\n",
+                                         __func__, path);
+        }
+
+        manycore_pr_dbg(mc, "Initialized configuration from %s\n",
+                        cached ? path : "ROM");
+
+        return HB_MC_SUCCESS;
+}
+
+/*
+ * Outstanding remote loads.
+ *
+ * Load IDs are taken from free_ids by hb_mc_manycore_read_async() and
+ * returned when the read is waited on. A response may arrive before
+ * anyone waits on its read; its data is then held in its slot.
+ */
+typedef struct hb_mc_manycore_load {
+        enum { FREE, PENDING, DONE } state;
+        hb_mc_epa_t epa;       //!< byte address of the read, for masking
+        size_t      sz;        //!< size of the read in bytes
+        uint32_t    data;      //!< response data once DONE
+} hb_mc_manycore_load_t;
+
+typedef struct hb_mc_manycore_loads {
+        std::vector<hb_mc_manycore_load_t> slots; //!< indexed by load ID
+        std::vector<uint32_t> free_ids;           //!< a stack of unused load IDs
+        size_t pending;                           //!< number of slots awaiting a response
+} hb_mc_manycore_loads_t;
+
+static hb_mc_manycore_loads_t *hb_mc_manycore_get_loads(hb_mc_manycore_t *mc)
+{
+        return static_cast<hb_mc_manycore_loads_t*>(mc->loads);
+}
+
+/* create the load ID pool, sized to the number of remote loads the host may have in flight */
+static int hb_mc_manycore_init_loads(hb_mc_manycore_t *mc)
+{
+        unsigned n_ids = hb_mc_config_get_io_remote_load_cap(hb_mc_manycore_get_config(mc));
+
+        hb_mc_manycore_loads_t *loads = new (std::nothrow) hb_mc_manycore_loads_t;
+        if (loads == nullptr)
+                return HB_MC_NOMEM;
+
+        loads->slots.resize(n_ids);
+        for (unsigned i = 0; i < n_ids; i++) {
+                loads->slots[i].state = hb_mc_manycore_load_t::FREE;
+                loads->free_ids.push_back(n_ids - 1 - i);
+        }
+        loads->pending = 0;
 
+        mc->loads = loads;
         return HB_MC_SUCCESS;
 }
 
+static void hb_mc_manycore_cleanup_loads(hb_mc_manycore_t *mc)
+{
+        delete hb_mc_manycore_get_loads(mc);
+        mc->loads = nullptr;
+}
+
 /**
  * Initialize a manycore instance
  * @param[in] mc    A manycore to initialize
@@ -165,8 +645,25 @@ int  hb_mc_manycore_init(hb_mc_manycore_t *mc, const char *name, hb_mc_manycore_
                 return err;
         }
 
+        // initialize the load ID pool
+        if ((err = hb_mc_manycore_init_loads(mc)) != HB_MC_SUCCESS){
+                hb_mc_platform_cleanup(mc);
+                free((void*)mc->name);
+                return err;
+        }
+
+        // initialize the credit ledger
+        if ((err = hb_mc_manycore_init_credits(mc)) != HB_MC_SUCCESS){
+                hb_mc_manycore_cleanup_loads(mc);
+                hb_mc_platform_cleanup(mc);
+                free((void*)mc->name);
+                return err;
+        }
+
         // initialize responders
         if ((err = hb_mc_responders_init(mc))){
+                hb_mc_manycore_cleanup_credits(mc);
+                hb_mc_manycore_cleanup_loads(mc);
                 hb_mc_platform_cleanup(mc);
                 free((void*)mc->name);
                 return err;
@@ -174,6 +671,8 @@ int  hb_mc_manycore_init(hb_mc_manycore_t *mc, const char *name, hb_mc_manycore_
 
         // enable dram
         if ((err = hb_mc_manycore_enable_dram(mc)) != HB_MC_SUCCESS){
+                hb_mc_manycore_cleanup_credits(mc);
+                hb_mc_manycore_cleanup_loads(mc);
                 hb_mc_platform_cleanup(mc);
                 free((void*)mc->name);
                 return err;
@@ -195,6 +694,8 @@ int hb_mc_manycore_exit(hb_mc_manycore_t *mc)
                            __func__, hb_mc_strerror(err));
                 return err;
         }
+        hb_mc_manycore_cleanup_credits(mc);
+        hb_mc_manycore_cleanup_loads(mc);
         hb_mc_platform_cleanup(mc);
         free((void*)mc->name);
         return HB_MC_SUCCESS;
@@ -234,7 +735,12 @@ int hb_mc_manycore_request_tx(hb_mc_manycore_t *mc,
                               long timeout)
 {
         /* send the request packet */
-        return hb_mc_platform_transmit(mc, (hb_mc_packet_t*)request, HB_MC_FIFO_TX_REQ, timeout);
+        int err = hb_mc_platform_transmit(mc, (hb_mc_packet_t*)request, HB_MC_FIFO_TX_REQ, timeout);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        hb_mc_manycore_credits_sent(mc, request);
+        return HB_MC_SUCCESS;
 }
 
 /**
@@ -249,7 +755,12 @@ int hb_mc_manycore_response_rx(hb_mc_manycore_t *mc,
                                long timeout)
 {
         /* receive the response packet */
-        return hb_mc_platform_receive(mc, (hb_mc_packet_t*)response, HB_MC_FIFO_RX_RSP, timeout);
+        int err = hb_mc_platform_receive(mc, (hb_mc_packet_t*)response, HB_MC_FIFO_RX_RSP, timeout);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        hb_mc_manycore_credits_answered(mc);
+        return HB_MC_SUCCESS;
 }
 
 /**
@@ -423,6 +934,24 @@ static int hb_mc_manycore_format_cache_op_request_packet(hb_mc_manycore_t *mc,
         return 0;
 }
 
+static int hb_mc_manycore_format_amo_request_packet(hb_mc_manycore_t *mc,
+                                                    hb_mc_request_packet_t *pkt,
+                                                    const hb_mc_npa_t *npa,
+                                                    hb_mc_packet_amo_t amo,
+                                                    uint32_t operand)
+{
+        int r;
+
+        if ((r = hb_mc_manycore_format_request_packet(mc, pkt, npa)) != 0)
+                return r;
+
+        hb_mc_request_packet_set_data(pkt, operand);
+        hb_mc_request_packet_set_op(pkt, HB_MC_PACKET_OP_REMOTE_AMO);
+        hb_mc_request_packet_set_amo(pkt, amo);
+
+        return 0;
+}
+
 
 /************************/
 /* Cache Operations API */
@@ -486,7 +1015,7 @@ static int hb_mc_manycore_vcache_apply_to_npa_range(hb_mc_manycore_t *mc,
                 hb_mc_npa_t line_npa = *npa;
                 hb_mc_npa_set_epa(&line_npa, epa);
 
-                err = hb_mc_manycore_vcache_apply_to_npa(mc, npa, cache_op);
+                err = hb_mc_manycore_vcache_apply_to_npa(mc, &line_npa, cache_op);
                 if (err != HB_MC_SUCCESS)
                         return err;
 
@@ -538,6 +1067,72 @@ int hb_mc_manycore_vcache_flush_npa_range(hb_mc_manycore_t *mc,
         return hb_mc_manycore_read32(mc, npa, &dummy);
 }
 
+/**
+ * Start flushing a range of manycore DRAM addresses without waiting for the flush to complete.
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  npa    A valid hb_mc_npa_t (must map to DRAM) - start of the range to flush
+ * @param[in]  sz     The size of the range to flush in bytes
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_vcache_flush_npa_range_nowait(hb_mc_manycore_t *mc,
+                                                 const hb_mc_npa_t *npa,
+                                                 size_t sz)
+{
+        return hb_mc_manycore_vcache_apply_to_npa_range(mc, npa, sz,
+                                                        HB_MC_PACKET_CACHE_OP_AFL);
+}
+
+/**
+ * Flush the partially covered cache lines at either end of a range of manycore DRAM addresses.
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  npa    A valid hb_mc_npa_t (must map to DRAM) - start of the range
+ * @param[in]  sz     The size of the range in bytes
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ *
+ * Call this before writing the range behind the cache (e.g. via DMA)
+ * and invalidating it: the invalidate covers whole lines, and would
+ * otherwise drop dirty bytes that lie outside of the range.
+ */
+int hb_mc_manycore_vcache_flush_npa_range_edges(hb_mc_manycore_t *mc,
+                                                const hb_mc_npa_t *npa,
+                                                size_t sz)
+{
+        if (!hb_mc_manycore_has_cache(mc) || sz == 0)
+                return HB_MC_SUCCESS;
+
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        hb_mc_epa_t bsize = hb_mc_config_get_vcache_block_size(cfg);
+        hb_mc_epa_t epa = hb_mc_npa_get_epa(npa);
+        hb_mc_epa_t end = epa + sz;
+        hb_mc_epa_t head = epa & ~(bsize - 1);
+        hb_mc_epa_t tail = (end - 1) & ~(bsize - 1);
+        hb_mc_npa_t line_npa = *npa;
+        int flushed = 0, err;
+
+        if (epa & (bsize - 1)) {
+                hb_mc_npa_set_epa(&line_npa, head);
+                err = hb_mc_manycore_vcache_apply_to_npa(mc, &line_npa, HB_MC_PACKET_CACHE_OP_AFL);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+                flushed = 1;
+        }
+
+        if ((end & (bsize - 1)) && !(flushed && tail == head)) {
+                hb_mc_npa_set_epa(&line_npa, tail);
+                err = hb_mc_manycore_vcache_apply_to_npa(mc, &line_npa, HB_MC_PACKET_CACHE_OP_AFL);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+                flushed = 1;
+        }
+
+        if (!flushed)
+                return HB_MC_SUCCESS;
+
+        // read a single word from cache - when it completes, assume flush is done
+        uint32_t dummy;
+        return hb_mc_manycore_read32(mc, &line_npa, &dummy);
+}
+
 int hb_mc_manycore_vcache_flush_tag(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa)
 {
 
@@ -554,8 +1149,18 @@ int hb_mc_manycore_vcache_flush_tag(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa
         return hb_mc_manycore_request_tx(mc, &pkt, -1);
 }
 
-template <typename ApplyFunction>
-static int hb_mc_manycore_apply_to_vcache(hb_mc_manycore_t *mc, ApplyFunction apply_function)
+/**
+ * Apply an operation to every tag of every victim cache as one packet stream.
+ * @param[in]  mc              A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  format_function Formats the request packet for a way's tag address
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ *
+ * The whole stream is built before anything is sent. Caches are the innermost
+ * loop so that consecutive packets go to different caches, which then work
+ * in parallel. The stream completes with a single host request fence.
+ */
+template <typename FormatFunction>
+static int hb_mc_manycore_apply_to_vcache(hb_mc_manycore_t *mc, FormatFunction format_function)
 {
         if (!hb_mc_manycore_has_cache(mc))
                 return HB_MC_SUCCESS;
@@ -563,21 +1168,57 @@ static int hb_mc_manycore_apply_to_vcache(hb_mc_manycore_t *mc, ApplyFunction ap
         hb_mc_epa_t ways = hb_mc_vcache_num_ways(mc);
         hb_mc_epa_t sets = hb_mc_vcache_num_sets(mc);
         hb_mc_epa_t caches = hb_mc_vcache_num_caches(mc);
-        int err;
+        std::vector<hb_mc_request_packet_t> pkts(static_cast<size_t>(ways) * sets * caches);
+        int err = HB_MC_SUCCESS;
 
+        size_t i = 0;
         for (hb_mc_epa_t way_id = 0; way_id < ways; way_id++) {
                 for (hb_mc_epa_t set_id = 0; set_id < sets; set_id++) {
                         for (hb_mc_epa_t cache_id = 0; cache_id < caches; cache_id++) {
                                 // build the address for the way
                                 hb_mc_npa_t way_addr = hb_mc_vcache_way_npa(mc, cache_id, set_id, way_id);
-                                // apply
-                                err = apply_function(mc, &way_addr);
+                                // format
+                                err = format_function(mc, &pkts[i++], &way_addr);
                                 if (err != HB_MC_SUCCESS)
                                         return err;
                         }
                 }
         }
 
+        hb_mc_platform_start_bulk_transfer(mc);
+
+        for (i = 0; i < pkts.size(); i++) {
+                err = hb_mc_manycore_request_tx(mc, &pkts[i], -1);
+                if (err != HB_MC_SUCCESS)
+                        break;
+        }
+
+        if (err == HB_MC_SUCCESS)
+                err = hb_mc_manycore_host_request_fence(mc, -1);
+
+        hb_mc_platform_finish_bulk_transfer(mc);
+        return err;
+}
+
+/**
+ * Format a store of a tag value to a way's tag address.
+ * @param[in]  mc        A manycore instance initialized with hb_mc_manycore_init()
+ * @param[out] pkt       The request packet to format
+ * @param[in]  way_addr  The way's tag address
+ * @param[in]  tag       The tag value to store
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+static int hb_mc_manycore_format_vcache_tag_store(hb_mc_manycore_t *mc,
+                                                  hb_mc_request_packet_t *pkt,
+                                                  const hb_mc_npa_t *way_addr,
+                                                  uint32_t tag)
+{
+        int err = hb_mc_manycore_format_store_request_packet(mc, pkt, way_addr);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        hb_mc_request_packet_set_data(pkt, tag);
+        hb_mc_request_packet_set_mask(pkt, HB_MC_PACKET_REQUEST_MASK_WORD);
         return HB_MC_SUCCESS;
 }
 
@@ -587,13 +1228,10 @@ static int hb_mc_manycore_apply_to_vcache(hb_mc_manycore_t *mc, ApplyFunction ap
  */
 int hb_mc_manycore_invalidate_vcache(hb_mc_manycore_t *mc)
 {
-        return hb_mc_manycore_apply_to_vcache(mc, [](hb_mc_manycore_t *mc, const hb_mc_npa_t *way_addr) {
+        return hb_mc_manycore_apply_to_vcache(mc, [](hb_mc_manycore_t *mc, hb_mc_request_packet_t *pkt,
+                                                     const hb_mc_npa_t *way_addr) {
                         // write way_id (no valid bit)
-                        char npa_str [256];
-                        manycore_pr_dbg(mc, "Invalidating vcache tag @ %s\n",
-                                        hb_mc_npa_to_string(way_addr, npa_str, sizeof(npa_str)));
-
-                        return hb_mc_manycore_write32(mc, way_addr, 0);
+                        return hb_mc_manycore_format_vcache_tag_store(mc, pkt, way_addr, 0);
                 });
 }
 
@@ -604,14 +1242,11 @@ int hb_mc_manycore_invalidate_vcache(hb_mc_manycore_t *mc)
  */
 int hb_mc_manycore_validate_vcache(hb_mc_manycore_t *mc)
 {
-        return hb_mc_manycore_apply_to_vcache(mc, [](hb_mc_manycore_t *mc, const hb_mc_npa_t *way_addr) {
-                        char npa_str[256];
-                        uint32_t tag = HB_MC_VCACHE_VALID | hb_mc_vcache_way(mc, hb_mc_npa_get_epa(way_addr));
-                        manycore_pr_dbg(mc, "Validating vcache tag @ %s with tag = 0x%08" PRIx32 "\n",
-                                        hb_mc_npa_to_string(way_addr, npa_str, sizeof(npa_str)), tag);
-
+        return hb_mc_manycore_apply_to_vcache(mc, [](hb_mc_manycore_t *mc, hb_mc_request_packet_t *pkt,
+                                                     const hb_mc_npa_t *way_addr) {
                         // write the way_id or'd with the valid bit
-                        return hb_mc_manycore_write32(mc, way_addr, tag);
+                        uint32_t tag = HB_MC_VCACHE_VALID | hb_mc_vcache_way(mc, hb_mc_npa_get_epa(way_addr));
+                        return hb_mc_manycore_format_vcache_tag_store(mc, pkt, way_addr, tag);
                 });
 }
 
@@ -624,18 +1259,17 @@ int hb_mc_manycore_flush_vcache(hb_mc_manycore_t *mc)
         if (!hb_mc_manycore_has_cache(mc))
                 return HB_MC_SUCCESS;
 
-        int err = hb_mc_manycore_apply_to_vcache(mc, [](hb_mc_manycore_t *mc, const hb_mc_npa_t *way_addr) {
+        int err = hb_mc_manycore_apply_to_vcache(mc, [](hb_mc_manycore_t *mc, hb_mc_request_packet_t *pkt,
+                                                        const hb_mc_npa_t *way_addr) {
                         // flush tag
-                        char npa_str[256];
-                        manycore_pr_dbg(mc, "Flushing vcach tag @ %s\n",
-                                        hb_mc_npa_to_string(way_addr, npa_str, sizeof(npa_str)));
-                        return hb_mc_manycore_vcache_flush_tag(mc, way_addr);
+                        return hb_mc_manycore_format_cache_op_request_packet(mc, pkt, way_addr,
+                                                                             HB_MC_PACKET_CACHE_OP_TAGFL);
                 });
 
         if (err != HB_MC_SUCCESS)
                 return err;
 
-        // read a word from each cache
+        // read a word from each cache: it is served after that cache's flushes
         for (hb_mc_epa_t cache_id = 0; cache_id < hb_mc_vcache_num_caches(mc); cache_id++) {
                 hb_mc_npa_t way_addr = hb_mc_vcache_way_npa(mc, cache_id, 0, 0);
                 hb_mc_npa_set_epa(&way_addr, 0);
@@ -743,10 +1377,60 @@ static int hb_mc_manycore_send_read_rqst(hb_mc_manycore_t *mc,
         return HB_MC_SUCCESS;
 }
 
-/* read a response packet for a read request to an npa */
-static int hb_mc_manycore_recv_read_rsp(hb_mc_manycore_t *mc,
-                                        uint32_t *vp,
-                                        uint32_t *id = nullptr)
+/* send an atomic request and don't wait for the return packet */
+static int hb_mc_manycore_send_amo_rqst(hb_mc_manycore_t *mc,
+                                        const hb_mc_npa_t *npa,
+                                        hb_mc_packet_amo_t amo,
+                                        uint32_t operand,
+                                        uint32_t id)
+{
+        hb_mc_packet_t rqst;
+        int err;
+
+        err = hb_mc_platform_check_amo(mc);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        err = hb_mc_manycore_format_amo_request_packet(mc, &rqst.request, npa, amo, operand);
+        if (err != HB_MC_SUCCESS) {
+                manycore_pr_err(mc, "%s: Failed to format atomic request packet: %s\n",
+                                __func__, hb_mc_strerror(err));
+                return err;
+        }
+
+        // atomics operate on whole words
+        hb_mc_epa_t epa = hb_mc_npa_get_epa(npa);
+        err = hb_mc_manycore_epa_check_alignment(&epa, sizeof(uint32_t));
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        // the old value comes back as a load response with this id
+        hb_mc_request_packet_set_load_id(&rqst.request, id);
+
+        manycore_pr_dbg(mc, "Sending atomic %d request to NPA "
+                        "(x: %d, y: %d, 0x%08" PRIx32 ")\n",
+                        amo,
+                        hb_mc_npa_get_x(npa),
+                        hb_mc_npa_get_y(npa),
+                        hb_mc_npa_get_epa(npa));
+
+        err = hb_mc_manycore_request_tx(mc, &rqst.request, -1);
+        if (err == HB_MC_BUSY)
+                return err; // omit the error message if just busy
+
+        if (err != HB_MC_SUCCESS) {
+                manycore_pr_err(mc, "%s: Failed to send request packet: %s\n",
+                                __func__, hb_mc_strerror(err));
+                return err;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/* read a response packet for a read request to an npa */
+static int hb_mc_manycore_recv_read_rsp(hb_mc_manycore_t *mc,
+                                        uint32_t *vp,
+                                        uint32_t *id = nullptr)
 {
         hb_mc_packet_t rsp;
         int err;
@@ -768,55 +1452,354 @@ static int hb_mc_manycore_recv_read_rsp(hb_mc_manycore_t *mc,
         return HB_MC_SUCCESS;
 }
 
-template<typename UINT>
-static UINT hb_mc_manycore_mask_load_data(const hb_mc_npa_t *npa, uint32_t load_data)
+/* extract the bytes of a load response that were requested */
+static uint32_t hb_mc_manycore_mask_load_data(hb_mc_epa_t epa, size_t sz, uint32_t load_data)
+{
+        int shift = CHAR_BIT * (epa & 0x3);
+
+        switch (sz) {
+        case 2:
+                return (load_data >> shift) & 0xFFFF;
+        case 1:
+                return (load_data >> shift) & 0xFF;
+        default:
+                return load_data;
+        }
+}
+
+/* receive one read response and hold its data in its load's slot */
+static int hb_mc_manycore_recv_load(hb_mc_manycore_t *mc)
 {
-        int shift = CHAR_BIT * (hb_mc_npa_get_epa(npa) & 0x3);
-        uint32_t result;
+        hb_mc_manycore_loads_t *loads = hb_mc_manycore_get_loads(mc);
+        uint32_t read_data, load_id;
+        int err;
 
-        /* make sure this template is being used only as intended */
-        static_assert(std::is_unsigned<UINT>::value,
-                      "hb_mc_manycore_mask_load_data: UINT must be uint8_t, uint16_t, or uint32_t");
+        err = hb_mc_manycore_recv_read_rsp(mc, &read_data, &load_id);
+        if (err != HB_MC_SUCCESS)
+                return err;
 
-        static_assert(std::is_integral<UINT>::value,
-                      "hb_mc_manycore_mask_load_data: UINT must be uint8_t, uint16_t, or uint32_t");
+        manycore_pr_dbg(mc, "%s: Received response for load_id = %" PRIu32 "\n",
+                        __func__, load_id);
 
-        static_assert(sizeof(UINT) == 1 || sizeof(UINT) == 2 || sizeof(UINT) == 4,
-                      "hb_mc_manycore_mask_load_data: UINT must be uint8_t, uint16_t, or uint32_t");
+        // this should never happen unless something is messed up in hardware
+        if (load_id >= loads->slots.size() ||
+            loads->slots[load_id].state != hb_mc_manycore_load_t::PENDING) {
+                manycore_pr_err(mc, "%s: Bad load id = %" PRIu32 "\n",
+                                __func__, load_id);
+                return HB_MC_FAIL;
+        }
 
-        if (sizeof(UINT) == 4) {
-                result = load_data;
-        } else if (sizeof(UINT) == 2) {
-                result = (load_data >> shift) & 0xFFFF;
-        } else if (sizeof(UINT) == 1) {
-                result = (load_data >> shift) & 0xFF;
+        hb_mc_manycore_load_t &load = loads->slots[load_id];
+        load.data = hb_mc_manycore_mask_load_data(load.epa, load.sz, read_data);
+        load.state = hb_mc_manycore_load_t::DONE;
+        loads->pending--;
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Take a load ID from the pool and send a request that will be answered under it
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  npa    The NPA the request targets
+ * @param[in]  sz     The number of response bytes to keep: 1, 2, or 4
+ * @param[out] token  A handle to wait on with hb_mc_manycore_read_wait_any/all()
+ * @param[in]  send   Sends the request tagged with a load ID; returns HB_MC_BUSY if backed up
+ * @return HB_MC_SUCCESS on success. HB_MC_BUSY if no load ID is free.
+ */
+template <typename SendFunction>
+static int hb_mc_manycore_issue_load(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, size_t sz,
+                                     hb_mc_read_token_t *token, SendFunction send)
+{
+        hb_mc_manycore_loads_t *loads = hb_mc_manycore_get_loads(mc);
+        int err;
+
+        if (loads->free_ids.empty())
+                return HB_MC_BUSY;
+
+        uint32_t load_id = loads->free_ids.back();
+
+        /* if the request path is backed up, make room by taking in responses */
+        while ((err = send(load_id)) == HB_MC_BUSY) {
+                if (loads->pending == 0)
+                        return err;
+
+                err = hb_mc_manycore_recv_load(mc);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+        }
+
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        loads->free_ids.pop_back();
+        loads->slots[load_id].state = hb_mc_manycore_load_t::PENDING;
+        loads->slots[load_id].epa = hb_mc_npa_get_epa(npa);
+        loads->slots[load_id].sz = sz;
+        loads->pending++;
+
+        *token = load_id;
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Start reading from manycore hardware at a given NPA without waiting for the result
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  npa    A valid hb_mc_npa_t aligned to #sz
+ * @param[in]  sz     The number of bytes to read: 1, 2, or 4
+ * @param[out] token  A handle to wait on with hb_mc_manycore_read_wait_any/all()
+ * @return HB_MC_SUCCESS on success. HB_MC_BUSY if every load ID is held by a read
+ * that has not been waited on. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_read_async(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, size_t sz,
+                              hb_mc_read_token_t *token)
+{
+        return hb_mc_manycore_issue_load(mc, npa, sz, token,
+                                         [=](uint32_t load_id) {
+                                                 return hb_mc_manycore_send_read_rqst(mc, npa, sz, load_id);
+                                         });
+}
+
+/**
+ * Wait for any one of a set of outstanding reads to complete
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  tokens A list of tokens returned by hb_mc_manycore_read_async()
+ * @param[in]  n      The number of tokens in #tokens
+ * @param[out] idx    Set to the index in #tokens of the read that completed
+ * @param[out] data   Set to the data read, zero extended
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_read_wait_any(hb_mc_manycore_t *mc, const hb_mc_read_token_t *tokens, size_t n,
+                                 size_t *idx, uint32_t *data)
+{
+        hb_mc_manycore_loads_t *loads = hb_mc_manycore_get_loads(mc);
+        int err;
+
+        if (n == 0)
+                return HB_MC_INVALID;
+
+        for (size_t i = 0; i < n; i++) {
+                if (tokens[i] >= loads->slots.size() ||
+                    loads->slots[tokens[i]].state == hb_mc_manycore_load_t::FREE) {
+                        manycore_pr_err(mc, "%s: Token %" PRIu32 " is not an outstanding read\n",
+                                        __func__, tokens[i]);
+                        return HB_MC_INVALID;
+                }
+        }
+
+        for (;;) {
+                for (size_t i = 0; i < n; i++) {
+                        hb_mc_manycore_load_t &load = loads->slots[tokens[i]];
+                        if (load.state != hb_mc_manycore_load_t::DONE)
+                                continue;
+
+                        *idx = i;
+                        *data = load.data;
+
+                        // return the load id to the pool
+                        load.state = hb_mc_manycore_load_t::FREE;
+                        loads->free_ids.push_back(tokens[i]);
+                        return HB_MC_SUCCESS;
+                }
+
+                err = hb_mc_manycore_recv_load(mc);
+                if (err != HB_MC_SUCCESS) {
+                        manycore_pr_err(mc, "%s: Failed to receive read response: %s\n",
+                                        __func__, hb_mc_strerror(err));
+                        return err;
+                }
+        }
+}
+
+/**
+ * Wait for all of a set of outstanding reads to complete
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  tokens A list of tokens returned by hb_mc_manycore_read_async()
+ * @param[in]  n      The number of tokens in #tokens
+ * @param[out] data   An array of #n words; data[i] is set to the data read for tokens[i]
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_read_wait_all(hb_mc_manycore_t *mc, const hb_mc_read_token_t *tokens, size_t n,
+                                 uint32_t *data)
+{
+        for (size_t i = 0; i < n; i++) {
+                size_t idx;
+                int err = hb_mc_manycore_read_wait_any(mc, &tokens[i], 1, &idx, &data[i]);
+                if (err != HB_MC_SUCCESS)
+                        return err;
         }
 
-        return static_cast<UINT>(result);
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Give up on a set of outstanding reads, returning their load IDs to the pool
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  tokens A list of tokens returned by hb_mc_manycore_read_async()
+ * @param[in]  n      The number of tokens in #tokens
+ *
+ * Responses are drained first, so that an ID is not reused while its
+ * response is still in flight. If draining fails the IDs are released
+ * anyway: the host can no longer tell which responses will arrive.
+ */
+static void hb_mc_manycore_read_abandon(hb_mc_manycore_t *mc, const hb_mc_read_token_t *tokens, size_t n)
+{
+        hb_mc_manycore_loads_t *loads = hb_mc_manycore_get_loads(mc);
+
+        for (size_t i = 0; i < n; i++) {
+                size_t idx;
+                uint32_t data;
+                if (hb_mc_manycore_read_wait_any(mc, &tokens[i], 1, &idx, &data) == HB_MC_SUCCESS)
+                        continue;
+
+                manycore_pr_err(mc, "%s: Failed to drain read responses; releasing %zu load ids\n",
+                                __func__, n - i);
+
+                for (; i < n; i++) {
+                        hb_mc_manycore_load_t &load = loads->slots[tokens[i]];
+                        if (load.state == hb_mc_manycore_load_t::PENDING)
+                                loads->pending--;
+                        load.state = hb_mc_manycore_load_t::FREE;
+                        loads->free_ids.push_back(tokens[i]);
+                }
+                return;
+        }
 }
 
 /* read from a memory address on the manycore */
 template <typename UINT>
 static int hb_mc_manycore_read(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, UINT *vp)
 {
+        hb_mc_manycore_loads_t *loads = hb_mc_manycore_get_loads(mc);
+        hb_mc_read_token_t token;
         int err;
 
         /* send load request */
-        err = hb_mc_manycore_send_read_rqst(mc, npa, sizeof(UINT));
+        while ((err = hb_mc_manycore_read_async(mc, npa, sizeof(UINT), &token)) == HB_MC_BUSY) {
+                // every load id is held by a read no one has waited on yet
+                if (loads->free_ids.empty()) {
+                        manycore_pr_err(mc, "%s: No load ids available\n", __func__);
+                        return err;
+                }
+        }
+
         if (err != HB_MC_SUCCESS)
                 return err;
 
         /* read back response */
         uint32_t load_data;
-        err = hb_mc_manycore_recv_read_rsp(mc, &load_data);
+        err = hb_mc_manycore_read_wait_all(mc, &token, 1, &load_data);
         if (err != HB_MC_SUCCESS)
                 return err;
 
-        /* mask off unused bits */
-        *vp = hb_mc_manycore_mask_load_data<UINT>(npa, load_data);
+        *vp = static_cast<UINT>(load_data);
         return HB_MC_SUCCESS;
 }
 
+/**
+ * Apply an atomic memory operation to a word of manycore memory
+ * @param[in]  mc      A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  npa     A valid hb_mc_npa_t aligned to a word
+ * @param[in]  amo     The atomic operation to apply
+ * @param[in]  operand The operand of #amo
+ * @param[out] old     Set to the value of the word before #amo was applied. May be NULL.
+ * @return HB_MC_SUCCESS on success. HB_MC_NOIMPL if the platform cannot send atomic requests.
+ * Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_amo(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa,
+                       hb_mc_packet_amo_t amo, uint32_t operand, uint32_t *old)
+{
+        hb_mc_manycore_loads_t *loads = hb_mc_manycore_get_loads(mc);
+        hb_mc_read_token_t token;
+        int err;
+
+        /* fail before taking a load id if atomics cannot be sent */
+        err = hb_mc_platform_check_amo(mc);
+        if (err != HB_MC_SUCCESS) {
+                manycore_pr_err(mc, "%s: Atomic operations are not supported on this platform\n",
+                                __func__);
+                return err;
+        }
+
+        /* send atomic request; the old value is returned like a load */
+        while ((err = hb_mc_manycore_issue_load(mc, npa, sizeof(uint32_t), &token,
+                                                [=](uint32_t load_id) {
+                                                        return hb_mc_manycore_send_amo_rqst(mc, npa, amo,
+                                                                                            operand, load_id);
+                                                })) == HB_MC_BUSY) {
+                // every load id is held by a read no one has waited on yet
+                if (loads->free_ids.empty()) {
+                        manycore_pr_err(mc, "%s: No load ids available\n", __func__);
+                        return err;
+                }
+        }
+
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        /* read back response */
+        uint32_t old_data;
+        err = hb_mc_manycore_read_wait_all(mc, &token, 1, &old_data);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        if (old != nullptr)
+                *old = old_data;
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Atomically add to a word of manycore memory
+ * @param[in]  mc      A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  npa     A valid hb_mc_npa_t aligned to a word
+ * @param[in]  v       The value to add
+ * @param[out] old     Set to the value of the word before the add. May be NULL.
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_amo_add(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, uint32_t v, uint32_t *old)
+{
+        return hb_mc_manycore_amo(mc, npa, HB_MC_PACKET_AMO_ADD, v, old);
+}
+
+/**
+ * Atomically swap a word of manycore memory
+ * @param[in]  mc      A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  npa     A valid hb_mc_npa_t aligned to a word
+ * @param[in]  v       The value to store
+ * @param[out] old     Set to the value of the word before the swap. May be NULL.
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_amo_swap(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, uint32_t v, uint32_t *old)
+{
+        return hb_mc_manycore_amo(mc, npa, HB_MC_PACKET_AMO_SWAP, v, old);
+}
+
+/**
+ * Atomically or a value into a word of manycore memory
+ * @param[in]  mc      A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  npa     A valid hb_mc_npa_t aligned to a word
+ * @param[in]  v       The value to or in
+ * @param[out] old     Set to the value of the word before the or. May be NULL.
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_amo_or(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, uint32_t v, uint32_t *old)
+{
+        return hb_mc_manycore_amo(mc, npa, HB_MC_PACKET_AMO_OR, v, old);
+}
+
+/**
+ * Atomically and a value into a word of manycore memory
+ * @param[in]  mc      A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  npa     A valid hb_mc_npa_t aligned to a word
+ * @param[in]  v       The value to and in
+ * @param[out] old     Set to the value of the word before the and. May be NULL.
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_amo_and(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, uint32_t v, uint32_t *old)
+{
+        return hb_mc_manycore_amo(mc, npa, HB_MC_PACKET_AMO_AND, v, old);
+}
+
 /* write to a memory address on the manycore */
 static int hb_mc_manycore_write(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, const void *vp, size_t sz)
 {
@@ -869,6 +1852,58 @@ static int hb_mc_manycore_write(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, co
         return hb_mc_manycore_request_tx(mc, &rqst.request, -1);
 }
 
+/* number of store packets encoded at once by hb_mc_manycore_write_words */
+#define HB_MC_MANYCORE_WRITE_BATCH 64
+
+/* send word stores to consecutive words starting at an NPA, without a fence */
+static int hb_mc_manycore_write_words(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa,
+                                      const uint32_t *words, size_t n_words,
+                                      bool repeat)
+{
+        hb_mc_packet_t pkts[HB_MC_MANYCORE_WRITE_BATCH] __attribute__((aligned(16)));
+        hb_mc_coordinate_t host = hb_mc_manycore_get_host_coordinate(mc);
+        hb_mc_npa_t addr = *npa;
+        int err;
+
+        /* all packets go to one tile: validate it once */
+        if (!hb_mc_manycore_dst_npa_is_valid(mc, npa))
+                return HB_MC_INVALID;
+
+        if (hb_mc_npa_get_epa(npa) & 0x3)
+                return HB_MC_UNALIGNED;
+
+        while (n_words > 0) {
+                size_t n = std::min(n_words, static_cast<size_t>(HB_MC_MANYCORE_WRITE_BATCH));
+
+                err = hb_mc_request_packet_batch_encode(pkts, host, &addr, sizeof(uint32_t),
+                                                        words, n,
+                                                        HB_MC_PACKET_OP_REMOTE_STORE,
+                                                        HB_MC_PACKET_REQUEST_MASK_WORD);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+
+                manycore_pr_dbg(mc, "Sending %zu write requests to NPA "
+                                "(x: %d, y: %d, 0x%08" PRIx32 ")\n",
+                                n,
+                                hb_mc_npa_get_x(&addr),
+                                hb_mc_npa_get_y(&addr),
+                                hb_mc_npa_get_epa(&addr));
+
+                for (size_t i = 0; i < n; i++) {
+                        err = hb_mc_manycore_request_tx(mc, &pkts[i].request, -1);
+                        if (err != HB_MC_SUCCESS)
+                                return err;
+                }
+
+                if (!repeat)
+                        words += n;
+                n_words -= n;
+                hb_mc_npa_set_epa(&addr, hb_mc_npa_get_epa(&addr) + n * sizeof(uint32_t));
+        }
+
+        return HB_MC_SUCCESS;
+}
+
 /* checks that the arguments of read/write_mem are supported */
 static int hb_mc_manycore_read_write_mem_check_args(hb_mc_manycore_t *mc,
                                                     const char *caller_name,
@@ -913,23 +1948,17 @@ int hb_mc_manycore_write_mem(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa,
 
         const uint32_t *words = (const uint32_t*)data;
         size_t n_words = sz >> 2;
-        hb_mc_npa_t addr = *npa;
-
-        /* send store requests one word at a time */
-        for (size_t i = 0; i < n_words; i++) {
-
-                err = hb_mc_manycore_write(mc, &addr, &words[i], 4);
-                if (err != HB_MC_SUCCESS) {
-                        manycore_pr_err(mc, "%s: Failed to send write request: %s\n",
-                                        __func__, hb_mc_strerror(err));
-                        return err;
-                }
 
-                // Increment EPA by 4:
-                hb_mc_npa_set_epa(&addr, hb_mc_npa_get_epa(&addr) + 4);
+        /* send store requests in encoded batches */
+        err = hb_mc_manycore_write_words(mc, npa, words, n_words, false);
+        if (err != HB_MC_SUCCESS) {
+                manycore_pr_err(mc, "%s: Failed to send write request: %s\n",
+                                __func__, hb_mc_strerror(err));
+                return err;
         }
 
-        err = hb_mc_manycore_host_request_fence(mc, -1);
+        hb_mc_coordinate_t dst = hb_mc_npa_get_xy(npa);
+        err = hb_mc_manycore_host_request_fence_dsts(mc, &dst, 1, -1);
         if (err != HB_MC_SUCCESS)
                 return err;
 
@@ -956,25 +1985,21 @@ int hb_mc_manycore_memset(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa,
 
         const uint32_t word = (val << 24) | (val << 16) | (val << 8) | val;
         size_t n_words = sz >> 2;
-        hb_mc_npa_t addr = *npa;
+        uint32_t words[HB_MC_MANYCORE_WRITE_BATCH];
+        std::fill(words, words + HB_MC_MANYCORE_WRITE_BATCH, word);
 
         hb_mc_platform_start_bulk_transfer(mc);
 
-        /* send store requests one word at a time */
-        for (size_t i = 0; i < n_words; i++) {
-
-                err = hb_mc_manycore_write(mc, &addr, &word, 4);
-                if (err != HB_MC_SUCCESS) {
-                        manycore_pr_err(mc, "%s: Failed to send write request: %s\n",
-                                        __func__, hb_mc_strerror(err));
-                        return err;
-                }
-
-                // increment EPA by 1: (EPA's address words)
-                hb_mc_npa_set_epa(&addr, hb_mc_npa_get_epa(&addr) + sizeof(uint32_t));
+        /* send store requests in encoded batches */
+        err = hb_mc_manycore_write_words(mc, npa, words, n_words, true);
+        if (err != HB_MC_SUCCESS) {
+                manycore_pr_err(mc, "%s: Failed to send write request: %s\n",
+                                __func__, hb_mc_strerror(err));
+                return err;
         }
 
-        err = hb_mc_manycore_host_request_fence(mc, -1);
+        hb_mc_coordinate_t dst = hb_mc_npa_get_xy(npa);
+        err = hb_mc_manycore_host_request_fence_dsts(mc, &dst, 1, -1);
         if (err != HB_MC_SUCCESS)
                 return err;
 
@@ -1004,24 +2029,17 @@ static int hb_mc_manycore_read_mem_internal(hb_mc_manycore_t *mc,
                                             NPA_OF_I_FUNCTION npa,
                                             UINTV & data, size_t cnt)
 {
-        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        hb_mc_manycore_loads_t *loads = hb_mc_manycore_get_loads(mc);
         size_t rsp_i = 0, rqst_i = 0;
-        uint32_t occupancy;
-        unsigned n_ids;
-        int err;
-
-        /* cap the number of load ids to the maximum number of pending requests */
-        n_ids = hb_mc_config_get_io_remote_load_cap(cfg);
+        int err = HB_MC_SUCCESS;
 
         hb_mc_platform_start_bulk_transfer(mc);
 
-        /* track requests and responses with ids and id_to_rsp_i */
-        std::stack <uint32_t, std::vector<uint32_t> > ids;
-        for (int i = n_ids - 1; i >= 0; i--)
-                ids.push(static_cast<uint32_t>(i));
-
-        int id_to_rsp_i [n_ids];
-        hb_mc_npa_t id_to_npa[n_ids];
+        /* track our outstanding reads and the index each one fills */
+        std::vector<hb_mc_read_token_t> tokens;
+        std::vector<size_t> token_to_rsp_i;
+        tokens.reserve(loads->slots.size());
+        token_to_rsp_i.reserve(loads->slots.size());
 
         /* until we've received all responses... */
         while (rsp_i < cnt) {
@@ -1030,70 +2048,59 @@ static int hb_mc_manycore_read_mem_internal(hb_mc_manycore_t *mc,
                 while (rqst_i < cnt) {
                         // get the NPA of the next load address
                         hb_mc_npa_t rqst_addr = npa(rqst_i);
-
-                        // if we're out of load ids, break to start reading requests
-                        if (ids.empty())
-                                break;
-
-                        // get an available load id for this load request
-                        uint32_t rqst_load_id = ids.top();
-
-                        // save which request this is
-                        id_to_rsp_i[rqst_load_id] = rqst_i;
-                        id_to_npa[rqst_load_id] = rqst_addr;
+                        hb_mc_read_token_t token;
 
                         // send a load request
-                        err = hb_mc_manycore_send_read_rqst(mc, &rqst_addr, sizeof(UINT),
-                                                            rqst_load_id);
+                        err = hb_mc_manycore_read_async(mc, &rqst_addr, sizeof(UINT), &token);
                         if (err == HB_MC_SUCCESS) {
-                                // success; increment succesful requests and pop the load id
-                                rqst_i++;
-                                ids.pop();
+                                // success; save which request this is
+                                tokens.push_back(token);
+                                token_to_rsp_i.push_back(rqst_i++);
                         } else if (err == HB_MC_BUSY) {
-                                // if we're busy, break to start reading requests
+                                // if we're busy or out of load ids, break to start reading responses
                                 break;
                         } else {
                                 // we've hit some other error: abort with an error message
                                 manycore_pr_err(mc, "%s: Failed to send read request: %s\n",
                                                 __func__, hb_mc_strerror(err));
-                                return err;
+                                goto done;
                         }
                 }
 
-                /* read all available response packets */
-                while (rsp_i < rqst_i) {
-                        /* read a response and write it back to the location marked by load_id */
-                        uint32_t read_data, load_id;
-                        err = hb_mc_manycore_recv_read_rsp(mc, &read_data, &load_id);
-                        if (err != HB_MC_SUCCESS) {
-                                manycore_pr_err(mc, "%s: Failed to receive read response: %s\n",
-                                                __func__, hb_mc_strerror(err));
-                                return err;
+                if (tokens.empty()) {
+                        // every load id is held by a read no one has waited on yet
+                        if (loads->free_ids.empty()) {
+                                manycore_pr_err(mc, "%s: No load ids available\n", __func__);
+                                err = HB_MC_BUSY;
+                                goto done;
                         }
+                        continue;
+                }
 
-                        manycore_pr_dbg(mc, "%s: Received response for load_id = %" PRIu32 "\n",
-                                        __func__, load_id);
+                /* read a response and write it back to the location of its request */
+                size_t k;
+                uint32_t read_data;
+                err = hb_mc_manycore_read_wait_any(mc, tokens.data(), tokens.size(), &k, &read_data);
+                if (err != HB_MC_SUCCESS)
+                        goto done;
 
-                        // this should never happen unless something is messed up in hardware
-                        if (load_id >= n_ids) {
-                                manycore_pr_err(mc, "%s: Bad load id = %" PRIu32 "\n",
-                                                __func__, load_id);
-                                return HB_MC_FAIL;
-                        }
+                data[token_to_rsp_i[k]] = static_cast<UINT>(read_data);
+                rsp_i++;
 
-                        // write 'read_data' back to the correct location
-                        data[id_to_rsp_i[load_id]] = hb_mc_manycore_mask_load_data<UINT>(&id_to_npa[load_id], read_data);
+                tokens[k] = tokens.back();
+                tokens.pop_back();
+                token_to_rsp_i[k] = token_to_rsp_i.back();
+                token_to_rsp_i.pop_back();
+        }
 
-                        // increment succesful responses
-                        rsp_i++;
+        err = HB_MC_SUCCESS;
+done:
+        // don't leak the load ids of reads still in flight
+        if (err != HB_MC_SUCCESS && !tokens.empty())
+                hb_mc_manycore_read_abandon(mc, tokens.data(), tokens.size());
 
-                        // push the load id onto the stack so we can use it again
-                        ids.push(load_id);
-                }
-        }
         hb_mc_platform_finish_bulk_transfer(mc);
-
-        return HB_MC_SUCCESS;
+        return err;
 }
 
 /**
@@ -1152,6 +2159,107 @@ int hb_mc_manycore_read_mem(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa,
         return hb_mc_manycore_read_mem_internal<uint32_t>(mc, npa_function(npa), words, n_words);
 }
 
+/**
+ * Write a list of host buffers out to manycore hardware
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  iov    A list of segments to write
+ * @param[in]  n      The number of segments in #iov
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_write_mem_vec(hb_mc_manycore_t *mc, const hb_mc_npa_iovec_t *iov, size_t n)
+{
+        int err;
+
+        for (size_t i = 0; i < n; i++) {
+                err = hb_mc_manycore_read_write_mem_check_args(mc, __func__, iov[i].data, iov[i].sz);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+        }
+
+        hb_mc_platform_start_bulk_transfer(mc);
+
+        /* send store requests for every segment, then fence once */
+        for (size_t i = 0; i < n; i++) {
+                err = hb_mc_manycore_write_words(mc, &iov[i].npa,
+                                                 static_cast<const uint32_t*>(iov[i].data),
+                                                 iov[i].sz >> 2, false);
+                if (err != HB_MC_SUCCESS) {
+                        manycore_pr_err(mc, "%s: Failed to send write request: %s\n",
+                                        __func__, hb_mc_strerror(err));
+                        hb_mc_platform_finish_bulk_transfer(mc);
+                        return err;
+                }
+        }
+
+        err = hb_mc_manycore_host_request_fence(mc, -1);
+
+        hb_mc_platform_finish_bulk_transfer(mc);
+        return err;
+}
+
+/**
+ * Read a list of manycore memory regions into host buffers
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  iov    A list of segments to read
+ * @param[in]  n      The number of segments in #iov
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_read_mem_vec(hb_mc_manycore_t *mc, const hb_mc_npa_iovec_t *iov, size_t n)
+{
+        int err;
+
+        /* first_word[s] is the index of the first word of segment s across all segments */
+        std::vector<size_t> first_word(n + 1, 0);
+        for (size_t s = 0; s < n; s++) {
+                err = hb_mc_manycore_read_write_mem_check_args(mc, __func__, iov[s].data, iov[s].sz);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+
+                first_word[s+1] = first_word[s] + (iov[s].sz >> 2);
+        }
+
+        /* find the segment holding the ith word */
+        struct segment_of {
+                const std::vector<size_t> &first_word;
+                segment_of(const std::vector<size_t> &first_word) : first_word(first_word) {}
+                size_t operator()(size_t i) const {
+                        return std::upper_bound(first_word.begin(), first_word.end(), i)
+                                - first_word.begin() - 1;
+                }
+        };
+
+        /* ith NPA => NPA of segment s + offset of word i in s */
+        struct npa_function {
+                const hb_mc_npa_iovec_t *iov;
+                segment_of seg;
+                npa_function(const hb_mc_npa_iovec_t *iov, segment_of seg) : iov(iov), seg(seg) {}
+                hb_mc_npa_t operator()(size_t i) {
+                        size_t s = seg(i);
+                        const hb_mc_npa_t *npa = &iov[s].npa;
+                        return hb_mc_npa_from_x_y(hb_mc_npa_get_x(npa),
+                                                  hb_mc_npa_get_y(npa),
+                                                  hb_mc_npa_get_epa(npa) +
+                                                  (i - seg.first_word[s]) * sizeof(uint32_t));
+                }
+        };
+
+        /* ith word => word of segment s's host buffer */
+        struct word_vector {
+                const hb_mc_npa_iovec_t *iov;
+                segment_of seg;
+                word_vector(const hb_mc_npa_iovec_t *iov, segment_of seg) : iov(iov), seg(seg) {}
+                uint32_t & operator[](size_t i) {
+                        size_t s = seg(i);
+                        return static_cast<uint32_t*>(iov[s].data)[i - seg.first_word[s]];
+                }
+        };
+
+        segment_of seg(first_word);
+        word_vector words(iov, seg);
+
+        return hb_mc_manycore_read_mem_internal<uint32_t>(mc, npa_function(iov, seg), words, first_word[n]);
+}
+
 /**
  * Read one byte from manycore hardware at a given NPA
  * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
@@ -1233,21 +2341,17 @@ int hb_mc_manycore_write32(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, uint32_
 int hb_mc_manycore_enable_dram(hb_mc_manycore_t *mc)
 {
         const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        hb_mc_coordinate_t origin = hb_mc_coordinate(hb_mc_config_get_vcore_base_x(cfg),
+                                                     hb_mc_config_get_vcore_base_y(cfg));
+        hb_mc_tile_csr_write_t w = { HB_MC_TILE_EPA_CSR_DRAM_ENABLE, 1 };
+
         /* for each tile */
-        hb_mc_idx_t
-                n_rows = hb_mc_dimension_get_y(hb_mc_config_get_dimension_vcore(cfg)),
-                n_cols = hb_mc_dimension_get_x(hb_mc_config_get_dimension_vcore(cfg));
-
-        for (hb_mc_idx_t row = 0; row < n_rows; row++) {
-                for (hb_mc_idx_t col = 0; col < n_cols; col++) {
-                        hb_mc_idx_t x = col + hb_mc_config_get_vcore_base_x(cfg);
-                        hb_mc_idx_t y = row + hb_mc_config_get_vcore_base_y(cfg);
-                        hb_mc_coordinate_t tile = hb_mc_coordinate(x,y);
-                        int err = hb_mc_tile_set_dram_enabled(mc, &tile);
-                        if (err != HB_MC_SUCCESS)
-                                return err;
-                }
-        }
+        int err = hb_mc_tile_rect_write_csrs(mc, &origin,
+                                             hb_mc_config_get_dimension_vcore(cfg),
+                                             &w, 1);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
         mc->dram_enabled = 1;
         return HB_MC_SUCCESS;
 }
@@ -1260,21 +2364,17 @@ int hb_mc_manycore_enable_dram(hb_mc_manycore_t *mc)
 int hb_mc_manycore_disable_dram(hb_mc_manycore_t *mc)
 {
         const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        hb_mc_coordinate_t origin = hb_mc_coordinate(hb_mc_config_get_vcore_base_x(cfg),
+                                                     hb_mc_config_get_vcore_base_y(cfg));
+        hb_mc_tile_csr_write_t w = { HB_MC_TILE_EPA_CSR_DRAM_ENABLE, 0 };
+
         /* for each tile */
-        hb_mc_idx_t
-                n_rows = hb_mc_dimension_get_y(hb_mc_config_get_dimension_vcore(cfg)),
-                n_cols = hb_mc_dimension_get_x(hb_mc_config_get_dimension_vcore(cfg));
-
-        for (hb_mc_idx_t row = 0; row < n_rows; row++) {
-                for (hb_mc_idx_t col = 0; col < n_cols; col++) {
-                        hb_mc_idx_t x = col + hb_mc_config_get_vcore_base_x(cfg);
-                        hb_mc_idx_t y = row + hb_mc_config_get_vcore_base_y(cfg);
-                        hb_mc_coordinate_t tile = hb_mc_coordinate(x,y);
-                        int err = hb_mc_tile_clear_dram_enabled(mc, &tile);
-                        if (err != HB_MC_SUCCESS)
-                                return err;
-                }
-        }
+        int err = hb_mc_tile_rect_write_csrs(mc, &origin,
+                                             hb_mc_config_get_dimension_vcore(cfg),
+                                             &w, 1);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
         mc->dram_enabled = 0;
         return HB_MC_SUCCESS;
 }
@@ -1344,6 +2444,11 @@ int hb_mc_manycore_dma_write(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa,
         if (!hb_mc_manycore_dram_is_enabled(mc))
                 return HB_MC_FAIL;
 
+        // the invalidate covers whole lines: write back dirty bytes around the range first
+        err = hb_mc_manycore_vcache_flush_npa_range_edges(mc, npa, sz);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
         err = hb_mc_manycore_dma_write_no_cache_ainv(mc, npa, data, sz);
         if (err != HB_MC_SUCCESS)
                 return err;
@@ -1417,6 +2522,188 @@ int hb_mc_manycore_dma_read_no_cache_afl(hb_mc_manycore_t *mc, const hb_mc_npa_t
         return hb_mc_dma_read(mc, npa, data, sz);
 }
 
+/**
+ * Get a host pointer to manycore DRAM starting at a given NPA - unsafe
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  npa    A valid hb_mc_npa_t (must map to DRAM)
+ * @param[in]  sz     The number of bytes that will be accessed through the pointer
+ * @param[out] ptr    Set to a host pointer to #npa
+ * @return HB_MC_SUCCESS on success. HB_MC_INVALID if the #sz bytes at #npa
+ * are not contiguous in host memory. Otherwise an error code defined in bsg_manycore_errno.h.
+ *
+ * On platforms whose DRAM lives in host memory (simulation) this gives
+ * zero-copy access to DRAM: loads and stores through #ptr read and write
+ * DRAM directly. Memory systems that permute addresses (DRAMSim3) keep
+ * only small granules of a bank together in host memory, so a range
+ * that crosses a granule cannot be mapped. Like hb_mc_manycore_dma_read_no_cache_afl() and
+ * hb_mc_manycore_dma_write_no_cache_ainv(), it does nothing about the
+ * caches: flush the range before reading data the manycore wrote, and
+ * invalidate it after writing data the manycore will read.
+ *
+ * This function is not supported on all HammerBlade platforms.
+ * Please check the return code for HB_MC_NOIMPL.
+ */
+int hb_mc_manycore_dma_map(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa,
+                           size_t sz, void **ptr)
+{
+        if (!hb_mc_manycore_supports_dma_read(mc) ||
+            !hb_mc_manycore_supports_dma_write(mc))
+                return HB_MC_NOIMPL;
+
+        if (!hb_mc_manycore_dram_is_enabled(mc))
+                return HB_MC_FAIL;
+
+        // is dram?
+        if (!hb_mc_manycore_npa_is_dram(mc, npa))
+                return HB_MC_INVALID;
+
+        return hb_mc_dma_map(mc, npa, sz, ptr);
+}
+
+/**
+ * Check that every segment of a DMA transfer lies in DRAM
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  segs   Segments of the transfer
+ * @param[in]  nsegs  The number of segments in #segs
+ * @return HB_MC_SUCCESS if all segments are DRAM. HB_MC_INVALID otherwise.
+ */
+static int hb_mc_manycore_dma_segments_check(hb_mc_manycore_t *mc,
+                                             const hb_mc_dma_segment_t *segs,
+                                             size_t nsegs)
+{
+        for (size_t i = 0; i < nsegs; i++) {
+                if (!hb_mc_manycore_npa_is_dram(mc, &segs[i].npa))
+                        return HB_MC_INVALID;
+        }
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Write a list of segments via DMA to manycore DRAM
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  segs   Segments to write; host is the source of each
+ * @param[in]  nsegs  The number of segments in #segs
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ *
+ * Like hb_mc_manycore_dma_write_segments_no_cache_ainv(), but any
+ * data in the cache that becomes stale is invalidated. When the
+ * segments cover more lines than the caches hold, the caches are
+ * flushed before the transfer and invalidated entirely after it.
+ *
+ * This function is not supported on all HammerBlade platforms.
+ * Please check the return code for HB_MC_NOIMPL.
+ */
+int hb_mc_manycore_dma_write_segments(hb_mc_manycore_t *mc,
+                                      const hb_mc_dma_segment_t *segs,
+                                      size_t nsegs)
+{
+        size_t lines = 0;
+        int err;
+
+        if (!hb_mc_manycore_supports_dma_write(mc))
+                return HB_MC_NOIMPL;
+
+        for (size_t i = 0; i < nsegs; i++)
+                lines += hb_mc_vcache_num_lines(mc, &segs[i].npa, segs[i].sz);
+
+        int whole_cache = hb_mc_vcache_whole_cache_is_cheaper(mc, lines);
+        if (whole_cache) {
+                err = hb_mc_manycore_flush_vcache(mc);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+        } else {
+                // the invalidates cover whole lines: write back dirty bytes around each segment first
+                for (size_t i = 0; i < nsegs; i++) {
+                        err = hb_mc_manycore_vcache_flush_npa_range_edges(mc, &segs[i].npa, segs[i].sz);
+                        if (err != HB_MC_SUCCESS)
+                                return err;
+                }
+        }
+
+        err = hb_mc_manycore_dma_write_segments_no_cache_ainv(mc, segs, nsegs);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        if (whole_cache)
+                return hb_mc_manycore_invalidate_vcache(mc);
+
+        if (!hb_mc_manycore_has_cache(mc))
+                return HB_MC_SUCCESS;
+
+        for (size_t i = 0; i < nsegs; i++) {
+                err = hb_mc_manycore_vcache_invalidate_npa_range(mc, &segs[i].npa, segs[i].sz);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+        }
+
+        // wait for the invalidates to land
+        return hb_mc_manycore_host_request_fence(mc, -1);
+}
+
+/**
+ * Write a list of segments via DMA to manycore DRAM - unsafe
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  segs   Segments to write; host is the source of each
+ * @param[in]  nsegs  The number of segments in #segs
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ *
+ * Equivalent to calling hb_mc_manycore_dma_write_no_cache_ainv()
+ * on each segment, but lets the platform plan the whole list at
+ * once: merge segments that are adjacent in DRAM and copy in
+ * parallel. Segments must not overlap.
+ *
+ * This function is not supported on all HammerBlade platforms.
+ * Please check the return code for HB_MC_NOIMPL.
+ */
+int hb_mc_manycore_dma_write_segments_no_cache_ainv(hb_mc_manycore_t *mc,
+                                                    const hb_mc_dma_segment_t *segs,
+                                                    size_t nsegs)
+{
+        int err;
+        if (!hb_mc_manycore_supports_dma_write(mc))
+                return HB_MC_NOIMPL;
+
+        if (!hb_mc_manycore_dram_is_enabled(mc))
+                return HB_MC_FAIL;
+
+        err = hb_mc_manycore_dma_segments_check(mc, segs, nsegs);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        return hb_mc_dma_write_segments(mc, segs, nsegs);
+}
+
+/**
+ * Read a list of segments via DMA from manycore DRAM - unsafe
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  segs   Segments to read; host is the destination of each
+ * @param[in]  nsegs  The number of segments in #segs
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ *
+ * Equivalent to calling hb_mc_manycore_dma_read_no_cache_afl()
+ * on each segment. See hb_mc_manycore_dma_write_segments_no_cache_ainv().
+ *
+ * This function is not supported on all HammerBlade platforms.
+ * Please check the return code for HB_MC_NOIMPL.
+ */
+int hb_mc_manycore_dma_read_segments_no_cache_afl(hb_mc_manycore_t *mc,
+                                                  const hb_mc_dma_segment_t *segs,
+                                                  size_t nsegs)
+{
+        int err;
+        if (!hb_mc_manycore_supports_dma_read(mc))
+                return HB_MC_NOIMPL;
+
+        if (!hb_mc_manycore_dram_is_enabled(mc))
+                return HB_MC_FAIL;
+
+        err = hb_mc_manycore_dma_segments_check(mc, segs, nsegs);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        return hb_mc_dma_read_segments(mc, segs, nsegs);
+}
+
 /**
  * Read memory via DMA from manycore DRAM starting at a given NPA
  * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
@@ -1501,3 +2788,56 @@ int hb_mc_manycore_log_enable(hb_mc_manycore_t *mc){
 int hb_mc_manycore_log_disable(hb_mc_manycore_t *mc){
         return hb_mc_platform_log_disable(mc);
 }
+
+/**
+ * Get the path of the DRAM contents that go with a checkpoint
+ * @param[in]  path  Path of a checkpoint file
+ * @return The path of the DRAM file
+ */
+static std::string hb_mc_manycore_checkpoint_dram_path(const char *path)
+{
+        return std::string(path) + ".dram";
+}
+
+/**
+ * Save the state of the manycore hardware to a checkpoint
+ * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in] path  Path of the checkpoint file to write
+ * @return HB_MC_SUCCESS on success. HB_MC_NOIMPL if the platform cannot take checkpoints.
+ *
+ * When DRAM is held in C++ models rather than in the hardware model, its
+ * contents are written to #path with a .dram suffix.
+ */
+int hb_mc_manycore_checkpoint_save(hb_mc_manycore_t *mc, const char *path){
+        int err = hb_mc_platform_checkpoint_save(mc, path);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        // The platform fenced before saving, so no request to DRAM is
+        // in flight and the backing store is consistent with the model
+        if (!hb_mc_manycore_supports_dma_write(mc))
+                return HB_MC_SUCCESS;
+
+        return hb_mc_dma_checkpoint_save(mc, hb_mc_manycore_checkpoint_dram_path(path).c_str());
+}
+
+/**
+ * Restore the state of the manycore hardware from a checkpoint
+ * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in] path  Path of a checkpoint file written by hb_mc_manycore_checkpoint_save()
+ * @return HB_MC_SUCCESS on success. HB_MC_NOIMPL if the platform cannot take checkpoints.
+ */
+int hb_mc_manycore_checkpoint_restore(hb_mc_manycore_t *mc, const char *path){
+        int err = hb_mc_platform_checkpoint_restore(mc, path);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        // The checkpoint was taken after a fence, and the requests sent
+        // since then were lost with the model they were sent to
+        hb_mc_manycore_reset_credits(mc);
+
+        if (!hb_mc_manycore_supports_dma_write(mc))
+                return HB_MC_SUCCESS;
+
+        return hb_mc_dma_checkpoint_restore(mc, hb_mc_manycore_checkpoint_dram_path(path).c_str());
+}
@@ -55,6 +55,8 @@ extern "C" {
                 hb_mc_config_t config; //!< configuration of the manycore
                 void *platform;        //!< machine-specific data pointer
                 int dram_enabled;      //!< operating in no-dram mode?
+                void *loads;           //!< load IDs of outstanding remote loads
+                void *credits;         //!< ledger of request credits held by the host
         } hb_mc_manycore_t;
 
 #define HB_MC_MANYCORE_INIT {0}
@@ -289,6 +291,154 @@ extern "C" {
         int hb_mc_manycore_read_mem_scatter_gather(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa,
                                                    uint32_t *data, size_t words);
 
+        /**
+         * A handle on an outstanding read started with hb_mc_manycore_read_async().
+         */
+        typedef uint32_t hb_mc_read_token_t;
+
+        /**
+         * Start reading from manycore hardware at a given NPA without waiting for the result
+         * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  npa    A valid hb_mc_npa_t aligned to #sz
+         * @param[in]  sz     The number of bytes to read: 1, 2, or 4
+         * @param[out] token  A handle to wait on with hb_mc_manycore_read_wait_any/all()
+         * @return HB_MC_SUCCESS on success. HB_MC_BUSY if every load ID is held by a read
+         * that has not been waited on. Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * All reads on a manycore instance, synchronous or not, share one pool of
+         * load IDs sized to the number of remote loads the host may have in flight.
+         * Every token must be waited on exactly once to return its load ID to the pool.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_read_async(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, size_t sz,
+                                      hb_mc_read_token_t *token);
+
+        /**
+         * Wait for any one of a set of outstanding reads to complete
+         * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  tokens A list of tokens returned by hb_mc_manycore_read_async()
+         * @param[in]  n      The number of tokens in #tokens
+         * @param[out] idx    Set to the index in #tokens of the read that completed
+         * @param[out] data   Set to the data read, zero extended
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * The completed token is released; the others remain outstanding.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_read_wait_any(hb_mc_manycore_t *mc, const hb_mc_read_token_t *tokens, size_t n,
+                                         size_t *idx, uint32_t *data);
+
+        /**
+         * Wait for all of a set of outstanding reads to complete
+         * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  tokens A list of tokens returned by hb_mc_manycore_read_async()
+         * @param[in]  n      The number of tokens in #tokens
+         * @param[out] data   An array of #n words; data[i] is set to the data read for tokens[i]
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * All tokens are released.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_read_wait_all(hb_mc_manycore_t *mc, const hb_mc_read_token_t *tokens, size_t n,
+                                         uint32_t *data);
+
+        /**
+         * Apply an atomic memory operation to a word of manycore memory
+         * @param[in]  mc      A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  npa     A valid hb_mc_npa_t aligned to a word
+         * @param[in]  amo     The atomic operation to apply
+         * @param[in]  operand The operand of #amo
+         * @param[out] old     Set to the value of the word before #amo was applied. May be NULL.
+         * @return HB_MC_SUCCESS on success. HB_MC_NOIMPL on platforms that cannot send
+         * atomic requests (aws-fpga, aws-vcs). Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * The operation is performed at the destination (a vcache or a tile's DMEM)
+         * and is atomic with respect to the kernels running on the manycore. The
+         * old value returns through the response network and shares the load ID
+         * pool with hb_mc_manycore_read_async().
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_amo(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa,
+                               hb_mc_packet_amo_t amo, uint32_t operand, uint32_t *old);
+
+        /**
+         * Atomically add to a word of manycore memory
+         * @param[in]  mc      A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  npa     A valid hb_mc_npa_t aligned to a word
+         * @param[in]  v       The value to add
+         * @param[out] old     Set to the value of the word before the add. May be NULL.
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_amo_add(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, uint32_t v, uint32_t *old);
+
+        /**
+         * Atomically swap a word of manycore memory
+         * @param[in]  mc      A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  npa     A valid hb_mc_npa_t aligned to a word
+         * @param[in]  v       The value to store
+         * @param[out] old     Set to the value of the word before the swap. May be NULL.
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_amo_swap(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, uint32_t v, uint32_t *old);
+
+        /**
+         * Atomically or a value into a word of manycore memory
+         * @param[in]  mc      A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  npa     A valid hb_mc_npa_t aligned to a word
+         * @param[in]  v       The value to or in
+         * @param[out] old     Set to the value of the word before the or. May be NULL.
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_amo_or(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, uint32_t v, uint32_t *old);
+
+        /**
+         * Atomically and a value into a word of manycore memory
+         * @param[in]  mc      A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  npa     A valid hb_mc_npa_t aligned to a word
+         * @param[in]  v       The value to and in
+         * @param[out] old     Set to the value of the word before the and. May be NULL.
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_amo_and(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, uint32_t v, uint32_t *old);
+
+        /**
+         * One segment of a vectored read or write.
+         */
+        typedef struct hb_mc_npa_iovec {
+                hb_mc_npa_t npa;   //!< NPA of the first word of the segment
+                void       *data;  //!< host buffer; written out on writes, filled in on reads
+                size_t      sz;    //!< segment length in bytes; a multiple of 4
+        } hb_mc_npa_iovec_t;
+
+        /**
+         * Write a list of host buffers out to manycore hardware
+         * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  iov    A list of segments to write
+         * @param[in]  n      The number of segments in #iov
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * Stores to all segments are sent back to back and completed with a single fence.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_write_mem_vec(hb_mc_manycore_t *mc, const hb_mc_npa_iovec_t *iov, size_t n);
+
+        /**
+         * Read a list of manycore memory regions into host buffers
+         * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  iov    A list of segments to read
+         * @param[in]  n      The number of segments in #iov
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * Loads from all segments share one pipeline, so short segments do not
+         * each wait for their own responses to drain.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_read_mem_vec(hb_mc_manycore_t *mc, const hb_mc_npa_iovec_t *iov, size_t n);
+
         /***********/
         /* DMA API */
         /***********/
@@ -386,6 +536,99 @@ extern "C" {
         int hb_mc_manycore_dma_read_no_cache_afl(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa,
                                                  void *data, size_t sz);
 
+        /**
+         * Get a host pointer to manycore DRAM starting at a given NPA - unsafe
+         * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  npa    A valid hb_mc_npa_t (must map to DRAM)
+         * @param[in]  sz     The number of bytes that will be accessed through the pointer
+         * @param[out] ptr    Set to a host pointer to #npa
+         * @return HB_MC_SUCCESS on success. HB_MC_INVALID if the #sz bytes at #npa
+         * are not contiguous in host memory. Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * On platforms whose DRAM lives in host memory (simulation) this gives
+         * zero-copy access to DRAM: loads and stores through #ptr read and write
+         * DRAM directly. Memory systems that permute addresses (DRAMSim3) keep
+         * only small granules of a bank together in host memory, so a range
+         * that crosses a granule cannot be mapped. Like hb_mc_manycore_dma_read_no_cache_afl() and
+         * hb_mc_manycore_dma_write_no_cache_ainv(), it does nothing about the
+         * caches: flush the range before reading data the manycore wrote, and
+         * invalidate it after writing data the manycore will read.
+         *
+         * This function is not supported on all HammerBlade platforms.
+         * Please check the return code for HB_MC_NOIMPL.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_dma_map(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa,
+                                   size_t sz, void **ptr);
+
+        /**
+         * One piece of a DMA transfer: #sz bytes between #npa and #host.
+         * The NPA range must lie within a single DRAM bank.
+         */
+        typedef struct hb_mc_dma_segment {
+                hb_mc_npa_t npa; //!< DRAM address of the first byte
+                void *host;      //!< host address of the first byte
+                size_t sz;       //!< number of bytes
+        } hb_mc_dma_segment_t;
+
+        /**
+         * Write a list of segments via DMA to manycore DRAM
+         * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  segs   Segments to write; host is the source of each
+         * @param[in]  nsegs  The number of segments in #segs
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * Like hb_mc_manycore_dma_write_segments_no_cache_ainv(), but any
+         * data in the cache that becomes stale is invalidated. When the
+         * segments cover more lines than the caches hold, the caches are
+         * flushed before the transfer and invalidated entirely after it.
+         *
+         * This function is not supported on all HammerBlade platforms.
+         * Please check the return code for HB_MC_NOIMPL.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_dma_write_segments(hb_mc_manycore_t *mc,
+                                              const hb_mc_dma_segment_t *segs,
+                                              size_t nsegs);
+
+        /**
+         * Write a list of segments via DMA to manycore DRAM - unsafe
+         * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  segs   Segments to write; host is the source of each
+         * @param[in]  nsegs  The number of segments in #segs
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * Equivalent to calling hb_mc_manycore_dma_write_no_cache_ainv()
+         * on each segment, but lets the platform plan the whole list at
+         * once: merge segments that are adjacent in DRAM and copy in
+         * parallel. Segments must not overlap.
+         *
+         * This function is not supported on all HammerBlade platforms.
+         * Please check the return code for HB_MC_NOIMPL.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_dma_write_segments_no_cache_ainv(hb_mc_manycore_t *mc,
+                                                            const hb_mc_dma_segment_t *segs,
+                                                            size_t nsegs);
+
+        /**
+         * Read a list of segments via DMA from manycore DRAM - unsafe
+         * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  segs   Segments to read; host is the destination of each
+         * @param[in]  nsegs  The number of segments in #segs
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * Equivalent to calling hb_mc_manycore_dma_read_no_cache_afl()
+         * on each segment. See hb_mc_manycore_dma_write_segments_no_cache_ainv().
+         *
+         * This function is not supported on all HammerBlade platforms.
+         * Please check the return code for HB_MC_NOIMPL.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_dma_read_segments_no_cache_afl(hb_mc_manycore_t *mc,
+                                                          const hb_mc_dma_segment_t *segs,
+                                                          size_t nsegs);
+
         /************************/
         /* Cache Operations API */
         /************************/
@@ -420,6 +663,32 @@ extern "C" {
         __attribute__((warn_unused_result))
         int hb_mc_manycore_vcache_flush_npa_range(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, size_t sz);
 
+        /**
+         * Start flushing a range of manycore DRAM addresses without waiting for the flush to complete.
+         * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  npa    A valid hb_mc_npa_t (must map to DRAM) - start of the range to flush
+         * @param[in]  sz     The size of the range to flush in bytes
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * A cache handles requests in order: the flush is done once a
+         * later read of any address in the same cache completes.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_vcache_flush_npa_range_nowait(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, size_t sz);
+
+        /**
+         * Flush the partially covered cache lines at either end of a range of manycore DRAM addresses.
+         * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  npa    A valid hb_mc_npa_t (must map to DRAM) - start of the range
+         * @param[in]  sz     The size of the range in bytes
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * Call this before writing a range behind the cache and invalidating it with
+         * hb_mc_manycore_vcache_invalidate_npa_range(), which invalidates whole lines.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_vcache_flush_npa_range_edges(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, size_t sz);
+
         /**
          * Flush a cache tag.
          * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
@@ -504,6 +773,42 @@ extern "C" {
          */
         int hb_mc_manycore_host_request_fence(hb_mc_manycore_t *mc, long timeout);
 
+        /**
+         * Stall until all requests to a set of destinations have reached them.
+         * Requests to other destinations may still be in flight.
+         * @param[in]  mc      A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  dsts    The destinations to fence
+         * @param[in]  n       The number of destinations in #dsts
+         * @param[in]  timeout A timeout counter. Unused - set to -1 to wait forever.
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_host_request_fence_dsts(hb_mc_manycore_t *mc,
+                                                   const hb_mc_coordinate_t *dsts,
+                                                   size_t n,
+                                                   long timeout);
+
+        /**
+         * Get the number of requests that the host has sent, including the
+         * loads that hb_mc_manycore_host_request_fence_dsts() sends
+         * @param[in]  mc      A manycore instance initialized with hb_mc_manycore_init()
+         * @param[out] sent    Set to the number of requests sent
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_get_requests_sent(hb_mc_manycore_t *mc, uint64_t *sent);
+
+        /**
+         * Check whether every request sent to a destination is known to have completed
+         * @param[in]  mc      A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  dst     The destination to check
+         * @param[out] fenced  Set to one if no request to #dst can be in flight. Zero otherwise.
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_dst_is_fenced(hb_mc_manycore_t *mc, const hb_mc_coordinate_t *dst,
+                                         int *fenced);
+
         /**
          * Get the current cycle counter value of the Manycore Platform
          *
@@ -556,6 +861,29 @@ extern "C" {
          */
         int hb_mc_manycore_log_disable(hb_mc_manycore_t *mc);
 
+        /**
+         * Save the state of the manycore hardware to a checkpoint
+         * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in] path  Path of the checkpoint file to write
+         * @return HB_MC_SUCCESS on success. HB_MC_NOIMPL if the platform cannot take checkpoints.
+         *
+         * DRAM held in C++ models is saved to #path with a .dram suffix.
+         * The timing state of DRAMSim3 is not saved: the checkpoint is
+         * taken with no request in flight, and DRAMSim3 restarts idle.
+         */
+        int hb_mc_manycore_checkpoint_save(hb_mc_manycore_t *mc, const char *path);
+
+        /**
+         * Restore the state of the manycore hardware from a checkpoint
+         *
+         * The checkpoint must have been taken on the same machine.
+         *
+         * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in] path  Path of a checkpoint file written by hb_mc_manycore_checkpoint_save()
+         * @return HB_MC_SUCCESS on success. HB_MC_NOIMPL if the platform cannot take checkpoints.
+         */
+        int hb_mc_manycore_checkpoint_restore(hb_mc_manycore_t *mc, const char *path);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,402 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include <bsg_manycore_branch_trace.h>
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_printing.h>
+#include <cerrno>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/* The number of full chunks that may wait for the writer thread */
+#define HB_MC_BRANCH_TRACE_MAX_QUEUED_CHUNKS 64
+
+#define HB_MC_BRANCH_TRACE_HEADER_BYTES       8
+#define HB_MC_BRANCH_TRACE_CHUNK_HEADER_BYTES 16
+
+typedef std::vector<uint8_t> hb_mc_branch_trace_buf_t;
+
+static void put_u16(hb_mc_branch_trace_buf_t &buf, uint16_t v)
+{
+        buf.push_back(v);
+        buf.push_back(v >> 8);
+}
+
+static void put_u32(hb_mc_branch_trace_buf_t &buf, uint32_t v)
+{
+        put_u16(buf, v);
+        put_u16(buf, v >> 16);
+}
+
+static void put_uleb(hb_mc_branch_trace_buf_t &buf, uint64_t v)
+{
+        while (v >= 0x80) {
+                buf.push_back((v & 0x7F) | 0x80);
+                v >>= 7;
+        }
+        buf.push_back(v);
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+        return p[0] | (p[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+        return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+/* decode an unsigned LEB128; returns the number of bytes used, or 0 if truncated */
+static size_t get_uleb(const uint8_t *p, size_t n, uint64_t *v)
+{
+        uint64_t r = 0;
+        for (size_t i = 0; i < n && i < 10; i++) {
+                r |= (uint64_t)(p[i] & 0x7F) << (7 * i);
+                if (!(p[i] & 0x80)) {
+                        *v = r;
+                        return i + 1;
+                }
+        }
+        return 0;
+}
+
+static uint32_t zigzag(int32_t v)
+{
+        return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v)
+{
+        return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+/* the chunk being filled for one tile */
+typedef struct {
+        hb_mc_idx_t x, y;
+        uint32_t count;
+        uint64_t prev_cycle;
+        uint32_t prev_data;
+        hb_mc_branch_trace_buf_t payload;
+} hb_mc_branch_trace_chunk_t;
+
+struct hb_mc_branch_trace_writer {
+        FILE *f;
+        std::unordered_map<uint64_t, hb_mc_branch_trace_chunk_t> chunks;
+
+        // full chunks, serialized, waiting for the writer thread
+        std::mutex mutex;
+        std::condition_variable ready;   //!< signaled when a chunk is queued or on close
+        std::condition_variable drained; //!< signaled when a chunk is written out
+        std::deque<hb_mc_branch_trace_buf_t> queue;
+        bool closing;
+        bool failed;
+        std::thread thread;
+};
+
+/* the writer thread: write queued chunks out until closed and drained */
+static void hb_mc_branch_trace_writer_main(hb_mc_branch_trace_writer_t *w)
+{
+        std::unique_lock<std::mutex> lock(w->mutex);
+
+        for (;;) {
+                w->ready.wait(lock, [w] { return !w->queue.empty() || w->closing; });
+                if (w->queue.empty())
+                        return;
+
+                hb_mc_branch_trace_buf_t buf = std::move(w->queue.front());
+                w->queue.pop_front();
+
+                lock.unlock();
+                bool ok = fwrite(buf.data(), 1, buf.size(), w->f) == buf.size();
+                lock.lock();
+
+                if (!ok)
+                        w->failed = true;
+                w->drained.notify_one();
+        }
+}
+
+/* hand a tile's chunk to the writer thread and start a new one */
+static int hb_mc_branch_trace_writer_flush_chunk(hb_mc_branch_trace_writer_t *w,
+                                                 hb_mc_branch_trace_chunk_t &chunk)
+{
+        hb_mc_branch_trace_buf_t buf;
+
+        if (chunk.count == 0)
+                return HB_MC_SUCCESS;
+
+        buf.reserve(HB_MC_BRANCH_TRACE_CHUNK_HEADER_BYTES + chunk.payload.size());
+        put_u32(buf, HB_MC_BRANCH_TRACE_CHUNK_MAGIC);
+        put_u16(buf, chunk.x);
+        put_u16(buf, chunk.y);
+        put_u32(buf, chunk.count);
+        put_u32(buf, chunk.payload.size());
+        buf.insert(buf.end(), chunk.payload.begin(), chunk.payload.end());
+
+        chunk.count = 0;
+        chunk.prev_cycle = 0;
+        chunk.prev_data = 0;
+        chunk.payload.clear();
+
+        std::unique_lock<std::mutex> lock(w->mutex);
+        // if the disk can't keep up, wait rather than buffer without bound
+        w->drained.wait(lock, [w] {
+                        return w->queue.size() < HB_MC_BRANCH_TRACE_MAX_QUEUED_CHUNKS || w->failed;
+                });
+        if (w->failed)
+                return HB_MC_FAIL;
+
+        w->queue.push_back(std::move(buf));
+        w->ready.notify_one();
+        return HB_MC_SUCCESS;
+}
+
+int hb_mc_branch_trace_writer_open(const char *path, hb_mc_branch_trace_writer_t **writer)
+{
+        hb_mc_branch_trace_writer_t *w = new (std::nothrow) hb_mc_branch_trace_writer_t;
+        if (w == nullptr)
+                return HB_MC_NOMEM;
+
+        w->f = fopen(path, "wb");
+        if (w->f == nullptr) {
+                bsg_pr_err("%s: Failed to open '%s': %s\n", __func__, path, strerror(errno));
+                delete w;
+                return HB_MC_FAIL;
+        }
+
+        hb_mc_branch_trace_buf_t header;
+        put_u32(header, HB_MC_BRANCH_TRACE_MAGIC);
+        put_u32(header, HB_MC_BRANCH_TRACE_VERSION);
+        if (fwrite(header.data(), 1, header.size(), w->f) != header.size()) {
+                bsg_pr_err("%s: Failed to write '%s'\n", __func__, path);
+                fclose(w->f);
+                delete w;
+                return HB_MC_FAIL;
+        }
+
+        w->closing = false;
+        w->failed = false;
+
+        try {
+                w->thread = std::thread(hb_mc_branch_trace_writer_main, w);
+        } catch (const std::system_error &e) {
+                bsg_pr_err("%s: Failed to start writer thread: %s\n", __func__, e.what());
+                fclose(w->f);
+                delete w;
+                return HB_MC_FAIL;
+        }
+
+        *writer = w;
+        return HB_MC_SUCCESS;
+}
+
+int hb_mc_branch_trace_writer_append(hb_mc_branch_trace_writer_t *w,
+                                     const hb_mc_branch_trace_record_t *record)
+{
+        uint64_t key = ((uint64_t)record->x << 32) | record->y;
+        auto it = w->chunks.find(key);
+
+        if (it == w->chunks.end()) {
+                hb_mc_branch_trace_chunk_t chunk = {};
+                chunk.x = record->x;
+                chunk.y = record->y;
+                it = w->chunks.emplace(key, std::move(chunk)).first;
+        }
+
+        hb_mc_branch_trace_chunk_t &chunk = it->second;
+
+        // packets of a tile arrive in order, so cycles don't go backwards
+        put_uleb(chunk.payload, record->cycle - chunk.prev_cycle);
+        put_uleb(chunk.payload, zigzag((int32_t)(record->data - chunk.prev_data)));
+        chunk.prev_cycle = record->cycle;
+        chunk.prev_data = record->data;
+        chunk.count++;
+
+        if (chunk.count == HB_MC_BRANCH_TRACE_CHUNK_RECORDS)
+                return hb_mc_branch_trace_writer_flush_chunk(w, chunk);
+
+        return HB_MC_SUCCESS;
+}
+
+int hb_mc_branch_trace_writer_close(hb_mc_branch_trace_writer_t *w)
+{
+        int r = HB_MC_SUCCESS;
+
+        for (auto &kv : w->chunks) {
+                int err = hb_mc_branch_trace_writer_flush_chunk(w, kv.second);
+                if (err != HB_MC_SUCCESS)
+                        r = err;
+        }
+
+        {
+                std::lock_guard<std::mutex> lock(w->mutex);
+                w->closing = true;
+                w->ready.notify_one();
+        }
+
+        w->thread.join();
+
+        if (w->failed || fclose(w->f) != 0) {
+                bsg_pr_err("%s: Failed to write branch trace\n", __func__);
+                r = HB_MC_FAIL;
+        }
+
+        delete w;
+        return r;
+}
+
+struct hb_mc_branch_trace_reader {
+        FILE *f;
+        hb_mc_branch_trace_buf_t payload; //!< payload of the current chunk
+        size_t pos;                       //!< read position in payload
+        uint32_t remaining;               //!< records left in the current chunk
+        hb_mc_idx_t x, y;
+        uint64_t prev_cycle;
+        uint32_t prev_data;
+};
+
+int hb_mc_branch_trace_reader_open(const char *path, hb_mc_branch_trace_reader_t **reader)
+{
+        uint8_t header[HB_MC_BRANCH_TRACE_HEADER_BYTES];
+
+        FILE *f = fopen(path, "rb");
+        if (f == nullptr) {
+                bsg_pr_err("%s: Failed to open '%s': %s\n", __func__, path, strerror(errno));
+                return HB_MC_FAIL;
+        }
+
+        if (fread(header, 1, sizeof(header), f) != sizeof(header) ||
+            get_u32(&header[0]) != HB_MC_BRANCH_TRACE_MAGIC) {
+                bsg_pr_err("%s: '%s' is not a branch trace\n", __func__, path);
+                fclose(f);
+                return HB_MC_INVALID;
+        }
+
+        if (get_u32(&header[4]) != HB_MC_BRANCH_TRACE_VERSION) {
+                bsg_pr_err("%s: '%s' has unsupported version %" PRIu32 "\n",
+                           __func__, path, get_u32(&header[4]));
+                fclose(f);
+                return HB_MC_INVALID;
+        }
+
+        hb_mc_branch_trace_reader_t *r = new (std::nothrow) hb_mc_branch_trace_reader_t;
+        if (r == nullptr) {
+                fclose(f);
+                return HB_MC_NOMEM;
+        }
+
+        r->f = f;
+        r->pos = 0;
+        r->remaining = 0;
+
+        *reader = r;
+        return HB_MC_SUCCESS;
+}
+
+/* read the next chunk header and payload */
+static int hb_mc_branch_trace_reader_next_chunk(hb_mc_branch_trace_reader_t *r)
+{
+        uint8_t header[HB_MC_BRANCH_TRACE_CHUNK_HEADER_BYTES];
+        size_t n = fread(header, 1, sizeof(header), r->f);
+
+        if (n == 0 && feof(r->f))
+                return HB_MC_NOTFOUND;
+
+        if (n != sizeof(header) || get_u32(&header[0]) != HB_MC_BRANCH_TRACE_CHUNK_MAGIC) {
+                bsg_pr_err("%s: Bad chunk header\n", __func__);
+                return HB_MC_INVALID;
+        }
+
+        r->x = get_u16(&header[4]);
+        r->y = get_u16(&header[6]);
+        r->remaining = get_u32(&header[8]);
+        r->payload.resize(get_u32(&header[12]));
+        r->pos = 0;
+        r->prev_cycle = 0;
+        r->prev_data = 0;
+
+        if (fread(r->payload.data(), 1, r->payload.size(), r->f) != r->payload.size()) {
+                bsg_pr_err("%s: Truncated chunk\n", __func__);
+                return HB_MC_INVALID;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+int hb_mc_branch_trace_reader_next(hb_mc_branch_trace_reader_t *r,
+                                   hb_mc_branch_trace_record_t *record)
+{
+        uint64_t dcycle, ddata;
+        size_t n;
+        int err;
+
+        while (r->remaining == 0) {
+                err = hb_mc_branch_trace_reader_next_chunk(r);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+        }
+
+        n = get_uleb(r->payload.data() + r->pos, r->payload.size() - r->pos, &dcycle);
+        if (n == 0)
+                goto corrupt;
+        r->pos += n;
+
+        n = get_uleb(r->payload.data() + r->pos, r->payload.size() - r->pos, &ddata);
+        if (n == 0)
+                goto corrupt;
+        r->pos += n;
+
+        r->prev_cycle += dcycle;
+        r->prev_data += unzigzag(ddata);
+        r->remaining--;
+
+        record->cycle = r->prev_cycle;
+        record->x = r->x;
+        record->y = r->y;
+        record->data = r->prev_data;
+        return HB_MC_SUCCESS;
+
+corrupt:
+        bsg_pr_err("%s: Corrupt chunk for tile (%" PRIu32 ", %" PRIu32 ")\n",
+                   __func__, r->x, r->y);
+        return HB_MC_INVALID;
+}
+
+void hb_mc_branch_trace_reader_close(hb_mc_branch_trace_reader_t *r)
+{
+        fclose(r->f);
+        delete r;
+}
@@ -0,0 +1,161 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef BSG_MANYCORE_BRANCH_TRACE_H
+#define BSG_MANYCORE_BRANCH_TRACE_H
+
+#include <bsg_manycore_features.h>
+#include <bsg_manycore_coordinate.h>
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+/*
+ * Binary branch trace format
+ *
+ * A trace file is a header followed by a sequence of chunks. Each
+ * chunk holds the records of one tile, in the order they arrived:
+ *
+ *   file header:  uint32 magic ("HBBT"), uint32 version
+ *   chunk header: uint32 magic ("HBTC"), uint16 x, uint16 y,
+ *                 uint32 number of records, uint32 payload bytes
+ *   payload:      per record, the cycle delta as an unsigned LEB128
+ *                 and the data delta (zig-zag) as an unsigned LEB128
+ *
+ * Deltas are taken against the previous record of the same chunk,
+ * starting from zero, so each chunk decodes on its own. Consecutive
+ * branches of a tile are a few cycles and a few instructions apart,
+ * so most records take 2-3 bytes instead of a ~40 byte text line.
+ *
+ * All fields are little endian.
+ */
+#define HB_MC_BRANCH_TRACE_MAGIC        0x54424248 // "HBBT"
+#define HB_MC_BRANCH_TRACE_CHUNK_MAGIC  0x43544248 // "HBTC"
+#define HB_MC_BRANCH_TRACE_VERSION      1
+
+/* The maximum number of records in one chunk */
+#define HB_MC_BRANCH_TRACE_CHUNK_RECORDS 4096
+
+/* If set, the branch trace responder writes a binary trace to this path */
+#define HB_MC_BRANCH_TRACE_ENV "BSG_MANYCORE_BRANCH_TRACE"
+
+/*
+ * Reading the cycle counter can cost a round trip to the device (an
+ * MMIO read on F1). If set to N, the branch trace responder reads it
+ * once every N records, and the records in between reuse that cycle.
+ * Zero records no cycles. Defaults to one: every record is timed.
+ */
+#define HB_MC_BRANCH_TRACE_CYCLE_PERIOD_ENV "BSG_MANYCORE_BRANCH_TRACE_CYCLE_PERIOD"
+
+/*
+ * Branch trace data is the PC of the branch. Instructions are word
+ * aligned, so the hardware reports whether the branch was taken in
+ * the low bit.
+ */
+#define hb_mc_branch_trace_data_get_pc(data)    ((data) & ~0x3u)
+#define hb_mc_branch_trace_data_get_taken(data) ((data) & 0x1u)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+        typedef struct hb_mc_branch_trace_record {
+                uint64_t    cycle; //!< cycle at which the host received the trace packet
+                hb_mc_idx_t x;     //!< x coordinate of the tile
+                hb_mc_idx_t y;     //!< y coordinate of the tile
+                uint32_t    data;  //!< trace packet payload
+        } hb_mc_branch_trace_record_t;
+
+        typedef struct hb_mc_branch_trace_writer hb_mc_branch_trace_writer_t;
+        typedef struct hb_mc_branch_trace_reader hb_mc_branch_trace_reader_t;
+
+        /**
+         * Create a binary branch trace file.
+         * @param[in]  path   Path of the trace file
+         * @param[out] writer Set to a new writer
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * Full chunks are written out by a background thread.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_branch_trace_writer_open(const char *path, hb_mc_branch_trace_writer_t **writer);
+
+        /**
+         * Append a record to a branch trace.
+         * @param[in]  writer A writer returned by hb_mc_branch_trace_writer_open()
+         * @param[in]  record A record to append
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * Not thread safe: callers must serialize appends to the same writer.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_branch_trace_writer_append(hb_mc_branch_trace_writer_t *writer,
+                                             const hb_mc_branch_trace_record_t *record);
+
+        /**
+         * Write out all buffered records and close a branch trace.
+         * @param[in]  writer A writer returned by hb_mc_branch_trace_writer_open()
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_branch_trace_writer_close(hb_mc_branch_trace_writer_t *writer);
+
+        /**
+         * Open a binary branch trace file for reading.
+         * @param[in]  path   Path of a trace file written by a hb_mc_branch_trace_writer_t
+         * @param[out] reader Set to a new reader
+         * @return HB_MC_SUCCESS if succesful. HB_MC_INVALID if the file is not a branch trace.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_branch_trace_reader_open(const char *path, hb_mc_branch_trace_reader_t **reader);
+
+        /**
+         * Read the next record of a branch trace.
+         * @param[in]  reader A reader returned by hb_mc_branch_trace_reader_open()
+         * @param[out] record Set to the next record
+         * @return HB_MC_SUCCESS if succesful. HB_MC_NOTFOUND at the end of the trace.
+         * HB_MC_INVALID if the trace is corrupt.
+         *
+         * Records of one tile are returned in the order they were appended.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_branch_trace_reader_next(hb_mc_branch_trace_reader_t *reader,
+                                           hb_mc_branch_trace_record_t *record);
+
+        /**
+         * Close a branch trace reader.
+         * @param[in]  reader A reader returned by hb_mc_branch_trace_reader_open()
+         */
+        void hb_mc_branch_trace_reader_close(hb_mc_branch_trace_reader_t *reader);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
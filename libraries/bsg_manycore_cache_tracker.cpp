@@ -0,0 +1,381 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore_cache_tracker.h>
+#include <bsg_manycore_config.h>
+#include <bsg_manycore_printing.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <new>
+#include <utility>
+
+namespace {
+        /**
+         * A set of EVA ranges, or everything.
+         */
+        class hb_mc_eva_range_set {
+        public:
+                bool all = true;                      //!< the set holds every address
+                std::map<uint64_t, uint64_t> ranges;  //!< start -> end of disjoint ranges
+                uint64_t bytes = 0;                   //!< total size of #ranges
+
+                void set_all() {
+                        all = true;
+                        ranges.clear();
+                        bytes = 0;
+                }
+
+                void clear() {
+                        all = false;
+                        ranges.clear();
+                        bytes = 0;
+                }
+
+                bool empty() const {
+                        return !all && ranges.empty();
+                }
+
+                // add [lo, hi), merging with the ranges it touches
+                void add(uint64_t lo, uint64_t hi) {
+                        if (all || lo >= hi)
+                                return;
+
+                        auto it = ranges.upper_bound(lo);
+                        if (it != ranges.begin() && std::prev(it)->second >= lo)
+                                it = std::prev(it);
+
+                        while (it != ranges.end() && it->first <= hi) {
+                                lo = std::min(lo, it->first);
+                                hi = std::max(hi, it->second);
+                                bytes -= it->second - it->first;
+                                it = ranges.erase(it);
+                        }
+
+                        ranges[lo] = hi;
+                        bytes += hi - lo;
+
+                        if (bytes > HB_MC_CACHE_TRACKER_MAX_BYTES
+                            || ranges.size() > HB_MC_CACHE_TRACKER_MAX_RANGES)
+                                set_all();
+                }
+        };
+}
+
+struct hb_mc_cache_tracker {
+        hb_mc_manycore_t *mc;
+        hb_mc_eva_range_set dirty;    //!< lines that may be dirty
+        hb_mc_eva_range_set resident; //!< lines that may be valid
+        bool invalidate_all;          //!< a whole-cache invalidation is pending
+        bool verify;                  //!< check elided operations
+};
+
+/**
+ * Widen a range to whole cache lines.
+ * @param[in]  tracker A tracker returned by hb_mc_cache_tracker_init()
+ * @param[in]  eva     Start of the range
+ * @param[in]  sz      Size of the range in bytes
+ * @param[out] lo      Start of the first line
+ * @param[out] hi      End of the last line
+ */
+static void hb_mc_cache_tracker_lines(const hb_mc_cache_tracker_t *tracker,
+                                      hb_mc_eva_t eva, size_t sz,
+                                      uint64_t *lo, uint64_t *hi)
+{
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(tracker->mc);
+        uint64_t line = hb_mc_config_get_vcache_block_size(cfg);
+
+        *lo = eva & ~(line - 1);
+        *hi = (static_cast<uint64_t>(eva) + sz + line - 1) & ~(line - 1);
+}
+
+/**
+ * Apply a cache operation to the DRAM lines of an EVA range.
+ * @param[in]  tracker A tracker returned by hb_mc_cache_tracker_init()
+ * @param[in]  lo      Start of the range
+ * @param[in]  hi      End of the range
+ * @param[in]  op      Applied to the NPA range of each stripe
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+template <typename OpFunction>
+static int hb_mc_cache_tracker_apply(hb_mc_cache_tracker_t *tracker,
+                                     uint64_t lo, uint64_t hi, OpFunction op)
+{
+        hb_mc_manycore_t *mc = tracker->mc;
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        hb_mc_coordinate_t host = hb_mc_manycore_get_host_coordinate(mc);
+
+        while (lo < hi) {
+                hb_mc_eva_t eva = static_cast<hb_mc_eva_t>(lo);
+                hb_mc_npa_t npa;
+                size_t sz;
+
+                int err = hb_mc_eva_to_npa(mc, &default_map, &host, &eva, &npa, &sz);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+
+                sz = std::min<uint64_t>(sz, hi - lo);
+
+                // ranges may include tile memory, which has no cache
+                if (hb_mc_config_coordinate_is_dram(cfg, hb_mc_npa_get_xy(&npa))) {
+                        err = op(mc, &npa, sz);
+                        if (err != HB_MC_SUCCESS)
+                                return err;
+                }
+
+                lo += sz;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Create a cache tracker.
+ * @param[in]  mc      A manycore instance initialized with hb_mc_manycore_init()
+ * @param[out] tracker Set to a new tracker
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code defined in bsg_manycore_errno.h.
+ *
+ * Nothing is known about the caches at first: every line may be dirty.
+ */
+int hb_mc_cache_tracker_init(hb_mc_manycore_t *mc, hb_mc_cache_tracker_t **tracker)
+{
+        hb_mc_cache_tracker_t *t = new (std::nothrow) hb_mc_cache_tracker_t;
+        if (t == nullptr) {
+                bsg_pr_err("%s: failed to allocate cache tracker\n", __func__);
+                return HB_MC_NOMEM;
+        }
+
+        const char *verify = getenv(HB_MC_CACHE_TRACKER_VERIFY_ENV);
+
+        t->mc = mc;
+        t->dirty.set_all();
+        t->resident.set_all();
+        t->invalidate_all = false;
+        t->verify = verify != nullptr && atoi(verify) != 0;
+
+        if (t->verify)
+                bsg_pr_info("%s: verifying elided cache operations\n", __func__);
+
+        *tracker = t;
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Destroy a cache tracker.
+ * @param[in]  tracker A tracker returned by hb_mc_cache_tracker_init()
+ */
+void hb_mc_cache_tracker_exit(hb_mc_cache_tracker_t *tracker)
+{
+        delete tracker;
+}
+
+/**
+ * Check if elided cache operations should be verified.
+ * @param[in]  tracker A tracker returned by hb_mc_cache_tracker_init()
+ * @return One if #HB_MC_CACHE_TRACKER_VERIFY_ENV is set. Zero otherwise.
+ */
+int hb_mc_cache_tracker_verifying(const hb_mc_cache_tracker_t *tracker)
+{
+        return tracker->verify;
+}
+
+/**
+ * Record an event after which any line may be dirty, e.g. a kernel launch.
+ * @param[in]  tracker A tracker returned by hb_mc_cache_tracker_init()
+ */
+void hb_mc_cache_tracker_kernel(hb_mc_cache_tracker_t *tracker)
+{
+        tracker->dirty.set_all();
+        tracker->resident.set_all();
+}
+
+/**
+ * Forget everything known about the caches, e.g. after a checkpoint is restored.
+ * @param[in]  tracker A tracker returned by hb_mc_cache_tracker_init()
+ */
+void hb_mc_cache_tracker_reset(hb_mc_cache_tracker_t *tracker)
+{
+        hb_mc_cache_tracker_kernel(tracker);
+        tracker->invalidate_all = false;
+}
+
+/**
+ * Record a host write over the mesh, which goes through the caches.
+ * @param[in]  tracker A tracker returned by hb_mc_cache_tracker_init()
+ * @param[in]  eva     Start of the written range
+ * @param[in]  sz      Size of the written range in bytes
+ */
+void hb_mc_cache_tracker_mesh_write(hb_mc_cache_tracker_t *tracker,
+                                    hb_mc_eva_t eva, size_t sz)
+{
+        uint64_t lo, hi;
+        hb_mc_cache_tracker_lines(tracker, eva, sz, &lo, &hi);
+        tracker->dirty.add(lo, hi);
+        tracker->resident.add(lo, hi);
+}
+
+/**
+ * Record a host read over the mesh, which goes through the caches.
+ * @param[in]  tracker A tracker returned by hb_mc_cache_tracker_init()
+ * @param[in]  eva     Start of the read range
+ * @param[in]  sz      Size of the read range in bytes
+ */
+void hb_mc_cache_tracker_mesh_read(hb_mc_cache_tracker_t *tracker,
+                                   hb_mc_eva_t eva, size_t sz)
+{
+        uint64_t lo, hi;
+        hb_mc_cache_tracker_lines(tracker, eva, sz, &lo, &hi);
+        tracker->resident.add(lo, hi);
+}
+
+/**
+ * Write back every line that may be dirty, before a DMA transfer.
+ * @param[in]  tracker A tracker returned by hb_mc_cache_tracker_init()
+ * @param[out] elided  Set to one if less than a whole-cache flush was sent. May be NULL.
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_cache_tracker_flush(hb_mc_cache_tracker_t *tracker, int *elided)
+{
+        int err;
+        hb_mc_manycore_t *mc = tracker->mc;
+        int partial = 0;
+
+        if (!hb_mc_manycore_has_cache(mc)) {
+                // nothing to do
+        } else if (tracker->dirty.all) {
+                err = hb_mc_manycore_flush_vcache(mc);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+                // the flush completes with a read from each cache
+                tracker->resident.set_all();
+        } else {
+                partial = 1;
+                bsg_pr_dbg("%s: flushing %zu ranges (%" PRIu64 " bytes)\n",
+                           __func__, tracker->dirty.ranges.size(), tracker->dirty.bytes);
+
+                // send every flush back to back, remembering an address in each cache flushed
+                std::map<std::pair<hb_mc_idx_t, hb_mc_idx_t>, hb_mc_npa_t> caches;
+                auto flush = [&caches](hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, size_t sz) {
+                        caches.emplace(std::make_pair(hb_mc_npa_get_x(npa), hb_mc_npa_get_y(npa)), *npa);
+                        return hb_mc_manycore_vcache_flush_npa_range_nowait(mc, npa, sz);
+                };
+
+                for (const auto &range : tracker->dirty.ranges) {
+                        err = hb_mc_cache_tracker_apply(tracker, range.first, range.second, flush);
+                        if (err != HB_MC_SUCCESS)
+                                return err;
+                }
+
+                // then wait once per cache: a read completes after the flushes before it
+                for (const auto &cache : caches) {
+                        uint32_t dummy;
+                        err = hb_mc_manycore_read32(mc, &cache.second, &dummy);
+                        if (err != HB_MC_SUCCESS)
+                                return err;
+                }
+        }
+
+        tracker->dirty.clear();
+
+        if (elided != nullptr)
+                *elided = partial;
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Invalidate the lines of a range written by DMA.
+ * @param[in]  tracker A tracker returned by hb_mc_cache_tracker_init()
+ * @param[in]  eva     Start of the written range
+ * @param[in]  sz      Size of the written range in bytes
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_cache_tracker_invalidate(hb_mc_cache_tracker_t *tracker,
+                                   hb_mc_eva_t eva, size_t sz)
+{
+        if (!hb_mc_manycore_has_cache(tracker->mc) || tracker->invalidate_all)
+                return HB_MC_SUCCESS;
+
+        if (tracker->resident.all) {
+                tracker->invalidate_all = true;
+                return HB_MC_SUCCESS;
+        }
+
+        uint64_t lo, hi;
+        hb_mc_cache_tracker_lines(tracker, eva, sz, &lo, &hi);
+
+        // invalidate only the resident part of [lo, hi)
+        const std::map<uint64_t, uint64_t> &ranges = tracker->resident.ranges;
+        auto it = ranges.upper_bound(lo);
+        if (it != ranges.begin())
+                it = std::prev(it);
+
+        for (; it != ranges.end() && it->first < hi; ++it) {
+                uint64_t start = std::max(lo, it->first);
+                uint64_t end = std::min(hi, it->second);
+                if (start >= end)
+                        continue;
+
+                int err = hb_mc_cache_tracker_apply(tracker, start, end,
+                                                    hb_mc_manycore_vcache_invalidate_npa_range);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Finish the invalidations of a batch of DMA writes.
+ * @param[in]  tracker A tracker returned by hb_mc_cache_tracker_init()
+ * @param[out] elided  Set to one if less than a whole-cache invalidation was sent. May be NULL.
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_cache_tracker_invalidate_finish(hb_mc_cache_tracker_t *tracker, int *elided)
+{
+        int partial = 1;
+
+        if (tracker->invalidate_all) {
+                int err = hb_mc_manycore_invalidate_vcache(tracker->mc);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+
+                // the caches are empty
+                tracker->dirty.clear();
+                tracker->resident.clear();
+                tracker->invalidate_all = false;
+                partial = 0;
+        }
+
+        if (elided != nullptr)
+                *elided = partial;
+
+        return HB_MC_SUCCESS;
+}
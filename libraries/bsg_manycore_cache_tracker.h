@@ -0,0 +1,173 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef BSG_MANYCORE_CACHE_TRACKER_H
+#define BSG_MANYCORE_CACHE_TRACKER_H
+
+#include <bsg_manycore_features.h>
+#include <bsg_manycore.h>
+#include <bsg_manycore_eva.h>
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+/*
+ * Victim cache state tracking
+ *
+ * DMA bypasses the victim caches, so a DMA read must be preceded by a
+ * flush of any dirty lines in its range, and a DMA write must be
+ * followed by an invalidation of any lines that hold its range. Doing
+ * both for the whole cache on every transfer is expensive and usually
+ * unnecessary: between two kernels the only traffic through the caches
+ * is what the host sends over the mesh.
+ *
+ * The tracker keeps what the host knows about the caches since the
+ * last maintenance operation:
+ *
+ *   dirty:    lines that may hold data newer than DRAM
+ *   resident: lines that may be valid (dirty or not)
+ *
+ * Each is either "anything" (after a kernel, or when too much has been
+ * recorded) or a set of DRAM EVA ranges from host mesh accesses. Flush
+ * and invalidate requests are narrowed to those ranges, or skipped.
+ *
+ * Accesses that bypass the tracker (e.g. hb_mc_manycore_* calls made
+ * directly by the application) must be reported with
+ * hb_mc_cache_tracker_kernel().
+ */
+
+/* If set to a non-zero value, DMA transfers check every elided cache operation */
+#define HB_MC_CACHE_TRACKER_VERIFY_ENV "BSG_MANYCORE_CACHE_VERIFY"
+
+/* Above this many tracked bytes (per state) the tracker gives up on ranges */
+#define HB_MC_CACHE_TRACKER_MAX_BYTES (64 << 10)
+/* Above this many tracked ranges (per state) the tracker gives up on ranges */
+#define HB_MC_CACHE_TRACKER_MAX_RANGES 64
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+        typedef struct hb_mc_cache_tracker hb_mc_cache_tracker_t;
+
+        /**
+         * Create a cache tracker.
+         * @param[in]  mc      A manycore instance initialized with hb_mc_manycore_init()
+         * @param[out] tracker Set to a new tracker
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * Nothing is known about the caches at first: every line may be dirty.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_cache_tracker_init(hb_mc_manycore_t *mc, hb_mc_cache_tracker_t **tracker);
+
+        /**
+         * Destroy a cache tracker.
+         * @param[in]  tracker A tracker returned by hb_mc_cache_tracker_init()
+         */
+        void hb_mc_cache_tracker_exit(hb_mc_cache_tracker_t *tracker);
+
+        /**
+         * Check if elided cache operations should be verified.
+         * @param[in]  tracker A tracker returned by hb_mc_cache_tracker_init()
+         * @return One if #HB_MC_CACHE_TRACKER_VERIFY_ENV is set. Zero otherwise.
+         */
+        int hb_mc_cache_tracker_verifying(const hb_mc_cache_tracker_t *tracker);
+
+        /**
+         * Record an event after which any line may be dirty, e.g. a kernel launch.
+         * @param[in]  tracker A tracker returned by hb_mc_cache_tracker_init()
+         */
+        void hb_mc_cache_tracker_kernel(hb_mc_cache_tracker_t *tracker);
+
+        /**
+         * Forget everything known about the caches, e.g. after a checkpoint is restored.
+         * Any line may be dirty, and no invalidation is pending.
+         * @param[in]  tracker A tracker returned by hb_mc_cache_tracker_init()
+         */
+        void hb_mc_cache_tracker_reset(hb_mc_cache_tracker_t *tracker);
+
+        /**
+         * Record a host write over the mesh, which goes through the caches.
+         * @param[in]  tracker A tracker returned by hb_mc_cache_tracker_init()
+         * @param[in]  eva     Start of the written range
+         * @param[in]  sz      Size of the written range in bytes
+         */
+        void hb_mc_cache_tracker_mesh_write(hb_mc_cache_tracker_t *tracker,
+                                            hb_mc_eva_t eva, size_t sz);
+
+        /**
+         * Record a host read over the mesh, which goes through the caches.
+         * @param[in]  tracker A tracker returned by hb_mc_cache_tracker_init()
+         * @param[in]  eva     Start of the read range
+         * @param[in]  sz      Size of the read range in bytes
+         */
+        void hb_mc_cache_tracker_mesh_read(hb_mc_cache_tracker_t *tracker,
+                                           hb_mc_eva_t eva, size_t sz);
+
+        /**
+         * Write back every line that may be dirty, before a DMA transfer.
+         * @param[in]  tracker A tracker returned by hb_mc_cache_tracker_init()
+         * @param[out] elided  Set to one if less than a whole-cache flush was sent. May be NULL.
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_cache_tracker_flush(hb_mc_cache_tracker_t *tracker, int *elided);
+
+        /**
+         * Invalidate the lines of a range written by DMA.
+         * @param[in]  tracker A tracker returned by hb_mc_cache_tracker_init()
+         * @param[in]  eva     Start of the written range
+         * @param[in]  sz      Size of the written range in bytes
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * Lines that may be resident are invalidated now. If any line may
+         * be resident, the invalidation is deferred to
+         * hb_mc_cache_tracker_invalidate_finish() and done once for the
+         * whole cache.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_cache_tracker_invalidate(hb_mc_cache_tracker_t *tracker,
+                                           hb_mc_eva_t eva, size_t sz);
+
+        /**
+         * Finish the invalidations of a batch of DMA writes.
+         * @param[in]  tracker A tracker returned by hb_mc_cache_tracker_init()
+         * @param[out] elided  Set to one if less than a whole-cache invalidation was sent. May be NULL.
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_cache_tracker_invalidate_finish(hb_mc_cache_tracker_t *tracker, int *elided);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -30,6 +30,7 @@
 #include <bsg_manycore_memory_manager.h>
 #include <bsg_manycore_elf.h>
 #include <bsg_manycore_loader.h>
+#include <bsg_manycore_load_image.h>
 #include <bsg_manycore.h>
 #include <bsg_manycore_printing.h>
 #include <bsg_manycore_eva.h>
@@ -38,10 +39,16 @@
 
 #ifdef __cplusplus
 #include <cstring>
+#include <cstdio>
 #else
 #include <string.h>
+#include <stdio.h>
 #endif
 
+#include <list>
+#include <string>
+#include <vector>
+
 
 
 
@@ -76,34 +83,41 @@ static int hb_mc_tile_group_allocate_tiles (hb_mc_device_t *device,
                                             hb_mc_tile_group_t *tg);
 
 __attribute__((warn_unused_result))
-static int hb_mc_tile_group_enqueue (hb_mc_device_t* device,
-                                     grid_id_t grid_id,
-                                     hb_mc_coordinate_t tg_id,
-                                     hb_mc_dimension_t grid_dim,
-                                     hb_mc_dimension_t dim,
-                                     const char* name,
-                                     uint32_t argc,
-                                     const uint32_t *argv);
+static int hb_mc_grid_enqueue (hb_mc_device_t *device,
+                               hb_mc_dimension_t grid_dim,
+                               hb_mc_dimension_t tg_dim,
+                               const char* name,
+                               const hb_mc_kernel_t *args);
 
 __attribute__((warn_unused_result))
-static int hb_mc_tile_group_kernel_init (hb_mc_tile_group_t *tg, 
-                                         const char* name, 
-                                         uint32_t argc, 
-                                         const uint32_t *argv); 
+static int hb_mc_grid_kernel_init (hb_mc_device_t *device,
+                                   hb_mc_grid_t *grid,
+                                   const char* name,
+                                   const hb_mc_kernel_t *args);
+
+static void hb_mc_grid_kernel_exit (hb_mc_kernel_t *kernel);
 
 __attribute__((warn_unused_result))
-static int hb_mc_tile_group_launch (hb_mc_device_t *device,
-                                    hb_mc_tile_group_t *tg);
+static int hb_mc_grid_symbols_init (hb_mc_device_t *device,
+                                    hb_mc_grid_t *grid);
 
 __attribute__((warn_unused_result))
-static int hb_mc_tile_group_deallocate_tiles(hb_mc_device_t *device,
-                                             hb_mc_tile_group_t *tg);
+static int hb_mc_grid_args_init (hb_mc_device_t *device,
+                                 hb_mc_grid_t *grid);
+
+__attribute__((warn_unused_result))
+static int hb_mc_grid_args_exit (hb_mc_device_t *device,
+                                 hb_mc_grid_t *grid);
+
+static void hb_mc_device_grids_reset (hb_mc_device_t *device);
 
 __attribute__((warn_unused_result))
-static int hb_mc_tile_group_exit (hb_mc_tile_group_t *tg); 
+static int hb_mc_tile_group_launch (hb_mc_device_t *device,
+                                    hb_mc_tile_group_t *tg);
 
 __attribute__((warn_unused_result))
-static int hb_mc_tile_group_kernel_exit (hb_mc_kernel_t *kernel); 
+static int hb_mc_tile_group_deallocate_tiles(hb_mc_device_t *device,
+                                             hb_mc_tile_group_t *tg);
 
 __attribute__((warn_unused_result))
 static int hb_mc_device_program_load (hb_mc_device_t *device);
@@ -115,9 +129,14 @@ __attribute__((warn_unused_result))
 static int hb_mc_device_program_exit (hb_mc_program_t *program); 
 
 __attribute__((warn_unused_result))
-static int hb_mc_program_binary_copy (hb_mc_program_t *program,
-                                      const unsigned char *bin_data,
-                                      size_t bin_size); 
+static int hb_mc_device_program_init_image (hb_mc_device_t *device,
+                                            const char *bin_name,
+                                            hb_mc_program_image_t *image,
+                                            const char *alloc_name,
+                                            hb_mc_allocator_id_t id);
+
+static void hb_mc_program_set_image (hb_mc_program_t *program,
+                                     hb_mc_program_image_t *image);
 
 __attribute__((warn_unused_result))
 static int hb_mc_program_allocator_init (const hb_mc_config_t *cfg,
@@ -135,7 +154,8 @@ __attribute__((warn_unused_result))
 static int hb_mc_device_wait_for_tile_group_finish_any(hb_mc_device_t *device);
 
 __attribute__((warn_unused_result))
-static hb_mc_epa_t hb_mc_tile_group_get_finish_signal_addr(hb_mc_tile_group_t *tg);  
+static hb_mc_epa_t hb_mc_tile_group_get_finish_signal_addr(const hb_mc_grid_t *grid,
+                                                           const hb_mc_tile_group_t *tg);
 
 __attribute__((warn_unused_result))
 static hb_mc_idx_t hb_mc_get_tile_id (hb_mc_coordinate_t origin, hb_mc_dimension_t dim, hb_mc_coordinate_t coord); 
@@ -154,29 +174,34 @@ static int hb_mc_device_tiles_unfreeze (hb_mc_device_t *device,
 __attribute__((warn_unused_result))
 static int hb_mc_tile_set_symbol_val (hb_mc_manycore_t *mc,
                                       const hb_mc_eva_map_t *map,
-                                      const unsigned char* bin,
-                                      size_t bin_size,
+                                      const hb_mc_program_image_t *image,
                                       const hb_mc_coordinate_t *coord,
                                       const char* symbol,
                                       const uint32_t *val);
 
+__attribute__((warn_unused_result))
+static int hb_mc_tile_symbol_iovec_push (hb_mc_device_t *device,
+                                         const hb_mc_grid_t *grid,
+                                         const hb_mc_eva_map_t *map,
+                                         const hb_mc_coordinate_t *coord,
+                                         hb_mc_cuda_symbol_t symbol,
+                                         uint32_t *val,
+                                         std::vector<hb_mc_npa_iovec_t> &iov);
+
 __attribute__((warn_unused_result))
 static int hb_mc_device_tiles_set_config_symbols (hb_mc_device_t *device,
+                                                  const hb_mc_grid_t *grid,
                                                   const hb_mc_eva_map_t *map, 
                                                   hb_mc_coordinate_t origin,
                                                   hb_mc_coordinate_t tg_id,
-                                                  hb_mc_dimension_t tg_dim, 
-                                                  hb_mc_dimension_t grid_dim,
                                                   const hb_mc_coordinate_t *tiles,
                                                   uint32_t num_tiles);
 
 __attribute__((warn_unused_result))
 static int hb_mc_device_tiles_set_runtime_symbols (hb_mc_device_t *device,
+                                                   const hb_mc_grid_t *grid,
                                                    const hb_mc_eva_map_t *map, 
-                                                   uint32_t argc, 
-                                                   hb_mc_eva_t args_eva,
                                                    hb_mc_npa_t finish_signal_npa, 
-                                                   hb_mc_eva_t kernel_eva,      
                                                    const hb_mc_coordinate_t *tiles,
                                                    uint32_t num_tiles); 
 
@@ -187,6 +212,31 @@ static int hb_mc_device_tiles_set_runtime_symbols (hb_mc_device_t *device,
 
 
 
+/**
+ * Names of the symbols the runtime writes into every tile, indexed by hb_mc_cuda_symbol_t.
+ */
+static const char *hb_mc_cuda_symbol_names[HB_MC_CUDA_SYMBOL_MAX] = {
+        "__bsg_grp_org_x",
+        "__bsg_grp_org_y",
+        "__bsg_x",
+        "__bsg_y",
+        "__bsg_id",
+        "__bsg_tile_group_id_x",
+        "__bsg_tile_group_id_y",
+        "__bsg_tile_group_id",
+        "__bsg_grid_dim_x",
+        "__bsg_grid_dim_y",
+        "cuda_finish_signal_val",
+        "cuda_kernel_not_loaded_val",
+        "cuda_argc",
+        "cuda_argv_ptr",
+        "cuda_finish_signal_addr",
+        "cuda_kernel_ptr",
+};
+
+
+
+
 /**
  * Takes in a hb_mc_device_t struct and initializes a mesh of tile in the Manycore device.
  * @param[in]  device        Pointer to device
@@ -290,7 +340,7 @@ static int hb_mc_device_mesh_exit (hb_mc_mesh_t *mesh) {
 /**
  * Enqueues and schedules a kernel to be run on device
  * Takes the grid size, tile group dimensions, kernel name, argc, argv* and the
- * finish signal address, calls hb_mc_tile_group_enqueue to initialize all tile groups for grid.
+ * finish signal address, calls hb_mc_grid_enqueue to initialize all tile groups for grid.
  * @param[in]  device        Pointer to device
  * @param[in]  grid_dim      X/Y dimensions of the grid to be initialized
  * @param[in]  tg_dim        X/Y dimensions of tile groups in grid
@@ -305,43 +355,30 @@ int hb_mc_kernel_enqueue (hb_mc_device_t *device,
                                const char* name,
                                uint32_t argc,
                                const uint32_t *argv) {
-        int error; 
-        for (hb_mc_idx_t tg_id_x = 0; tg_id_x < hb_mc_dimension_get_x(grid_dim); tg_id_x ++) { 
-                for (hb_mc_idx_t tg_id_y = 0; tg_id_y < hb_mc_dimension_get_y(grid_dim); tg_id_y ++) { 
-                        hb_mc_coordinate_t tg_id = hb_mc_coordinate(tg_id_x, tg_id_y);
-                        error = hb_mc_tile_group_enqueue(device, device->num_grids, tg_id, grid_dim, tg_dim, name, argc, argv); 
-                        if (error != HB_MC_SUCCESS) { 
-                                bsg_pr_err("%s: failed to initialize tile group (%d,%d) of grid %d.\n",
-                                           __func__,
-                                           tg_id_x, tg_id_y,
-                                           device->num_grids);
-                                return HB_MC_UNINITIALIZED;
-                        }
-                }
-        }
-        device->num_grids ++;
-        return HB_MC_SUCCESS;
+        hb_mc_kernel_t args;
+        args.argc = argc;
+        args.argv = argv;
+        args.args_size = argc * sizeof(uint32_t);
+        args.nrefs = 0;
+        args.refs = NULL;
+
+        return hb_mc_grid_enqueue(device, grid_dim, tg_dim, name, &args);
 }
 
 
 
 
-
 /**
- * Initializes the tile group structure of a device 
- * @param[in]  device        Pointer to device
+ * Initializes a kernel argument list with no arguments.
+ * @param[in]  args          Pointer to kernel argument list
  * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
  */
-static int hb_mc_device_tile_groups_init (hb_mc_device_t *device) { 
-        
-        device->tile_group_capacity = 1;
-        device->tile_groups = (hb_mc_tile_group_t *) malloc (device->tile_group_capacity * sizeof(hb_mc_tile_group_t));
-        if (device->tile_groups == NULL) {
-                bsg_pr_err("%s: failed to allocated space for list of tile groups.\n", __func__);
-                return HB_MC_NOMEM;
+int hb_mc_kernel_args_init (hb_mc_kernel_args_t *args) {
+        if (args == NULL) {
+                bsg_pr_err("%s: calling init on null argument list.\n", __func__);
+                return HB_MC_INVALID;
         }
-        memset (device->tile_groups, 0, device->tile_group_capacity * sizeof(hb_mc_tile_group_t));
-        device->num_tile_groups = 0;
+        memset(args, 0, sizeof(*args));
         return HB_MC_SUCCESS;
 }
 
@@ -349,331 +386,327 @@ static int hb_mc_device_tile_groups_init (hb_mc_device_t *device) {
 
 
 /**
- * Destructs the tile group structure of a device 
- * @param[in]  device        Pointer to device
+ * Frees the memory held by a kernel argument list.
+ * @param[in]  args          Pointer to kernel argument list
  * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
  */
-static int hb_mc_device_tile_groups_exit (hb_mc_device_t *device) { 
-        int error;
-
-        if (!device) { 
-                bsg_pr_err("%s: calling exit on tile group list in null device.\n", __func__); 
+int hb_mc_kernel_args_exit (hb_mc_kernel_args_t *args) {
+        if (args == NULL) {
+                bsg_pr_err("%s: calling exit on null argument list.\n", __func__);
                 return HB_MC_INVALID;
         }
+        free(args->argv);
+        free(args->data);
+        free(args->refs);
+        memset(args, 0, sizeof(*args));
+        return HB_MC_SUCCESS;
+}
 
 
-        if (!device->tile_groups) { 
-                bsg_pr_err("%s: calling exit on null tile group list.\n", __func__); 
-                return HB_MC_INVALID;
-        }
 
 
-        for (int tg_num = 0; tg_num < device->num_tile_groups; tg_num++) { 
-                error = hb_mc_tile_group_exit(&(device->tile_groups[tg_num])); 
-                if ( error != HB_MC_SUCCESS) { 
-                        bsg_pr_err("%s: failed to remove tile group struct.\n", __func__);
-                        return error;
+/**
+ * Appends one word to the argv of a kernel argument list.
+ * @param[in]  args          Pointer to kernel argument list
+ * @param[in]  val           Argument word
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+__attribute__((warn_unused_result))
+static int hb_mc_kernel_args_push_word (hb_mc_kernel_args_t *args, uint32_t val) {
+        if (args->argc == args->argv_capacity) {
+                uint32_t capacity = args->argv_capacity ? 2 * args->argv_capacity : 8;
+                uint32_t *argv = (uint32_t *) realloc (args->argv, capacity * sizeof(uint32_t));
+                if (argv == NULL) {
+                        bsg_pr_err("%s: failed to allocate space for kernel argument list.\n", __func__);
+                        return HB_MC_NOMEM;
                 }
+                args->argv = argv;
+                args->argv_capacity = capacity;
         }
-
-
-        // Free tile group list 
-        const hb_mc_tile_group_t *tile_groups;
-        tile_groups = device->tile_groups;
-        if (!tile_groups) { 
-                bsg_pr_err("%s: calling exit on device with null tile group list.\n", __func__);
-                return HB_MC_INVALID;
-        } else {
-                free ((hb_mc_tile_group_t *) tile_groups); 
-                device->tile_groups = NULL;
-        }
-
+        args->argv[args->argc++] = val;
         return HB_MC_SUCCESS;
 }
 
 
 
 
-
 /**
- * Checks if a groups of tiles starting from a specific origin are all free or not.
- * @param[in]  device        Pointer to device
- * @param[in]  origin        Origin of the group of tiles to check for availability
- * @param[in]  dim           Dimension of the group of tiles in question
- * @return HB_MC_SUCCESS if all tiles in the group are free, otherwise an error code is returned. 
+ * Appends a 32-bit integer argument to a kernel argument list.
+ * @param[in]  args          Pointer to kernel argument list
+ * @param[in]  val           Argument value
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
  */
-static int hb_mc_device_tiles_are_free (hb_mc_device_t *device,
-                                        hb_mc_coordinate_t origin,
-                                        hb_mc_dimension_t dim) { 
-        if (hb_mc_coordinate_get_x(origin) + hb_mc_dimension_get_x(dim) > 
-            hb_mc_coordinate_get_x(device->mesh->origin) + hb_mc_dimension_get_x(device->mesh->dim)) { 
-                bsg_pr_err ("%s: a %dx%d tile group starting from origin (%d,%d) \
-                              does not fit in %dx%d device mesh. Check X dimension or origin.\n",
-                            __func__, 
-                            hb_mc_dimension_get_x(dim), hb_mc_dimension_get_y(dim),
-                            hb_mc_coordinate_get_x(origin), hb_mc_coordinate_get_y(origin), 
-                            hb_mc_dimension_get_x(device->mesh->dim), hb_mc_dimension_get_y(device->mesh->dim)); 
-                return HB_MC_INVALID;
-        }
-                                
-        if (hb_mc_coordinate_get_y(origin) + hb_mc_dimension_get_y(dim) >
-            hb_mc_coordinate_get_y(device->mesh->origin) + hb_mc_dimension_get_y(device->mesh->dim)) { 
-                bsg_pr_err ("%s: a %dx%d tile group starting from origin (%d,%d) \
-                             does not fit in %dx%d device mesh. Check Y dimension or origin.\n",
-                            __func__, 
-                            hb_mc_dimension_get_x(dim), hb_mc_dimension_get_y(dim),
-                            hb_mc_coordinate_get_x(origin), hb_mc_coordinate_get_y(origin), 
-                            hb_mc_dimension_get_x(device->mesh->dim), hb_mc_dimension_get_y(device->mesh->dim)); 
-                return HB_MC_INVALID;
-        }
+int hb_mc_kernel_args_push_u32 (hb_mc_kernel_args_t *args, uint32_t val) {
+        return hb_mc_kernel_args_push_word(args, val);
+}
 
 
-        hb_mc_coordinate_t tile_coord;
-        hb_mc_idx_t tile_id;
-                        
-        // Iterate over a tg->dim.x * tg->dim.y square of tiles starting from the (org_x,org_y)
-        // checking to see if all tiles are free so they can be allocated to tile group
-        for (hb_mc_idx_t x = hb_mc_coordinate_get_x(origin);
-             x < hb_mc_coordinate_get_x(origin) + hb_mc_dimension_get_x(dim); x++){
-                for (hb_mc_idx_t y = hb_mc_coordinate_get_y(origin);
-                     y < hb_mc_coordinate_get_y(origin) + hb_mc_dimension_get_y(dim); y++){
-                        tile_id = hb_mc_get_tile_id (device->mesh->origin, device->mesh->dim, hb_mc_coordinate(x, y)); 
-                        if (device->mesh->tiles[tile_id].status != HB_MC_TILE_STATUS_FREE) 
-                                return HB_MC_FAIL;
-                }
-        }
 
-        return HB_MC_SUCCESS;
+
+/**
+ * Appends a device pointer argument to a kernel argument list.
+ * @param[in]  args          Pointer to kernel argument list
+ * @param[in]  ptr           Eva address of device memory
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_kernel_args_push_ptr (hb_mc_kernel_args_t *args, hb_mc_eva_t ptr) {
+        return hb_mc_kernel_args_push_word(args, ptr);
 }
 
 
 
 
 /**
- * Takes in a device and tile group and an origin, initializes tile group
- * and sends packets to all tiles in tile group to set their symbols. 
- * @param[in]  device        Pointer to device
- * @param[in]  tg            Pointer to tile group
- * @param[in]  origin        Origin coordinates of tile group
+ * Copies a struct into the argument block of a kernel argument list and
+ * appends an argument that points to the copy.
+ * @param[in]  args          Pointer to kernel argument list
+ * @param[in]  data          Host copy of the struct
+ * @param[in]  sz            Size of the struct in bytes
  * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
  */
-static int hb_mc_tile_group_initialize_tiles (hb_mc_device_t *device,
-                                              hb_mc_tile_group_t *tg,
-                                              hb_mc_coordinate_t origin) { 
-
+__attribute__((warn_unused_result))
+static int hb_mc_kernel_args_push_copy (hb_mc_kernel_args_t *args,
+                                        const void *data, size_t sz) {
         int error;
 
-        tg->origin = origin;
-
-        error = hb_mc_origin_eva_map_init (tg->map, origin); 
-        if (error != HB_MC_SUCCESS) { 
-                bsg_pr_err("%s: failed to initialize grid %d tile group (%d,%d) eva map origin.\n",
-                           __func__,
-                           tg->grid_id,
-                           hb_mc_coordinate_get_x(tg->id), hb_mc_coordinate_get_y(tg->id));
-                return error;
+        // The copy is 8-byte aligned, and the argument word holds its offset
+        size_t offset = (args->data_size + 7) & ~(size_t) 7;
+        if (offset + sz > args->data_capacity) {
+                size_t capacity = args->data_capacity ? args->data_capacity : 64;
+                while (capacity < offset + sz)
+                        capacity *= 2;
+                unsigned char *buf = (unsigned char *) realloc (args->data, capacity);
+                if (buf == NULL) {
+                        bsg_pr_err("%s: failed to allocate space for kernel struct argument.\n", __func__);
+                        return HB_MC_NOMEM;
+                }
+                args->data = buf;
+                args->data_capacity = capacity;
         }
 
+        if (args->nrefs == args->refs_capacity) {
+                uint32_t capacity = args->refs_capacity ? 2 * args->refs_capacity : 4;
+                uint32_t *refs = (uint32_t *) realloc (args->refs, capacity * sizeof(uint32_t));
+                if (refs == NULL) {
+                        bsg_pr_err("%s: failed to allocate space for kernel struct argument.\n", __func__);
+                        return HB_MC_NOMEM;
+                }
+                args->refs = refs;
+                args->refs_capacity = capacity;
+        }
 
+        error = hb_mc_kernel_args_push_word(args, offset);
+        if (error != HB_MC_SUCCESS)
+                return error;
 
-        // Define a list of tiles who's configuration symbols are to be set
-        uint32_t num_tiles = hb_mc_dimension_to_length(tg->dim); 
-        hb_mc_coordinate_t tile_list[num_tiles];
-        
-        hb_mc_idx_t tg_tile_id = 0;
-
-        // Set tiles variables inside hb_mc_device_t struct
-        // And prepare a list of tile coordinates who's config symbols are to be set 
-        for (hb_mc_idx_t x = hb_mc_coordinate_get_x(origin);
-             x < hb_mc_coordinate_get_x(origin) + hb_mc_dimension_get_x(tg->dim); x++){
-                for (hb_mc_idx_t y = hb_mc_coordinate_get_y(origin);
-                     y < hb_mc_coordinate_get_y(origin) + hb_mc_dimension_get_y(tg->dim); y++){
-                        hb_mc_idx_t device_tile_id = hb_mc_get_tile_id (device->mesh->origin, device->mesh->dim, hb_mc_coordinate(x, y));
-
-                        device->mesh->tiles[device_tile_id].origin = origin;
-                        device->mesh->tiles[device_tile_id].tile_group_id = tg->id;
-                        device->mesh->tiles[device_tile_id].status = HB_MC_TILE_STATUS_BUSY;
+        memset(&args->data[args->data_size], 0, offset - args->data_size);
+        memcpy(&args->data[offset], data, sz);
+        args->data_size = offset + sz;
+        args->refs[args->nrefs++] = args->argc - 1;
 
+        return HB_MC_SUCCESS;
+}
 
-                        tile_list[tg_tile_id] = hb_mc_coordinate (x, y); 
-                        tg_tile_id ++;
-                }
-        }
 
 
 
+/**
+ * Appends a struct argument, passed by value, to a kernel argument list.
+ * Structs of up to two words are passed in argv. Larger structs are
+ * copied into the argument block and passed by reference, as the RV32
+ * calling convention does for aggregates.
+ * @param[in]  args          Pointer to kernel argument list
+ * @param[in]  data          Host copy of the struct
+ * @param[in]  sz            Size of the struct in bytes
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_kernel_args_push_struct (hb_mc_kernel_args_t *args,
+                                   const void *data, size_t sz) {
+        int error;
 
-        // Set the configuration symbols of all tiles inside tile group
-        error = hb_mc_device_tiles_set_config_symbols(device,
-                                                      tg->map,
-                                                      tg->origin,
-                                                      tg->id,
-                                                      tg->dim,
-                                                      tg->grid_dim,
-                                                      tile_list,
-                                                      num_tiles);
-        if (error != HB_MC_SUCCESS) { 
-                bsg_pr_err("%s: failed to set grid %d tile group (%d,%d) tiles configuration symbols.\n", 
-                           __func__,
-                           tg->grid_id,
-                           hb_mc_coordinate_get_x (tg->id),
-                           hb_mc_coordinate_get_y (tg->id));
-                return error;
+        if (data == NULL || sz == 0) {
+                bsg_pr_err("%s: invalid struct argument.\n", __func__);
+                return HB_MC_INVALID;
         }
 
+        // Small structs are passed in one or two argument words
+        if (sz <= 2 * sizeof(uint32_t)) {
+                uint32_t words[2] = {0, 0};
+                memcpy(words, data, sz);
+                for (size_t i = 0; i < (sz + sizeof(uint32_t) - 1) / sizeof(uint32_t); i++) {
+                        error = hb_mc_kernel_args_push_word(args, words[i]);
+                        if (error != HB_MC_SUCCESS)
+                                return error;
+                }
+                return HB_MC_SUCCESS;
+        }
 
+        return hb_mc_kernel_args_push_copy(args, data, sz);
+}
 
-        tg->status = HB_MC_TILE_GROUP_STATUS_ALLOCATED;
 
 
-        bsg_pr_dbg("%s: Grid %d: %dx%d tile group (%d,%d) allocated at origin (%d,%d).\n", 
-                   __func__,
-                   tg-> grid_id,
-                   hb_mc_dimension_get_x(tg->dim), hb_mc_dimension_get_y(tg->dim),
-                   hb_mc_coordinate_get_x(tg->id), hb_mc_coordinate_get_y(tg->id),
-                   hb_mc_coordinate_get_x(tg->origin), hb_mc_coordinate_get_y(tg->origin));     
 
+/**
+ * Appends a pointer to a copy of a struct to a kernel argument list.
+ * The struct is copied into the argument block whatever its size.
+ * @param[in]  args          Pointer to kernel argument list
+ * @param[in]  data          Host copy of the struct
+ * @param[in]  sz            Size of the struct in bytes
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_kernel_args_push_struct_ptr (hb_mc_kernel_args_t *args,
+                                       const void *data, size_t sz) {
+        if (data == NULL || sz == 0) {
+                bsg_pr_err("%s: invalid struct argument.\n", __func__);
+                return HB_MC_INVALID;
+        }
 
-        return HB_MC_SUCCESS;
+        return hb_mc_kernel_args_push_copy(args, data, sz);
 }
 
 
 
 
-
-
 /**
- * Searches for a free tile group inside the device mesh and allocoates it,
- * and sets the dimensions, origin, and id of tile group.
+ * Enqueues and schedules a kernel to be run on device with a typed
+ * argument list. The argv words and the struct payloads are packed into a
+ * single argument block: argv first, then the payloads starting at the
+ * next 8-byte boundary.
  * @param[in]  device        Pointer to device
- * @param[in]  tg            Pointer to tile group
+ * @param[in]  grid_dim      X/Y dimensions of the grid to be initialized
+ * @param[in]  tg_dim        X/Y dimensions of tile groups in grid
+ * @param[in]  name          Kernel name to be executed on tile groups in grid
+ * @param[in]  args          Kernel argument list
  * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
  */
-static int hb_mc_tile_group_allocate_tiles (hb_mc_device_t *device,
-                                            hb_mc_tile_group_t *tg){
+int hb_mc_kernel_enqueue_args (hb_mc_device_t *device,
+                               hb_mc_dimension_t grid_dim,
+                               hb_mc_dimension_t tg_dim,
+                               const char *name,
+                               const hb_mc_kernel_args_t *args) {
         int error;
-        if (hb_mc_dimension_get_x(tg->dim) > hb_mc_dimension_get_x(device->mesh->dim)){
-                bsg_pr_err("%s: tile group X dimension (%d) larger than mesh X dimension (%d).\n",
-                           __func__,
-                           hb_mc_dimension_get_x(tg->dim),
-                           hb_mc_dimension_get_x(device->mesh->dim));
-                return HB_MC_INVALID;
-        }
-        if (hb_mc_dimension_get_y(tg->dim) > hb_mc_dimension_get_y(device->mesh->dim)){
-                bsg_pr_err("%s: tile group Y dimension (%d) larger than mesh Y dimension (%d).\n",
-                           __func__,
-                           hb_mc_dimension_get_y(tg->dim),
-                           hb_mc_dimension_get_y(device->mesh->dim));
-                return HB_MC_INVALID;
-        }
+        hb_mc_kernel_t block;
 
-        hb_mc_coordinate_t tile_coord;
-        hb_mc_idx_t tile_id; 
+        // The block is a whole number of words
+        size_t argv_size = ((args->argc * sizeof(uint32_t)) + 7) & ~(size_t) 7;
+        size_t data_size = (args->data_size + 3) & ~(size_t) 3;
+        size_t size = argv_size + data_size;
 
-        // Iterate over the entire mesh as tile (org_y, org_x) being the origin of the new tile group to allcoate 
-        for (hb_mc_idx_t org_y = hb_mc_coordinate_get_y(device->mesh->origin);
-             org_y <= (hb_mc_coordinate_get_y(device->mesh->origin)
-                       + hb_mc_dimension_get_y(device->mesh->dim)
-                       - hb_mc_dimension_get_y(tg->dim)); org_y++){
-                for (hb_mc_idx_t org_x = hb_mc_coordinate_get_x(device->mesh->origin);
-                     org_x <= (hb_mc_coordinate_get_x(device->mesh->origin)
-                               + hb_mc_dimension_get_x(device->mesh->dim)
-                               - hb_mc_dimension_get_x(tg->dim)); org_x++){
+        unsigned char *buf = (unsigned char *) calloc (1, size ? size : sizeof(uint32_t));
+        if (buf == NULL) {
+                bsg_pr_err("%s: failed to allocate space for kernel argument block.\n", __func__);
+                return HB_MC_NOMEM;
+        }
 
+        uint32_t *argv = (uint32_t *) buf;
+        if (args->argc)
+                memcpy(argv, args->argv, args->argc * sizeof(uint32_t));
+        if (args->data_size)
+                memcpy(&buf[argv_size], args->data, args->data_size);
 
-                        // Search if a tg->dim.x * tg->dim.y group of tiles starting from (org_x,org_y) are all free
-                        if (hb_mc_device_tiles_are_free(device, hb_mc_coordinate(org_x, org_y), tg->dim) == HB_MC_SUCCESS) { 
+        // Make payload offsets relative to the start of the block
+        for (uint32_t i = 0; i < args->nrefs; i++)
+                argv[args->refs[i]] += argv_size;
 
-                                // Found a free group of tiles at origin (org_x, org_y), now initialize
-                                // all these tiles by sending packets and claiming them for this tile group
-                                error = hb_mc_tile_group_initialize_tiles (device, tg, hb_mc_coordinate(org_x, org_y));
-                                if (error != HB_MC_SUCCESS) { 
-                                        bsg_pr_err("%s: failed to initialize mesh tiles for grid %d tile group (%d,%d).\n",
-                                                   __func__,
-                                                   tg->grid_id,
-                                                   hb_mc_coordinate_get_x(tg->id),
-                                                   hb_mc_coordinate_get_y(tg->id)); 
-                                        return error;
-                                }
-                                return HB_MC_SUCCESS;
-                        }
-                }
-        }
-        return HB_MC_NOTFOUND;
+        block.argc = args->argc;
+        block.argv = argv;
+        block.args_size = size;
+        block.nrefs = args->nrefs;
+        block.refs = args->refs;
+
+        error = hb_mc_grid_enqueue(device, grid_dim, tg_dim, name, &block);
+        free(buf);
+        return error;
 }
 
 
 
 
 /**
- * Takes the kernel name, argc, argv* and the finish signal address, and initializes a kernel and passes it to tilegroup.
+ * Initializes a grid to run a kernel with an argument block, and all of its tile groups.
+ * The kernel, its argument block and the runtime symbol addresses are resolved
+ * once and shared by the tile groups, and room for all tile groups is reserved at once.
  * @param[in]  device        Pointer to device
- * @parma[in]  grid_id       Id of grid to which the tile group belongs
- * @param[in]  tg_id         Id of tile group
- * @param[in]  grid_dim      X/Y dimensions of grid to which tile group belongs
- * @parma[in]  dim           X/Y dimensions of tie pool (mesh)
- * @param[in]  name          Kernel name that is to be executed on tile group
- * @param[in]  argc          Number of input arguments to the kernel
- * @param[in]  argv          List of input arguments to the kernel
+ * @param[in]  grid_dim      X/Y dimensions of the grid to be initialized
+ * @param[in]  tg_dim        X/Y dimensions of tile groups in grid
+ * @param[in]  name          Kernel name to be executed on tile groups in grid
+ * @param[in]  args          Kernel argument block (name and finish_signal_addr are unused)
  * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
  */
-static int hb_mc_tile_group_enqueue (hb_mc_device_t* device,
-                                     grid_id_t grid_id,
-                                     hb_mc_coordinate_t tg_id,
-                                     hb_mc_dimension_t grid_dim,
-                                     hb_mc_dimension_t dim,
-                                     const char* name,
-                                     uint32_t argc,
-                                     const uint32_t *argv) {
-
-        if (device->num_tile_groups == device->tile_group_capacity) { 
-                device->tile_group_capacity *= 2;
-                device->tile_groups = (hb_mc_tile_group_t *) realloc (device->tile_groups, device->tile_group_capacity * sizeof(hb_mc_tile_group_t));
-                if (device->tile_groups == NULL) {
-                        bsg_pr_err("%s: failed to allocate space for hb_mc_tile_group_t structs.\n", __func__);
+static int hb_mc_grid_enqueue (hb_mc_device_t *device,
+                               hb_mc_dimension_t grid_dim,
+                               hb_mc_dimension_t tg_dim,
+                               const char* name,
+                               const hb_mc_kernel_t *args) {
+        int error; 
+
+        uint32_t num_tile_groups = hb_mc_dimension_to_length(grid_dim);
+        if (num_tile_groups == 0 || hb_mc_dimension_to_length(tg_dim) == 0) {
+                bsg_pr_err("%s: grid and tile group dimensions must be non-zero.\n", __func__);
+                return HB_MC_INVALID;
+        }
+
+        if (device->num_queued_grids == device->grid_capacity) {
+                uint32_t capacity = device->grid_capacity * 2;
+                hb_mc_grid_t *grids = (hb_mc_grid_t *) realloc (device->grids, capacity * sizeof(hb_mc_grid_t));
+                if (grids == NULL) {
+                        bsg_pr_err("%s: failed to allocate space for hb_mc_grid_t structs.\n", __func__);
                         return HB_MC_NOMEM;
                 }
+                device->grids = grids;
+                device->grid_capacity = capacity;
         }
-        
 
-        hb_mc_tile_group_t* tg = &device->tile_groups[device->num_tile_groups];
-        tg->dim = dim;
-        tg->origin = device->mesh->origin;
-        tg->id = tg_id;
-        tg->grid_id = grid_id;
-        tg->grid_dim = grid_dim;
-        tg->argc = argc;
-        tg->status = HB_MC_TILE_GROUP_STATUS_INITIALIZED;
-
-        tg->map = (hb_mc_eva_map_t *) malloc (sizeof(hb_mc_eva_map_t)); 
-        if (tg->map == NULL) { 
-                bsg_pr_err ("%s: failed to allocate space for tile group hb_mc_eva_map_t struct map.\n", __func__);
-                return HB_MC_NOMEM;
-        }
-        int error = hb_mc_origin_eva_map_init (tg->map, tg->origin); 
-        if (error != HB_MC_SUCCESS) { 
-                bsg_pr_err("%s: failed to initialize grid %d tile group (%d,%d) eva map origin.\n",
-                           __func__,
-                           tg->grid_id,
-                           tg->id.x, tg->id.y); 
-                return HB_MC_UNINITIALIZED;
+        // Reserve space for every tile group of the grid at once
+        if (device->num_tile_groups + num_tile_groups > device->tile_group_capacity) {
+                uint32_t capacity = device->tile_group_capacity * 2;
+                if (capacity < device->num_tile_groups + num_tile_groups)
+                        capacity = device->num_tile_groups + num_tile_groups;
+                hb_mc_tile_group_t *tile_groups = (hb_mc_tile_group_t *) realloc (device->tile_groups, capacity * sizeof(hb_mc_tile_group_t));
+                if (tile_groups == NULL) {
+                        bsg_pr_err("%s: failed to allocate space for hb_mc_tile_group_t structs.\n", __func__);
+                        return HB_MC_NOMEM;
+                }
+                device->tile_groups = tile_groups;
+                device->tile_group_capacity = capacity;
         }
-        
 
-        error = hb_mc_tile_group_kernel_init (tg, name, argc, argv); 
-        if (error != HB_MC_SUCCESS) { 
-                bsg_pr_err("%s: failed to initialize tile group's kernel\n", __func__);
+        hb_mc_grid_t *grid = &device->grids[device->num_queued_grids];
+        grid->id = device->num_grids;
+        grid->dim = grid_dim;
+        grid->tg_dim = tg_dim;
+        grid->args_eva = 0;
+        grid->first_tile_group = device->num_tile_groups;
+        grid->num_tile_groups = num_tile_groups;
+        grid->num_launched = 0;
+        grid->num_finished = 0;
+
+        error = hb_mc_grid_kernel_init (device, grid, name, args);
+        if (error != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to initialize grid %d kernel.\n", __func__, grid->id);
                 return error;
         }
 
-                        
-        device->num_tile_groups += 1;
-        
-        bsg_pr_dbg("%s: Grid %d: %dx%d tile group (%d,%d) initialized.\n", 
+        hb_mc_tile_group_t *tg = &device->tile_groups[grid->first_tile_group];
+        for (hb_mc_idx_t tg_id_x = 0; tg_id_x < hb_mc_dimension_get_x(grid_dim); tg_id_x ++) { 
+                for (hb_mc_idx_t tg_id_y = 0; tg_id_y < hb_mc_dimension_get_y(grid_dim); tg_id_y ++, tg ++) { 
+                        tg->id = hb_mc_coordinate(tg_id_x, tg_id_y);
+                        tg->origin = device->mesh->origin;
+                        tg->status = HB_MC_TILE_GROUP_STATUS_INITIALIZED;
+                        tg->grid = device->num_queued_grids;
+                }
+        }
+
+        device->num_tile_groups += num_tile_groups;
+        device->num_queued_grids ++;
+        device->num_grids ++;
+
+        bsg_pr_dbg("%s: Grid %d: %dx%d grid of %dx%d tile groups initialized.\n", 
                    __func__,
-                   tg->grid_id,
-                   hb_mc_dimension_get_x(tg->dim), hb_mc_dimension_get_y(tg->dim),
-                   hb_mc_coordinate_get_x(tg->id), hb_mc_coordinate_get_y(tg->id)) ;
+                   grid->id,
+                   hb_mc_dimension_get_x(grid->dim), hb_mc_dimension_get_y(grid->dim),
+                   hb_mc_dimension_get_x(grid->tg_dim), hb_mc_dimension_get_y(grid->tg_dim));
 
         return HB_MC_SUCCESS;
 }
@@ -682,132 +715,403 @@ static int hb_mc_tile_group_enqueue (hb_mc_device_t* device,
 
 
 /**
- * Takes in a kernel name, argument count and list of arguments 
- * and initializes a hb_mc_kernel_t struct for the tile group.
- * @param[in]  tg            Pointer to tile group. 
- * @param[in]  name          Kernel name that is to be executed on tile group
- * @param[in]  argc          Number of input arguments to the kernel
- * @param[in]  argv          List of input arguments to the kernel
+ * Takes in a kernel name and argument block and initializes the kernel shared
+ * by all tile groups of a grid. Resolves the kernel and the runtime symbols
+ * of the device's program, so tile groups need not search the binary.
+ * @param[in]  device        Pointer to device
+ * @param[in]  grid          Pointer to grid
+ * @param[in]  name          Kernel name that is to be executed on the grid
+ * @param[in]  args          Argument block of the kernel
  * @return HB_MC_SUCCESS if successful, otherwise an error code is returned. 
  */
-__attribute__((warn_unused_result))
-static int hb_mc_tile_group_kernel_init (hb_mc_tile_group_t *tg, 
-                                         const char* name, 
-                                         uint32_t argc, 
-                                         const uint32_t *argv) {
-        tg->kernel = (hb_mc_kernel_t *) malloc (sizeof(hb_mc_kernel_t));
-        if (tg->kernel == NULL) { 
-                bsg_pr_err("%s: failed to allocated space for hb_mc_kernel_t struct.\n", __func__);
-                return HB_MC_NOMEM;
+static int hb_mc_grid_kernel_init (hb_mc_device_t *device,
+                                   hb_mc_grid_t *grid,
+                                   const char* name,
+                                   const hb_mc_kernel_t *args) {
+        int error;
+        hb_mc_kernel_t *kernel = &grid->kernel;
+
+        memset (kernel, 0, sizeof(*kernel));
+
+        if (!device->program) {
+                bsg_pr_err("%s: no program has been initialized.\n", __func__);
+                return HB_MC_UNINITIALIZED;
+        }
+
+        error = hb_mc_program_image_symbol_to_eva (device->program->image, name, &grid->kernel_eva); 
+        if (error != HB_MC_SUCCESS) { 
+                bsg_pr_err("%s: invalid kernel name %s for grid %d.\n",
+                           __func__, name, grid->id);
+                return error;
+        }       
+
+        error = hb_mc_grid_symbols_init (device, grid);
+        if (error != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to resolve runtime symbols for grid %d.\n",
+                           __func__, grid->id);
+                return error;
         }
-        tg->kernel->name = strdup (name); 
-        if (tg->kernel->name == NULL) { 
-                bsg_pr_err("%s: failed to allocate space on device for tile group's kernel's name.\n", __func__);
+
+        kernel->name = strdup (name); 
+        if (kernel->name == NULL) { 
+                bsg_pr_err("%s: failed to allocate space for grid's kernel's name.\n", __func__);
                 return HB_MC_NOMEM;
         }
-        tg->kernel->argc = argc;
-        uint32_t *cpy = (uint32_t *) malloc (tg->kernel->argc * sizeof(uint32_t)); 
+        kernel->argc = args->argc;
+        kernel->args_size = args->args_size;
+        uint32_t *cpy = (uint32_t *) malloc (kernel->args_size ? kernel->args_size : sizeof(uint32_t)); 
         if (cpy == NULL) { 
-                bsg_pr_err("%s: failed to allocate space on devcie for kernel's argument list.\n", __func__); 
+                bsg_pr_err("%s: failed to allocate space for kernel's argument list.\n", __func__); 
+                hb_mc_grid_kernel_exit (kernel);
                 return HB_MC_NOMEM;
         }
-        memcpy (cpy, argv, argc * sizeof(uint32_t));    
-        tg->kernel->argv = (const uint32_t *) cpy;
-        tg->kernel->finish_signal_addr = hb_mc_tile_group_get_finish_signal_addr(tg); 
+        if (kernel->args_size)
+                memcpy (cpy, args->argv, kernel->args_size);    
+        kernel->argv = (const uint32_t *) cpy;
+
+        kernel->nrefs = args->nrefs;
+        if (args->nrefs) {
+                uint32_t *refs = (uint32_t *) malloc (args->nrefs * sizeof(uint32_t));
+                if (refs == NULL) {
+                        bsg_pr_err("%s: failed to allocate space for kernel's argument list.\n", __func__);
+                        hb_mc_grid_kernel_exit (kernel);
+                        return HB_MC_NOMEM;
+                }
+                memcpy (refs, args->refs, args->nrefs * sizeof(uint32_t));
+                kernel->refs = (const uint32_t *) refs;
+        }
+
+        // Each tile group signals at its own offset from the grid's base address
+        kernel->finish_signal_addr = HB_MC_CUDA_HOST_FINISH_SIGNAL_BASE_ADDR;
+
+        return HB_MC_SUCCESS;
+}
+
+
 
+
+/**
+ * Resolves the addresses of the runtime symbols in the device's program for a grid.
+ * @param[in]  device        Pointer to device
+ * @param[in]  grid          Pointer to grid
+ * @return HB_MC_SUCCESS if successful, otherwise an error code is returned. 
+ */
+static int hb_mc_grid_symbols_init (hb_mc_device_t *device,
+                                    hb_mc_grid_t *grid) {
+        int error;
+
+        // Load images lowered by hb_mc_device_program_lower() list these symbols in order
+        const hb_mc_load_image_t *load_image = hb_mc_program_image_get_load_image (device->program->image);
+        if (load_image
+            && hb_mc_load_image_get_cfg_symbols (load_image, hb_mc_cuda_symbol_names,
+                                                 HB_MC_CUDA_SYMBOL_MAX, grid->symbols) == HB_MC_SUCCESS)
+                return HB_MC_SUCCESS;
+
+        for (int symbol = 0; symbol < HB_MC_CUDA_SYMBOL_MAX; symbol ++) {
+                error = hb_mc_program_image_symbol_to_eva (device->program->image,
+                                                           hb_mc_cuda_symbol_names[symbol], &grid->symbols[symbol]);
+                if (error != HB_MC_SUCCESS) {
+                        bsg_pr_err("%s: failed to acquire %s symbol's eva.\n",
+                                   __func__, hb_mc_cuda_symbol_names[symbol]);
+                        return HB_MC_NOTFOUND;
+                }
+        }
         return HB_MC_SUCCESS;
 }
 
 
 
 
+/**
+ * Frees the name and argument block of a grid's kernel
+ * @param[in]  kernel    Pointer to kernel
+ */
+static void hb_mc_grid_kernel_exit (hb_mc_kernel_t *kernel) {
+        free ((void *) kernel->name);
+        kernel->name = NULL;
+        free ((void *) kernel->argv);
+        kernel->argv = NULL;
+        free ((void *) kernel->refs);
+        kernel->refs = NULL;
+}
+
 
 
 
 /**
- * Launches a tile group by sending packets to each tile in the
- * tile group setting the argc, argv, finish_addr and kernel pointer.
+ * Allocates a grid's argument block on the device and copies it there.
+ * Called once, when the first tile group of the grid launches.
  * @param[in]  device        Pointer to device
- * @parma[in]  tg            Pointer to tile group
- * @return HB_MC_SUCCESS if tile group is launched successfully, otherwise an error code is returned.
+ * @param[in]  grid          Pointer to grid
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
  */
-static int hb_mc_tile_group_launch (hb_mc_device_t *device,
-                                    hb_mc_tile_group_t *tg) {
-
+static int hb_mc_grid_args_init (hb_mc_device_t *device,
+                                 hb_mc_grid_t *grid) {
         int error;
-        const hb_mc_config_t *cfg = hb_mc_manycore_get_config (device->mc); 
-
-        hb_mc_eva_t args_eva;
+        const hb_mc_kernel_t *kernel = &grid->kernel;
 
         // allocate device memory for arguments
-        error = hb_mc_device_malloc (device, (tg->kernel->argc) * sizeof(uint32_t), &args_eva);
+        error = hb_mc_device_malloc (device, kernel->args_size, &grid->args_eva);
         if (error != HB_MC_SUCCESS) {
-                bsg_pr_err("%s: failed to allocate space on device for grid %d tile group (%d,%d) arguments.\n",
-                           __func__,
-                           tg->grid_id,
-                           hb_mc_coordinate_get_x(tg->id), hb_mc_coordinate_get_y(tg->id));
+                bsg_pr_err("%s: failed to allocate space on device for grid %d arguments.\n",
+                           __func__, grid->id);
                 return HB_MC_NOMEM;
         }
 
-        // store the address of argv in the host, to free the 
-        // memory location in the device DRAM after tile group is executed
-        tg->argv_eva = args_eva;
+        // point by-reference struct arguments at their copies in
+        // the argument block, now that its address is known
+        std::vector<uint32_t> relocated;
+        const void *args_src = kernel->argv;
+        if (kernel->nrefs) {
+                relocated.assign(kernel->argv,
+                                 kernel->argv + kernel->args_size / sizeof(uint32_t));
+                for (uint32_t i = 0; i < kernel->nrefs; i++)
+                        relocated[kernel->refs[i]] += grid->args_eva;
+                args_src = relocated.data();
+        }
 
-        // transfer the arguments to dram
-        error = hb_mc_device_memcpy(    device, reinterpret_cast<void *>(args_eva),
-                                        (void *) &(tg->kernel->argv[0]),
-                                        (tg->kernel->argc) * sizeof(uint32_t), HB_MC_MEMCPY_TO_DEVICE);
+        // transfer the whole argument block to dram
+        error = hb_mc_device_memcpy(    device, reinterpret_cast<void *>(grid->args_eva),
+                                        args_src,
+                                        kernel->args_size, HB_MC_MEMCPY_TO_DEVICE);
         if (error != HB_MC_SUCCESS) {
-                bsg_pr_err("%s: failed to copy grid %d tile group (%d,%d) arguments to device.\n",
-                           __func__,
-                           tg->grid_id, hb_mc_coordinate_get_x(tg->id),
-                           hb_mc_coordinate_get_y(tg->id)); 
+                bsg_pr_err("%s: failed to copy grid %d arguments to device.\n",
+                           __func__, grid->id);
                 return error;
         }
+
+        return HB_MC_SUCCESS;
+}
+
+
+
+
+/**
+ * Frees a grid's argument block on the device, once all of its tile groups have finished.
+ * @param[in]  device        Pointer to device
+ * @param[in]  grid          Pointer to grid
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+static int hb_mc_grid_args_exit (hb_mc_device_t *device,
+                                 hb_mc_grid_t *grid) {
+        int error = hb_mc_device_free(device, grid->args_eva);
+        if (error != HB_MC_SUCCESS) { 
+                bsg_pr_err("%s: failed to free the argument list for grid %d.\n", 
+                           __func__, grid->id);
+                return error;
+        }
+        return HB_MC_SUCCESS;
+}
+
+
+
+
+/**
+ * Frees the kernels of all queued grids, and empties the device's
+ * grid and tile group lists while keeping their space for reuse.
+ * @param[in]  device        Pointer to device
+ */
+static void hb_mc_device_grids_reset (hb_mc_device_t *device) {
+        for (uint32_t grid_num = 0; grid_num < device->num_queued_grids; grid_num ++)
+                hb_mc_grid_kernel_exit (&device->grids[grid_num].kernel);
+        device->num_queued_grids = 0;
+        device->num_tile_groups = 0;
+}
+
+
+
+
+
+/**
+ * Initializes the grid and tile group structures of a device 
+ * @param[in]  device        Pointer to device
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+static int hb_mc_device_tile_groups_init (hb_mc_device_t *device) { 
         
-        hb_mc_eva_t kernel_eva; 
-        error = hb_mc_loader_symbol_to_eva (device->program->bin, device->program->bin_size, tg->kernel->name, &kernel_eva); 
+        device->tile_group_capacity = 1;
+        device->tile_groups = (hb_mc_tile_group_t *) malloc (device->tile_group_capacity * sizeof(hb_mc_tile_group_t));
+        if (device->tile_groups == NULL) {
+                bsg_pr_err("%s: failed to allocated space for list of tile groups.\n", __func__);
+                return HB_MC_NOMEM;
+        }
+        memset (device->tile_groups, 0, device->tile_group_capacity * sizeof(hb_mc_tile_group_t));
+        device->num_tile_groups = 0;
+
+        device->grid_capacity = 1;
+        device->grids = (hb_mc_grid_t *) malloc (device->grid_capacity * sizeof(hb_mc_grid_t));
+        if (device->grids == NULL) {
+                bsg_pr_err("%s: failed to allocated space for list of grids.\n", __func__);
+                free (device->tile_groups);
+                device->tile_groups = NULL;
+                return HB_MC_NOMEM;
+        }
+        memset (device->grids, 0, device->grid_capacity * sizeof(hb_mc_grid_t));
+        device->num_queued_grids = 0;
+        return HB_MC_SUCCESS;
+}
+
+
+
+
+/**
+ * Destructs the grid and tile group structures of a device 
+ * @param[in]  device        Pointer to device
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+static int hb_mc_device_tile_groups_exit (hb_mc_device_t *device) { 
+
+        if (!device) { 
+                bsg_pr_err("%s: calling exit on tile group list in null device.\n", __func__); 
+                return HB_MC_INVALID;
+        }
+
+
+        if (!device->tile_groups || !device->grids) { 
+                bsg_pr_err("%s: calling exit on null tile group list.\n", __func__); 
+                return HB_MC_INVALID;
+        }
+
+
+        // Free the kernels of grids that were never executed
+        hb_mc_device_grids_reset (device);
+
+
+        // Free grid and tile group lists 
+        free (device->grids);
+        device->grids = NULL;
+        free (device->tile_groups);
+        device->tile_groups = NULL;
+
+        return HB_MC_SUCCESS;
+}
+
+
+
+
+
+/**
+ * Checks if a groups of tiles starting from a specific origin are all free or not.
+ * @param[in]  device        Pointer to device
+ * @param[in]  origin        Origin of the group of tiles to check for availability
+ * @param[in]  dim           Dimension of the group of tiles in question
+ * @return HB_MC_SUCCESS if all tiles in the group are free, otherwise an error code is returned. 
+ */
+static int hb_mc_device_tiles_are_free (hb_mc_device_t *device,
+                                        hb_mc_coordinate_t origin,
+                                        hb_mc_dimension_t dim) { 
+        if (hb_mc_coordinate_get_x(origin) + hb_mc_dimension_get_x(dim) > 
+            hb_mc_coordinate_get_x(device->mesh->origin) + hb_mc_dimension_get_x(device->mesh->dim)) { 
+                bsg_pr_err ("%s: a %dx%d tile group starting from origin (%d,%d) \
+                              does not fit in %dx%d device mesh. Check X dimension or origin.\n",
+                            __func__, 
+                            hb_mc_dimension_get_x(dim), hb_mc_dimension_get_y(dim),
+                            hb_mc_coordinate_get_x(origin), hb_mc_coordinate_get_y(origin), 
+                            hb_mc_dimension_get_x(device->mesh->dim), hb_mc_dimension_get_y(device->mesh->dim)); 
+                return HB_MC_INVALID;
+        }
+                                
+        if (hb_mc_coordinate_get_y(origin) + hb_mc_dimension_get_y(dim) >
+            hb_mc_coordinate_get_y(device->mesh->origin) + hb_mc_dimension_get_y(device->mesh->dim)) { 
+                bsg_pr_err ("%s: a %dx%d tile group starting from origin (%d,%d) \
+                             does not fit in %dx%d device mesh. Check Y dimension or origin.\n",
+                            __func__, 
+                            hb_mc_dimension_get_x(dim), hb_mc_dimension_get_y(dim),
+                            hb_mc_coordinate_get_x(origin), hb_mc_coordinate_get_y(origin), 
+                            hb_mc_dimension_get_x(device->mesh->dim), hb_mc_dimension_get_y(device->mesh->dim)); 
+                return HB_MC_INVALID;
+        }
+
+
+        hb_mc_coordinate_t tile_coord;
+        hb_mc_idx_t tile_id;
+                        
+        // Iterate over a tg->dim.x * tg->dim.y square of tiles starting from the (org_x,org_y)
+        // checking to see if all tiles are free so they can be allocated to tile group
+        for (hb_mc_idx_t x = hb_mc_coordinate_get_x(origin);
+             x < hb_mc_coordinate_get_x(origin) + hb_mc_dimension_get_x(dim); x++){
+                for (hb_mc_idx_t y = hb_mc_coordinate_get_y(origin);
+                     y < hb_mc_coordinate_get_y(origin) + hb_mc_dimension_get_y(dim); y++){
+                        tile_id = hb_mc_get_tile_id (device->mesh->origin, device->mesh->dim, hb_mc_coordinate(x, y)); 
+                        if (device->mesh->tiles[tile_id].status != HB_MC_TILE_STATUS_FREE) 
+                                return HB_MC_FAIL;
+                }
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+
+
+
+/**
+ * Takes in a device and tile group and an origin, initializes tile group
+ * and sends packets to all tiles in tile group to set their symbols. 
+ * @param[in]  device        Pointer to device
+ * @param[in]  tg            Pointer to tile group
+ * @param[in]  origin        Origin coordinates of tile group
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+static int hb_mc_tile_group_initialize_tiles (hb_mc_device_t *device,
+                                              hb_mc_tile_group_t *tg,
+                                              hb_mc_coordinate_t origin) { 
+
+        int error;
+        const hb_mc_grid_t *grid = &device->grids[tg->grid];
+        hb_mc_eva_map_t map;
+
+        tg->origin = origin;
+
+        error = hb_mc_origin_eva_map_bind (&map, &tg->origin); 
         if (error != HB_MC_SUCCESS) { 
-                bsg_pr_err("%s: invalid kernel name %s for grid %d tile group (%d,%d).\n",
+                bsg_pr_err("%s: failed to initialize grid %d tile group (%d,%d) eva map origin.\n",
                            __func__,
-                           tg->kernel->name,
-                           tg->grid_id,
+                           grid->id,
                            hb_mc_coordinate_get_x(tg->id), hb_mc_coordinate_get_y(tg->id));
                 return error;
-        }       
+        }
 
-        hb_mc_coordinate_t host_coordinate = hb_mc_manycore_get_host_coordinate(device->mc); 
-        hb_mc_npa_t finish_signal_npa = hb_mc_npa(host_coordinate, tg->kernel->finish_signal_addr); 
 
 
-        // Create a list of tile coordinates for tiles inside tile group 
-        uint32_t num_tiles = hb_mc_dimension_to_length(tg->dim); 
+        // Define a list of tiles who's configuration symbols are to be set
+        uint32_t num_tiles = hb_mc_dimension_to_length(grid->tg_dim); 
         hb_mc_coordinate_t tile_list[num_tiles];
+        
+        hb_mc_idx_t tg_tile_id = 0;
+
+        // Set tiles variables inside hb_mc_device_t struct
+        // And prepare a list of tile coordinates who's config symbols are to be set 
+        for (hb_mc_idx_t x = hb_mc_coordinate_get_x(origin);
+             x < hb_mc_coordinate_get_x(origin) + hb_mc_dimension_get_x(grid->tg_dim); x++){
+                for (hb_mc_idx_t y = hb_mc_coordinate_get_y(origin);
+                     y < hb_mc_coordinate_get_y(origin) + hb_mc_dimension_get_y(grid->tg_dim); y++){
+                        hb_mc_idx_t device_tile_id = hb_mc_get_tile_id (device->mesh->origin, device->mesh->dim, hb_mc_coordinate(x, y));
+
+                        device->mesh->tiles[device_tile_id].origin = origin;
+                        device->mesh->tiles[device_tile_id].tile_group_id = tg->id;
+                        device->mesh->tiles[device_tile_id].status = HB_MC_TILE_STATUS_BUSY;
+
 
-        int tg_tile_id = 0;
-        for (   hb_mc_idx_t y = hb_mc_coordinate_get_y(tg->origin);
-                y < hb_mc_coordinate_get_y(tg->origin) + hb_mc_dimension_get_y(tg->dim); y++){
-                for (   hb_mc_idx_t x = hb_mc_coordinate_get_x(tg->origin);
-                        x < hb_mc_coordinate_get_x(tg->origin) + hb_mc_dimension_get_x(tg->dim); x++){
                         tile_list[tg_tile_id] = hb_mc_coordinate (x, y); 
                         tg_tile_id ++;
                 }
         }
-        
 
-        // Set the runtime symbols of all tiles inside tile group
-        error = hb_mc_device_tiles_set_runtime_symbols(device,
-                                                       tg->map,
-                                                       tg->kernel->argc,
-                                                       args_eva,
-                                                       finish_signal_npa, 
-                                                       kernel_eva,
-                                                       tile_list,
-                                                       num_tiles);
+
+
+
+        // Set the configuration symbols of all tiles inside tile group
+        error = hb_mc_device_tiles_set_config_symbols(device,
+                                                      grid,
+                                                      &map,
+                                                      tg->origin,
+                                                      tg->id,
+                                                      tile_list,
+                                                      num_tiles);
         if (error != HB_MC_SUCCESS) { 
-                bsg_pr_err("%s: failed to set grid %d tile group (%d,%d) tiles runtime symbols.\n", 
+                bsg_pr_err("%s: failed to set grid %d tile group (%d,%d) tiles configuration symbols.\n", 
                            __func__,
-                           tg->grid_id,
+                           grid->id,
                            hb_mc_coordinate_get_x (tg->id),
                            hb_mc_coordinate_get_y (tg->id));
                 return error;
@@ -815,14 +1119,16 @@ static int hb_mc_tile_group_launch (hb_mc_device_t *device,
 
 
 
+        tg->status = HB_MC_TILE_GROUP_STATUS_ALLOCATED;
 
-        tg->status=HB_MC_TILE_GROUP_STATUS_LAUNCHED;
-        bsg_pr_dbg("%s: Grid %d: %dx%d tile group (%d,%d) launched at origin (%d,%d).\n",
+
+        bsg_pr_dbg("%s: Grid %d: %dx%d tile group (%d,%d) allocated at origin (%d,%d).\n", 
                    __func__,
-                   tg->grid_id,
-                   hb_mc_dimension_get_x(tg->dim), hb_mc_dimension_get_y(tg->dim),
+                   grid->id,
+                   hb_mc_dimension_get_x(grid->tg_dim), hb_mc_dimension_get_y(grid->tg_dim),
                    hb_mc_coordinate_get_x(tg->id), hb_mc_coordinate_get_y(tg->id),
-                   hb_mc_coordinate_get_x(tg->origin), hb_mc_coordinate_get_y(tg->origin));
+                   hb_mc_coordinate_get_x(tg->origin), hb_mc_coordinate_get_y(tg->origin));     
+
 
         return HB_MC_SUCCESS;
 }
@@ -830,81 +1136,154 @@ static int hb_mc_tile_group_launch (hb_mc_device_t *device,
 
 
 
+
+
 /**
- * De-allocates all tiles in tile group, and resets their tile-group id and origin in the device book keeping.
- * Also free's the memory location in device's DRAM that holds the list of argument for tile group's kernel.
+ * Searches for a free tile group inside the device mesh and allocoates it,
+ * and sets the dimensions, origin, and id of tile group.
  * @param[in]  device        Pointer to device
- * @parma[in]  tg            Pointer to tile group
+ * @param[in]  tg            Pointer to tile group
  * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
  */
-static int hb_mc_tile_group_deallocate_tiles(hb_mc_device_t *device,
-                                             hb_mc_tile_group_t *tg) {
+static int hb_mc_tile_group_allocate_tiles (hb_mc_device_t *device,
+                                            hb_mc_tile_group_t *tg){
         int error;
-        hb_mc_idx_t tile_id; 
-        for (   int x = hb_mc_coordinate_get_x(tg->origin);
-                x < hb_mc_coordinate_get_x(tg->origin) + hb_mc_dimension_get_x(tg->dim); x++){
-                for (   int y = hb_mc_coordinate_get_y(tg->origin);
-                        y < hb_mc_coordinate_get_y(tg->origin) + hb_mc_dimension_get_y(tg->dim); y++){
-                        tile_id = hb_mc_get_tile_id (device->mesh->origin, device->mesh->dim, hb_mc_coordinate (x, y));  
-                        
-                        device->mesh->tiles[tile_id].origin = device->mesh->origin;
-                        device->mesh->tiles[tile_id].tile_group_id = hb_mc_coordinate( 0, 0);
-                        device->mesh->tiles[tile_id].status = HB_MC_TILE_STATUS_FREE;
-                }
+        const hb_mc_grid_t *grid = &device->grids[tg->grid];
+        if (hb_mc_dimension_get_x(grid->tg_dim) > hb_mc_dimension_get_x(device->mesh->dim)){
+                bsg_pr_err("%s: tile group X dimension (%d) larger than mesh X dimension (%d).\n",
+                           __func__,
+                           hb_mc_dimension_get_x(grid->tg_dim),
+                           hb_mc_dimension_get_x(device->mesh->dim));
+                return HB_MC_INVALID;
         }
-        bsg_pr_dbg("%s: Grid %d: %dx%d tile group (%d,%d) de-allocated at origin (%d,%d).\n",
-                   __func__,
-                   tg->grid_id,
-                   hb_mc_dimension_get_x(tg->dim), hb_mc_dimension_get_y(tg->dim),
-                   hb_mc_coordinate_get_x(tg->id), hb_mc_coordinate_get_y(tg->id),
-                   hb_mc_coordinate_get_x(tg->origin), hb_mc_coordinate_get_y(tg->origin));
-        
-        tg->status = HB_MC_TILE_GROUP_STATUS_FINISHED;
-
-        // Free the memory location in the device that holds the list of arguments of tile group's kernel
-        error = hb_mc_device_free(device, tg->argv_eva);
-        if (error != HB_MC_SUCCESS) { 
-                bsg_pr_err("%s: failed to free the argument list for grid %d tile group (%d,%d).\n", 
+        if (hb_mc_dimension_get_y(grid->tg_dim) > hb_mc_dimension_get_y(device->mesh->dim)){
+                bsg_pr_err("%s: tile group Y dimension (%d) larger than mesh Y dimension (%d).\n",
                            __func__,
-                           tg->grid_id,
-                           hb_mc_coordinate_get_x (tg->id),
-                           hb_mc_coordinate_get_y (tg->id));
-                return error;
+                           hb_mc_dimension_get_y(grid->tg_dim),
+                           hb_mc_dimension_get_y(device->mesh->dim));
+                return HB_MC_INVALID;
         }
 
-        return HB_MC_SUCCESS;
-}
+        hb_mc_coordinate_t tile_coord;
+        hb_mc_idx_t tile_id; 
 
+        // Iterate over the entire mesh as tile (org_y, org_x) being the origin of the new tile group to allcoate 
+        for (hb_mc_idx_t org_y = hb_mc_coordinate_get_y(device->mesh->origin);
+             org_y <= (hb_mc_coordinate_get_y(device->mesh->origin)
+                       + hb_mc_dimension_get_y(device->mesh->dim)
+                       - hb_mc_dimension_get_y(grid->tg_dim)); org_y++){
+                for (hb_mc_idx_t org_x = hb_mc_coordinate_get_x(device->mesh->origin);
+                     org_x <= (hb_mc_coordinate_get_x(device->mesh->origin)
+                               + hb_mc_dimension_get_x(device->mesh->dim)
+                               - hb_mc_dimension_get_x(grid->tg_dim)); org_x++){
+
+
+                        // Search if a grid->tg_dim.x * grid->tg_dim.y group of tiles starting from (org_x,org_y) are all free
+                        if (hb_mc_device_tiles_are_free(device, hb_mc_coordinate(org_x, org_y), grid->tg_dim) == HB_MC_SUCCESS) { 
+
+                                // Found a free group of tiles at origin (org_x, org_y), now initialize
+                                // all these tiles by sending packets and claiming them for this tile group
+                                error = hb_mc_tile_group_initialize_tiles (device, tg, hb_mc_coordinate(org_x, org_y));
+                                if (error != HB_MC_SUCCESS) { 
+                                        bsg_pr_err("%s: failed to initialize mesh tiles for grid %d tile group (%d,%d).\n",
+                                                   __func__,
+                                                   grid->id,
+                                                   hb_mc_coordinate_get_x(tg->id),
+                                                   hb_mc_coordinate_get_y(tg->id)); 
+                                        return error;
+                                }
+                                return HB_MC_SUCCESS;
+                        }
+                }
+        }
+        return HB_MC_NOTFOUND;
+}
 
 
 
 
 /**
- * Frees memroy and removes tile group object
- * @param[in]  tg        Pointer to tile group
- * @return HB_MC_SUCCESS if successful, otherwise an error code is returned. 
+ * Launches a tile group by sending packets to each tile in the
+ * tile group setting the argc, argv, finish_addr and kernel pointer.
+ * The grid's argument block is copied to the device when its first tile group launches.
+ * @param[in]  device        Pointer to device
+ * @parma[in]  tg            Pointer to tile group
+ * @return HB_MC_SUCCESS if tile group is launched successfully, otherwise an error code is returned.
  */
-__attribute__((warn_unused_result))
-static int hb_mc_tile_group_exit (hb_mc_tile_group_t *tg) {
+static int hb_mc_tile_group_launch (hb_mc_device_t *device,
+                                    hb_mc_tile_group_t *tg) {
+
         int error;
+        hb_mc_grid_t *grid = &device->grids[tg->grid];
+        hb_mc_eva_map_t map;
 
-        if (!tg) { 
-                bsg_pr_err("%s: calling exit on null tile group.\n", __func__); 
-                return HB_MC_INVALID;
+        // from here on the kernel may touch any line of the caches
+        hb_mc_cache_tracker_kernel(device->cache_tracker);
+
+        if (grid->num_launched == 0) {
+                error = hb_mc_grid_args_init (device, grid);
+                if (error != HB_MC_SUCCESS) {
+                        bsg_pr_err("%s: failed to initialize grid %d arguments.\n",
+                                   __func__, grid->id);
+                        return error;
+                }
         }
 
-        error = hb_mc_tile_group_kernel_exit (tg->kernel); 
+        error = hb_mc_origin_eva_map_bind (&map, &tg->origin); 
         if (error != HB_MC_SUCCESS) { 
-                bsg_pr_err ("%s: failed to remove tile group's kernel object.\n", __func__);
+                bsg_pr_err("%s: failed to initialize grid %d tile group (%d,%d) eva map origin.\n",
+                           __func__,
+                           grid->id,
+                           hb_mc_coordinate_get_x(tg->id), hb_mc_coordinate_get_y(tg->id));
                 return error;
         }
 
-        error = hb_mc_origin_eva_map_exit (tg->map);
+        hb_mc_coordinate_t host_coordinate = hb_mc_manycore_get_host_coordinate(device->mc); 
+        hb_mc_npa_t finish_signal_npa = hb_mc_npa(host_coordinate, hb_mc_tile_group_get_finish_signal_addr(grid, tg)); 
+
+
+        // Create a list of tile coordinates for tiles inside tile group 
+        uint32_t num_tiles = hb_mc_dimension_to_length(grid->tg_dim); 
+        hb_mc_coordinate_t tile_list[num_tiles];
+
+        int tg_tile_id = 0;
+        for (   hb_mc_idx_t y = hb_mc_coordinate_get_y(tg->origin);
+                y < hb_mc_coordinate_get_y(tg->origin) + hb_mc_dimension_get_y(grid->tg_dim); y++){
+                for (   hb_mc_idx_t x = hb_mc_coordinate_get_x(tg->origin);
+                        x < hb_mc_coordinate_get_x(tg->origin) + hb_mc_dimension_get_x(grid->tg_dim); x++){
+                        tile_list[tg_tile_id] = hb_mc_coordinate (x, y); 
+                        tg_tile_id ++;
+                }
+        }
+        
+
+        // Set the runtime symbols of all tiles inside tile group
+        error = hb_mc_device_tiles_set_runtime_symbols(device,
+                                                       grid,
+                                                       &map,
+                                                       finish_signal_npa, 
+                                                       tile_list,
+                                                       num_tiles);
         if (error != HB_MC_SUCCESS) { 
-                bsg_pr_err ("%s: failed to delete tile group's map object.\n", __func__);
+                bsg_pr_err("%s: failed to set grid %d tile group (%d,%d) tiles runtime symbols.\n", 
+                           __func__,
+                           grid->id,
+                           hb_mc_coordinate_get_x (tg->id),
+                           hb_mc_coordinate_get_y (tg->id));
                 return error;
         }
-        tg = NULL;      
+
+
+
+
+        tg->status=HB_MC_TILE_GROUP_STATUS_LAUNCHED;
+        grid->num_launched ++;
+        bsg_pr_dbg("%s: Grid %d: %dx%d tile group (%d,%d) launched at origin (%d,%d).\n",
+                   __func__,
+                   grid->id,
+                   hb_mc_dimension_get_x(grid->tg_dim), hb_mc_dimension_get_y(grid->tg_dim),
+                   hb_mc_coordinate_get_x(tg->id), hb_mc_coordinate_get_y(tg->id),
+                   hb_mc_coordinate_get_x(tg->origin), hb_mc_coordinate_get_y(tg->origin));
 
         return HB_MC_SUCCESS;
 }
@@ -912,44 +1291,51 @@ static int hb_mc_tile_group_exit (hb_mc_tile_group_t *tg) {
 
 
 
-
 /**
- * Frees memroy and removes kernel object
- * @param[in]  kernel    Pointer kernel
- * @return HB_MC_SUCCESS if successful, otherwise an error code is returned. 
+ * De-allocates all tiles in tile group, and resets their tile-group id and origin in the device book keeping.
+ * Once the last tile group of a grid finishes, also free's the memory location in device's DRAM
+ * that holds the grid's argument block.
+ * @param[in]  device        Pointer to device
+ * @parma[in]  tg            Pointer to tile group
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
  */
-__attribute__((warn_unused_result))
-static int hb_mc_tile_group_kernel_exit (hb_mc_kernel_t *kernel) {
-        if (!kernel) { 
-                bsg_pr_err("%s: calling exit on null kernel object.\n", __func__);
-                return HB_MC_INVALID;
+static int hb_mc_tile_group_deallocate_tiles(hb_mc_device_t *device,
+                                             hb_mc_tile_group_t *tg) {
+        int error;
+        hb_mc_grid_t *grid = &device->grids[tg->grid];
+        hb_mc_idx_t tile_id; 
+        for (   int x = hb_mc_coordinate_get_x(tg->origin);
+                x < hb_mc_coordinate_get_x(tg->origin) + hb_mc_dimension_get_x(grid->tg_dim); x++){
+                for (   int y = hb_mc_coordinate_get_y(tg->origin);
+                        y < hb_mc_coordinate_get_y(tg->origin) + hb_mc_dimension_get_y(grid->tg_dim); y++){
+                        tile_id = hb_mc_get_tile_id (device->mesh->origin, device->mesh->dim, hb_mc_coordinate (x, y));  
+                        
+                        device->mesh->tiles[tile_id].origin = device->mesh->origin;
+                        device->mesh->tiles[tile_id].tile_group_id = hb_mc_coordinate( 0, 0);
+                        device->mesh->tiles[tile_id].status = HB_MC_TILE_STATUS_FREE;
+                }
         }
+        bsg_pr_dbg("%s: Grid %d: %dx%d tile group (%d,%d) de-allocated at origin (%d,%d).\n",
+                   __func__,
+                   grid->id,
+                   hb_mc_dimension_get_x(grid->tg_dim), hb_mc_dimension_get_y(grid->tg_dim),
+                   hb_mc_coordinate_get_x(tg->id), hb_mc_coordinate_get_y(tg->id),
+                   hb_mc_coordinate_get_x(tg->origin), hb_mc_coordinate_get_y(tg->origin));
+        
+        tg->status = HB_MC_TILE_GROUP_STATUS_FINISHED;
+        grid->num_finished ++;
 
-
-        // Free name
-        const char* name;
-        name = kernel->name;
-        if (!name) { 
-                bsg_pr_err("%s: calling exit on kernel with null name.\n", __func__);
-                return HB_MC_INVALID;
-        } else {
-                free ((void *) name); 
-                kernel->name = NULL;
+        // Free the memory location in the device that holds the grid's arguments
+        // once no tile group of the grid can read them any more
+        if (grid->num_finished == grid->num_tile_groups) {
+                error = hb_mc_grid_args_exit(device, grid);
+                if (error != HB_MC_SUCCESS) { 
+                        bsg_pr_err("%s: failed to free the argument list for grid %d.\n", 
+                                   __func__, grid->id);
+                        return error;
+                }
         }
 
-
-        // Free argv
-        const uint32_t *argv;
-        argv = kernel->argv;
-        if (!argv) { 
-                bsg_pr_err("%s: calling exit on kernel with null argument list.\n", __func__);
-                return HB_MC_INVALID;
-        } else { 
-                free ((void*)argv); 
-                kernel->argv = NULL;
-        }
-        free(kernel);
-        
         return HB_MC_SUCCESS;
 }
 
@@ -1017,6 +1403,12 @@ int hb_mc_device_init_custom_dimensions (hb_mc_device_t *device,
                 return error; 
         }
 
+        error = hb_mc_cache_tracker_init (device->mc, &device->cache_tracker);
+        if (error != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to initialize device's cache tracker.\n", __func__);
+                return error;
+        }
+
         device->num_grids = 0;
 
         return HB_MC_SUCCESS;
@@ -1049,30 +1441,60 @@ static int hb_mc_device_program_load (hb_mc_device_t *device) {
         }
 
 
-        // Load binary into all tiles 
-        error = hb_mc_loader_load (device->program->bin,
-                                   device->program->bin_size,
-                                   device->mc,
-                                   &default_map,
-                                   &tile_list[0],
-                                   num_tiles); 
+        // Loading writes through the caches and starts the runtime on every tile
+        hb_mc_cache_tracker_kernel(device->cache_tracker);
+
+        hb_mc_loader_tile_set_t tile_set = { &tile_list[0], num_tiles };
+        const hb_mc_load_image_t *load_image = hb_mc_program_image_get_load_image (device->program->image);
+        if (load_image) {
+                // Load images were lowered for this machine ahead of time
+                error = hb_mc_loader_load_image (load_image,
+                                                 device->mc,
+                                                 &default_map,
+                                                 &tile_set, 1);
+        } else {
+                // Plan how to load the binary, once per program
+                if (!device->program->load_plan) {
+                        error = hb_mc_loader_plan_create (device->program->bin,
+                                                          device->program->bin_size,
+                                                          device->mc,
+                                                          &device->program->load_plan);
+                        if (error != HB_MC_SUCCESS) { 
+                                bsg_pr_err ("%s: failed to plan loading binary.\n", __func__); 
+                                return error;
+                        }
+                }
+
+                // Load binary into all tiles 
+                error = hb_mc_loader_plan_load (device->program->load_plan,
+                                                device->mc,
+                                                &default_map,
+                                                &tile_set, 1); 
+        }
         if (error != HB_MC_SUCCESS) { 
                 bsg_pr_err ("%s: failed to load binary into tiles.\n", __func__); 
                 return error;
         }       
 
 
-        // Set all tiles configuration symbols 
+        // Set all tiles configuration symbols, as a 1x1 grid of 1x1 tile groups
         hb_mc_coordinate_t tg_id = hb_mc_coordinate (0, 0);
-        hb_mc_coordinate_t tg_dim = hb_mc_coordinate (1, 1); 
-        hb_mc_coordinate_t grid_dim = hb_mc_coordinate (1, 1); 
+        hb_mc_grid_t grid;
+        memset (&grid, 0, sizeof(grid));
+        grid.tg_dim = hb_mc_dimension (1, 1); 
+        grid.dim = hb_mc_dimension (1, 1); 
+
+        error = hb_mc_grid_symbols_init(device, &grid);
+        if (error != HB_MC_SUCCESS) { 
+                bsg_pr_err("%s: failed to resolve runtime symbols.\n", __func__);
+                return error;
+        }
 
         error = hb_mc_device_tiles_set_config_symbols(device,
+                                                      &grid,
                                                       &default_map,
                                                       device->mesh->origin,
                                                       tg_id,
-                                                      tg_dim, 
-                                                      grid_dim,
                                                       tile_list,
                                                       num_tiles);
         if (error != HB_MC_SUCCESS) { 
@@ -1095,105 +1517,487 @@ static int hb_mc_device_program_load (hb_mc_device_t *device) {
 
 
 
-
+
+/**
+ * Takes in a buffer containing binary and its size,
+ * freezes tiles, loads program binary into all tiles and into dram,
+ * and sets the symbols and registers for each tile.
+ * @param[in]  device        Pointer to device
+ * @parma[in]  bin_name      Name of binary elf file
+ * @param[in]  bin_data      Buffer containing binary
+ * @param[in]  bin_size      Size of binary to be loaded onto device
+ * @param[in]  id            Id of program's meomry allocator
+ * @param[in]  alloc_name    Unique name of program's memory allocator
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_device_program_init_binary (hb_mc_device_t *device, 
+                                      const char *bin_name,
+                                      const unsigned char* bin_data, 
+                                      size_t bin_size, 
+                                      const char* alloc_name, 
+                                      hb_mc_allocator_id_t id) { 
+        int error;
+        hb_mc_program_image_t *image;
+
+        // Copy binary into a program image and index it
+        error = hb_mc_program_image_from_buffer (bin_data, bin_size, &image);
+        if (error != HB_MC_SUCCESS) { 
+                bsg_pr_err("%s: failed to copy binary into program image.\n", __func__); 
+                return error;
+        }
+
+        return hb_mc_device_program_init_image (device, bin_name, image, alloc_name, id);
+}
+
+
+
+
+
+/**
+ * Takes in a binary name, maps the binary file into a program image,
+ * freezes tiles, loads program binary into all tiles and into dram,
+ * and sets the symbols and registers for each tile.
+ * @param[in]  device        Pointer to device
+ * @parma[in]  bin_name      Name of binary elf file
+ * @param[in]  id            Id of program's meomry allocator
+ * @param[in]  alloc_name    Unique name of program's memory allocator
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_device_program_init (hb_mc_device_t *device,
+                               const char *bin_name,
+                               const char *alloc_name,
+                               hb_mc_allocator_id_t id) {
+        int error; 
+        hb_mc_program_image_t *image;
+
+        error = hb_mc_program_image_open (bin_name, &image);
+        if (error != HB_MC_SUCCESS) { 
+                bsg_pr_err ("%s: failed to read binary file.\n", __func__); 
+                return error;
+        }
+
+        error = hb_mc_device_program_init_image (device, bin_name, image, alloc_name, id);
+        if (error != HB_MC_SUCCESS) { 
+                bsg_pr_err("%s: failed to initialize device with program binary.\n", __func__);
+                return error;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+
+
+
+
+/**
+ * Lowers a binary into a load image for a machine, with the
+ * runtime's configuration symbols resolved.
+ * @param[in]  mc            A manycore instance whose configuration is the target machine
+ * @param[in]  bin_name      Name of binary elf file
+ * @param[in]  image_name    Name of the load image to write
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_device_program_lower (hb_mc_manycore_t *mc,
+                                const char *bin_name,
+                                const char *image_name) {
+        int error;
+        hb_mc_program_image_t *image;
+
+        error = hb_mc_program_image_open (bin_name, &image);
+        if (error != HB_MC_SUCCESS) { 
+                bsg_pr_err ("%s: failed to read binary file.\n", __func__); 
+                return error;
+        }
+
+        error = hb_mc_load_image_lower (image, mc, &default_map,
+                                        hb_mc_cuda_symbol_names, HB_MC_CUDA_SYMBOL_MAX,
+                                        image_name);
+        hb_mc_program_image_release (image);
+        if (error != HB_MC_SUCCESS) { 
+                bsg_pr_err ("%s: failed to lower %s: %s\n", __func__, bin_name, hb_mc_strerror(error));
+                return error;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+
+
+
+
+/**
+ * Takes in a program image, freezes tiles, loads program binary into
+ * all tiles and into dram, and sets the symbols and registers for each tile.
+ * @param[in]  device        Pointer to device
+ * @parma[in]  bin_name      Name of binary elf file
+ * @param[in]  image         Program image of the binary; the program takes over the caller's reference
+ * @param[in]  alloc_name    Unique name of program's memory allocator
+ * @param[in]  id            Id of program's meomry allocator
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+static int hb_mc_device_program_init_image (hb_mc_device_t *device,
+                                            const char *bin_name,
+                                            hb_mc_program_image_t *image,
+                                            const char *alloc_name,
+                                            hb_mc_allocator_id_t id) {
+        int error;
+
+        device->program = (hb_mc_program_t *) calloc (1, sizeof (hb_mc_program_t));
+        if (device->program == NULL) { 
+                bsg_pr_err("%s: failed to allocate space on host for device hb_mc_program_t struct.\n", __func__);
+                hb_mc_program_image_release (image);
+                return HB_MC_NOMEM;
+        }
+
+        hb_mc_program_set_image (device->program, image);
+
+        device->program->bin_name = strdup (bin_name);
+        if (!device->program->bin_name) { 
+                bsg_pr_err("%s: failed to copy binary name into program struct.\n", __func__); 
+                return HB_MC_NOMEM;
+        }
+
+
+        // Initialize program's memory allocator
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(device->mc); 
+        error = hb_mc_program_allocator_init (cfg, device->program, alloc_name, id); 
+        if (error != HB_MC_SUCCESS) { 
+                bsg_pr_err("%s: failed to initialize memory allocator for program %s.\n", __func__, device->program->bin_name); 
+                return HB_MC_UNINITIALIZED;
+        }
+
+        // Load binary onto all tiles
+        error = hb_mc_device_program_load (device); 
+        if (error != HB_MC_SUCCESS) { 
+                bsg_pr_err("%s: failed to load program binary onto device tiles.\n", __func__);
+                return error;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+
+
+
+
+/**
+ * Host runtime state saved next to a simulation checkpoint.
+ * It is followed by the mesh tiles, the program binary and the
+ * allocator's free and busy lists (as base/size pairs).
+ */
+#define HB_MC_CHECKPOINT_MAGIC "HBMCCKPT"
+typedef struct {
+        char magic[8];
+        hb_mc_dimension_t dim;
+        hb_mc_coordinate_t origin;
+        uint32_t num_grids;
+        uint64_t bin_size;
+        uint64_t num_free;
+        uint64_t num_busy;
+} hb_mc_checkpoint_header_t;
+
+typedef std::list<std::pair<uint64_t, uint64_t> > hb_mc_checkpoint_list_t;
+
+static std::string hb_mc_checkpoint_host_path (const char *path) {
+        return std::string(path) + ".host";
+}
+
+static bool hb_mc_checkpoint_write_u32 (FILE *f, uint32_t v) {
+        return fwrite(&v, sizeof(v), 1, f) == 1;
+}
+
+static bool hb_mc_checkpoint_read_u32 (FILE *f, uint32_t *v) {
+        return fread(v, sizeof(*v), 1, f) == 1;
+}
+
+static bool hb_mc_checkpoint_write_u64 (FILE *f, uint64_t v) {
+        return fwrite(&v, sizeof(v), 1, f) == 1;
+}
+
+static bool hb_mc_checkpoint_read_u64 (FILE *f, uint64_t *v) {
+        return fread(v, sizeof(*v), 1, f) == 1;
+}
+
+static bool hb_mc_checkpoint_write_coord (FILE *f, hb_mc_coordinate_t c) {
+        return hb_mc_checkpoint_write_u32(f, c.x)
+                && hb_mc_checkpoint_write_u32(f, c.y);
+}
+
+static bool hb_mc_checkpoint_read_coord (FILE *f, hb_mc_coordinate_t *c) {
+        return hb_mc_checkpoint_read_u32(f, &c->x)
+                && hb_mc_checkpoint_read_u32(f, &c->y);
+}
+
+// The header and tiles are written field by field, so that the
+// file does not depend on the padding of the structs
+static bool hb_mc_checkpoint_write_header (FILE *f, const hb_mc_checkpoint_header_t &hdr) {
+        return fwrite(hdr.magic, sizeof(hdr.magic), 1, f) == 1
+                && hb_mc_checkpoint_write_coord(f, hdr.dim)
+                && hb_mc_checkpoint_write_coord(f, hdr.origin)
+                && hb_mc_checkpoint_write_u32(f, hdr.num_grids)
+                && hb_mc_checkpoint_write_u64(f, hdr.bin_size)
+                && hb_mc_checkpoint_write_u64(f, hdr.num_free)
+                && hb_mc_checkpoint_write_u64(f, hdr.num_busy);
+}
+
+static bool hb_mc_checkpoint_read_header (FILE *f, hb_mc_checkpoint_header_t &hdr) {
+        return fread(hdr.magic, sizeof(hdr.magic), 1, f) == 1
+                && hb_mc_checkpoint_read_coord(f, &hdr.dim)
+                && hb_mc_checkpoint_read_coord(f, &hdr.origin)
+                && hb_mc_checkpoint_read_u32(f, &hdr.num_grids)
+                && hb_mc_checkpoint_read_u64(f, &hdr.bin_size)
+                && hb_mc_checkpoint_read_u64(f, &hdr.num_free)
+                && hb_mc_checkpoint_read_u64(f, &hdr.num_busy);
+}
+
+static bool hb_mc_checkpoint_write_tiles (FILE *f, const hb_mc_tile_t *tiles, uint32_t n) {
+        for (uint32_t i = 0; i < n; i ++) {
+                if (!hb_mc_checkpoint_write_coord(f, tiles[i].coord)
+                    || !hb_mc_checkpoint_write_coord(f, tiles[i].origin)
+                    || !hb_mc_checkpoint_write_coord(f, tiles[i].tile_group_id)
+                    || !hb_mc_checkpoint_write_u32(f, tiles[i].status))
+                        return false;
+        }
+        return true;
+}
+
+static bool hb_mc_checkpoint_read_tiles (FILE *f, hb_mc_tile_t *tiles, uint32_t n) {
+        for (uint32_t i = 0; i < n; i ++) {
+                uint32_t status;
+                if (!hb_mc_checkpoint_read_coord(f, &tiles[i].coord)
+                    || !hb_mc_checkpoint_read_coord(f, &tiles[i].origin)
+                    || !hb_mc_checkpoint_read_coord(f, &tiles[i].tile_group_id)
+                    || !hb_mc_checkpoint_read_u32(f, &status))
+                        return false;
+                tiles[i].status = (hb_mc_tile_status_t) status;
+        }
+        return true;
+}
+
+static bool hb_mc_checkpoint_write_list (FILE *f, const hb_mc_checkpoint_list_t &list) {
+        for (const auto &b : list) {
+                if (!hb_mc_checkpoint_write_u64(f, b.first)
+                    || !hb_mc_checkpoint_write_u64(f, b.second))
+                        return false;
+        }
+        return true;
+}
+
+static bool hb_mc_checkpoint_read_list (FILE *f, uint64_t n, hb_mc_checkpoint_list_t &list) {
+        for (uint64_t i = 0; i < n; i ++) {
+                uint64_t base, size;
+                if (!hb_mc_checkpoint_read_u64(f, &base)
+                    || !hb_mc_checkpoint_read_u64(f, &size))
+                        return false;
+                list.push_back(std::make_pair(base, size));
+        }
+        return true;
+}
+
+/**
+ * Frees a program that was partially initialized from a checkpoint,
+ * so that the caller can fall back to hb_mc_device_program_init()
+ * @param[in]  device        Pointer to device
+ */
+static void hb_mc_checkpoint_program_free (hb_mc_device_t *device) {
+        hb_mc_program_t *program = device->program;
+        free ((void *) program->bin_name);
+        if (program->image)
+                hb_mc_program_image_release (program->image);
+        free (program);
+        device->program = NULL;
+}
+
+
+
+
+/**
+ * Saves a checkpoint of a device after program initialization.
+ * The simulation is written to #path, DRAM held in C++ models to
+ * <path>.dram, and the host runtime state (mesh, program and
+ * memory allocator) to <path>.host.
+ * No tile groups may be enqueued when the checkpoint is taken.
+ * @param[in]  device        Pointer to device
+ * @param[in]  path          Path of the checkpoint
+ * @return HB_MC_SUCCESS if succesful. HB_MC_NOIMPL if the platform cannot take checkpoints.
+ */
+int hb_mc_device_checkpoint_save (hb_mc_device_t *device, const char *path) {
+        int error;
+
+        if (!device->program) {
+                bsg_pr_err("%s: no program has been initialized.\n", __func__);
+                return HB_MC_UNINITIALIZED;
+        }
+
+        if (device->num_tile_groups != 0) {
+                bsg_pr_err("%s: cannot take a checkpoint with tile groups enqueued.\n", __func__);
+                return HB_MC_BUSY;
+        }
+
+        error = hb_mc_manycore_checkpoint_save(device->mc, path);
+        if (error != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to save simulation checkpoint: %s\n",
+                           __func__, hb_mc_strerror(error));
+                return error;
+        }
+
+        awsbwhal::MemoryManager *mem_manager =
+                (awsbwhal::MemoryManager *) device->program->allocator->memory_manager;
+        hb_mc_checkpoint_list_t free_list, busy_list;
+        mem_manager->save(free_list, busy_list);
+
+        hb_mc_checkpoint_header_t hdr;
+        memcpy(hdr.magic, HB_MC_CHECKPOINT_MAGIC, sizeof(hdr.magic));
+        hdr.dim = device->mesh->dim;
+        hdr.origin = device->mesh->origin;
+        hdr.num_grids = device->num_grids;
+        hdr.bin_size = device->program->bin_size;
+        hdr.num_free = free_list.size();
+        hdr.num_busy = busy_list.size();
+
+        std::string host_path = hb_mc_checkpoint_host_path(path);
+        FILE *f = fopen(host_path.c_str(), "wb");
+        if (!f) {
+                bsg_pr_err("%s: failed to open '%s': %m\n", __func__, host_path.c_str());
+                return HB_MC_FAIL;
+        }
+
+        uint32_t num_tiles = hb_mc_dimension_to_length(device->mesh->dim);
+        bool ok = hb_mc_checkpoint_write_header(f, hdr)
+                && hb_mc_checkpoint_write_tiles(f, device->mesh->tiles, num_tiles)
+                && fwrite(device->program->bin, 1, hdr.bin_size, f) == hdr.bin_size
+                && hb_mc_checkpoint_write_list(f, free_list)
+                && hb_mc_checkpoint_write_list(f, busy_list);
+        fclose(f);
+
+        if (!ok) {
+                bsg_pr_err("%s: failed to write '%s'.\n", __func__, host_path.c_str());
+                return HB_MC_FAIL;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+
+
+
 /**
- * Takes in a buffer containing binary and its size,
- * freezes tiles, loads program binary into all tiles and into dram,
- * and sets the symbols and registers for each tile.
+ * Initializes a program from a checkpoint written by hb_mc_device_checkpoint_save(),
+ * instead of loading the binary onto the device. The device should have been
+ * initialized with the same dimensions as when the checkpoint was taken.
  * @param[in]  device        Pointer to device
- * @parma[in]  bin_name      Name of binary elf file
- * @param[in]  bin_data      Buffer containing binary
- * @param[in]  bin_size      Size of binary to be loaded onto device
- * @param[in]  id            Id of program's meomry allocator
+ * @param[in]  path          Path of the checkpoint
+ * @parma[in]  bin_name      Name of binary elf file; must match the checkpointed binary
  * @param[in]  alloc_name    Unique name of program's memory allocator
- * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ * @param[in]  id            Id of program's meomry allocator
+ * @return HB_MC_SUCCESS if succesful. HB_MC_NOTFOUND if there is no usable checkpoint,
+ * in which case the caller should fall back to hb_mc_device_program_init().
  */
-int hb_mc_device_program_init_binary (hb_mc_device_t *device, 
-                                      const char *bin_name,
-                                      const unsigned char* bin_data, 
-                                      size_t bin_size, 
-                                      const char* alloc_name, 
-                                      hb_mc_allocator_id_t id) { 
+int hb_mc_device_program_init_checkpoint (hb_mc_device_t *device,
+                                          const char *path,
+                                          const char *bin_name,
+                                          const char *alloc_name,
+                                          hb_mc_allocator_id_t id) {
         int error;
-        
-        device->program = (hb_mc_program_t *) malloc (sizeof (hb_mc_program_t));
-        if (device->program == NULL) { 
-                bsg_pr_err("%s: failed to allocate space on host for device hb_mc_program_t struct.\n", __func__);
-                return HB_MC_NOMEM;
+
+        std::string host_path = hb_mc_checkpoint_host_path(path);
+        FILE *f = fopen(host_path.c_str(), "rb");
+        if (!f) {
+                bsg_pr_dbg("%s: no checkpoint at '%s'.\n", __func__, host_path.c_str());
+                return HB_MC_NOTFOUND;
         }
 
-        device->program->bin_name = strdup (bin_name);
-        if (!device->program->bin_name) { 
-                bsg_pr_err("%s: failed to copy binary name into program struct.\n", __func__); 
-                return HB_MC_NOMEM;
+        // Read the host runtime state
+        hb_mc_checkpoint_header_t hdr;
+        uint32_t num_tiles = hb_mc_dimension_to_length(device->mesh->dim);
+        std::vector<hb_mc_tile_t> tiles(num_tiles);
+        std::vector<unsigned char> bin;
+        hb_mc_checkpoint_list_t free_list, busy_list;
+
+        bool ok = hb_mc_checkpoint_read_header(f, hdr)
+                && !memcmp(hdr.magic, HB_MC_CHECKPOINT_MAGIC, sizeof(hdr.magic))
+                && hdr.dim.x == device->mesh->dim.x
+                && hdr.dim.y == device->mesh->dim.y
+                && hdr.origin.x == device->mesh->origin.x
+                && hdr.origin.y == device->mesh->origin.y;
+        if (ok) {
+                bin.resize(hdr.bin_size);
+                ok = hb_mc_checkpoint_read_tiles(f, tiles.data(), num_tiles)
+                        && fread(bin.data(), 1, hdr.bin_size, f) == hdr.bin_size
+                        && hb_mc_checkpoint_read_list(f, hdr.num_free, free_list)
+                        && hb_mc_checkpoint_read_list(f, hdr.num_busy, busy_list);
+        }
+        fclose(f);
+
+        if (!ok) {
+                bsg_pr_warn("%s: '%s' is not a checkpoint of this device.\n",
+                            __func__, host_path.c_str());
+                return HB_MC_NOTFOUND;
         }
 
 
-        // Copy binary into device's program struct and set it's size in characters
-        error = hb_mc_program_binary_copy (device->program,
-                                           bin_data,
-                                           bin_size);
-        if (error != HB_MC_SUCCESS) { 
-                bsg_pr_err("%s: failed to copy binary into program struct.\n", __func__); 
+        // A checkpoint is only valid for the binary it was taken with
+        hb_mc_program_image_t *image;
+        error = hb_mc_program_image_open (bin_name, &image);
+        if (error != HB_MC_SUCCESS) {
+                bsg_pr_err ("%s: failed to read binary file.\n", __func__);
                 return error;
         }
 
-
-        // Initialize program's memory allocator
-        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(device->mc); 
-        error = hb_mc_program_allocator_init (cfg, device->program, alloc_name, id); 
-        if (error != HB_MC_SUCCESS) { 
-                bsg_pr_err("%s: failed to initialize memory allocator for program %s.\n", __func__, device->program->bin_name); 
-                return HB_MC_UNINITIALIZED;
+        ok = hb_mc_program_image_get_size(image) == bin.size()
+                && !memcmp(hb_mc_program_image_get_data(image), bin.data(), bin.size());
+        if (!ok) {
+                bsg_pr_warn("%s: checkpoint '%s' was taken with a different binary.\n",
+                            __func__, path);
+                hb_mc_program_image_release(image);
+                return HB_MC_NOTFOUND;
         }
 
-        // Load binary onto all tiles
-        error = hb_mc_device_program_load (device); 
-        if (error != HB_MC_SUCCESS) { 
-                bsg_pr_err("%s: failed to load program binary onto device tiles.\n", __func__);
+
+        // Restore the simulation before touching the device, so that
+        // the caller can still fall back to loading the program
+        error = hb_mc_manycore_checkpoint_restore(device->mc, path);
+        if (error != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to restore simulation checkpoint: %s\n",
+                           __func__, hb_mc_strerror(error));
+                hb_mc_program_image_release(image);
                 return error;
         }
 
-        return HB_MC_SUCCESS;
-}
-
+        // The caches now hold whatever they held when the checkpoint was taken
+        hb_mc_cache_tracker_reset(device->cache_tracker);
 
 
+        device->program = (hb_mc_program_t *) calloc (1, sizeof (hb_mc_program_t));
+        if (device->program == NULL) {
+                bsg_pr_err("%s: failed to allocate space on host for device hb_mc_program_t struct.\n", __func__);
+                hb_mc_program_image_release(image);
+                return HB_MC_NOMEM;
+        }
 
+        hb_mc_program_set_image (device->program, image);
 
-/**
- * Takes in a binary name, loads the binary from file onto a buffer,
- * freezes tiles, loads program binary into all tiles and into dram,
- * and sets the symbols and registers for each tile.
- * @param[in]  device        Pointer to device
- * @parma[in]  bin_name      Name of binary elf file
- * @param[in]  id            Id of program's meomry allocator
- * @param[in]  alloc_name    Unique name of program's memory allocator
- * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
- */
-int hb_mc_device_program_init (hb_mc_device_t *device,
-                               const char *bin_name,
-                               const char *alloc_name,
-                               hb_mc_allocator_id_t id) {
-        int error; 
-        
-        unsigned char* bin_data;
-        size_t bin_size;
+        device->program->bin_name = strdup (bin_name);
+        if (!device->program->bin_name) {
+                bsg_pr_err("%s: failed to copy binary name into program struct.\n", __func__);
+                hb_mc_checkpoint_program_free (device);
+                return HB_MC_NOMEM;
+        }
 
-        error = hb_mc_loader_read_program_file (bin_name, &bin_data, &bin_size);
-        if (error != HB_MC_SUCCESS) { 
-                bsg_pr_err ("%s: failed to read binary file.\n", __func__); 
-                return error;
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(device->mc);
+        error = hb_mc_program_allocator_init (cfg, device->program, alloc_name, id);
+        if (error != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to initialize memory allocator for program %s.\n", __func__, device->program->bin_name);
+                hb_mc_checkpoint_program_free (device);
+                return HB_MC_UNINITIALIZED;
         }
 
+        awsbwhal::MemoryManager *mem_manager =
+                (awsbwhal::MemoryManager *) device->program->allocator->memory_manager;
+        mem_manager->restore(free_list, busy_list);
 
-        error = hb_mc_device_program_init_binary (      device, bin_name, 
-                                                        bin_data, bin_size, 
-                                                        alloc_name, id); 
-        if (error != HB_MC_SUCCESS) { 
-                bsg_pr_err("%s: failed to initialize device with program binary.\n", __func__);
-                return error;
-        }
+        memcpy(device->mesh->tiles, tiles.data(), num_tiles * sizeof(hb_mc_tile_t));
+        device->num_grids = hdr.num_grids;
 
         return HB_MC_SUCCESS;
 }
@@ -1243,7 +2047,6 @@ static int hb_mc_device_program_exit (hb_mc_program_t *program) {
 
 
         const char* bin_name;
-        const unsigned char* bin;
 
         // Free name
         bin_name = program->bin_name;
@@ -1256,13 +2059,15 @@ static int hb_mc_device_program_exit (hb_mc_program_t *program) {
         }
 
 
-        // Free binary
-        bin = program->bin;
-        if (!bin) { 
+        // Release binary
+        if (!program->image) { 
                 bsg_pr_err("%s: calling exit on program with null binary.\n", __func__);
                 return HB_MC_INVALID;
         } else {
-                free ((void *) bin); 
+                hb_mc_loader_plan_destroy (program->load_plan); 
+                program->load_plan = NULL;
+                hb_mc_program_image_release (program->image); 
+                program->image = NULL;
                 program->bin = NULL;
         }
 
@@ -1281,34 +2086,16 @@ static int hb_mc_device_program_exit (hb_mc_program_t *program) {
 
 
 /**
- * Copies the binary into the hb_mc_program_t struct's binary section
- * And sets the program's binary size in characters 
+ * Sets the program's image, and points the program's binary and
+ * binary size in characters at the image's
  * @param[in]  program       Pointer to program
- * @param[in]  bin_data      Buffer containing the binary
- * @param[in]  bin_size      Size of binary in characters
- * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ * @param[in]  image         Program image; the program takes over the caller's reference
  */
-static int hb_mc_program_binary_copy (hb_mc_program_t *program,
-                                      const unsigned char *bin_data,
-                                      size_t bin_size) { 
-
-        if (!bin_data) {
-                bsg_pr_err("%s: binary is null.\n", __func__);
-                return HB_MC_INVALID;
-        }
-
-        unsigned char* copy = (unsigned char*) malloc (bin_size);
-        if (!copy){ 
-                bsg_pr_err("%s: failed to allocated space on device for program binary.\n", __func__);
-                return HB_MC_NOMEM;
-        }
-
-        memcpy((unsigned char*) copy, (const unsigned char*) bin_data, bin_size);
-        
-        program->bin = copy; 
-        program->bin_size = bin_size;
-
-        return HB_MC_SUCCESS;   
+static void hb_mc_program_set_image (hb_mc_program_t *program,
+                                     hb_mc_program_image_t *image) { 
+        program->image = image;
+        program->bin = hb_mc_program_image_get_data (image);
+        program->bin_size = hb_mc_program_image_get_size (image);
 }
 
 
@@ -1341,7 +2128,7 @@ static int hb_mc_program_allocator_init (const hb_mc_config_t *cfg,
         program->allocator->id = id; 
 
         hb_mc_eva_t program_end_eva;
-        error = hb_mc_loader_symbol_to_eva(program->bin, program->bin_size, "_bsg_dram_end_addr", &program_end_eva); 
+        error = hb_mc_program_image_symbol_to_eva(program->image, "_bsg_dram_end_addr", &program_end_eva); 
         if (error != HB_MC_SUCCESS) { 
                 bsg_pr_err("%s: failed to acquire _bsg_dram_end_addr eva from binary file.\n", __func__); 
                 return HB_MC_INVALID;
@@ -1414,9 +2201,9 @@ static int hb_mc_program_allocator_exit (hb_mc_allocator_t *allocator) {
  */
 static int hb_mc_device_all_tile_groups_finished(hb_mc_device_t *device) {
         
-        hb_mc_tile_group_t *tg = device->tile_groups; 
-        for (int tg_num = 0; tg_num < device->num_tile_groups; tg_num ++, tg ++) {
-                if (tg->status != HB_MC_TILE_GROUP_STATUS_FINISHED )
+        const hb_mc_grid_t *grid = device->grids; 
+        for (uint32_t grid_num = 0; grid_num < device->num_queued_grids; grid_num ++, grid ++) {
+                if (grid->num_finished != grid->num_tile_groups)
                         return HB_MC_FAIL; 
         }
 
@@ -1446,44 +2233,47 @@ static int hb_mc_device_wait_for_tile_group_finish_any(hb_mc_device_t *device) {
                         return error;
                 }
 
-                /* Check all tile groups to see if the received packet is the finish packet from one of them */
-                hb_mc_tile_group_t *tg = device->tile_groups;
-                for (int tg_num = 0; tg_num < device->num_tile_groups; tg_num ++, tg ++) {
-                        if (tg->status == HB_MC_TILE_GROUP_STATUS_LAUNCHED) {
-
-                                hb_mc_request_packet_set_x_dst(&finish, hb_mc_coordinate_get_x(host_coordinate));
-                                hb_mc_request_packet_set_y_dst(&finish, hb_mc_coordinate_get_y(host_coordinate));
-                                hb_mc_request_packet_set_x_src(&finish, hb_mc_coordinate_get_x(tg->origin));
-                                hb_mc_request_packet_set_y_src(&finish, hb_mc_coordinate_get_y(tg->origin));
-                                hb_mc_request_packet_set_data(&finish, HB_MC_CUDA_FINISH_SIGNAL_VAL);
-                                hb_mc_request_packet_set_mask(&finish, HB_MC_PACKET_REQUEST_MASK_WORD);
-                                hb_mc_request_packet_set_op(&finish, HB_MC_PACKET_OP_REMOTE_STORE);
-                                hb_mc_request_packet_set_addr(&finish, tg->kernel->finish_signal_addr >> 2);
-
-                                if (hb_mc_request_packet_equals(&recv, &finish) == HB_MC_SUCCESS) {
+                /* Check all launched tile groups to see if the received packet is the finish packet from one of them */
+                for (uint32_t grid_num = 0; grid_num < device->num_queued_grids && !tile_group_finished; grid_num ++) {
+                        const hb_mc_grid_t *grid = &device->grids[grid_num];
+                        hb_mc_tile_group_t *tg = &device->tile_groups[grid->first_tile_group];
+                        for (uint32_t tg_num = 0; tg_num < grid->num_launched; tg_num ++, tg ++) {
+                                if (tg->status == HB_MC_TILE_GROUP_STATUS_LAUNCHED) {
+
+                                        hb_mc_request_packet_set_x_dst(&finish, hb_mc_coordinate_get_x(host_coordinate));
+                                        hb_mc_request_packet_set_y_dst(&finish, hb_mc_coordinate_get_y(host_coordinate));
+                                        hb_mc_request_packet_set_x_src(&finish, hb_mc_coordinate_get_x(tg->origin));
+                                        hb_mc_request_packet_set_y_src(&finish, hb_mc_coordinate_get_y(tg->origin));
+                                        hb_mc_request_packet_set_data(&finish, HB_MC_CUDA_FINISH_SIGNAL_VAL);
+                                        hb_mc_request_packet_set_mask(&finish, HB_MC_PACKET_REQUEST_MASK_WORD);
+                                        hb_mc_request_packet_set_op(&finish, HB_MC_PACKET_OP_REMOTE_STORE);
+                                        hb_mc_request_packet_set_addr(&finish, hb_mc_tile_group_get_finish_signal_addr(grid, tg) >> 2);
+
+                                        if (hb_mc_request_packet_equals(&recv, &finish) == HB_MC_SUCCESS) {
                 
-                                        bsg_pr_dbg("%s: Finish packet received for grid %d tile group (%d,%d): \
-                                                    src (%d,%d), dst (%d,%d), addr: 0x%08" PRIx32 ", data: %d.\n", 
-                                                   __func__, 
-                                                   tg->grid_id, 
-                                                   hb_mc_coordinate_get_x(tg->id), hb_mc_coordinate_get_y(tg->id), 
-                                                   recv.x_src, recv.y_src, 
-                                                   recv.x_dst, recv.y_dst, 
-                                                   recv.addr, recv.data);
-
-                                        error = hb_mc_tile_group_deallocate_tiles(device, tg);
-                                        if (error != HB_MC_SUCCESS) { 
-                                                bsg_pr_err("%s: failed to deallocate grid %d tile group (%d,%d).\n",
-                                                           __func__,
-                                                           tg->grid_id, hb_mc_coordinate_get_x(tg->id),
-                                                           hb_mc_coordinate_get_y(tg->id));
-                                                return error;
-                                        }
-                                        tile_group_finished = 1; 
-                                        break;
-                                }                               
-                        }
-                }       
+                                                bsg_pr_dbg("%s: Finish packet received for grid %d tile group (%d,%d): \
+                                                            src (%d,%d), dst (%d,%d), addr: 0x%08" PRIx32 ", data: %d.\n", 
+                                                           __func__, 
+                                                           grid->id, 
+                                                           hb_mc_coordinate_get_x(tg->id), hb_mc_coordinate_get_y(tg->id), 
+                                                           recv.x_src, recv.y_src, 
+                                                           recv.x_dst, recv.y_dst, 
+                                                           recv.addr, recv.data);
+
+                                                error = hb_mc_tile_group_deallocate_tiles(device, tg);
+                                                if (error != HB_MC_SUCCESS) { 
+                                                        bsg_pr_err("%s: failed to deallocate grid %d tile group (%d,%d).\n",
+                                                                   __func__,
+                                                                   grid->id, hb_mc_coordinate_get_x(tg->id),
+                                                                   hb_mc_coordinate_get_y(tg->id));
+                                                        return error;
+                                                }
+                                                tile_group_finished = 1; 
+                                                break;
+                                        }                               
+                                }
+                        }       
+                }
         }
 
         return HB_MC_SUCCESS;
@@ -1495,7 +2285,7 @@ static int hb_mc_device_wait_for_tile_group_finish_any(hb_mc_device_t *device) {
 /**
  * Iterates over all tile groups inside device, allocates those that fit in mesh and launches them. 
  * API remains in this function until all tile groups have successfully finished execution.
- * Number of tile groups is reset to zero after all tile groups are executed.
+ * Number of grids and tile groups is reset to zero after all tile groups are executed.
  * @param[in]  device        Pointer to device
  * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
  */
@@ -1504,17 +2294,25 @@ int hb_mc_device_tile_groups_execute (hb_mc_device_t *device) {
         int error ;
         /* loop untill all tile groups have been allocated, launched and finished. */
         while(hb_mc_device_all_tile_groups_finished(device) != HB_MC_SUCCESS) {
-                /* loop over all tile groups and try to launch as many as possible */
-                hb_mc_tile_group_t *tg = device->tile_groups;
-                for (int tg_num = 0; tg_num < device->num_tile_groups; tg_num ++, tg ++) { 
-                        if (tg->status == HB_MC_TILE_GROUP_STATUS_INITIALIZED) {
+                /* loop over all grids and try to launch as many tile groups as possible */
+                hb_mc_grid_t *grid = device->grids;
+                for (uint32_t grid_num = 0; grid_num < device->num_queued_grids; grid_num ++, grid ++) { 
+                        /* tile groups of a grid launch in order and have the same dimensions, */
+                        /* so once one of them does not fit, none of the following ones do */
+                        while (grid->num_launched < grid->num_tile_groups) {
+                                uint32_t tg_num = grid->first_tile_group + grid->num_launched;
+                                hb_mc_tile_group_t *tg = &device->tile_groups[tg_num];
                                 error = hb_mc_tile_group_allocate_tiles(device, tg) ;
-                                if (error == HB_MC_SUCCESS) {
-                                        error = hb_mc_tile_group_launch(device, tg);
-                                        if (error != HB_MC_SUCCESS) {
-                                                bsg_pr_err("%s: failed to launch tile group %d.\n", __func__, tg_num);
-                                                return error;
-                                        }
+                                if (error == HB_MC_NOTFOUND)
+                                        break;
+                                if (error != HB_MC_SUCCESS) {
+                                        bsg_pr_err("%s: failed to allocate tile group %d.\n", __func__, tg_num);
+                                        return error;
+                                }
+                                error = hb_mc_tile_group_launch(device, tg);
+                                if (error != HB_MC_SUCCESS) {
+                                        bsg_pr_err("%s: failed to launch tile group %d.\n", __func__, tg_num);
+                                        return error;
                                 }
                         }
                 }
@@ -1528,16 +2326,9 @@ int hb_mc_device_tile_groups_execute (hb_mc_device_t *device) {
 
         }
 
-        // Reset number of tile groups to zero
-        // Reset the device's tile group capacity to 1
-        // Readjust the space needed for device's tile groups 
-        device->num_tile_groups = 0;
-        device->tile_group_capacity = 1;
-        device->tile_groups = (hb_mc_tile_group_t *) realloc (device->tile_groups, device->tile_group_capacity * sizeof(hb_mc_tile_group_t));
-        if (device->tile_groups == NULL) {
-                bsg_pr_err("%s: failed to reset the space for hb_mc_tile_group_t structs.\n", __func__);
-                return HB_MC_NOMEM;
-        }
+        // Reset number of grids and tile groups to zero
+        // The space for them is kept for the next launch
+        hb_mc_device_grids_reset(device);
 
         return HB_MC_SUCCESS;
 }
@@ -1604,6 +2395,9 @@ int hb_mc_device_finish (hb_mc_device_t *device) {
                 return error;
         }
 
+        hb_mc_cache_tracker_exit(device->cache_tracker);
+        device->cache_tracker = NULL;
+
         return HB_MC_SUCCESS;
 }
 
@@ -1696,9 +2490,16 @@ int hb_mc_device_memcpy (hb_mc_device_t *device,
                 return hb_mc_device_memcpy_to_host(device, dst, src_eva, sz);
         }
 
+        else if (kind == HB_MC_MEMCPY_DEVICE_TO_DEVICE) {
+                hb_mc_eva_t dst_eva = (hb_mc_eva_t) reinterpret_cast<uintptr_t>(dst);
+                hb_mc_eva_t src_eva = (hb_mc_eva_t) reinterpret_cast<uintptr_t>(src);
+                return hb_mc_device_memcpy_device_to_device(device, dst_eva, src_eva, sz);
+        }
+
         else {
                 bsg_pr_err("%s: invalid copy type. Copy type can be one of \
-                            HB_MC_MEMCPY_TO_DEVICE or HB_MC_MEMCPY_TO_HOST.\n", __func__);
+                            HB_MC_MEMCPY_TO_DEVICE, HB_MC_MEMCPY_TO_HOST or \
+                            HB_MC_MEMCPY_DEVICE_TO_DEVICE.\n", __func__);
                 return HB_MC_INVALID;
         }
 
@@ -1721,6 +2522,7 @@ int hb_mc_device_memcpy_to_device(hb_mc_device_t *device,
 {
         int err;
         hb_mc_coordinate_t host = hb_mc_manycore_get_host_coordinate(device->mc);
+        hb_mc_cache_tracker_mesh_write(device->cache_tracker, daddr, bytes);
         err = hb_mc_manycore_eva_write(device->mc,
                                        &default_map,
                                        &host,
@@ -1751,6 +2553,7 @@ int hb_mc_device_memcpy_to_host(hb_mc_device_t *device,
         int err;
         hb_mc_coordinate_t host = hb_mc_manycore_get_host_coordinate(device->mc);
 
+        hb_mc_cache_tracker_mesh_read(device->cache_tracker, daddr, bytes);
         err = hb_mc_manycore_eva_read(device->mc,
                                       &default_map,
                                       &host,
@@ -1765,6 +2568,81 @@ int hb_mc_device_memcpy_to_host(hb_mc_device_t *device,
         return HB_MC_SUCCESS;
 }
 
+/**
+ * Copies a buffer from src on device DRAM to dst on device DRAM.
+ * @param[in]  device        Pointer to device
+ * @parma[in]  dst           EVA address of destination to be copied into
+ * @parma[in]  src           EVA address of source to be copied from
+ * @param[in]  bytes         Size of buffer to be copied
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_device_memcpy_device_to_device(hb_mc_device_t *device,
+                                         hb_mc_eva_t dst,
+                                         hb_mc_eva_t src,
+                                         uint32_t bytes)
+{
+        int err;
+        hb_mc_coordinate_t host = hb_mc_manycore_get_host_coordinate(device->mc);
+
+        hb_mc_cache_tracker_mesh_read(device->cache_tracker, src, bytes);
+        hb_mc_cache_tracker_mesh_write(device->cache_tracker, dst, bytes);
+        err = hb_mc_manycore_eva_copy(device->mc,
+                                      &default_map,
+                                      &host,
+                                      &dst, &src, bytes);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to copy memory on device: %s\n",
+                           __func__,
+                           hb_mc_strerror(err));
+                return err;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Copies a list of buffers between the host and the device.
+ * @param[in]  device        Pointer to device
+ * @param[in]  iov           List of buffers to be copied
+ * @param[in]  n             Number of buffers in #iov
+ * @param[in]  kind          Direction of copy (HB_MC_MEMCPY_TO_DEVICE / HB_MC_MEMCPY_TO_HOST)
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_device_memcpy_vec(hb_mc_device_t *device,
+                            const hb_mc_iovec_t *iov,
+                            size_t n,
+                            enum hb_mc_memcpy_kind kind)
+{
+        int err;
+        hb_mc_coordinate_t host = hb_mc_manycore_get_host_coordinate(device->mc);
+
+        if (kind == HB_MC_MEMCPY_TO_DEVICE) {
+                for (size_t i = 0; i < n; i++)
+                        hb_mc_cache_tracker_mesh_write(device->cache_tracker, iov[i].eva, iov[i].sz);
+                err = hb_mc_manycore_eva_write_vec(device->mc, &default_map, &host, iov, n);
+        }
+        else if (kind == HB_MC_MEMCPY_TO_HOST) {
+                for (size_t i = 0; i < n; i++)
+                        hb_mc_cache_tracker_mesh_read(device->cache_tracker, iov[i].eva, iov[i].sz);
+                err = hb_mc_manycore_eva_read_vec(device->mc, &default_map, &host, iov, n);
+        }
+        else {
+                bsg_pr_err("%s: invalid copy type. Copy type can be one of \
+                            HB_MC_MEMCPY_TO_DEVICE or HB_MC_MEMCPY_TO_HOST.\n", __func__);
+                return HB_MC_INVALID;
+        }
+
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to copy %zu buffers %s device: %s\n",
+                           __func__, n,
+                           kind == HB_MC_MEMCPY_TO_DEVICE ? "to" : "from",
+                           hb_mc_strerror(err));
+                return err;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
 /**
  * Sets memory to a give value starting from an address in device's DRAM.
  * @param[in]  device        Pointer to device
@@ -1782,6 +2660,7 @@ int hb_mc_device_memset (hb_mc_device_t *device,
         const hb_mc_config_t *cfg = hb_mc_manycore_get_config (device->mc); 
         hb_mc_coordinate_t host_coordinate = hb_mc_manycore_get_host_coordinate(device->mc); 
 
+        hb_mc_cache_tracker_mesh_write(device->cache_tracker, *eva, sz);
         error = hb_mc_manycore_eva_memset (device->mc, 
                                            &default_map, 
                                            &host_coordinate, 
@@ -1798,16 +2677,115 @@ int hb_mc_device_memset (hb_mc_device_t *device,
 
 
 
+/**
+ * Applies an atomic memory operation to a word in device memory.
+ * @param[in]  device        Pointer to device
+ * @param[in]  eva           EVA address of a word in device memory
+ * @param[in]  amo           The atomic operation to apply
+ * @param[in]  operand       The operand of #amo
+ * @param[out] old           Set to the value of the word before #amo. May be NULL.
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_device_amo(hb_mc_device_t *device,
+                     hb_mc_eva_t eva,
+                     hb_mc_packet_amo_t amo,
+                     uint32_t operand,
+                     uint32_t *old)
+{
+        int err;
+        hb_mc_coordinate_t host = hb_mc_manycore_get_host_coordinate(device->mc);
+        hb_mc_npa_t npa;
+        size_t sz;
+
+        err = hb_mc_eva_to_npa(device->mc, &default_map, &host, &eva, &npa, &sz);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to translate EVA 0x%08" PRIx32 ": %s\n",
+                           __func__, eva, hb_mc_strerror(err));
+                return err;
+        }
+
+        if (sz < sizeof(uint32_t)) {
+                bsg_pr_err("%s: EVA 0x%08" PRIx32 " does not map a whole word\n",
+                           __func__, eva);
+                return HB_MC_INVALID;
+        }
+
+        hb_mc_cache_tracker_mesh_write(device->cache_tracker, eva, sizeof(uint32_t));
+        err = hb_mc_manycore_amo(device->mc, &npa, amo, operand, old);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to apply atomic operation: %s\n",
+                           __func__, hb_mc_strerror(err));
+                return err;
+        }
+
+        return HB_MC_SUCCESS;
+}
 
 /**
- * Calculates and returns a tile group's finish signal address based on tile group id and grid dimension
+ * Atomically adds to a word in device memory.
+ * @param[in]  device        Pointer to device
+ * @param[in]  eva           EVA address of a word in device memory
+ * @param[in]  v             The value to add
+ * @param[out] old           Set to the value of the word before the add. May be NULL.
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_device_amo_add(hb_mc_device_t *device, hb_mc_eva_t eva, uint32_t v, uint32_t *old)
+{
+        return hb_mc_device_amo(device, eva, HB_MC_PACKET_AMO_ADD, v, old);
+}
+
+/**
+ * Atomically swaps a word in device memory.
+ * @param[in]  device        Pointer to device
+ * @param[in]  eva           EVA address of a word in device memory
+ * @param[in]  v             The value to store
+ * @param[out] old           Set to the value of the word before the swap. May be NULL.
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_device_amo_swap(hb_mc_device_t *device, hb_mc_eva_t eva, uint32_t v, uint32_t *old)
+{
+        return hb_mc_device_amo(device, eva, HB_MC_PACKET_AMO_SWAP, v, old);
+}
+
+/**
+ * Atomically ors a value into a word in device memory.
+ * @param[in]  device        Pointer to device
+ * @param[in]  eva           EVA address of a word in device memory
+ * @param[in]  v             The value to or in
+ * @param[out] old           Set to the value of the word before the or. May be NULL.
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_device_amo_or(hb_mc_device_t *device, hb_mc_eva_t eva, uint32_t v, uint32_t *old)
+{
+        return hb_mc_device_amo(device, eva, HB_MC_PACKET_AMO_OR, v, old);
+}
+
+/**
+ * Atomically ands a value into a word in device memory.
  * @param[in]  device        Pointer to device
+ * @param[in]  eva           EVA address of a word in device memory
+ * @param[in]  v             The value to and in
+ * @param[out] old           Set to the value of the word before the and. May be NULL.
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_device_amo_and(hb_mc_device_t *device, hb_mc_eva_t eva, uint32_t v, uint32_t *old)
+{
+        return hb_mc_device_amo(device, eva, HB_MC_PACKET_AMO_AND, v, old);
+}
+
+
+
+
+/**
+ * Calculates and returns a tile group's finish signal address based on tile group id and grid dimension
+ * @param[in]  grid          Pointer to the tile group's grid
  * @parma[in]  tg            Pointer to tile group 
  * @return     finish_signal_addr
  */
-static hb_mc_epa_t hb_mc_tile_group_get_finish_signal_addr(hb_mc_tile_group_t *tg) { 
-        hb_mc_epa_t finish_addr = HB_MC_CUDA_HOST_FINISH_SIGNAL_BASE_ADDR
-                + ((hb_mc_coordinate_get_y(tg->id) * hb_mc_dimension_get_x(tg->grid_dim)
+static hb_mc_epa_t hb_mc_tile_group_get_finish_signal_addr(const hb_mc_grid_t *grid,
+                                                           const hb_mc_tile_group_t *tg) { 
+        hb_mc_epa_t finish_addr = grid->kernel.finish_signal_addr
+                + ((hb_mc_coordinate_get_y(tg->id) * hb_mc_dimension_get_x(grid->dim)
                     + hb_mc_coordinate_get_x(tg->id)) << 2); 
         return finish_addr;
 }
@@ -1843,15 +2821,10 @@ static int hb_mc_device_tiles_freeze (hb_mc_device_t *device,
                                       const hb_mc_coordinate_t *tiles,
                                       uint32_t num_tiles) { 
         int error;
-        for (hb_mc_idx_t tile_id = 0; tile_id < num_tiles; tile_id ++) { 
-                error = hb_mc_tile_freeze(device->mc, &tiles[tile_id]); 
-                if (error != HB_MC_SUCCESS) { 
-                        bsg_pr_err("%s: failed to freeze tile (%d,%d).\n",
-                                   __func__,
-                                   hb_mc_coordinate_get_x(tiles[tile_id]),
-                                   hb_mc_coordinate_get_y(tiles[tile_id]));
-                        return error;
-                }
+        error = hb_mc_tiles_freeze(device->mc, tiles, num_tiles);
+        if (error != HB_MC_SUCCESS) { 
+                bsg_pr_err("%s: failed to freeze tiles.\n", __func__);
+                return error;
         }
         return HB_MC_SUCCESS;
 }
@@ -1880,8 +2853,7 @@ static int hb_mc_device_tiles_unfreeze (hb_mc_device_t *device,
                 // Set the tile's cuda_kernel_ptr_eva symbol to HB_MC_CUDA_KERNEL_NOT_LOADED_VAL
                 error = hb_mc_tile_set_symbol_val(device->mc,
                                                   map,
-                                                  device->program->bin,
-                                                  device->program->bin_size,
+                                                  device->program->image,
                                                   &(tiles[tile_id]),
                                                   "cuda_kernel_ptr",
                                                   &kernel_eva);
@@ -1892,15 +2864,13 @@ static int hb_mc_device_tiles_unfreeze (hb_mc_device_t *device,
                                    hb_mc_coordinate_get_y(tiles[tile_id]));
                         return error;
                 }
+        }
 
-                error = hb_mc_tile_unfreeze(device->mc, &tiles[tile_id]);
-                if (error != HB_MC_SUCCESS) { 
-                        bsg_pr_err("%s: failed to unfreeze tile (%d,%d).\n",
-                                   __func__,
-                                   hb_mc_coordinate_get_x(tiles[tile_id]),
-                                   hb_mc_coordinate_get_y(tiles[tile_id]));
-                        return error;
-                }
+        // Unfreeze only once every tile's kernel pointer has been reset
+        error = hb_mc_tiles_unfreeze(device->mc, tiles, num_tiles);
+        if (error != HB_MC_SUCCESS) { 
+                bsg_pr_err("%s: failed to unfreeze tiles.\n", __func__);
+                return error;
         }
         return HB_MC_SUCCESS;
 }
@@ -1914,8 +2884,7 @@ static int hb_mc_device_tiles_unfreeze (hb_mc_device_t *device,
  * Behavior is undefined if #mc is not initialized with hb_mc_manycore_init().
  * @param[in] mc         A manycore instance initialized with hb_mc_manycore_init().
  * @param[in] map        Eva to npa mapping. 
- * @param[in] bin        Binary elf file. 
- * @param[in] bin_size   Size of binary file. 
+ * @param[in] image      Program image of the binary. 
  * @param[in] coord      Tile coordinates to set the tile group id of.
  * @param[in] symbol     Symbol to be set in tile's binary
  * @param[in] val        Val to set the symbol 
@@ -1923,8 +2892,7 @@ static int hb_mc_device_tiles_unfreeze (hb_mc_device_t *device,
  */
 static int hb_mc_tile_set_symbol_val (hb_mc_manycore_t *mc,
                                       const hb_mc_eva_map_t *map,
-                                      const unsigned char* bin,
-                                      size_t bin_size,
+                                      const hb_mc_program_image_t *image,
                                       const hb_mc_coordinate_t *coord,
                                       const char* symbol,
                                       const uint32_t *val) {
@@ -1932,7 +2900,7 @@ static int hb_mc_tile_set_symbol_val (hb_mc_manycore_t *mc,
         int error;
 
         hb_mc_eva_t symbol_eva;
-        error = hb_mc_loader_symbol_to_eva(bin, bin_size, symbol, &symbol_eva); 
+        error = hb_mc_program_image_symbol_to_eva(image, symbol, &symbol_eva); 
         if (error != HB_MC_SUCCESS) { 
                 bsg_pr_err("%s: failed to acquire %s symbol's eva.\n",
                            __func__,
@@ -1951,15 +2919,66 @@ static int hb_mc_tile_set_symbol_val (hb_mc_manycore_t *mc,
                            __func__,
                            symbol,
                            hb_mc_coordinate_get_x(*coord),
-                           hb_mc_coordinate_get_y(*coord)); 
+                           hb_mc_coordinate_get_y(*coord)); 
+                return error;
+        }
+        bsg_pr_dbg("%s: Setting tile (%d,%d) %s symbol (eva 0x%08" PRIx32 ") to 0x%08" PRIx32 ".\n",
+                   __func__,
+                   hb_mc_coordinate_get_x(*coord),
+                   hb_mc_coordinate_get_y(*coord),
+                   symbol,
+                   symbol_eva,
+                   *val);
+
+        return HB_MC_SUCCESS;
+}
+
+
+
+
+
+/**
+ * Translates a symbol in a tile's binary to an NPA, and appends a write of
+ * a value to it to a list of writes.
+ * @param[in]  device        Pointer to device
+ * @param[in]  grid          Grid whose symbol addresses are used
+ * @param[in]  map           EVA to NPA mapping for the tile
+ * @param[in]  coord         Tile coordinates
+ * @param[in]  symbol        Symbol to be set in tile's binary
+ * @param[in]  val           Value to set the symbol to; must outlive the write
+ * @param[out] iov           List of writes to append to
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+static int hb_mc_tile_symbol_iovec_push (hb_mc_device_t *device,
+                                         const hb_mc_grid_t *grid,
+                                         const hb_mc_eva_map_t *map,
+                                         const hb_mc_coordinate_t *coord,
+                                         hb_mc_cuda_symbol_t symbol,
+                                         uint32_t *val,
+                                         std::vector<hb_mc_npa_iovec_t> &iov) {
+        hb_mc_npa_iovec_t seg;
+        size_t sz;
+
+        int error = hb_mc_eva_to_npa (device->mc, map, coord, &grid->symbols[symbol], &seg.npa, &sz);
+        if (error != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to translate tile (%d,%d) %s symbol's eva.\n",
+                           __func__,
+                           hb_mc_coordinate_get_x(*coord),
+                           hb_mc_coordinate_get_y(*coord),
+                           hb_mc_cuda_symbol_names[symbol]);
                 return error;
         }
+
+        seg.data = val;
+        seg.sz = sizeof(*val);
+        iov.push_back(seg);
+
         bsg_pr_dbg("%s: Setting tile (%d,%d) %s symbol (eva 0x%08" PRIx32 ") to 0x%08" PRIx32 ".\n",
                    __func__,
                    hb_mc_coordinate_get_x(*coord),
                    hb_mc_coordinate_get_y(*coord),
-                   symbol,
-                   symbol_eva,
+                   hb_mc_cuda_symbol_names[symbol],
+                   grid->symbols[symbol],
                    *val);
 
         return HB_MC_SUCCESS;
@@ -1968,283 +2987,106 @@ static int hb_mc_tile_set_symbol_val (hb_mc_manycore_t *mc,
 
 
 
-
 /**
  * Sends packets to all tiles in the list to set their configuration symbols in binary 
  * Symbols include: __bsg_x/y, __bsg_id, __bsg_grp_org_x/y, CSR_TGO_X/Y registers,
  * __bsg_tile_group_id_x/y, __bsg_grid_dim_x/y 
+ * The symbols of all tiles are written together, and completed with a single fence.
  * @param[in]  device        Pointer to device
+ * @param[in]  grid          Grid of the tiles in the list
  * @param[in]  map           EVA to NPA mapping for tiles 
  * @param[in]  origin        Origin  coordinates of the tiles in the list
  * @param[in]  tg_id         Tile group id of the tiles in the list
- * @param[in]  tg_dim        Tile group dimensions of the tiles in the list
- * @param[in]  grid_dim      Grid dimensions of the tiles in the list
  * @param[in]  tiles         List of tile coordinates to set symbols 
  * @param[in]  num_tiles     Number of tiles in the list
  * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
  */
 static int hb_mc_device_tiles_set_config_symbols (hb_mc_device_t *device,
+                                                  const hb_mc_grid_t *grid,
                                                   const hb_mc_eva_map_t *map, 
                                                   hb_mc_coordinate_t origin,
                                                   hb_mc_coordinate_t tg_id,
-                                                  hb_mc_dimension_t tg_dim, 
-                                                  hb_mc_dimension_t grid_dim,
                                                   const hb_mc_coordinate_t *tiles,
                                                   uint32_t num_tiles) { 
 
         int error;
+        const int num_symbols = HB_MC_CUDA_SYMBOL_KERNEL_NOT_LOADED_VAL + 1;
 
-        for (hb_mc_idx_t tile_id = 0; tile_id < num_tiles; tile_id ++) { 
-                
-                hb_mc_coordinate_t coord = hb_mc_coordinate_get_relative (origin, tiles[tile_id]); 
-
-                error = hb_mc_tile_set_origin_registers(device->mc,
-                                                        &(tiles[tile_id]),
-                                                        &origin);
-                if (error != HB_MC_SUCCESS) { 
-                        bsg_pr_err("%s: failed to set tile (%d,%d) tile group origin registers CSR_TGO_X/Y.\n",
-                                   __func__,
-                                   hb_mc_coordinate_get_x(tiles[tile_id]),
-                                   hb_mc_coordinate_get_y(tiles[tile_id]));
-                        return error;
-                }
-
-
-
-                // Set tile's tile group origin __bsg_grp_org_x/y symbols.
-                hb_mc_idx_t origin_x = hb_mc_coordinate_get_x (origin); 
-                hb_mc_idx_t origin_y = hb_mc_coordinate_get_y (origin); 
-                error = hb_mc_tile_set_symbol_val(device->mc,
-                                                  map,
-                                                  device->program->bin,
-                                                  device->program->bin_size,
-                                                  &(tiles[tile_id]),
-                                                  "__bsg_grp_org_x",
-                                                  &origin_x);
-                if (error != HB_MC_SUCCESS) { 
-                        bsg_pr_err("%s: failed to set tile (%d,%d) __bsg_grp_org_x symbol.\n",
-                                   __func__,
-                                   hb_mc_coordinate_get_x(tiles[tile_id]),
-                                   hb_mc_coordinate_get_y(tiles[tile_id]));
-                        return error;
-                }
-
+        // Set all tiles' tile group origin registers CSR_TGO_X/Y at once
+        error = hb_mc_tiles_set_origin(device->mc, tiles, num_tiles, &origin);
+        if (error != HB_MC_SUCCESS) { 
+                bsg_pr_err("%s: failed to set tile group origin registers CSR_TGO_X/Y.\n",
+                           __func__);
+                return error;
+        }
 
-                error = hb_mc_tile_set_symbol_val(device->mc,
-                                                  map,
-                                                  device->program->bin,
-                                                  device->program->bin_size,
-                                                  &(tiles[tile_id]),
-                                                  "__bsg_grp_org_y",
-                                                  &origin_y);
-                if (error != HB_MC_SUCCESS) { 
-                        bsg_pr_err("%s: failed to set tile (%d,%d) __bsg_grp_org_y symbol.\n",
-                                   __func__,
-                                   hb_mc_coordinate_get_x(tiles[tile_id]),
-                                   hb_mc_coordinate_get_y(tiles[tile_id]));
-                        return error;
-                }
+        // Values written by the tile group's writes, which refer to them until sent
+        std::vector<uint32_t> vals(num_tiles * num_symbols);
+        std::vector<hb_mc_npa_iovec_t> iov;
+        iov.reserve(vals.size());
 
+        // Tile group index __bsg_tile_group_id_x/y.
+        // Grid is a 2D array of tile groups representing an application
+        // bsg_tile_group_id uniquely identifies each tile group in a grid.
+        // The flat tile group id is calculated using the grid dimensions
+        // and the tile group X/Y coordinates relative to grid origin as follows:
+        // __bsg_tile_group_id = __bsg_tile_group_id_y * __bsg_grid_dim_x + __bsg_tile_group_id_x
+        // bsg_tile_group_id is used in bsg_print_stat to distinguish between
+        // unique tile group invocations that have been executed in sequence on the same tile(s).
+        hb_mc_idx_t tg_id_x = hb_mc_coordinate_get_x (tg_id); 
+        hb_mc_idx_t tg_id_y = hb_mc_coordinate_get_y (tg_id);
+        hb_mc_idx_t tg_id_flat = tg_id_y * hb_mc_dimension_get_x(grid->dim) + tg_id_x;
 
+        for (hb_mc_idx_t tile_id = 0; tile_id < num_tiles; tile_id ++) { 
+                
+                hb_mc_coordinate_t coord = hb_mc_coordinate_get_relative (origin, tiles[tile_id]); 
+                uint32_t *val = &vals[tile_id * num_symbols];
 
+                // Tile group origin __bsg_grp_org_x/y.
+                val[HB_MC_CUDA_SYMBOL_GRP_ORG_X] = hb_mc_coordinate_get_x (origin);
+                val[HB_MC_CUDA_SYMBOL_GRP_ORG_Y] = hb_mc_coordinate_get_y (origin);
 
-                // Set tile's index __bsg_x/y symbols.
+                // Tile index __bsg_x/y.
                 // A tile's __bsg_x/y symbols represent its X/Y 
                 // coordinates with respect to the origin tile 
-                hb_mc_idx_t coord_x = hb_mc_coordinate_get_x (coord); 
-                hb_mc_idx_t coord_y = hb_mc_coordinate_get_y (coord); 
-                error = hb_mc_tile_set_symbol_val(device->mc,
-                                                  map,
-                                                  device->program->bin,
-                                                  device->program->bin_size,
-                                                  &(tiles[tile_id]),
-                                                  "__bsg_x",
-                                                  &coord_x);
-                if (error != HB_MC_SUCCESS) { 
-                        bsg_pr_err("%s: failed to set tile (%d,%d) __bsg_x symbol.\n",
-                                   __func__,
-                                   hb_mc_coordinate_get_x(tiles[tile_id]),
-                                   hb_mc_coordinate_get_y(tiles[tile_id]));
-                        return error;
-                }
-
-
-                error = hb_mc_tile_set_symbol_val(device->mc,
-                                                  map,
-                                                  device->program->bin,
-                                                  device->program->bin_size,
-                                                  &(tiles[tile_id]),
-                                                  "__bsg_y",
-                                                  &coord_y);
-                if (error != HB_MC_SUCCESS) { 
-                        bsg_pr_err("%s: failed to set tile (%d,%d) __bsg_y symbol.\n",
-                                   __func__,
-                                   hb_mc_coordinate_get_x(tiles[tile_id]),
-                                   hb_mc_coordinate_get_y(tiles[tile_id]));
-                        return error;
-                }
+                val[HB_MC_CUDA_SYMBOL_X] = hb_mc_coordinate_get_x (coord);
+                val[HB_MC_CUDA_SYMBOL_Y] = hb_mc_coordinate_get_y (coord);
 
-
-
-
-                // Set tile's __bsg_id symbol.
+                // Tile id __bsg_id.
                 // bsg_id uniquely identifies each tile in a tile group
                 // Tile group is a 2D array of tiles that concurrently run a kernel inside the binary
                 // __bsg_x/y represent the X/Y coordiantes of tile relative to tile group origin
                 // The flat tile id is calculated using tile group dimensions 
                 // and the tile group X/Y coordiantes relative to tile group origin as follows:
                 // __bsg_id = __bsg_y * __bsg_tile_group_dim_x + __bsg_x
-                hb_mc_idx_t id = hb_mc_coordinate_get_y(coord) * hb_mc_dimension_get_x(tg_dim) + hb_mc_coordinate_get_x(coord); 
-                error = hb_mc_tile_set_symbol_val(device->mc,
-                                                  map,
-                                                  device->program->bin,
-                                                  device->program->bin_size,
-                                                  &(tiles[tile_id]),
-                                                  "__bsg_id",
-                                                  &id);
-                if (error != HB_MC_SUCCESS) { 
-                        bsg_pr_err("%s: failed to set tile (%d,%d) __bsg_id symbol.\n",
-                                   __func__,
-                                   hb_mc_coordinate_get_x(tiles[tile_id]),
-                                   hb_mc_coordinate_get_y(tiles[tile_id]));
-                        return error;
-                }
-        
-
-
-
-                // Set tile's tile group index __bsg_tile_group_id_x/y symbols.
-                // Grid is a 2D array of tile groups representing an application
-                // bsg_tile_group_id uniquely identifies each tile group in a grid.
-                // The flat tile group id is calculated using the grid dimensions
-                // and the tile group X/Y coordinates relative to grid origin as follows:
-                // __bsg_tile_group_id = __bsg_tile_group_id_y * __bsg_grid_dim_x + __bsg_tile_group_id_x
-                // bsg_tile_group_id is used in bsg_print_stat to distinguish between
-                // unique tile group invocations that have been executed in sequence on the same tile(s).
-                hb_mc_idx_t tg_id_x = hb_mc_coordinate_get_x (tg_id); 
-                hb_mc_idx_t tg_id_y = hb_mc_coordinate_get_y (tg_id);
-                hb_mc_idx_t tg_id = tg_id_y * hb_mc_dimension_get_x(grid_dim) + tg_id_x;
-                error = hb_mc_tile_set_symbol_val(device->mc,
-                                                  map,
-                                                  device->program->bin,
-                                                  device->program->bin_size,
-                                                  &(tiles[tile_id]),
-                                                  "__bsg_tile_group_id_x",
-                                                  &tg_id_x);
-                if (error != HB_MC_SUCCESS) { 
-                        bsg_pr_err("%s: failed to set tile (%d,%d) __bsg_tile_group_id_x symbol.\n",
-                                   __func__,
-                                   hb_mc_coordinate_get_x(tiles[tile_id]),
-                                   hb_mc_coordinate_get_y(tiles[tile_id]));
-                        return error;
-                }
-
-
-                error = hb_mc_tile_set_symbol_val(device->mc,
-                                                  map,
-                                                  device->program->bin,
-                                                  device->program->bin_size,
-                                                  &(tiles[tile_id]),
-                                                  "__bsg_tile_group_id_y",
-                                                  &tg_id_y);
-                if (error != HB_MC_SUCCESS) { 
-                        bsg_pr_err("%s: failed to set tile (%d,%d) __bsg_tile_group_id_y symbol.\n",
-                                   __func__,
-                                   hb_mc_coordinate_get_x(tiles[tile_id]),
-                                   hb_mc_coordinate_get_y(tiles[tile_id]));
-                        return error;
-                }
-
-
-                error = hb_mc_tile_set_symbol_val(device->mc,
-                                                  map,
-                                                  device->program->bin,
-                                                  device->program->bin_size,
-                                                  &(tiles[tile_id]),
-                                                  "__bsg_tile_group_id",
-                                                  &tg_id);
-                if (error != HB_MC_SUCCESS) { 
-                        bsg_pr_err("%s: failed to set tile (%d,%d) __bsg_tile_group_id symbol.\n",
-                                    __func__,
-                                    hb_mc_coordinate_get_x(tiles[tile_id]),
-                                    hb_mc_coordinate_get_y(tiles[tile_id]));
-                        return error;
-                }
-
-
-
-                // Set tile's grid dimension __bsg_grid_dim_x/y symbol.
-                hb_mc_idx_t grid_dim_x = hb_mc_dimension_get_x (grid_dim); 
-                hb_mc_idx_t grid_dim_y = hb_mc_dimension_get_y (grid_dim);
-                error = hb_mc_tile_set_symbol_val(device->mc,
-                                                  map,
-                                                  device->program->bin,
-                                                  device->program->bin_size,
-                                                  &(tiles[tile_id]),
-                                                  "__bsg_grid_dim_x",
-                                                  &grid_dim_x);
-                if (error != HB_MC_SUCCESS) { 
-                        bsg_pr_err("%s: failed to set tile (%d,%d) __bsg_grid_dim_x symbol.\n",
-                                   __func__,
-                                   hb_mc_coordinate_get_x(tiles[tile_id]),
-                                   hb_mc_coordinate_get_y(tiles[tile_id]));
-                        return error;
-                }
-
-
-                error = hb_mc_tile_set_symbol_val(device->mc,
-                                                  map,
-                                                  device->program->bin,
-                                                  device->program->bin_size,
-                                                  &(tiles[tile_id]),
-                                                  "__bsg_grid_dim_y",
-                                                  &grid_dim_y);
-                if (error != HB_MC_SUCCESS) { 
-                        bsg_pr_err("%s: failed to set tile (%d,%d) __bsg_grid_dim_y symbol.\n",
-                                   __func__,
-                                   hb_mc_coordinate_get_x(tiles[tile_id]),
-                                   hb_mc_coordinate_get_y(tiles[tile_id]));
-                        return error;
-                }
-
-
-
-                // Set tile's finish signal value  cuda_finish_signal_val symbol.
-                uint32_t finish_signal_val = HB_MC_CUDA_FINISH_SIGNAL_VAL;
-                error = hb_mc_tile_set_symbol_val(device->mc,
-                                                  map,
-                                                  device->program->bin,
-                                                  device->program->bin_size,
-                                                  &(tiles[tile_id]),
-                                                  "cuda_finish_signal_val",
-                                                  &finish_signal_val);
-                if (error != HB_MC_SUCCESS) { 
-                        bsg_pr_err("%s: failed to set tile (%d,%d) cuda_finish_signal_val symbol.\n",
-                                   __func__,
-                                   hb_mc_coordinate_get_x(tiles[tile_id]),
-                                   hb_mc_coordinate_get_y(tiles[tile_id]));
-                        return error;
+                val[HB_MC_CUDA_SYMBOL_ID] = hb_mc_coordinate_get_y(coord) * hb_mc_dimension_get_x(grid->tg_dim)
+                        + hb_mc_coordinate_get_x(coord);
+
+                val[HB_MC_CUDA_SYMBOL_TILE_GROUP_ID_X] = tg_id_x;
+                val[HB_MC_CUDA_SYMBOL_TILE_GROUP_ID_Y] = tg_id_y;
+                val[HB_MC_CUDA_SYMBOL_TILE_GROUP_ID] = tg_id_flat;
+
+                // Grid dimension __bsg_grid_dim_x/y.
+                val[HB_MC_CUDA_SYMBOL_GRID_DIM_X] = hb_mc_dimension_get_x (grid->dim);
+                val[HB_MC_CUDA_SYMBOL_GRID_DIM_Y] = hb_mc_dimension_get_y (grid->dim);
+
+                // Finish signal value cuda_finish_signal_val and
+                // kernel not loaded value cuda_kernel_not_loaded_val.
+                val[HB_MC_CUDA_SYMBOL_FINISH_SIGNAL_VAL] = HB_MC_CUDA_FINISH_SIGNAL_VAL;
+                val[HB_MC_CUDA_SYMBOL_KERNEL_NOT_LOADED_VAL] = HB_MC_CUDA_KERNEL_NOT_LOADED_VAL;
+
+                for (int symbol = 0; symbol < num_symbols; symbol ++) {
+                        error = hb_mc_tile_symbol_iovec_push(device, grid, map, &tiles[tile_id],
+                                                             (hb_mc_cuda_symbol_t) symbol, &val[symbol], iov);
+                        if (error != HB_MC_SUCCESS)
+                                return error;
                 }
+        }
 
-
-
-
-                // Set tile's kernel not loaded value  cuda_kernel_not_loaded_val symbol.
-                uint32_t kernel_not_loaded_val = HB_MC_CUDA_KERNEL_NOT_LOADED_VAL;
-                error = hb_mc_tile_set_symbol_val(device->mc,
-                                                  map,
-                                                  device->program->bin,
-                                                  device->program->bin_size,
-                                                  &(tiles[tile_id]),
-                                                  "cuda_kernel_not_loaded_val",
-                                                  &kernel_not_loaded_val);
-                if (error != HB_MC_SUCCESS) { 
-                        bsg_pr_err("%s: failed to set tile (%d,%d) cuda_kernel_not_loaded_val symbol.\n",
-                                   __func__,
-                                   hb_mc_coordinate_get_x(tiles[tile_id]),
-                                   hb_mc_coordinate_get_y(tiles[tile_id]));
-                        return error;
-                }
+        error = hb_mc_manycore_write_mem_vec(device->mc, iov.data(), iov.size());
+        if (error != HB_MC_SUCCESS) { 
+                bsg_pr_err("%s: failed to set tiles configuration symbols.\n", __func__);
+                return error;
         }
 
         return HB_MC_SUCCESS; 
@@ -2257,112 +3099,142 @@ static int hb_mc_device_tiles_set_config_symbols (hb_mc_device_t *device,
 /**
  * Sends packets to all tiles in the list to set their runtime symbols in binary 
  * Symbols include: cuda_kernel_ptr, cuda_argc, cuda_argv_ptr, cuda_finish_signal_addr
+ * cuda_kernel_ptr starts the kernel, so it is only written once every
+ * tile's other symbols have been written.
  * @param[in]  device        Pointer to device
+ * @param[in]  grid          Grid of the tiles in the list, with its kernel and argument block
  * @param[in]  map           EVA to NPA mapping for tiles 
- * @param[in]  argc          Kernel's argument count for cuda_argc symbol
- * @param[in]  args_eva      Kernel's pointer to argument list for cuda_argv_ptr symbol
  * @param[in]  finish_signal_npa   Kernel's finish signal npa
- * @param[in]  kernel_eva    EVA address of kernel on DRAM for cuda_kernel_ptr symbols
  * @param[in]  tiles         List of tile coordinates to set symbols 
  * @param[in]  num_tiles     Number of tiles in the list
  * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
  */
 static int hb_mc_device_tiles_set_runtime_symbols (     hb_mc_device_t *device,
+                                                        const hb_mc_grid_t *grid,
                                                         const hb_mc_eva_map_t *map, 
-                                                        uint32_t argc, 
-                                                        hb_mc_eva_t args_eva,
                                                         hb_mc_npa_t finish_signal_npa, 
-                                                        hb_mc_eva_t kernel_eva, 
                                                         const hb_mc_coordinate_t *tiles,
                                                         uint32_t num_tiles) { 
         int error;
-        const hb_mc_config_t *cfg = hb_mc_manycore_get_config (device->mc); 
+        uint32_t argc = grid->kernel.argc;
+        hb_mc_eva_t args_eva = grid->args_eva;
+        hb_mc_eva_t kernel_eva = grid->kernel_eva;
 
+        // Finish signal addresses differ per tile; the other values are shared
+        std::vector<hb_mc_eva_t> finish_signal_eva(num_tiles);
+        std::vector<hb_mc_npa_iovec_t> iov;
+        iov.reserve(3 * num_tiles);
 
         for (hb_mc_idx_t tile_id = 0; tile_id < num_tiles; tile_id ++) { 
 
-
-                // Set tile's argument count cuda_argc symbol.
-                error = hb_mc_tile_set_symbol_val(device->mc,
-                                                  map,
-                                                  device->program->bin,
-                                                  device->program->bin_size,
-                                                  &(tiles[tile_id]),
-                                                  "cuda_argc",
-                                                  &argc);
+                // Calculate the eva address to which the tile is supposed to send it's finish signal
+                size_t sz; 
+                error = hb_mc_npa_to_eva (device->mc, map, &(tiles[tile_id]), &(finish_signal_npa), &finish_signal_eva[tile_id], &sz); 
                 if (error != HB_MC_SUCCESS) { 
-                        bsg_pr_err("%s: failed to set tile (%d,%d) cuda_argc symbol.\n",
-                                   __func__,
-                                   hb_mc_coordinate_get_x(tiles[tile_id]),
-                                   hb_mc_coordinate_get_y(tiles[tile_id]));
+                        bsg_pr_err("%s: failed to acquire finish signal address eva from npa.\n", __func__); 
                         return error;
                 }
 
-
-
+                // Set tile's argument count cuda_argc symbol.
+                error = hb_mc_tile_symbol_iovec_push(device, grid, map, &tiles[tile_id],
+                                                     HB_MC_CUDA_SYMBOL_ARGC, &argc, iov);
+                if (error != HB_MC_SUCCESS)
+                        return error;
 
                 // Set tile's pointer to argument list cuda_argv_ptr symbol.
-                error = hb_mc_tile_set_symbol_val(device->mc,
-                                                  map,
-                                                  device->program->bin,
-                                                  device->program->bin_size,
-                                                  &(tiles[tile_id]),
-                                                  "cuda_argv_ptr",
-                                                  &args_eva);
-                if (error != HB_MC_SUCCESS) { 
-                        bsg_pr_err("%s: failed to set tile (%d,%d) cuda_argv_ptr symbol.\n",
-                                   __func__,
-                                   hb_mc_coordinate_get_x(tiles[tile_id]),
-                                   hb_mc_coordinate_get_y(tiles[tile_id]));
+                error = hb_mc_tile_symbol_iovec_push(device, grid, map, &tiles[tile_id],
+                                                     HB_MC_CUDA_SYMBOL_ARGV_PTR, &args_eva, iov);
+                if (error != HB_MC_SUCCESS)
                         return error;
-                }
 
+                // Set tile's finish signal address cuda_finish_signal_addr symbol.
+                error = hb_mc_tile_symbol_iovec_push(device, grid, map, &tiles[tile_id],
+                                                     HB_MC_CUDA_SYMBOL_FINISH_SIGNAL_ADDR,
+                                                     &finish_signal_eva[tile_id], iov);
+                if (error != HB_MC_SUCCESS)
+                        return error;
+        }
 
+        error = hb_mc_manycore_write_mem_vec(device->mc, iov.data(), iov.size());
+        if (error != HB_MC_SUCCESS) { 
+                bsg_pr_err("%s: failed to set tiles cuda_argc, cuda_argv_ptr and cuda_finish_signal_addr symbols.\n",
+                           __func__);
+                return error;
+        }
 
 
-                // Set tile's pointer to argument list cuda_argv_ptr symbol.
-                // Calculate the eva address to which the tile is supposed to send it's finish signal
-                hb_mc_eva_t finish_signal_eva;
-                size_t sz; 
-                error = hb_mc_npa_to_eva (device->mc, map, &(tiles[tile_id]), &(finish_signal_npa), &finish_signal_eva, &sz); 
-                if (error != HB_MC_SUCCESS) { 
-                        bsg_pr_err("%s: failed to acquire finish signal address eva from npa.\n", __func__); 
-                        return error;
-                }
 
-                error = hb_mc_tile_set_symbol_val(device->mc,
-                                                  map,
-                                                  device->program->bin,
-                                                  device->program->bin_size,
-                                                  &(tiles[tile_id]),
-                                                  "cuda_finish_signal_addr",
-                                                  &finish_signal_eva);
-                if (error != HB_MC_SUCCESS) { 
-                        bsg_pr_err("%s: failed to set tile (%d,%d) cuda_finish_signal_addr symbol.\n",
-                                   __func__,
-                                   hb_mc_coordinate_get_x(tiles[tile_id]),
-                                   hb_mc_coordinate_get_y(tiles[tile_id]));
+        // Finally, set tiles' pointer to kernel cuda_kernel_ptr symbol.
+        iov.clear();
+        for (hb_mc_idx_t tile_id = 0; tile_id < num_tiles; tile_id ++) { 
+                error = hb_mc_tile_symbol_iovec_push(device, grid, map, &tiles[tile_id],
+                                                     HB_MC_CUDA_SYMBOL_KERNEL_PTR, &kernel_eva, iov);
+                if (error != HB_MC_SUCCESS)
                         return error;
-                }
+        }
 
+        error = hb_mc_manycore_write_mem_vec(device->mc, iov.data(), iov.size());
+        if (error != HB_MC_SUCCESS) { 
+                bsg_pr_err("%s: failed to set tiles cuda_kernel_ptr symbol.\n", __func__);
+                return error;
+        }
 
+        return HB_MC_SUCCESS;
+}
 
+/**
+ * Check DMA'd device memory against host memory, reading it back through the caches.
+ * @param[in] device  Pointer to device
+ * @param[in] eva     EVA of the device memory
+ * @param[in] data    Host copy of the memory
+ * @param[in] size    Number of bytes to compare
+ * @return HB_MC_SUCCESS if the copies match. HB_MC_FAIL if they differ.
+ *
+ * Used when the cache tracker elided a cache operation and is
+ * verifying. The caches are fully flushed first and then read over the
+ * mesh, which returns what the manycore sees: a stale line that should
+ * have been invalidated, or a dirty line whose flush was wrongly
+ * elided, shows up as a mismatch.
+ *
+ * The check leaves the caches clean and empty, so it needs no update
+ * to the tracker and does not change which later operations it elides.
+ */
+static int hb_mc_device_dma_verify(hb_mc_device_t *device,
+                                   hb_mc_eva_t eva,
+                                   const void *data,
+                                   uint32_t size)
+{
+        hb_mc_coordinate_t host = hb_mc_manycore_get_host_coordinate(device->mc);
+        std::vector<unsigned char> mesh(size);
+        int err;
 
-                // Finally, set tile's pointer to kernel cuda_kernel_ptr symbol.
-                error = hb_mc_tile_set_symbol_val(device->mc,
-                                                  map,
-                                                  device->program->bin,
-                                                  device->program->bin_size,
-                                                  &(tiles[tile_id]),
-                                                  "cuda_kernel_ptr",
-                                                  &kernel_eva);
-                if (error != HB_MC_SUCCESS) { 
-                        bsg_pr_err("%s: failed to set tile (%d,%d) cuda_kernel_ptr symbol.\n",
-                                   __func__,
-                                   hb_mc_coordinate_get_x(tiles[tile_id]),
-                                   hb_mc_coordinate_get_y(tiles[tile_id]));
-                        return error;
-                }
+        err = hb_mc_manycore_flush_vcache(device->mc);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to flush victim cache: %s\n",
+                           __func__, hb_mc_strerror(err));
+                return err;
+        }
+
+        err = hb_mc_manycore_eva_read(device->mc, &default_map, &host, &eva, mesh.data(), size);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to read 0x%" PRIx32 " over the mesh: %s\n",
+                           __func__, eva, hb_mc_strerror(err));
+                return err;
+        }
+
+        // everything is clean after the flush, so this loses nothing
+        err = hb_mc_manycore_invalidate_vcache(device->mc);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to invalidate victim cache: %s\n",
+                           __func__, hb_mc_strerror(err));
+                return err;
+        }
+
+        if (memcmp(mesh.data(), data, size) != 0) {
+                bsg_pr_err("%s: DMA of 0x%" PRIx32 " (%" PRIu32 " bytes) disagrees with the caches: "
+                           "the cache tracker elided a necessary operation\n",
+                           __func__, eva, size);
+                return HB_MC_FAIL;
         }
 
         return HB_MC_SUCCESS;
@@ -2373,18 +3245,22 @@ static int hb_mc_device_tiles_set_runtime_symbols (     hb_mc_device_t *device,
  * @param[in] device  Pointer to device
  * @param[in] jobs    Vector of host-to-device DMA jobs
  * @param[in] count   Number of host-to-device jobs
+ *
+ * Cache maintenance is limited to what the device's cache tracker
+ * cannot rule out: with no kernel run since the last DMA, back-to-back
+ * batches do not flush or invalidate the caches at all.
  */
 int hb_mc_device_dma_to_device (hb_mc_device_t *device,
                                 const hb_mc_dma_htod_t *jobs,
                                 size_t count)
 {
-        int err;
+        int err, elided;
 
         if (!hb_mc_manycore_supports_dma_read(device->mc))
                 return HB_MC_NOIMPL;
 
-        // flush cache
-        err = hb_mc_manycore_flush_vcache(device->mc);
+        // write back lines that may be dirty, so invalidating them loses nothing
+        err = hb_mc_cache_tracker_flush(device->cache_tracker, NULL);
         if (err != HB_MC_SUCCESS) {
                 bsg_pr_err("%s: failed to flush victim cache: %s\n",
                            __func__,
@@ -2415,14 +3291,29 @@ int hb_mc_device_dma_to_device (hb_mc_device_t *device,
                                    hb_mc_strerror(err));
                         return err;
                 }
+
+                // invalidate lines that may hold the old data
+                err = hb_mc_cache_tracker_invalidate(device->cache_tracker,
+                                                     dma->d_addr, dma->size);
+                if (err != HB_MC_SUCCESS)
+                        return err;
         }
 
         // invalidate cache
-        err = hb_mc_manycore_invalidate_vcache(device->mc);
+        err = hb_mc_cache_tracker_invalidate_finish(device->cache_tracker, &elided);
         if (err != HB_MC_SUCCESS) {
                 return err;
         }
 
+        if (elided && hb_mc_cache_tracker_verifying(device->cache_tracker)) {
+                for (size_t i = 0; i < count; i++) {
+                        err = hb_mc_device_dma_verify(device, jobs[i].d_addr,
+                                                      jobs[i].h_addr, jobs[i].size);
+                        if (err != HB_MC_SUCCESS)
+                                return err;
+                }
+        }
+
         return HB_MC_SUCCESS;
 }
 
@@ -2431,16 +3322,19 @@ int hb_mc_device_dma_to_device (hb_mc_device_t *device,
  * @param[in] device  Pointer to device
  * @param[in] jobs    Vector of device-to-host DMA jobs
  * @param[in] count   Number of device-to-host jobs
+ *
+ * Only lines that the device's cache tracker cannot prove clean are
+ * flushed first.
  */
 int hb_mc_device_dma_to_host(hb_mc_device_t *device, const hb_mc_dma_dtoh_t *jobs, size_t count)
 {
-        int err;
+        int err, elided;
 
         if (!hb_mc_manycore_supports_dma_read(device->mc))
                 return HB_MC_NOIMPL;
 
         // flush cache
-        err = hb_mc_manycore_flush_vcache(device->mc);
+        err = hb_mc_cache_tracker_flush(device->cache_tracker, &elided);
         if (err != HB_MC_SUCCESS) {
                 bsg_pr_err("%s: failed to flush victim cache: %s\n",
                            __func__,
@@ -2473,5 +3367,14 @@ int hb_mc_device_dma_to_host(hb_mc_device_t *device, const hb_mc_dma_dtoh_t *job
                 }
         }
 
+        if (elided && hb_mc_cache_tracker_verifying(device->cache_tracker)) {
+                for (size_t i = 0; i < count; i++) {
+                        err = hb_mc_device_dma_verify(device, jobs[i].d_addr,
+                                                      jobs[i].h_addr, jobs[i].size);
+                        if (err != HB_MC_SUCCESS)
+                                return err;
+                }
+        }
+
         return HB_MC_SUCCESS;
 }
@@ -29,6 +29,9 @@
 #define BSG_MANYCORE_CUDA_H
 #include <bsg_manycore_features.h>
 #include <bsg_manycore_eva.h>
+#include <bsg_manycore_cache_tracker.h>
+#include <bsg_manycore_program_image.h>
+#include <bsg_manycore_loader.h>
 
 #ifdef __cplusplus
 #include <cstdint>
@@ -69,6 +72,31 @@ extern "C" {
         } hb_mc_tile_status_t;
 
 
+        /**
+         * Symbols in the kernel binary that the runtime writes into every
+         * tile of a tile group. Their addresses are resolved once per grid.
+         */
+        typedef enum {
+                HB_MC_CUDA_SYMBOL_GRP_ORG_X = 0,
+                HB_MC_CUDA_SYMBOL_GRP_ORG_Y,
+                HB_MC_CUDA_SYMBOL_X,
+                HB_MC_CUDA_SYMBOL_Y,
+                HB_MC_CUDA_SYMBOL_ID,
+                HB_MC_CUDA_SYMBOL_TILE_GROUP_ID_X,
+                HB_MC_CUDA_SYMBOL_TILE_GROUP_ID_Y,
+                HB_MC_CUDA_SYMBOL_TILE_GROUP_ID,
+                HB_MC_CUDA_SYMBOL_GRID_DIM_X,
+                HB_MC_CUDA_SYMBOL_GRID_DIM_Y,
+                HB_MC_CUDA_SYMBOL_FINISH_SIGNAL_VAL,
+                HB_MC_CUDA_SYMBOL_KERNEL_NOT_LOADED_VAL,
+                HB_MC_CUDA_SYMBOL_ARGC,
+                HB_MC_CUDA_SYMBOL_ARGV_PTR,
+                HB_MC_CUDA_SYMBOL_FINISH_SIGNAL_ADDR,
+                HB_MC_CUDA_SYMBOL_KERNEL_PTR,
+                HB_MC_CUDA_SYMBOL_MAX,
+        } hb_mc_cuda_symbol_t;
+
+
         typedef struct {
                 hb_mc_coordinate_t coord;
                 hb_mc_coordinate_t origin;      
@@ -79,24 +107,59 @@ extern "C" {
         typedef struct {
                 const char *name;
                 uint32_t argc;
-                const uint32_t *argv;
+                const uint32_t *argv;      // Argument block; the first argc words are argv
+                size_t args_size;          // Size of the argument block in bytes
+                uint32_t nrefs;
+                const uint32_t *refs;      // argv words holding an offset into the argument block
                 hb_mc_epa_t finish_signal_addr;
         } hb_mc_kernel_t;
 
+
+        /**
+         * Typed kernel argument list, built with hb_mc_kernel_args_push_*().
+         * All arguments, including structs passed by value, are packed into
+         * one argument block that is copied to the device in a single transfer.
+         */
+        typedef struct {
+                uint32_t argc;
+                uint32_t argv_capacity;
+                uint32_t *argv;
+                size_t data_size;
+                size_t data_capacity;
+                unsigned char *data;       // Payloads of structs passed by reference
+                uint32_t nrefs;
+                uint32_t refs_capacity;
+                uint32_t *refs;            // argv words holding an offset into data
+        } hb_mc_kernel_args_t;
+
         typedef struct {
                 hb_mc_coordinate_t id;
-                grid_id_t grid_id;
-                hb_mc_dimension_t grid_dim;
-                hb_mc_tile_group_status_t status;
                 hb_mc_coordinate_t origin;
-                hb_mc_dimension_t dim;
-                hb_mc_eva_map_t *map;
-                hb_mc_kernel_t *kernel;
-                uint32_t argc;
-                hb_mc_eva_t argv_eva;
+                hb_mc_tile_group_status_t status;
+                uint32_t grid;             // Index of the tile group's grid in device->grids
         } hb_mc_tile_group_t;
 
 
+        /**
+         * A grid of tile groups that run the same kernel. The kernel name,
+         * kernel address, argument block and runtime symbol addresses are
+         * kept once here and shared by all tile groups of the grid.
+         */
+        typedef struct {
+                grid_id_t id;
+                hb_mc_dimension_t dim;             // Grid dimensions in tile groups
+                hb_mc_dimension_t tg_dim;          // Tile group dimensions in tiles
+                hb_mc_kernel_t kernel;
+                hb_mc_eva_t kernel_eva;
+                hb_mc_eva_t args_eva;              // Argument block on device; valid while tile groups run
+                hb_mc_eva_t symbols[HB_MC_CUDA_SYMBOL_MAX];
+                uint32_t first_tile_group;         // Index of the grid's first tile group in device->tile_groups
+                uint32_t num_tile_groups;
+                uint32_t num_launched;
+                uint32_t num_finished;
+        } hb_mc_grid_t;
+
+
         typedef struct {
                 hb_mc_dimension_t dim;
                 hb_mc_coordinate_t origin;
@@ -113,8 +176,10 @@ extern "C" {
 
         typedef struct {
                 const char* bin_name;
-                const unsigned char* bin;
+                hb_mc_program_image_t *image;   //!< the binary, its segments and its symbols
+                const unsigned char* bin;       //!< the binary, inside #image
                 size_t bin_size;
+                hb_mc_loader_plan_t *load_plan; //!< how to load #image; made on first load
                 hb_mc_allocator_t *allocator;
         } hb_mc_program_t;
 
@@ -126,13 +191,18 @@ extern "C" {
                 hb_mc_tile_group_t *tile_groups;
                 uint32_t num_tile_groups;
                 uint32_t tile_group_capacity;
+                hb_mc_grid_t *grids;
+                uint32_t num_queued_grids;
+                uint32_t grid_capacity;
                 uint8_t num_grids;
+                hb_mc_cache_tracker_t *cache_tracker;  // What the victim caches may hold; see bsg_manycore_cache_tracker.h
         } hb_mc_device_t; 
 
 
         enum hb_mc_memcpy_kind {
                 HB_MC_MEMCPY_TO_DEVICE = 0,
                 HB_MC_MEMCPY_TO_HOST = 1,
+                HB_MC_MEMCPY_DEVICE_TO_DEVICE = 2,
         };
 
 
@@ -201,6 +271,8 @@ extern "C" {
          * Takes in a binary name, loads the binary from file onto a buffer,
          * freezes tiles, loads program binary into all tiles and into dram,
          * and sets the symbols and registers for each tile.
+         * #bin_name may also be a load image made by hb_mc_device_program_lower(),
+         * which is loaded without being parsed.
          * @param[in]  device        Pointer to device
          * @parma[in]  bin_name      Name of binary elf file
          * @param[in]  id            Id of program's memory allocator
@@ -215,6 +287,62 @@ extern "C" {
 
 
 
+
+        /**
+         * Lowers a binary into a load image for a machine, with the
+         * runtime's configuration symbols resolved.
+         * @param[in]  mc            A manycore instance whose configuration is the target machine;
+         *                           only its configuration and DRAM mode are used
+         * @param[in]  bin_name      Name of binary elf file
+         * @param[in]  image_name    Name of the load image to write
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_device_program_lower (hb_mc_manycore_t *mc,
+                                        const char *bin_name,
+                                        const char *image_name);
+
+
+
+
+        /**
+         * Saves a checkpoint of a device after program initialization.
+         * The simulation is written to #path, DRAM held in C++ models to
+         * <path>.dram, and the host runtime state (mesh, program and
+         * memory allocator) to <path>.host. Verilator machines must be
+         * built with BSG_VERILATOR_SAVABLE=1.
+         * No tile groups may be enqueued when the checkpoint is taken.
+         * @param[in]  device        Pointer to device
+         * @param[in]  path          Path of the checkpoint
+         * @return HB_MC_SUCCESS if succesful. HB_MC_NOIMPL if the platform cannot take checkpoints.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_device_checkpoint_save (hb_mc_device_t *device, const char *path);
+
+
+
+
+        /**
+         * Initializes a program from a checkpoint written by hb_mc_device_checkpoint_save(),
+         * instead of loading the binary onto the device. The device should have been
+         * initialized with the same dimensions as when the checkpoint was taken.
+         * @param[in]  device        Pointer to device
+         * @param[in]  path          Path of the checkpoint
+         * @parma[in]  bin_name      Name of binary elf file; must match the checkpointed binary
+         * @param[in]  alloc_name    Unique name of program's memory allocator
+         * @param[in]  id            Id of program's meomry allocator
+         * @return HB_MC_SUCCESS if succesful. HB_MC_NOTFOUND if there is no usable checkpoint,
+         * in which case the caller should fall back to hb_mc_device_program_init().
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_device_program_init_checkpoint (hb_mc_device_t *device,
+                                                  const char *path,
+                                                  const char *bin_name,
+                                                  const char *alloc_name,
+                                                  hb_mc_allocator_id_t id);
+
+
+
         /**
          * Allocates memory on device DRAM
          * hb_mc_device_program_init() or hb_mc_device_program_init_binary() should
@@ -238,7 +366,7 @@ extern "C" {
          * @parma[in]  dst           EVA address of destination to be copied into
          * @param[in]  name          EVA address of dst
          * @param[in]  count         Size of buffer (number of bytes) to be copied
-         * @param[in]  hb_mc_memcpy_kind         Direction of copy (HB_MC_MEMCPY_TO_DEVICE / HB_MC_MEMCPY_TO_HOST)
+         * @param[in]  hb_mc_memcpy_kind         Direction of copy (HB_MC_MEMCPY_TO_DEVICE / HB_MC_MEMCPY_TO_HOST / HB_MC_MEMCPY_DEVICE_TO_DEVICE)
          * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
          */
         __attribute__((warn_unused_result))
@@ -277,6 +405,46 @@ extern "C" {
                                         hb_mc_eva_t daddr,
                                         uint32_t bytes);
 
+        /**
+         * Copies a buffer from src on device DRAM to dst on device DRAM.
+         * @param[in]  device        Pointer to device
+         * @parma[in]  dst           EVA address of destination to be copied into
+         * @parma[in]  src           EVA address of source to be copied from
+         * @param[in]  bytes         Size of buffer to be copied
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         *
+         * The buffers must not overlap. On platforms with DMA the copy is done
+         * directly in the DRAM backing store and never crosses the host link.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_device_memcpy_device_to_device(hb_mc_device_t *device,
+                                                 hb_mc_eva_t dst,
+                                                 hb_mc_eva_t src,
+                                                 uint32_t bytes);
+
+
+        /**
+         * One buffer of a vectored memcpy: #sz bytes between host address #data and device address #eva.
+         */
+        typedef hb_mc_eva_iovec_t hb_mc_iovec_t;
+
+        /**
+         * Copies a list of buffers between the host and the device.
+         * @param[in]  device        Pointer to device
+         * @param[in]  iov           List of buffers to be copied
+         * @param[in]  n             Number of buffers in #iov
+         * @param[in]  kind          Direction of copy (HB_MC_MEMCPY_TO_DEVICE / HB_MC_MEMCPY_TO_HOST)
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         *
+         * All buffers are translated up front and moved in one pipelined transfer
+         * ending in a single fence, which is much cheaper than calling
+         * hb_mc_device_memcpy() once per buffer when the buffers are small.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_device_memcpy_vec(hb_mc_device_t *device,
+                                    const hb_mc_iovec_t *iov,
+                                    size_t n,
+                                    enum hb_mc_memcpy_kind kind);
 
         /**
          * Sets memory to a give value starting from an address in device's DRAM.
@@ -291,6 +459,67 @@ extern "C" {
                                  uint8_t data,
                                  size_t sz); 
 
+        /**
+         * Applies an atomic memory operation to a word in device memory.
+         * Kernels may be running; the operation is atomic with respect to them.
+         * @param[in]  device        Pointer to device
+         * @param[in]  eva           EVA address of a word in device memory
+         * @param[in]  amo           The atomic operation to apply
+         * @param[in]  operand       The operand of #amo
+         * @param[out] old           Set to the value of the word before #amo. May be NULL.
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_device_amo(hb_mc_device_t *device,
+                             hb_mc_eva_t eva,
+                             hb_mc_packet_amo_t amo,
+                             uint32_t operand,
+                             uint32_t *old);
+
+        /**
+         * Atomically adds to a word in device memory.
+         * @param[in]  device        Pointer to device
+         * @param[in]  eva           EVA address of a word in device memory
+         * @param[in]  v             The value to add
+         * @param[out] old           Set to the value of the word before the add. May be NULL.
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_device_amo_add(hb_mc_device_t *device, hb_mc_eva_t eva, uint32_t v, uint32_t *old);
+
+        /**
+         * Atomically swaps a word in device memory.
+         * @param[in]  device        Pointer to device
+         * @param[in]  eva           EVA address of a word in device memory
+         * @param[in]  v             The value to store
+         * @param[out] old           Set to the value of the word before the swap. May be NULL.
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_device_amo_swap(hb_mc_device_t *device, hb_mc_eva_t eva, uint32_t v, uint32_t *old);
+
+        /**
+         * Atomically ors a value into a word in device memory.
+         * @param[in]  device        Pointer to device
+         * @param[in]  eva           EVA address of a word in device memory
+         * @param[in]  v             The value to or in
+         * @param[out] old           Set to the value of the word before the or. May be NULL.
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_device_amo_or(hb_mc_device_t *device, hb_mc_eva_t eva, uint32_t v, uint32_t *old);
+
+        /**
+         * Atomically ands a value into a word in device memory.
+         * @param[in]  device        Pointer to device
+         * @param[in]  eva           EVA address of a word in device memory
+         * @param[in]  v             The value to and in
+         * @param[out] old           Set to the value of the word before the and. May be NULL.
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_device_amo_and(hb_mc_device_t *device, hb_mc_eva_t eva, uint32_t v, uint32_t *old);
+
 
 
 
@@ -334,6 +563,103 @@ extern "C" {
 
 
 
+        /**
+         * Initializes an empty kernel argument list
+         * @param[in]  args          Pointer to kernel argument list
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_kernel_args_init (hb_mc_kernel_args_t *args);
+
+        /**
+         * Frees a kernel argument list
+         * @param[in]  args          Pointer to kernel argument list
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        int hb_mc_kernel_args_exit (hb_mc_kernel_args_t *args);
+
+        /**
+         * Appends a 32-bit integer argument to a kernel argument list
+         * @param[in]  args          Pointer to kernel argument list
+         * @param[in]  val           Argument value
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_kernel_args_push_u32 (hb_mc_kernel_args_t *args, uint32_t val);
+
+        /**
+         * Appends a device pointer argument to a kernel argument list
+         * @param[in]  args          Pointer to kernel argument list
+         * @param[in]  ptr           Eva address of device memory
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_kernel_args_push_ptr (hb_mc_kernel_args_t *args, hb_mc_eva_t ptr);
+
+        /**
+         * Appends a struct argument, passed by value, to a kernel argument list
+         * @param[in]  args          Pointer to kernel argument list
+         * @param[in]  data          Host copy of the struct
+         * @param[in]  sz            Size of the struct in bytes
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         *
+         * This follows the RV32 integer calling convention for
+         * aggregates: a struct of up to 8 bytes is passed in one or two
+         * argument words, and a larger struct is copied into the argument
+         * block (8-byte aligned) and passed as a pointer to that copy. A
+         * kernel can therefore declare the parameter as the struct type,
+         * with two exceptions:
+         *
+         * - Under the ilp32f ABI of the manycore kernels, a struct of up
+         *   to 8 bytes with a float member is passed in FP registers,
+         *   which this function cannot set. Push such structs with
+         *   hb_mc_kernel_args_push_struct_ptr() instead.
+         * - The copy of a larger struct is shared by every tile that
+         *   runs the kernel. The kernel must treat it as read-only.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_kernel_args_push_struct (hb_mc_kernel_args_t *args,
+                                           const void *data, size_t sz);
+
+        /**
+         * Appends a pointer to a copy of a struct to a kernel argument list
+         * @param[in]  args          Pointer to kernel argument list
+         * @param[in]  data          Host copy of the struct
+         * @param[in]  sz            Size of the struct in bytes
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         *
+         * The struct is copied into the argument block (8-byte aligned)
+         * whatever its size, and the kernel declares the parameter as a
+         * const pointer to the struct type. Use this for structs that
+         * hb_mc_kernel_args_push_struct() cannot pass by value. The copy
+         * is shared by every tile that runs the kernel and must be
+         * treated as read-only.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_kernel_args_push_struct_ptr (hb_mc_kernel_args_t *args,
+                                               const void *data, size_t sz);
+
+        /**
+         * Enqueues and schedules a kernel to be run on device, like
+         * hb_mc_kernel_enqueue(), with a typed argument list. The argument
+         * list is copied and can be freed or reused after this call.
+         * @param[in]  device        Pointer to device
+         * @param[in]  grid_dim      X/Y dimensions of the grid to be initialized
+         * @param[in]  tg_dim        X/Y dimensions of tile groups in grid
+         * @param[in]  name          Kernel name to be executed on tile groups in grid
+         * @param[in]  args          Kernel argument list
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_kernel_enqueue_args (hb_mc_device_t *device,
+                                       hb_mc_dimension_t grid_dim,
+                                       hb_mc_dimension_t tg_dim,
+                                       const char *name,
+                                       const hb_mc_kernel_args_t *args);
+
+
+
+
         /**
          * Iterates over all tile groups inside device,
          * allocates those that fit in mesh and launches them. 
@@ -37,6 +37,9 @@
 #include <math.h>
 #endif
 
+#include <algorithm>
+#include <vector>
+
 #define MAKE_MASK(WIDTH) ((1ULL << (WIDTH)) - 1ULL)
 
 #define DEFAULT_GROUP_X_LOGSZ 6
@@ -1059,6 +1062,84 @@ int hb_mc_manycore_eva_write_internal(hb_mc_manycore_t *mc,
         return HB_MC_SUCCESS;
 }
 
+// most segments handed to the DMA layer at once
+#define HB_MC_EVA_DMA_BATCH_SEGMENTS (1 << 16)
+
+/**
+ * Internal function to move a contiguous EVA region via DMA
+ * @param[in]  mc     An initialized manycore struct
+ * @param[in]  map    An eva map for computing the eva to npa translation
+ * @param[in]  tgt    Coordinate of the tile issuing this #eva
+ * @param[in]  eva    A valid hb_mc_eva_t - must map to DRAM
+ * @param[in]  data   The host side of the transfer
+ * @param[in]  sz     The number of bytes to transfer
+ * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ *
+ * Rather than issuing one DMA per stripe, this translates the region
+ * into a list of NPA segments, merging stripes that continue in the
+ * same bank, and hands the list to #dma_function in batches so that
+ * the platform can plan and parallelize the copy.
+ */
+template <typename DMAFunction>
+int hb_mc_manycore_eva_dma_internal(hb_mc_manycore_t *mc,
+                                    const hb_mc_eva_map_t *map,
+                                    const hb_mc_coordinate_t *tgt,
+                                    const hb_mc_eva_t *eva,
+                                    void *data, size_t sz,
+                                    DMAFunction dma_function)
+{
+        int err;
+        size_t npa_sz, xfer_sz;
+        hb_mc_npa_t npa;
+        char *hostp = (char *)data;
+        hb_mc_eva_t curr_eva = *eva;
+        std::vector<hb_mc_dma_segment_t> segs;
+
+        segs.reserve(std::min<size_t>(HB_MC_EVA_DMA_BATCH_SEGMENTS, sz / sizeof(uint32_t) + 1));
+        while(sz > 0){
+                err = hb_mc_eva_to_npa(mc, map, tgt, &curr_eva, &npa, &npa_sz);
+                if(err != HB_MC_SUCCESS){
+                        bsg_pr_err("%s: Failed to translate EVA into a NPA\n",
+                                   __func__);
+                        return err;
+                }
+                xfer_sz = min_size_t(sz, npa_sz);
+
+                // continue the last segment if this stripe follows it in the same bank
+                hb_mc_dma_segment_t *last = segs.empty() ? nullptr : &segs.back();
+                if (last != nullptr
+                    && hb_mc_npa_get_x(&last->npa) == hb_mc_npa_get_x(&npa)
+                    && hb_mc_npa_get_y(&last->npa) == hb_mc_npa_get_y(&npa)
+                    && hb_mc_npa_get_epa(&last->npa) + last->sz == hb_mc_npa_get_epa(&npa)
+                    && (char*)last->host + last->sz == hostp) {
+                        last->sz += xfer_sz;
+                } else {
+                        if (segs.size() == HB_MC_EVA_DMA_BATCH_SEGMENTS) {
+                                err = dma_function(mc, segs.data(), segs.size());
+                                if (err != HB_MC_SUCCESS)
+                                        goto fail;
+                                segs.clear();
+                        }
+                        segs.push_back(hb_mc_dma_segment_t{npa, hostp, xfer_sz});
+                }
+
+                hostp += xfer_sz;
+                sz -= xfer_sz;
+                curr_eva += xfer_sz;
+        }
+
+        err = dma_function(mc, segs.data(), segs.size());
+        if (err != HB_MC_SUCCESS)
+                goto fail;
+
+        return HB_MC_SUCCESS;
+
+fail:
+        bsg_pr_err("%s: Failed to DMA %zu segments: %s\n",
+                   __func__, segs.size(), hb_mc_strerror(err));
+        return err;
+}
+
 /**
  * Write memory out to manycore hardware starting at a given EVA via DMA
  * @param[in]  mc     An initialized manycore struct
@@ -1075,8 +1156,8 @@ int hb_mc_manycore_eva_write_dma(hb_mc_manycore_t *mc,
                                  const hb_mc_eva_t *eva,
                                  const void *data, size_t sz)
 {
-        return hb_mc_manycore_eva_write_internal(mc, map, tgt, eva, data, sz,
-                                                 hb_mc_manycore_dma_write_no_cache_ainv);
+        return hb_mc_manycore_eva_dma_internal(mc, map, tgt, eva, const_cast<void*>(data), sz,
+                                               hb_mc_manycore_dma_write_segments_no_cache_ainv);
 }
 
 /**
@@ -1175,8 +1256,8 @@ int hb_mc_manycore_eva_read_dma(hb_mc_manycore_t *mc,
                                 const hb_mc_eva_t *eva,
                                 void *data, size_t sz)
 {
-        return hb_mc_manycore_eva_read_internal(mc, map, tgt, eva, data, sz,
-                                                hb_mc_manycore_dma_read_no_cache_afl);
+        return hb_mc_manycore_eva_dma_internal(mc, map, tgt, eva, data, sz,
+                                               hb_mc_manycore_dma_read_segments_no_cache_afl);
 }
 
 /**
@@ -1199,6 +1280,236 @@ int hb_mc_manycore_eva_read(hb_mc_manycore_t *mc,
                                                 hb_mc_manycore_read_mem);
 }
 
+/**
+ * Translate a list of EVA segments into a list of NPA segments
+ * @param[in]  mc     An initialized manycore struct
+ * @param[in]  map    An eva map for computing the eva to npa translation
+ * @param[in]  tgt    Coordinate of the tile issuing the EVAs
+ * @param[in]  iov    A list of EVA segments
+ * @param[in]  n      The number of segments in #iov
+ * @param[out] npa_iov Set to the NPA segments covering #iov, in order
+ * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ *
+ * An EVA segment that crosses a translation boundary becomes several NPA segments.
+ */
+static int hb_mc_eva_iovec_to_npa_iovec(hb_mc_manycore_t *mc,
+                                        const hb_mc_eva_map_t *map,
+                                        const hb_mc_coordinate_t *tgt,
+                                        const hb_mc_eva_iovec_t *iov, size_t n,
+                                        std::vector<hb_mc_npa_iovec_t> &npa_iov)
+{
+        int err;
+
+        npa_iov.clear();
+        npa_iov.reserve(n);
+
+        for (size_t i = 0; i < n; i++) {
+                hb_mc_eva_t curr_eva = iov[i].eva;
+                char *curr_data = static_cast<char*>(iov[i].data);
+                size_t sz = iov[i].sz;
+
+                while (sz > 0) {
+                        hb_mc_npa_iovec_t seg;
+                        size_t npa_sz;
+
+                        err = hb_mc_eva_to_npa(mc, map, tgt, &curr_eva, &seg.npa, &npa_sz);
+                        if (err != HB_MC_SUCCESS) {
+                                bsg_pr_err("%s: Failed to translate EVA 0x%08" PRIx32 " into a NPA\n",
+                                           __func__, hb_mc_eva_addr(&curr_eva));
+                                return err;
+                        }
+
+                        seg.data = curr_data;
+                        seg.sz = min_size_t(sz, npa_sz);
+                        npa_iov.push_back(seg);
+
+                        curr_data += seg.sz;
+                        curr_eva += seg.sz;
+                        sz -= seg.sz;
+                }
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Write a list of host buffers out to manycore hardware at given EVAs
+ * @param[in]  mc     An initialized manycore struct
+ * @param[in]  map    An eva map for computing the eva to npa translation
+ * @param[in]  tgt    Coordinate of the tile issuing the EVAs
+ * @param[in]  iov    A list of segments to write
+ * @param[in]  n      The number of segments in #iov
+ * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ */
+int hb_mc_manycore_eva_write_vec(hb_mc_manycore_t *mc,
+                                 const hb_mc_eva_map_t *map,
+                                 const hb_mc_coordinate_t *tgt,
+                                 const hb_mc_eva_iovec_t *iov, size_t n)
+{
+        std::vector<hb_mc_npa_iovec_t> npa_iov;
+        int err;
+
+        err = hb_mc_eva_iovec_to_npa_iovec(mc, map, tgt, iov, n, npa_iov);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        err = hb_mc_manycore_write_mem_vec(mc, npa_iov.data(), npa_iov.size());
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: Failed to copy data from host to NPAs\n",
+                           __func__);
+                return err;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Read a list of EVA regions from manycore hardware into host buffers
+ * @param[in]  mc     An initialized manycore struct
+ * @param[in]  map    An eva map for computing the eva to npa translation
+ * @param[in]  tgt    Coordinate of the tile issuing the EVAs
+ * @param[in]  iov    A list of segments to read
+ * @param[in]  n      The number of segments in #iov
+ * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ */
+int hb_mc_manycore_eva_read_vec(hb_mc_manycore_t *mc,
+                                const hb_mc_eva_map_t *map,
+                                const hb_mc_coordinate_t *tgt,
+                                const hb_mc_eva_iovec_t *iov, size_t n)
+{
+        std::vector<hb_mc_npa_iovec_t> npa_iov;
+        int err;
+
+        err = hb_mc_eva_iovec_to_npa_iovec(mc, map, tgt, iov, n, npa_iov);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        err = hb_mc_manycore_read_mem_vec(mc, npa_iov.data(), npa_iov.size());
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: Failed to copy data from NPAs to host\n",
+                           __func__);
+                return err;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Fills of at least this many bytes use DMA when the platform supports it.
+ * Smaller fills are cheaper as a handful of write packets.
+ */
+#define HB_MC_EVA_MEMSET_DMA_MIN_SZ (4096)
+
+/**
+ * Largest host buffer used to stage a DMA fill or copy
+ */
+#define HB_MC_EVA_DMA_BUF_SZ (64 * 1024)
+
+/**
+ * Set a DRAM EVA memory region to a value via DMA
+ * @param[in]  mc     An initialized manycore struct
+ * @param[in]  map    An eva map for computing the eva to npa translation
+ * @param[in]  tgt    Coordinate of the tile issuing this #eva
+ * @param[in]  eva    A valid hb_mc_eva_t
+ * @param[in]  val    The value to write to the region
+ * @param[in]  sz     The number of bytes to write to manycore hardware
+ * @return HB_MC_NOIMPL if any part of the region is not in DRAM and nothing was written.
+ * HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ *
+ * The victim caches are kept coherent with whichever is cheaper:
+ * invalidating each line of the region, or flushing the caches
+ * before the DMA and invalidating them entirely afterwards. Lines
+ * that the region only partly covers are flushed before the DMA, so
+ * invalidating them does not drop dirty bytes outside of the region.
+ */
+static int hb_mc_manycore_eva_memset_dma(hb_mc_manycore_t *mc,
+                                         const hb_mc_eva_map_t *map,
+                                         const hb_mc_coordinate_t *tgt,
+                                         const hb_mc_eva_t *eva,
+                                         uint8_t val, size_t sz)
+{
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        std::vector<hb_mc_npa_t> npas;
+        std::vector<size_t> sizes;
+        size_t dest_sz, xfer_sz, rem = sz;
+        hb_mc_npa_t dest_npa;
+        hb_mc_eva_t curr_eva = *eva;
+        int err;
+
+        // translate the whole region first: DMA can only reach DRAM
+        while (rem > 0) {
+                err = hb_mc_eva_to_npa(mc, map, tgt, &curr_eva, &dest_npa, &dest_sz);
+                if (err != HB_MC_SUCCESS) {
+                        bsg_pr_err("%s: Failed to translate EVA into a NPA\n",
+                                   __func__);
+                        return err;
+                }
+
+                if (!hb_mc_config_is_dram_y(cfg, hb_mc_npa_get_y(&dest_npa)))
+                        return HB_MC_NOIMPL;
+
+                xfer_sz = min_size_t(rem, dest_sz);
+                npas.push_back(dest_npa);
+                sizes.push_back(xfer_sz);
+
+                rem -= xfer_sz;
+                curr_eva += xfer_sz;
+        }
+
+        size_t lines = sz / hb_mc_config_get_vcache_block_size(cfg) + npas.size();
+        int whole_cache = hb_mc_vcache_whole_cache_is_cheaper(mc, lines);
+
+        if (whole_cache) {
+                err = hb_mc_manycore_flush_vcache(mc);
+                if (err != HB_MC_SUCCESS) {
+                        bsg_pr_err("%s: Failed to flush victim caches: %s\n",
+                                   __func__, hb_mc_strerror(err));
+                        return err;
+                }
+        }
+
+        std::vector<uint8_t> buf(min_size_t(sz, HB_MC_EVA_DMA_BUF_SZ), val);
+        for (size_t i = 0; i < npas.size(); i++) {
+                hb_mc_npa_t npa = npas[i];
+
+                if (!whole_cache) {
+                        err = hb_mc_manycore_vcache_flush_npa_range_edges(mc, &npas[i], sizes[i]);
+                        if (err != HB_MC_SUCCESS) {
+                                bsg_pr_err("%s: Failed to flush NPA region: %s\n",
+                                           __func__, hb_mc_strerror(err));
+                                return err;
+                        }
+                }
+
+                for (size_t off = 0; off < sizes[i]; off += buf.size()) {
+                        xfer_sz = min_size_t(sizes[i] - off, buf.size());
+                        hb_mc_npa_set_epa(&npa, hb_mc_npa_get_epa(&npas[i]) + off);
+
+                        err = hb_mc_manycore_dma_write_no_cache_ainv(mc, &npa, buf.data(), xfer_sz);
+                        if (err != HB_MC_SUCCESS) {
+                                bsg_pr_err("%s: Failed to DMA fill NPA region: %s\n",
+                                           __func__, hb_mc_strerror(err));
+                                return err;
+                        }
+                }
+
+                if (!whole_cache && hb_mc_manycore_has_cache(mc)) {
+                        err = hb_mc_manycore_vcache_invalidate_npa_range(mc, &npas[i], sizes[i]);
+                        if (err != HB_MC_SUCCESS) {
+                                bsg_pr_err("%s: Failed to invalidate NPA region: %s\n",
+                                           __func__, hb_mc_strerror(err));
+                                return err;
+                        }
+                }
+        }
+
+        if (whole_cache)
+                return hb_mc_manycore_invalidate_vcache(mc);
+
+        // wait for the invalidates to land, as the write path waits for its writes
+        return hb_mc_manycore_host_request_fence(mc, -1);
+}
+
 /**
  * Set a EVA memory region to a value
  * @param[in]  mc     An initialized manycore struct
@@ -1220,6 +1531,15 @@ int hb_mc_manycore_eva_memset(hb_mc_manycore_t *mc,
         hb_mc_npa_t dest_npa;
         hb_mc_eva_t curr_eva = *eva;
 
+        // large DRAM fills go through the DMA backdoor when there is one
+        if (sz >= HB_MC_EVA_MEMSET_DMA_MIN_SZ &&
+            hb_mc_manycore_dram_is_enabled(mc) &&
+            hb_mc_manycore_supports_dma_write(mc)) {
+                err = hb_mc_manycore_eva_memset_dma(mc, map, tgt, eva, val, sz);
+                if (err != HB_MC_NOIMPL)
+                        return err;
+        }
+
         while(sz > 0){
                 err = hb_mc_eva_to_npa(mc, map, tgt, &curr_eva, &dest_npa, &dest_sz);
                 if(err != HB_MC_SUCCESS){
@@ -1249,3 +1569,164 @@ int hb_mc_manycore_eva_memset(hb_mc_manycore_t *mc,
 
         return HB_MC_SUCCESS;
 }
+
+/**
+ * Copy between two DRAM EVA regions via DMA
+ * @param[in]  mc     An initialized manycore struct
+ * @param[in]  map    An eva map for computing the eva to npa translation
+ * @param[in]  tgt    Coordinate of the tile issuing both EVAs
+ * @param[in]  dst    A valid hb_mc_eva_t - start of the destination region
+ * @param[in]  src    A valid hb_mc_eva_t - start of the source region
+ * @param[in]  sz     The number of bytes to copy
+ * @return HB_MC_NOIMPL if either region is not entirely in DRAM and nothing was copied.
+ * HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ *
+ * The source is flushed from the victim caches before it is read and the
+ * destination is invalidated after it is written, either line by line or
+ * for the whole cache, whichever is cheaper. Destination lines that the
+ * copy only partly covers are flushed before they are written, so
+ * invalidating them does not drop dirty bytes outside of the copy.
+ */
+static int hb_mc_manycore_eva_copy_dma(hb_mc_manycore_t *mc,
+                                       const hb_mc_eva_map_t *map,
+                                       const hb_mc_coordinate_t *tgt,
+                                       const hb_mc_eva_t *dst,
+                                       const hb_mc_eva_t *src,
+                                       size_t sz)
+{
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        std::vector<hb_mc_npa_t> dst_npas, src_npas;
+        std::vector<size_t> sizes;
+        size_t dst_sz, src_sz, xfer_sz, rem = sz;
+        hb_mc_npa_t dst_npa, src_npa;
+        hb_mc_eva_t dst_eva = *dst, src_eva = *src;
+        int err;
+
+        // split the copy where either region crosses an NPA boundary
+        while (rem > 0) {
+                err = hb_mc_eva_to_npa(mc, map, tgt, &dst_eva, &dst_npa, &dst_sz);
+                if (err == HB_MC_SUCCESS)
+                        err = hb_mc_eva_to_npa(mc, map, tgt, &src_eva, &src_npa, &src_sz);
+                if (err != HB_MC_SUCCESS) {
+                        bsg_pr_err("%s: Failed to translate EVA into a NPA\n",
+                                   __func__);
+                        return err;
+                }
+
+                if (!hb_mc_config_is_dram_y(cfg, hb_mc_npa_get_y(&dst_npa)) ||
+                    !hb_mc_config_is_dram_y(cfg, hb_mc_npa_get_y(&src_npa)))
+                        return HB_MC_NOIMPL;
+
+                xfer_sz = min_size_t(rem, min_size_t(dst_sz, src_sz));
+                dst_npas.push_back(dst_npa);
+                src_npas.push_back(src_npa);
+                sizes.push_back(xfer_sz);
+
+                rem -= xfer_sz;
+                dst_eva += xfer_sz;
+                src_eva += xfer_sz;
+        }
+
+        size_t lines = 2 * (sz / hb_mc_config_get_vcache_block_size(cfg) + sizes.size());
+        int whole_cache = hb_mc_vcache_whole_cache_is_cheaper(mc, lines);
+
+        if (whole_cache) {
+                err = hb_mc_manycore_flush_vcache(mc);
+                if (err != HB_MC_SUCCESS) {
+                        bsg_pr_err("%s: Failed to flush victim caches: %s\n",
+                                   __func__, hb_mc_strerror(err));
+                        return err;
+                }
+        }
+
+        std::vector<uint8_t> buf(min_size_t(sz, HB_MC_EVA_DMA_BUF_SZ));
+        for (size_t i = 0; i < sizes.size(); i++) {
+                if (!whole_cache && hb_mc_manycore_has_cache(mc)) {
+                        err = hb_mc_manycore_vcache_flush_npa_range(mc, &src_npas[i], sizes[i]);
+                        if (err == HB_MC_SUCCESS)
+                                err = hb_mc_manycore_vcache_flush_npa_range_edges(mc, &dst_npas[i], sizes[i]);
+                        if (err != HB_MC_SUCCESS) {
+                                bsg_pr_err("%s: Failed to flush NPA region: %s\n",
+                                           __func__, hb_mc_strerror(err));
+                                return err;
+                        }
+                }
+
+                for (size_t off = 0; off < sizes[i]; off += buf.size()) {
+                        xfer_sz = min_size_t(sizes[i] - off, buf.size());
+                        dst_npa = dst_npas[i];
+                        src_npa = src_npas[i];
+                        hb_mc_npa_set_epa(&dst_npa, hb_mc_npa_get_epa(&dst_npas[i]) + off);
+                        hb_mc_npa_set_epa(&src_npa, hb_mc_npa_get_epa(&src_npas[i]) + off);
+
+                        err = hb_mc_manycore_dma_read_no_cache_afl(mc, &src_npa, buf.data(), xfer_sz);
+                        if (err == HB_MC_SUCCESS)
+                                err = hb_mc_manycore_dma_write_no_cache_ainv(mc, &dst_npa, buf.data(), xfer_sz);
+                        if (err != HB_MC_SUCCESS) {
+                                bsg_pr_err("%s: Failed to DMA copy NPA region: %s\n",
+                                           __func__, hb_mc_strerror(err));
+                                return err;
+                        }
+                }
+
+                if (!whole_cache && hb_mc_manycore_has_cache(mc)) {
+                        err = hb_mc_manycore_vcache_invalidate_npa_range(mc, &dst_npas[i], sizes[i]);
+                        if (err != HB_MC_SUCCESS) {
+                                bsg_pr_err("%s: Failed to invalidate NPA region: %s\n",
+                                           __func__, hb_mc_strerror(err));
+                                return err;
+                        }
+                }
+        }
+
+        if (whole_cache)
+                return hb_mc_manycore_invalidate_vcache(mc);
+
+        return hb_mc_manycore_host_request_fence(mc, -1);
+}
+
+/**
+ * Copy one EVA memory region to another
+ * @param[in]  mc     An initialized manycore struct
+ * @param[in]  map    An eva map for computing the eva to npa translation
+ * @param[in]  tgt    Coordinate of the tile issuing both EVAs
+ * @param[in]  dst    A valid hb_mc_eva_t - start of the destination region
+ * @param[in]  src    A valid hb_mc_eva_t - start of the source region
+ * @param[in]  sz     The number of bytes to copy
+ * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ */
+int hb_mc_manycore_eva_copy(hb_mc_manycore_t *mc,
+                            const hb_mc_eva_map_t *map,
+                            const hb_mc_coordinate_t *tgt,
+                            const hb_mc_eva_t *dst,
+                            const hb_mc_eva_t *src,
+                            size_t sz)
+{
+        int err;
+
+        // DRAM to DRAM copies never leave the backing store when there is DMA
+        if (hb_mc_manycore_dram_is_enabled(mc) &&
+            hb_mc_manycore_supports_dma_read(mc) &&
+            hb_mc_manycore_supports_dma_write(mc)) {
+                err = hb_mc_manycore_eva_copy_dma(mc, map, tgt, dst, src, sz);
+                if (err != HB_MC_NOIMPL)
+                        return err;
+        }
+
+        // otherwise stage the copy through a bounded host buffer
+        std::vector<uint8_t> buf(min_size_t(sz, HB_MC_EVA_DMA_BUF_SZ));
+        for (size_t off = 0; off < sz; off += buf.size()) {
+                size_t xfer_sz = min_size_t(sz - off, buf.size());
+                hb_mc_eva_t dst_eva = *dst + off, src_eva = *src + off;
+
+                err = hb_mc_manycore_eva_read(mc, map, tgt, &src_eva, buf.data(), xfer_sz);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+
+                err = hb_mc_manycore_eva_write(mc, map, tgt, &dst_eva, buf.data(), xfer_sz);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+        }
+
+        return HB_MC_SUCCESS;
+}
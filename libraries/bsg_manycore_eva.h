@@ -235,6 +235,51 @@ extern "C" {
                                     const hb_mc_eva_t *eva,
                                     void *data, size_t sz);
 
+        /**
+         * One segment of a vectored EVA read or write.
+         */
+        typedef struct hb_mc_eva_iovec {
+                hb_mc_eva_t eva;   //!< EVA of the first byte of the segment
+                void       *data;  //!< host buffer; written out on writes, filled in on reads
+                size_t      sz;    //!< segment length in bytes
+        } hb_mc_eva_iovec_t;
+
+        /**
+         * Write a list of host buffers out to manycore hardware at given EVAs
+         * @param[in]  mc     An initialized manycore struct
+         * @param[in]  map    An eva map for computing the eva to npa translation
+         * @param[in]  tgt    Coordinate of the tile issuing the EVAs
+         * @param[in]  iov    A list of segments to write
+         * @param[in]  n      The number of segments in #iov
+         * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+         *
+         * Every segment is translated before any data is sent; the stores
+         * are then pipelined together and completed with a single fence.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_eva_write_vec(hb_mc_manycore_t *mc,
+                                         const hb_mc_eva_map_t *map,
+                                         const hb_mc_coordinate_t *tgt,
+                                         const hb_mc_eva_iovec_t *iov, size_t n);
+
+        /**
+         * Read a list of EVA regions from manycore hardware into host buffers
+         * @param[in]  mc     An initialized manycore struct
+         * @param[in]  map    An eva map for computing the eva to npa translation
+         * @param[in]  tgt    Coordinate of the tile issuing the EVAs
+         * @param[in]  iov    A list of segments to read
+         * @param[in]  n      The number of segments in #iov
+         * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+         *
+         * Every segment is translated before any data is requested; the
+         * loads are then pipelined together.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_eva_read_vec(hb_mc_manycore_t *mc,
+                                        const hb_mc_eva_map_t *map,
+                                        const hb_mc_coordinate_t *tgt,
+                                        const hb_mc_eva_iovec_t *iov, size_t n);
+
         /**
          * Set a EVA memory region to a value
          * @param[in]  mc     An initialized manycore struct
@@ -244,6 +289,9 @@ extern "C" {
          * @param[in]  val    The value to write to the region
          * @param[in]  sz     The number of bytes to write to manycore hardware
          * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+         *
+         * Large fills that lie entirely in DRAM are written via DMA on
+         * platforms that support it; everything else is written with packets.
          */
         int hb_mc_manycore_eva_memset(hb_mc_manycore_t *mc,
                                       const hb_mc_eva_map_t *map,
@@ -251,6 +299,28 @@ extern "C" {
                                       const hb_mc_eva_t *eva,
                                       uint8_t val, size_t sz);
 
+        /**
+         * Copy one EVA memory region to another
+         * @param[in]  mc     An initialized manycore struct
+         * @param[in]  map    An eva map for computing the eva to npa translation
+         * @param[in]  tgt    Coordinate of the tile issuing both EVAs
+         * @param[in]  dst    A valid hb_mc_eva_t - start of the destination region
+         * @param[in]  src    A valid hb_mc_eva_t - start of the source region
+         * @param[in]  sz     The number of bytes to copy
+         * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+         *
+         * The regions must not overlap. Copies between DRAM regions are done
+         * with DMA on platforms that support it, so the data never crosses
+         * the host link; everything else is staged through host memory.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_eva_copy(hb_mc_manycore_t *mc,
+                                    const hb_mc_eva_map_t *map,
+                                    const hb_mc_coordinate_t *tgt,
+                                    const hb_mc_eva_t *dst,
+                                    const hb_mc_eva_t *src,
+                                    size_t sz);
+
         /**
          * Returns the EVA associated with a hb_mc_eva_t 
          * @param[in]  eva    A valid eva_t
@@ -0,0 +1,268 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore_io.h>
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_printing.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+struct hb_mc_io_future {
+        std::future<int> result;
+};
+
+/* a queued command; intrusive node of the submission queue */
+typedef struct hb_mc_io_command {
+        std::atomic<hb_mc_io_command*> next;
+        std::function<int(hb_mc_manycore_t*)> run;
+        std::promise<int> result;
+} hb_mc_io_command_t;
+
+/*
+ * Unbounded lock-free multi-producer single-consumer queue.
+ *
+ * Producers swap themselves in at head with one atomic exchange and then
+ * link the previous head to themselves; the single consumer follows the
+ * links from tail. A stub node keeps the queue non-empty so neither end
+ * ever needs a lock. pop() returns nullptr when the queue is empty or a
+ * producer is between its exchange and its link; the consumer retries.
+ */
+class hb_mc_io_queue {
+public:
+        hb_mc_io_queue() : head(&stub), tail(&stub) {
+                stub.next.store(nullptr, std::memory_order_relaxed);
+        }
+
+        void push(hb_mc_io_command_t *cmd) {
+                cmd->next.store(nullptr, std::memory_order_relaxed);
+                hb_mc_io_command_t *prev = head.exchange(cmd, std::memory_order_acq_rel);
+                prev->next.store(cmd, std::memory_order_release);
+        }
+
+        hb_mc_io_command_t *pop() {
+                hb_mc_io_command_t *t = tail;
+                hb_mc_io_command_t *next = t->next.load(std::memory_order_acquire);
+
+                if (t == &stub) {
+                        if (next == nullptr)
+                                return nullptr;
+                        tail = t = next;
+                        next = t->next.load(std::memory_order_acquire);
+                }
+
+                if (next != nullptr) {
+                        tail = next;
+                        return t;
+                }
+
+                // t is the last node; a producer may still be linking behind it
+                if (t != head.load(std::memory_order_acquire))
+                        return nullptr;
+
+                // put the stub back behind t so t can be handed out
+                push(&stub);
+                next = t->next.load(std::memory_order_acquire);
+                if (next != nullptr) {
+                        tail = next;
+                        return t;
+                }
+
+                return nullptr;
+        }
+
+private:
+        std::atomic<hb_mc_io_command_t*> head;
+        hb_mc_io_command_t *tail;
+        hb_mc_io_command_t stub;
+};
+
+struct hb_mc_io {
+        hb_mc_manycore_t *mc;
+        hb_mc_io_queue queue;
+        std::atomic<size_t> pending;  //!< commands submitted but not yet popped
+        std::atomic<bool> stopping;
+        std::mutex idle_mutex;        //!< held only to sleep and wake the I/O thread
+        std::condition_variable idle;
+        std::thread thread;
+};
+
+/* the I/O thread: run commands in order; sleep while there are none */
+static void hb_mc_io_main(hb_mc_io_t *io)
+{
+        for (;;) {
+                hb_mc_io_command_t *cmd = io->queue.pop();
+
+                if (cmd != nullptr) {
+                        io->pending.fetch_sub(1, std::memory_order_relaxed);
+                        cmd->result.set_value(cmd->run(io->mc));
+                        delete cmd;
+                        continue;
+                }
+
+                if (io->pending.load(std::memory_order_acquire) > 0) {
+                        // a producer is mid-push; it will finish shortly
+                        std::this_thread::yield();
+                        continue;
+                }
+
+                std::unique_lock<std::mutex> lock(io->idle_mutex);
+                io->idle.wait(lock, [io] {
+                                return io->pending.load(std::memory_order_acquire) > 0
+                                        || io->stopping.load(std::memory_order_acquire);
+                        });
+
+                if (io->pending.load(std::memory_order_acquire) == 0)
+                        return; // stopping and drained
+        }
+}
+
+/* queue a command and hand back its future */
+static int hb_mc_io_submit(hb_mc_io_t *io, std::function<int(hb_mc_manycore_t*)> run,
+                           hb_mc_io_future_t **future)
+{
+        hb_mc_io_command_t *cmd = new (std::nothrow) hb_mc_io_command_t;
+        if (cmd == nullptr)
+                return HB_MC_NOMEM;
+
+        hb_mc_io_future_t *f = nullptr;
+        if (future != nullptr) {
+                f = new (std::nothrow) hb_mc_io_future_t;
+                if (f == nullptr) {
+                        delete cmd;
+                        return HB_MC_NOMEM;
+                }
+                f->result = cmd->result.get_future();
+        }
+
+        cmd->run = std::move(run);
+
+        // count the command before it becomes visible so pending never underflows
+        bool wake = io->pending.fetch_add(1, std::memory_order_acq_rel) == 0;
+        io->queue.push(cmd);
+
+        // wake the I/O thread if this is the only command
+        if (wake) {
+                std::lock_guard<std::mutex> lock(io->idle_mutex);
+                io->idle.notify_one();
+        }
+
+        if (future != nullptr)
+                *future = f;
+
+        return HB_MC_SUCCESS;
+}
+
+int hb_mc_io_init(hb_mc_manycore_t *mc, hb_mc_io_t **io)
+{
+        hb_mc_io_t *new_io = new (std::nothrow) hb_mc_io_t;
+        if (new_io == nullptr)
+                return HB_MC_NOMEM;
+
+        new_io->mc = mc;
+        new_io->pending.store(0);
+        new_io->stopping.store(false);
+
+        try {
+                new_io->thread = std::thread(hb_mc_io_main, new_io);
+        } catch (const std::system_error &e) {
+                bsg_pr_err("%s: Failed to start I/O thread: %s\n", __func__, e.what());
+                delete new_io;
+                return HB_MC_FAIL;
+        }
+
+        *io = new_io;
+        return HB_MC_SUCCESS;
+}
+
+int hb_mc_io_exit(hb_mc_io_t *io)
+{
+        {
+                std::lock_guard<std::mutex> lock(io->idle_mutex);
+                io->stopping.store(true, std::memory_order_release);
+                io->idle.notify_one();
+        }
+
+        io->thread.join();
+        delete io;
+        return HB_MC_SUCCESS;
+}
+
+int hb_mc_io_write_mem(hb_mc_io_t *io, const hb_mc_npa_t *npa,
+                       const void *data, size_t sz,
+                       hb_mc_io_future_t **future)
+{
+        hb_mc_npa_t addr = *npa;
+
+        // copy the data so the caller may reuse its buffer immediately
+        std::vector<uint32_t> words((sz + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+        memcpy(words.data(), data, sz);
+
+        return hb_mc_io_submit(io, [addr, words, sz] (hb_mc_manycore_t *mc) {
+                        return hb_mc_manycore_write_mem(mc, &addr, words.data(), sz);
+                }, future);
+}
+
+int hb_mc_io_read_mem(hb_mc_io_t *io, const hb_mc_npa_t *npa,
+                      void *data, size_t sz,
+                      hb_mc_io_future_t **future)
+{
+        hb_mc_npa_t addr = *npa;
+
+        return hb_mc_io_submit(io, [addr, data, sz] (hb_mc_manycore_t *mc) {
+                        return hb_mc_manycore_read_mem(mc, &addr, data, sz);
+                }, future);
+}
+
+int hb_mc_io_call(hb_mc_io_t *io, hb_mc_io_function_t fn, void *arg,
+                  hb_mc_io_future_t **future)
+{
+        return hb_mc_io_submit(io, [fn, arg] (hb_mc_manycore_t *mc) {
+                        return fn(mc, arg);
+                }, future);
+}
+
+int hb_mc_io_future_ready(hb_mc_io_future_t *future)
+{
+        return future->result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+int hb_mc_io_future_wait(hb_mc_io_future_t *future)
+{
+        int result = future->result.get();
+        delete future;
+        return result;
+}
@@ -0,0 +1,154 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef BSG_MANYCORE_IO_H
+#define BSG_MANYCORE_IO_H
+
+#include <bsg_manycore_features.h>
+#include <bsg_manycore.h>
+#include <bsg_manycore_npa.h>
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+        /**
+         * An I/O thread that owns a manycore instance.
+         *
+         * Once an I/O thread is started, it is the only thread that may touch
+         * its manycore instance: the platform FIFOs, the load ID pool, the
+         * responders and anything built on top of them (EVA, CUDA-lite).
+         * Any number of application threads may then submit commands
+         * concurrently. Commands are queued on a lock-free multi-producer
+         * queue and run one at a time, in submission order, on the I/O thread.
+         * Responder callbacks also run on the I/O thread.
+         */
+        typedef struct hb_mc_io hb_mc_io_t;
+
+        /**
+         * The completion of a submitted command.
+         */
+        typedef struct hb_mc_io_future hb_mc_io_future_t;
+
+        /**
+         * A command run on the I/O thread by hb_mc_io_call().
+         * @param[in]  mc     The manycore instance owned by the I/O thread
+         * @param[in]  arg    The argument given to hb_mc_io_call()
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        typedef int (*hb_mc_io_function_t)(hb_mc_manycore_t *mc, void *arg);
+
+        /**
+         * Start an I/O thread for a manycore instance
+         * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+         * @param[out] io     Set to the new I/O thread
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_io_init(hb_mc_manycore_t *mc, hb_mc_io_t **io);
+
+        /**
+         * Stop an I/O thread after running every command already submitted
+         * @param[in]  io     An I/O thread started with hb_mc_io_init()
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * No commands may be submitted during or after this call. The
+         * manycore instance may be used directly again once it returns.
+         */
+        int hb_mc_io_exit(hb_mc_io_t *io);
+
+        /**
+         * Submit a write of a host buffer to manycore memory
+         * @param[in]  io     An I/O thread started with hb_mc_io_init()
+         * @param[in]  npa    A valid hb_mc_npa_t
+         * @param[in]  data   A buffer to be written out; copied before this call returns
+         * @param[in]  sz     The number of bytes to write
+         * @param[out] future Set to the completion of the write, or NULL to not wait on it
+         * @return HB_MC_SUCCESS if the command was queued. Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * The write is complete (fenced) when its future is ready.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_io_write_mem(hb_mc_io_t *io, const hb_mc_npa_t *npa,
+                               const void *data, size_t sz,
+                               hb_mc_io_future_t **future);
+
+        /**
+         * Submit a read of manycore memory into a host buffer
+         * @param[in]  io     An I/O thread started with hb_mc_io_init()
+         * @param[in]  npa    A valid hb_mc_npa_t
+         * @param[out] data   A buffer into which data will be read; must stay valid until #future is ready
+         * @param[in]  sz     The number of bytes to read
+         * @param[out] future Set to the completion of the read
+         * @return HB_MC_SUCCESS if the command was queued. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_io_read_mem(hb_mc_io_t *io, const hb_mc_npa_t *npa,
+                              void *data, size_t sz,
+                              hb_mc_io_future_t **future);
+
+        /**
+         * Submit an arbitrary command, e.g. a kernel launch, to run on the I/O thread
+         * @param[in]  io     An I/O thread started with hb_mc_io_init()
+         * @param[in]  fn     The command to run
+         * @param[in]  arg    An argument passed to #fn; must stay valid until #future is ready
+         * @param[out] future Set to the completion of the command, or NULL to not wait on it
+         * @return HB_MC_SUCCESS if the command was queued. Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * #fn may use any library call on the manycore instance, including
+         * the EVA and CUDA-lite APIs, but must not submit to and wait on #io.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_io_call(hb_mc_io_t *io, hb_mc_io_function_t fn, void *arg,
+                          hb_mc_io_future_t **future);
+
+        /**
+         * Check whether a command has completed without blocking
+         * @param[in]  future A future returned by a hb_mc_io_*() call
+         * @return One if the command has completed - Zero otherwise.
+         */
+        int hb_mc_io_future_ready(hb_mc_io_future_t *future);
+
+        /**
+         * Wait for a command to complete and release its future
+         * @param[in]  future A future returned by a hb_mc_io_*() call
+         * @return The return code of the command.
+         */
+        int hb_mc_io_future_wait(hb_mc_io_future_t *future);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
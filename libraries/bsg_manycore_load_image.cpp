@@ -0,0 +1,718 @@
+// Copyright (c) 2019, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore_load_image.h>
+#include <bsg_manycore_loader.h>
+#include <bsg_manycore_config.h>
+#include <bsg_manycore_npa.h>
+#include <bsg_manycore_printing.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+struct hb_mc_load_image {
+        const unsigned char *data;
+        const hb_mc_load_image_header_t *hdr;
+        const hb_mc_load_image_npa_write_t *once;
+        const hb_mc_load_image_epa_write_t *each;
+        const hb_mc_load_image_symbol_t *syms;
+        const hb_mc_load_image_symbol_t *cfg_syms;
+        const char *strs;
+        const unsigned char *payload;
+};
+
+/* is [off, off+len) within an object of sz bytes? */
+static bool hb_mc_load_image_in_bounds(uint64_t sz, uint64_t off, uint64_t len)
+{
+        return off <= sz && len <= sz - off;
+}
+
+/* is a table of n entries of entsz bytes at off aligned and within an object of sz bytes? */
+static bool hb_mc_load_image_table_in_bounds(uint64_t sz, uint32_t off, uint32_t n, size_t entsz)
+{
+        return off % sizeof(uint32_t) == 0
+                && hb_mc_load_image_in_bounds(sz, off, (uint64_t)n * entsz);
+}
+
+/* does a write of sz bytes at data_off lie within the payload? */
+static bool hb_mc_load_image_data_in_bounds(const hb_mc_load_image_header_t *hdr,
+                                            uint32_t data_off, uint32_t sz)
+{
+        return data_off == HB_MC_LOAD_IMAGE_ZEROS
+                || hb_mc_load_image_in_bounds(hdr->data_sz, data_off, sz);
+}
+
+/**
+ * Check if a buffer holds a load image rather than a manycore binary.
+ * @param[in]  data   A buffer
+ * @param[in]  sz     Size of #data in bytes
+ * @return One if #data starts with a load image header - Zero otherwise.
+ */
+int hb_mc_load_image_is_load_image(const void *data, size_t sz)
+{
+        const hb_mc_load_image_header_t *hdr = (const hb_mc_load_image_header_t *)data;
+
+        return data && sz >= sizeof(*hdr) && hdr->magic == HB_MC_LOAD_IMAGE_MAGIC;
+}
+
+/**
+ * Validate a load image in memory.
+ * @param[in]  data   A buffer holding a load image; it must outlive #image
+ * @param[in]  sz     Size of #data in bytes
+ * @param[out] image  Set to the image; free it with hb_mc_load_image_destroy()
+ * @return HB_MC_SUCCESS if succesful. HB_MC_INVALID if #data is not a valid load image.
+ * Otherwise an error code is returned.
+ */
+int hb_mc_load_image_init(const void *data, size_t sz, hb_mc_load_image_t **image)
+{
+        const unsigned char *bytes = (const unsigned char *)data;
+        const hb_mc_load_image_header_t *hdr = (const hb_mc_load_image_header_t *)data;
+
+        if (!image || !hb_mc_load_image_is_load_image(data, sz))
+                return HB_MC_INVALID;
+
+        if (hdr->version != HB_MC_LOAD_IMAGE_VERSION) {
+                bsg_pr_dbg("%s: unsupported version %" PRIu32 "\n", __func__, hdr->version);
+                return HB_MC_INVALID;
+        }
+
+        if (hdr->size != sz
+            || !hb_mc_load_image_table_in_bounds(sz, hdr->once_off, hdr->once_n,
+                                                 sizeof(hb_mc_load_image_npa_write_t))
+            || !hb_mc_load_image_table_in_bounds(sz, hdr->each_off, hdr->each_n,
+                                                 sizeof(hb_mc_load_image_epa_write_t))
+            || !hb_mc_load_image_table_in_bounds(sz, hdr->sym_off, hdr->sym_n,
+                                                 sizeof(hb_mc_load_image_symbol_t))
+            || !hb_mc_load_image_table_in_bounds(sz, hdr->cfg_sym_off, hdr->cfg_sym_n,
+                                                 sizeof(hb_mc_load_image_symbol_t))
+            || !hb_mc_load_image_in_bounds(sz, hdr->str_off, hdr->str_sz)
+            || !hb_mc_load_image_in_bounds(sz, hdr->data_off, hdr->data_sz)
+            || !hb_mc_load_image_in_bounds(hdr->data_sz, hdr->icache_off, hdr->icache_sz)) {
+                bsg_pr_dbg("%s: table exceeds image size (%zu)\n", __func__, sz);
+                return HB_MC_INVALID;
+        }
+
+        hb_mc_load_image_t *img = new (std::nothrow) hb_mc_load_image_t();
+        if (!img)
+                return HB_MC_NOMEM;
+
+        img->data     = bytes;
+        img->hdr      = hdr;
+        img->once     = (const hb_mc_load_image_npa_write_t *)&bytes[hdr->once_off];
+        img->each     = (const hb_mc_load_image_epa_write_t *)&bytes[hdr->each_off];
+        img->syms     = (const hb_mc_load_image_symbol_t *)&bytes[hdr->sym_off];
+        img->cfg_syms = (const hb_mc_load_image_symbol_t *)&bytes[hdr->cfg_sym_off];
+        img->strs     = (const char *)&bytes[hdr->str_off];
+        img->payload  = &bytes[hdr->data_off];
+
+        /* every name must be terminated within the string table */
+        if ((hdr->sym_n > 0 || hdr->cfg_sym_n > 0)
+            && (hdr->str_sz == 0 || img->strs[hdr->str_sz - 1] != '\0')) {
+                bsg_pr_dbg("%s: string table is not terminated\n", __func__);
+                goto fail;
+        }
+
+        for (uint32_t i = 0; i < hdr->sym_n; i++) {
+                if (img->syms[i].name_off >= hdr->str_sz) {
+                        bsg_pr_dbg("%s: symbol %" PRIu32 " has an out of bounds name\n", __func__, i);
+                        goto fail;
+                }
+        }
+
+        for (uint32_t i = 0; i < hdr->cfg_sym_n; i++) {
+                if (img->cfg_syms[i].name_off >= hdr->str_sz) {
+                        bsg_pr_dbg("%s: configuration symbol %" PRIu32 " has an out of bounds name\n",
+                                   __func__, i);
+                        goto fail;
+                }
+        }
+
+        for (uint32_t i = 0; i < hdr->once_n; i++) {
+                if (!hb_mc_load_image_data_in_bounds(hdr, img->once[i].data_off, img->once[i].sz)) {
+                        bsg_pr_dbg("%s: DRAM write %" PRIu32 " exceeds image data\n", __func__, i);
+                        goto fail;
+                }
+        }
+
+        for (uint32_t i = 0; i < hdr->each_n; i++) {
+                if (!hb_mc_load_image_data_in_bounds(hdr, img->each[i].data_off, img->each[i].sz)) {
+                        bsg_pr_dbg("%s: DMEM write %" PRIu32 " exceeds image data\n", __func__, i);
+                        goto fail;
+                }
+        }
+
+        *image = img;
+        return HB_MC_SUCCESS;
+
+fail:
+        delete img;
+        return HB_MC_INVALID;
+}
+
+/**
+ * Free a load image created with hb_mc_load_image_init().
+ * @param[in]  image  A load image
+ */
+void hb_mc_load_image_destroy(hb_mc_load_image_t *image)
+{
+        delete image;
+}
+
+/* compare a machine parameter recorded in a load image with the machine's own */
+#define hb_mc_load_image_check_field(name, fmt, image_val, mc_val)              \
+        do {                                                                    \
+                if ((uint32_t)(image_val) != (uint32_t)(mc_val)) {              \
+                        bsg_pr_err("%s: load image was lowered for " name " "   \
+                                   fmt " but the machine has " fmt "\n",        \
+                                   __func__, (uint32_t)(image_val),             \
+                                   (uint32_t)(mc_val));                         \
+                        return HB_MC_INVALID;                                   \
+                }                                                               \
+        } while (0)
+
+/**
+ * Check that a load image was lowered for a machine.
+ * @param[in]  image  A load image
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @return HB_MC_SUCCESS if #image can be loaded onto #mc. HB_MC_INVALID otherwise.
+ */
+int hb_mc_load_image_check_machine(const hb_mc_load_image_t *image,
+                                   const hb_mc_manycore_t *mc)
+{
+        const hb_mc_load_image_header_t *hdr = image->hdr;
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        hb_mc_dimension_t dim = hb_mc_config_get_dimension_vcore(cfg);
+        hb_mc_dimension_t net = hb_mc_config_get_dimension_network(cfg);
+
+        hb_mc_load_image_check_field("basejump githash", "%08" PRIx32,
+                                     hdr->basejump, hb_mc_config_get_githash_basejump(cfg));
+        hb_mc_load_image_check_field("manycore githash", "%08" PRIx32,
+                                     hdr->manycore, hb_mc_config_get_githash_manycore(cfg));
+        hb_mc_load_image_check_field("f1 githash", "%08" PRIx32,
+                                     hdr->f1, hb_mc_config_get_githash_f1(cfg));
+        hb_mc_load_image_check_field("vcore width", "%" PRIu32,
+                                     hdr->dim_x, hb_mc_dimension_get_x(dim));
+        hb_mc_load_image_check_field("vcore height", "%" PRIu32,
+                                     hdr->dim_y, hb_mc_dimension_get_y(dim));
+        hb_mc_load_image_check_field("vcore base X", "%" PRIu32,
+                                     hdr->vcore_base_x, hb_mc_config_get_vcore_base_x(cfg));
+        hb_mc_load_image_check_field("vcore base Y", "%" PRIu32,
+                                     hdr->vcore_base_y, hb_mc_config_get_vcore_base_y(cfg));
+        hb_mc_load_image_check_field("network width", "%" PRIu32,
+                                     hdr->net_x, hb_mc_dimension_get_x(net));
+        hb_mc_load_image_check_field("network height", "%" PRIu32,
+                                     hdr->net_y, hb_mc_dimension_get_y(net));
+        hb_mc_load_image_check_field("DRAM low Y", "%" PRIu32,
+                                     hdr->dram_low_y, hb_mc_config_get_dram_low_y(cfg));
+        hb_mc_load_image_check_field("DRAM high Y", "%" PRIu32,
+                                     hdr->dram_high_y, hb_mc_config_get_dram_high_y(cfg));
+        hb_mc_load_image_check_field("vcache ways", "%" PRIu32,
+                                     hdr->vcache_ways, hb_mc_config_get_vcache_ways(cfg));
+        hb_mc_load_image_check_field("vcache sets", "%" PRIu32,
+                                     hdr->vcache_sets, hb_mc_config_get_vcache_sets(cfg));
+        hb_mc_load_image_check_field("vcache block words", "%" PRIu32,
+                                     hdr->vcache_block_words, hb_mc_config_get_vcache_block_words(cfg));
+        hb_mc_load_image_check_field("vcache stripe words", "%" PRIu32,
+                                     hdr->vcache_stripe_words, hb_mc_config_get_vcache_stripe_words(cfg));
+        hb_mc_load_image_check_field("DRAM channels", "%" PRIu32,
+                                     hdr->dram_channels, hb_mc_config_get_dram_channels(cfg));
+        hb_mc_load_image_check_field("DRAM bank size", "%" PRIu32,
+                                     hdr->dram_bank_size, hb_mc_config_get_dram_bank_size(cfg));
+        hb_mc_load_image_check_field("DRAM enabled", "%" PRIu32,
+                                     hdr->dram_enabled, hb_mc_manycore_dram_is_enabled(mc) ? 1 : 0);
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Get the DRAM writes of a load image.
+ * @param[in]  image  A load image
+ * @param[out] writes Set to the writes
+ * @param[out] n      Set to the number of writes
+ */
+void hb_mc_load_image_get_once(const hb_mc_load_image_t *image,
+                               const hb_mc_load_image_npa_write_t **writes,
+                               size_t *n)
+{
+        *writes = image->once;
+        *n = image->hdr->once_n;
+}
+
+/**
+ * Get the DMEM writes of a load image.
+ * @param[in]  image  A load image
+ * @param[out] writes Set to the writes
+ * @param[out] n      Set to the number of writes
+ */
+void hb_mc_load_image_get_each(const hb_mc_load_image_t *image,
+                               const hb_mc_load_image_epa_write_t **writes,
+                               size_t *n)
+{
+        *writes = image->each;
+        *n = image->hdr->each_n;
+}
+
+/**
+ * Get the ICACHE contents of a load image.
+ * @param[in]  image  A load image
+ * @param[out] data   Set to the ICACHE contents
+ * @param[out] sz     Set to the number of bytes in #data
+ */
+void hb_mc_load_image_get_icache(const hb_mc_load_image_t *image,
+                                 const unsigned char **data,
+                                 size_t *sz)
+{
+        *data = &image->payload[image->hdr->icache_off];
+        *sz = image->hdr->icache_sz;
+}
+
+/**
+ * Get the data of a write.
+ * @param[in]  image    A load image
+ * @param[in]  data_off The data_off of a write
+ * @return the data, or NULL if the write fills with zeros
+ */
+const unsigned char *hb_mc_load_image_get_data(const hb_mc_load_image_t *image,
+                                               uint32_t data_off)
+{
+        if (data_off == HB_MC_LOAD_IMAGE_ZEROS)
+                return NULL;
+
+        return &image->payload[data_off];
+}
+
+/**
+ * Get an EVA for a symbol of a load image.
+ * @param[in]  image   A load image
+ * @param[in]  symbol  A program symbol
+ * @param[out] eva     An EVA that addresses #symbol
+ * @return HB_MC_SUCCESS if succesful. HB_MC_NOTFOUND if the image has no such symbol.
+ */
+int hb_mc_load_image_symbol_to_eva(const hb_mc_load_image_t *image,
+                                   const char *symbol,
+                                   hb_mc_eva_t *eva)
+{
+        if (!image || !symbol || !eva)
+                return HB_MC_INVALID;
+
+        /* symbols are sorted by name */
+        size_t lo = 0, hi = image->hdr->sym_n;
+        while (lo < hi) {
+                size_t mid = lo + (hi - lo) / 2;
+                int cmp = strcmp(&image->strs[image->syms[mid].name_off], symbol);
+                if (cmp == 0) {
+                        *eva = image->syms[mid].eva;
+                        return HB_MC_SUCCESS;
+                }
+                if (cmp < 0)
+                        lo = mid + 1;
+                else
+                        hi = mid;
+        }
+
+        bsg_pr_dbg("%s: failed to find symbol '%s'\n", __func__, symbol);
+        return HB_MC_NOTFOUND;
+}
+
+/**
+ * Get the EVAs of the configuration symbols of a load image.
+ * @param[in]  image     A load image
+ * @param[in]  cfg_syms  Names of the configuration symbols, as given when lowering
+ * @param[in]  ncfg_syms The number of names in #cfg_syms
+ * @param[out] evas      Set to the EVA of each symbol in #cfg_syms
+ * @return HB_MC_SUCCESS if succesful. HB_MC_NOTFOUND if the image was lowered
+ * with different configuration symbols.
+ */
+int hb_mc_load_image_get_cfg_symbols(const hb_mc_load_image_t *image,
+                                     const char *const *cfg_syms,
+                                     size_t ncfg_syms,
+                                     hb_mc_eva_t *evas)
+{
+        if (!image || (ncfg_syms && (!cfg_syms || !evas)))
+                return HB_MC_INVALID;
+
+        if (ncfg_syms != image->hdr->cfg_sym_n)
+                return HB_MC_NOTFOUND;
+
+        for (size_t i = 0; i < ncfg_syms; i++) {
+                if (strcmp(&image->strs[image->cfg_syms[i].name_off], cfg_syms[i]) != 0)
+                        return HB_MC_NOTFOUND;
+        }
+
+        for (size_t i = 0; i < ncfg_syms; i++)
+                evas[i] = image->cfg_syms[i].eva;
+
+        return HB_MC_SUCCESS;
+}
+
+/* A load image under construction */
+typedef struct hb_mc_load_image_builder {
+        std::vector<hb_mc_load_image_npa_write_t> once;
+        std::vector<hb_mc_load_image_epa_write_t> each;
+        std::vector<hb_mc_load_image_symbol_t> syms;
+        std::vector<hb_mc_load_image_symbol_t> cfg_syms;
+        std::string strs;
+        std::vector<unsigned char> data;
+} hb_mc_load_image_builder_t;
+
+/* append program data to the payload, returning its offset */
+static uint32_t hb_mc_load_image_builder_add_data(hb_mc_load_image_builder_t *b,
+                                                  const unsigned char *data, size_t sz)
+{
+        uint32_t off;
+
+        if (!data)
+                return HB_MC_LOAD_IMAGE_ZEROS;
+
+        off = b->data.size();
+        b->data.insert(b->data.end(), data, data + sz);
+        return off;
+}
+
+/**
+ * Lower the DRAM writes of a load plan to NPAs, as seen from the origin vcore.
+ * @param[in]  b      A load image under construction
+ * @param[in]  mc     A manycore instance whose configuration is the target machine
+ * @param[in]  map    An eva map for computing the eva to npa translation
+ * @param[in]  plan   A load plan
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+static int hb_mc_load_image_lower_once(hb_mc_load_image_builder_t *b,
+                                       hb_mc_manycore_t *mc,
+                                       const hb_mc_eva_map_t *map,
+                                       const hb_mc_loader_plan_t *plan)
+{
+        hb_mc_coordinate_t origin = hb_mc_config_get_origin_vcore(hb_mc_manycore_get_config(mc));
+        const hb_mc_loader_write_t *writes;
+        size_t n;
+        int rc;
+
+        hb_mc_loader_plan_get_once(plan, &writes, &n);
+        for (size_t i = 0; i < n; i++) {
+                hb_mc_eva_t eva = writes[i].eva;
+                size_t off = 0;
+
+                while (off < writes[i].sz) {
+                        hb_mc_npa_t npa;
+                        size_t npa_sz;
+
+                        rc = hb_mc_eva_to_npa(mc, map, &origin, &eva, &npa, &npa_sz);
+                        if (rc != HB_MC_SUCCESS) {
+                                bsg_pr_err("%s: failed to translate EVA 0x%08" PRIx32 ": %s\n",
+                                           __func__, eva, hb_mc_strerror(rc));
+                                return rc;
+                        }
+
+                        size_t sz = std::min(writes[i].sz - off, npa_sz);
+                        b->once.push_back({hb_mc_npa_get_x(&npa), hb_mc_npa_get_y(&npa),
+                                           hb_mc_npa_get_epa(&npa), (uint32_t)sz,
+                                           hb_mc_load_image_builder_add_data(b, writes[i].data ?
+                                                                             &writes[i].data[off] : NULL,
+                                                                             sz)});
+                        off += sz;
+                        eva += sz;
+                }
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Lower the DMEM writes of a load plan to EPAs within a tile.
+ * @param[in]  b      A load image under construction
+ * @param[in]  mc     A manycore instance whose configuration is the target machine
+ * @param[in]  map    An eva map for computing the eva to npa translation
+ * @param[in]  plan   A load plan
+ * @return HB_MC_SUCCESS if succesful. HB_MC_INVALID if a write leaves the tile.
+ * Otherwise an error code is returned.
+ */
+static int hb_mc_load_image_lower_each(hb_mc_load_image_builder_t *b,
+                                       hb_mc_manycore_t *mc,
+                                       const hb_mc_eva_map_t *map,
+                                       const hb_mc_loader_plan_t *plan)
+{
+        hb_mc_coordinate_t origin = hb_mc_config_get_origin_vcore(hb_mc_manycore_get_config(mc));
+        const hb_mc_loader_write_t *writes;
+        size_t n;
+        int rc;
+
+        hb_mc_loader_plan_get_each(plan, &writes, &n);
+        for (size_t i = 0; i < n; i++) {
+                hb_mc_eva_t eva = writes[i].eva;
+                size_t off = 0;
+
+                while (off < writes[i].sz) {
+                        hb_mc_npa_t npa;
+                        size_t npa_sz;
+
+                        rc = hb_mc_eva_to_npa(mc, map, &origin, &eva, &npa, &npa_sz);
+                        if (rc != HB_MC_SUCCESS) {
+                                bsg_pr_err("%s: failed to translate EVA 0x%08" PRIx32 ": %s\n",
+                                           __func__, eva, hb_mc_strerror(rc));
+                                return rc;
+                        }
+
+                        /* only the EPA is kept, so it must be the tile's own memory */
+                        if (hb_mc_npa_get_x(&npa) != hb_mc_coordinate_get_x(origin)
+                            || hb_mc_npa_get_y(&npa) != hb_mc_coordinate_get_y(origin)) {
+                                bsg_pr_err("%s: EVA 0x%08" PRIx32 " is not in tile memory\n",
+                                           __func__, eva);
+                                return HB_MC_INVALID;
+                        }
+
+                        size_t sz = std::min(writes[i].sz - off, npa_sz);
+                        b->each.push_back({hb_mc_npa_get_epa(&npa), (uint32_t)sz,
+                                           hb_mc_load_image_builder_add_data(b, writes[i].data ?
+                                                                             &writes[i].data[off] : NULL,
+                                                                             sz)});
+                        off += sz;
+                        eva += sz;
+                }
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/* collects the symbols of a program image */
+static int hb_mc_load_image_collect_symbol(const char *name, hb_mc_eva_t eva, void *arg)
+{
+        auto *symbols = static_cast<std::vector<std::pair<std::string, hb_mc_eva_t>> *>(arg);
+        symbols->emplace_back(name, eva);
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Add the symbol table and the configuration symbols to a load image.
+ * @param[in]  b         A load image under construction
+ * @param[in]  program   A program image of a manycore binary
+ * @param[in]  cfg_syms  Names of the configuration symbols
+ * @param[in]  ncfg_syms The number of names in #cfg_syms
+ * @return HB_MC_SUCCESS if succesful. HB_MC_NOTFOUND if a configuration symbol is missing.
+ */
+static int hb_mc_load_image_lower_symbols(hb_mc_load_image_builder_t *b,
+                                          const hb_mc_program_image_t *program,
+                                          const char *const *cfg_syms,
+                                          size_t ncfg_syms)
+{
+        std::vector<std::pair<std::string, hb_mc_eva_t>> symbols;
+        int rc;
+
+        rc = hb_mc_program_image_foreach_symbol(program, hb_mc_load_image_collect_symbol, &symbols);
+        if (rc != HB_MC_SUCCESS)
+                return rc;
+
+        std::sort(symbols.begin(), symbols.end());
+        for (const auto &sym : symbols) {
+                b->syms.push_back({(uint32_t)b->strs.size(), sym.second});
+                b->strs.append(sym.first);
+                b->strs.push_back('\0');
+        }
+
+        /* configuration symbols share the names of the symbol table */
+        for (size_t i = 0; i < ncfg_syms; i++) {
+                auto it = std::lower_bound(symbols.begin(), symbols.end(),
+                                           std::make_pair(std::string(cfg_syms[i]), (hb_mc_eva_t)0));
+                if (it == symbols.end() || it->first != cfg_syms[i]) {
+                        bsg_pr_err("%s: binary has no symbol '%s'\n", __func__, cfg_syms[i]);
+                        return HB_MC_NOTFOUND;
+                }
+
+                b->cfg_syms.push_back(b->syms[it - symbols.begin()]);
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/* append a table to the image, returning its offset */
+static uint32_t hb_mc_load_image_append(std::vector<unsigned char> &out, const void *table, size_t bytes)
+{
+        uint32_t off = out.size();
+        const unsigned char *p = static_cast<const unsigned char *>(table);
+        out.insert(out.end(), p, p + bytes);
+        return off;
+}
+
+/**
+ * Write a load image to a file; the rename makes the file appear atomically.
+ * @param[in]  file_name  Path to write the load image to
+ * @param[in]  out        The load image
+ * @return HB_MC_SUCCESS if succesful. HB_MC_FAIL otherwise.
+ */
+static int hb_mc_load_image_store(const char *file_name, const std::vector<unsigned char> &out)
+{
+        char tmp[PATH_MAX];
+        FILE *f;
+        bool ok;
+
+        snprintf(tmp, sizeof(tmp), "%s.%ld", file_name, (long)getpid());
+        f = fopen(tmp, "wb");
+        if (!f) {
+                bsg_pr_err("%s: failed to open '%s': %m\n", __func__, tmp);
+                return HB_MC_FAIL;
+        }
+
+        ok = fwrite(out.data(), 1, out.size(), f) == out.size();
+        ok = (fclose(f) == 0) && ok;
+
+        if (!ok || rename(tmp, file_name) != 0) {
+                bsg_pr_err("%s: failed to write '%s': %m\n", __func__, file_name);
+                remove(tmp);
+                return HB_MC_FAIL;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Lower a program image into a load image for a machine.
+ * @param[in]  program        A program image of a manycore binary
+ * @param[in]  mc             A manycore instance whose configuration is the target machine
+ * @param[in]  map            An eva map for computing the eva to npa translation
+ * @param[in]  cfg_syms       Names of the symbols the runtime configures on every tile
+ * @param[in]  ncfg_syms      The number of names in #cfg_syms
+ * @param[in]  file_name      Path to write the load image to
+ * @return HB_MC_SUCCESS if succesful. HB_MC_NOTFOUND if a configuration symbol is missing.
+ * Otherwise an error code is returned.
+ */
+int hb_mc_load_image_lower(const hb_mc_program_image_t *program,
+                           hb_mc_manycore_t *mc,
+                           const hb_mc_eva_map_t *map,
+                           const char *const *cfg_syms,
+                           size_t ncfg_syms,
+                           const char *file_name)
+{
+        const hb_mc_config_t *cfg;
+        hb_mc_loader_plan_t *plan;
+        hb_mc_load_image_builder_t b;
+        const unsigned char *icache_data;
+        size_t icache_sz;
+        int rc;
+
+        if (!program || !mc || !map || !file_name || (ncfg_syms && !cfg_syms))
+                return HB_MC_INVALID;
+
+        if (hb_mc_program_image_get_load_image(program)) {
+                bsg_pr_err("%s: program is already a load image\n", __func__);
+                return HB_MC_INVALID;
+        }
+
+        rc = hb_mc_loader_plan_create(hb_mc_program_image_get_data(program),
+                                      hb_mc_program_image_get_size(program),
+                                      mc, &plan);
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to plan load: %s\n", __func__, hb_mc_strerror(rc));
+                return rc;
+        }
+
+        rc = hb_mc_load_image_lower_once(&b, mc, map, plan);
+        if (rc == HB_MC_SUCCESS)
+                rc = hb_mc_load_image_lower_each(&b, mc, map, plan);
+
+        hb_mc_loader_plan_get_icache(plan, &icache_data, &icache_sz);
+        uint32_t icache_off = hb_mc_load_image_builder_add_data(&b, icache_data, icache_sz);
+        hb_mc_loader_plan_destroy(plan);
+        if (rc != HB_MC_SUCCESS)
+                return rc;
+
+        rc = hb_mc_load_image_lower_symbols(&b, program, cfg_syms, ncfg_syms);
+        if (rc != HB_MC_SUCCESS)
+                return rc;
+
+        /* keep the payload word aligned */
+        b.strs.resize((b.strs.size() + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1), '\0');
+
+        uint64_t total = sizeof(hb_mc_load_image_header_t)
+                + b.once.size() * sizeof(b.once[0])
+                + b.each.size() * sizeof(b.each[0])
+                + (b.syms.size() + b.cfg_syms.size()) * sizeof(hb_mc_load_image_symbol_t)
+                + b.strs.size() + b.data.size();
+        if (total >= HB_MC_LOAD_IMAGE_ZEROS) {
+                bsg_pr_err("%s: load image would be too large (%" PRIu64 " bytes)\n",
+                           __func__, total);
+                return HB_MC_INVALID;
+        }
+
+        cfg = hb_mc_manycore_get_config(mc);
+        hb_mc_dimension_t dim = hb_mc_config_get_dimension_vcore(cfg);
+        hb_mc_dimension_t net = hb_mc_config_get_dimension_network(cfg);
+        hb_mc_load_image_header_t hdr = {};
+        hdr.magic               = HB_MC_LOAD_IMAGE_MAGIC;
+        hdr.version             = HB_MC_LOAD_IMAGE_VERSION;
+        hdr.size                = total;
+        hdr.basejump            = hb_mc_config_get_githash_basejump(cfg);
+        hdr.manycore            = hb_mc_config_get_githash_manycore(cfg);
+        hdr.f1                  = hb_mc_config_get_githash_f1(cfg);
+        hdr.dim_x               = hb_mc_dimension_get_x(dim);
+        hdr.dim_y               = hb_mc_dimension_get_y(dim);
+        hdr.vcore_base_x        = hb_mc_config_get_vcore_base_x(cfg);
+        hdr.vcore_base_y        = hb_mc_config_get_vcore_base_y(cfg);
+        hdr.net_x               = hb_mc_dimension_get_x(net);
+        hdr.net_y               = hb_mc_dimension_get_y(net);
+        hdr.dram_low_y          = hb_mc_config_get_dram_low_y(cfg);
+        hdr.dram_high_y         = hb_mc_config_get_dram_high_y(cfg);
+        hdr.vcache_ways         = hb_mc_config_get_vcache_ways(cfg);
+        hdr.vcache_sets         = hb_mc_config_get_vcache_sets(cfg);
+        hdr.vcache_block_words  = hb_mc_config_get_vcache_block_words(cfg);
+        hdr.vcache_stripe_words = hb_mc_config_get_vcache_stripe_words(cfg);
+        hdr.dram_channels       = hb_mc_config_get_dram_channels(cfg);
+        hdr.dram_bank_size      = hb_mc_config_get_dram_bank_size(cfg);
+        hdr.dram_enabled        = hb_mc_manycore_dram_is_enabled(mc) ? 1 : 0;
+        hdr.icache_off          = icache_off;
+        hdr.icache_sz           = icache_sz;
+
+        std::vector<unsigned char> out(sizeof(hdr));
+        out.reserve(total);
+        hdr.once_n      = b.once.size();
+        hdr.once_off    = hb_mc_load_image_append(out, b.once.data(), b.once.size() * sizeof(b.once[0]));
+        hdr.each_n      = b.each.size();
+        hdr.each_off    = hb_mc_load_image_append(out, b.each.data(), b.each.size() * sizeof(b.each[0]));
+        hdr.sym_n       = b.syms.size();
+        hdr.sym_off     = hb_mc_load_image_append(out, b.syms.data(), b.syms.size() * sizeof(b.syms[0]));
+        hdr.cfg_sym_n   = b.cfg_syms.size();
+        hdr.cfg_sym_off = hb_mc_load_image_append(out, b.cfg_syms.data(),
+                                                  b.cfg_syms.size() * sizeof(b.cfg_syms[0]));
+        hdr.str_sz      = b.strs.size();
+        hdr.str_off     = hb_mc_load_image_append(out, b.strs.data(), b.strs.size());
+        hdr.data_sz     = b.data.size();
+        hdr.data_off    = hb_mc_load_image_append(out, b.data.data(), b.data.size());
+        memcpy(out.data(), &hdr, sizeof(hdr));
+
+        bsg_pr_dbg("%s: lowered %zu DRAM writes, %zu DMEM writes and %zu symbols (%zu bytes)\n",
+                   __func__, b.once.size(), b.each.size(), b.syms.size(), out.size());
+
+        return hb_mc_load_image_store(file_name, out);
+}
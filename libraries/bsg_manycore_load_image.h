@@ -0,0 +1,263 @@
+// Copyright (c) 2019, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef BSG_MANYCORE_LOAD_IMAGE_H
+#define BSG_MANYCORE_LOAD_IMAGE_H
+
+#include <bsg_manycore_features.h>
+#include <bsg_manycore.h>
+#include <bsg_manycore_eva.h>
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_program_image.h>
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+/*
+ * Load images
+ *
+ * A load image is a manycore binary lowered for one machine
+ * configuration. DRAM segments are already translated to NPAs, DMEM
+ * segments to tile EPAs, and the symbol table is sorted by name, so
+ * loading an image and looking up its symbols parse nothing.
+ *
+ * The image records the parts of the configuration that lowering
+ * depends on, and is rejected by any other machine. Images are written
+ * in host byte order.
+ *
+ * A load image is a header followed by its tables and payload:
+ *
+ *   hb_mc_load_image_header_t
+ *   hb_mc_load_image_npa_write_t[once_n]    DRAM writes, loaded once
+ *   hb_mc_load_image_epa_write_t[each_n]    DMEM writes, loaded on every tile
+ *   hb_mc_load_image_symbol_t[sym_n]        symbols, sorted by name
+ *   hb_mc_load_image_symbol_t[cfg_sym_n]    configuration symbols, in the order given when lowering
+ *   char[str_sz]                            symbol names
+ *   unsigned char[data_sz]                  segment data and the ICACHE contents
+ */
+
+#define HB_MC_LOAD_IMAGE_MAGIC   0x494c4248 /* "HBLI" */
+#define HB_MC_LOAD_IMAGE_VERSION 2
+
+/* data_off of a write that fills with zeros */
+#define HB_MC_LOAD_IMAGE_ZEROS   0xFFFFFFFF
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+        typedef struct hb_mc_load_image_header {
+                uint32_t magic;                 //!< HB_MC_LOAD_IMAGE_MAGIC
+                uint32_t version;               //!< HB_MC_LOAD_IMAGE_VERSION
+                uint32_t size;                  //!< bytes in the image, including this header
+                /* the machine the image was lowered for */
+                hb_mc_githash_t basejump;
+                hb_mc_githash_t manycore;
+                hb_mc_githash_t f1;
+                uint32_t dim_x;                 //!< vcore dimensions
+                uint32_t dim_y;
+                uint32_t vcore_base_x;          //!< coordinate of the first vcore
+                uint32_t vcore_base_y;
+                uint32_t net_x;                 //!< network dimensions
+                uint32_t net_y;
+                uint32_t dram_low_y;            //!< rows of the DRAM banks
+                uint32_t dram_high_y;
+                uint32_t vcache_ways;
+                uint32_t vcache_sets;
+                uint32_t vcache_block_words;
+                uint32_t vcache_stripe_words;
+                uint32_t dram_channels;
+                uint32_t dram_bank_size;
+                uint32_t dram_enabled;
+                /* tables, as offsets from the start of the image */
+                uint32_t once_off, once_n;
+                uint32_t each_off, each_n;
+                uint32_t sym_off, sym_n;
+                uint32_t cfg_sym_off, cfg_sym_n;
+                uint32_t str_off, str_sz;
+                uint32_t data_off, data_sz;
+                uint32_t icache_off, icache_sz; //!< ICACHE contents, as an offset into the data
+        } hb_mc_load_image_header_t;
+
+        /* A write to DRAM */
+        typedef struct hb_mc_load_image_npa_write {
+                uint32_t x;             //!< X coordinate of the DRAM bank
+                uint32_t y;             //!< Y coordinate of the DRAM bank
+                uint32_t epa;           //!< first byte written
+                uint32_t sz;            //!< number of bytes
+                uint32_t data_off;      //!< offset into the data, or HB_MC_LOAD_IMAGE_ZEROS
+        } hb_mc_load_image_npa_write_t;
+
+        /* A write to the DMEM of every tile */
+        typedef struct hb_mc_load_image_epa_write {
+                uint32_t epa;           //!< first byte written
+                uint32_t sz;            //!< number of bytes
+                uint32_t data_off;      //!< offset into the data, or HB_MC_LOAD_IMAGE_ZEROS
+        } hb_mc_load_image_epa_write_t;
+
+        typedef struct hb_mc_load_image_symbol {
+                uint32_t name_off;      //!< offset of the name in the string table
+                hb_mc_eva_t eva;
+        } hb_mc_load_image_symbol_t;
+
+        typedef struct hb_mc_load_image hb_mc_load_image_t;
+
+        /**
+         * Lower a program image into a load image for a machine.
+         * @param[in]  program        A program image of a manycore binary
+         * @param[in]  mc             A manycore instance whose configuration is the target machine
+         * @param[in]  map            An eva map for computing the eva to npa translation
+         * @param[in]  cfg_syms       Names of the symbols the runtime configures on every tile
+         * @param[in]  ncfg_syms      The number of names in #cfg_syms
+         * @param[in]  file_name      Path to write the load image to
+         * @return HB_MC_SUCCESS if succesful. HB_MC_NOTFOUND if a configuration symbol is missing.
+         * Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * #mc needs only its configuration and DRAM mode set, so images can
+         * be lowered without a device. The file is replaced atomically.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_load_image_lower(const hb_mc_program_image_t *program,
+                                   hb_mc_manycore_t *mc,
+                                   const hb_mc_eva_map_t *map,
+                                   const char *const *cfg_syms,
+                                   size_t ncfg_syms,
+                                   const char *file_name);
+
+        /**
+         * Check if a buffer holds a load image rather than a manycore binary.
+         * @param[in]  data   A buffer
+         * @param[in]  sz     Size of #data in bytes
+         * @return One if #data starts with a load image header - Zero otherwise.
+         */
+        int hb_mc_load_image_is_load_image(const void *data, size_t sz);
+
+        /**
+         * Validate a load image in memory.
+         * @param[in]  data   A buffer holding a load image; it must outlive #image
+         * @param[in]  sz     Size of #data in bytes
+         * @param[out] image  Set to the image; free it with hb_mc_load_image_destroy()
+         * @return HB_MC_SUCCESS if succesful. HB_MC_INVALID if #data is not a valid load image.
+         * Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * Checks that every table and write lies within the image. The image
+         * is not copied.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_load_image_init(const void *data, size_t sz, hb_mc_load_image_t **image);
+
+        /**
+         * Free a load image created with hb_mc_load_image_init().
+         * @param[in]  image  A load image
+         */
+        void hb_mc_load_image_destroy(hb_mc_load_image_t *image);
+
+        /**
+         * Check that a load image was lowered for a machine.
+         * @param[in]  image  A load image
+         * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+         * @return HB_MC_SUCCESS if #image can be loaded onto #mc. HB_MC_INVALID otherwise.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_load_image_check_machine(const hb_mc_load_image_t *image,
+                                           const hb_mc_manycore_t *mc);
+
+        /**
+         * Get the DRAM writes of a load image.
+         * @param[in]  image  A load image
+         * @param[out] writes Set to the writes
+         * @param[out] n      Set to the number of writes
+         */
+        void hb_mc_load_image_get_once(const hb_mc_load_image_t *image,
+                                       const hb_mc_load_image_npa_write_t **writes,
+                                       size_t *n);
+
+        /**
+         * Get the DMEM writes of a load image.
+         * @param[in]  image  A load image
+         * @param[out] writes Set to the writes
+         * @param[out] n      Set to the number of writes
+         */
+        void hb_mc_load_image_get_each(const hb_mc_load_image_t *image,
+                                       const hb_mc_load_image_epa_write_t **writes,
+                                       size_t *n);
+
+        /**
+         * Get the ICACHE contents of a load image.
+         * @param[in]  image  A load image
+         * @param[out] data   Set to the ICACHE contents
+         * @param[out] sz     Set to the number of bytes in #data
+         */
+        void hb_mc_load_image_get_icache(const hb_mc_load_image_t *image,
+                                         const unsigned char **data,
+                                         size_t *sz);
+
+        /**
+         * Get the data of a write.
+         * @param[in]  image    A load image
+         * @param[in]  data_off The data_off of a write
+         * @return the data, or NULL if the write fills with zeros
+         */
+        const unsigned char *hb_mc_load_image_get_data(const hb_mc_load_image_t *image,
+                                                       uint32_t data_off);
+
+        /**
+         * Get an EVA for a symbol of a load image.
+         * @param[in]  image   A load image
+         * @param[in]  symbol  A program symbol
+         * @param[out] eva     An EVA that addresses #symbol
+         * @return HB_MC_SUCCESS if succesful. HB_MC_NOTFOUND if the image has no such symbol.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_load_image_symbol_to_eva(const hb_mc_load_image_t *image,
+                                           const char *symbol,
+                                           hb_mc_eva_t *eva);
+
+        /**
+         * Get the EVAs of the configuration symbols of a load image.
+         * @param[in]  image     A load image
+         * @param[in]  cfg_syms  Names of the configuration symbols, as given when lowering
+         * @param[in]  ncfg_syms The number of names in #cfg_syms
+         * @param[out] evas      Set to the EVA of each symbol in #cfg_syms
+         * @return HB_MC_SUCCESS if succesful. HB_MC_NOTFOUND if the image was lowered
+         * with different configuration symbols.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_load_image_get_cfg_symbols(const hb_mc_load_image_t *image,
+                                             const char *const *cfg_syms,
+                                             size_t ncfg_syms,
+                                             hb_mc_eva_t *evas);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
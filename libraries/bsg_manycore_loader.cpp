@@ -56,6 +56,10 @@
 #include <stdbool.h>
 #endif
 
+#include <algorithm>
+#include <new>
+#include <vector>
+
 static size_t min_size_t(size_t x, size_t y)
 {
         return x < y ? x : y;
@@ -116,15 +120,11 @@ static Elf32_Versym RV32_Versym_to_host(Elf32_Versym versym)
 /**
  * Get the max memory capacity of a program segment (these map to hardware).
  * @param[in] mc       A manycore instance.
- * @param[in] id       An EVA id.
  * @param[in] phdr     A program header for the segment.
- * @param[in] tile     A manycore coordinate.
  * @return the max size for #segment.
  */
-static size_t hb_mc_loader_get_tile_segment_capacity(hb_mc_manycore_t *mc,
-                                                     const hb_mc_eva_map_t *id,
-                                                     const Elf32_Phdr *phdr,
-                                                     hb_mc_coordinate_t tile)
+static size_t hb_mc_loader_get_segment_capacity(hb_mc_manycore_t *mc,
+                                                const Elf32_Phdr *phdr)
 {
         /*
           The right thing to do here would be to get the hardware component
@@ -141,7 +141,8 @@ static size_t hb_mc_loader_get_tile_segment_capacity(hb_mc_manycore_t *mc,
         if (RV32_Addr_to_host(phdr->p_paddr) & (1<<31)) {
                 return hb_mc_manycore_get_size_dram(mc);
         } else {
-                return hb_mc_tile_get_size_dmem(mc, &tile);
+                /* every tile has the same DMEM */
+                return hb_mc_config_get_dmem_size(hb_mc_manycore_get_config(mc));
         }
 }
 
@@ -162,258 +163,6 @@ static const char *hb_mc_loader_segment_to_string(const Elf32_Phdr *phdr,
         return buffer;
 }
 
-/**
- * Writes program data to an EVA.
- * @param[in] phdr       The program header for this data (for debugging).
- * @param[in] data       Data to be written out.
- * @param[in] start_eva  The start EVA.
- * @param[in] mc         A manycore instance.
- * @param[in] map        And EVA to NPA map
- * @param[in] tile       A manycore coordinate.
- * @return HB_MC_SUCCESS if succesful. Otherwise and error code is returned.
- */
-static int hb_mc_loader_eva_write(const Elf32_Phdr *phdr,
-                                  const unsigned char *data, size_t sz,
-                                  hb_mc_eva_t start_eva,
-                                  hb_mc_manycore_t *mc,
-                                  const hb_mc_eva_map_t *map,
-                                  hb_mc_coordinate_t tile)
-{
-        hb_mc_eva_t eva = start_eva;
-        size_t off = 0, rem = sz;
-        int rc;
-        char segname[64];
-
-        hb_mc_loader_segment_to_string(phdr, segname, sizeof(segname));
-
-        rc = hb_mc_manycore_eva_write(mc, map, &tile, &start_eva, data, sz);
-        if (rc != HB_MC_SUCCESS) {
-                bsg_pr_err("%s: failed to write %s for tile (%d, %d)"
-                           ": %s\n",
-                           __func__,
-                           segname,
-                           hb_mc_coordinate_get_x(tile),
-                           hb_mc_coordinate_get_y(tile),
-                           hb_mc_strerror(rc));
-                return rc;
-        }
-
-        return HB_MC_SUCCESS;
-}
-
-/**
- * Writes program data to an EVA.
- * @param[in] phdr       The program header for this data (for debugging).
- * @param[in] val        The value to be written
- * @param[in] start_eva  The start EVA.
- * @param[in] mc         A manycore instance.
- * @param[in] map        And EVA to NPA map
- * @param[in] tile       A manycore coordinate.
- * @return HB_MC_SUCCESS if succesful. Otherwise and error code is returned.
- */
-static int hb_mc_loader_eva_memset(const Elf32_Phdr *phdr,
-                                   uint8_t val, size_t sz,
-                                   hb_mc_eva_t start_eva,
-                                   hb_mc_manycore_t *mc,
-                                   const hb_mc_eva_map_t *map,
-                                   hb_mc_coordinate_t tile)
-{
-        hb_mc_eva_t eva = start_eva;
-        size_t off = 0, rem = sz;
-        int rc;
-        char segname[64];
-
-        hb_mc_loader_segment_to_string(phdr, segname, sizeof(segname));
-
-        rc = hb_mc_manycore_eva_memset(mc, map, &tile, &start_eva, val, sz);
-        if (rc != HB_MC_SUCCESS) {
-                bsg_pr_err("%s: failed to memset %s @ eva 0x%08x for tile (%d, %d)"
-                           ": %s\n",
-                           __func__,
-                           segname,
-                           eva,
-                           hb_mc_coordinate_get_x(tile),
-                           hb_mc_coordinate_get_y(tile),
-                           hb_mc_strerror(rc));
-                return rc;
-        }
-
-        return HB_MC_SUCCESS;
-}
-
-/**
- * Load a program segment.
- * @param[in] mc       A manycore instance.
- * @param[in] map      A EVA to NPA map.
- * @param[in] phdr     A program header for the data to be loaded.
- * @param[in] segdata  Program data to be loaded.
- * @param[in] tile     A manycore coordinate.
- * @return HB_MC_SUCCESS if successful. Otherwise an error code is returned.
- */
-static int hb_mc_loader_load_tile_segment(hb_mc_manycore_t *mc,
-                                          const hb_mc_eva_map_t *map,
-                                          const Elf32_Phdr *phdr,
-                                          const unsigned char *segdata,
-                                          hb_mc_coordinate_t tile)
-{
-        int rc;
-        size_t cap, seg_sz;
-        char segname[64];
-
-        hb_mc_loader_segment_to_string(phdr, segname, sizeof(segname));
-
-        /* get hardware capacity of the segment */
-        cap = hb_mc_loader_get_tile_segment_capacity(mc, map, phdr, tile);
-        seg_sz = RV32_Word_to_host(phdr->p_memsz);
-
-        bsg_pr_dbg("%s: writing program data: %s\n", __func__, segname);
-
-        /* return error if the hardware lacks the capacity */
-        if (cap < seg_sz) {
-                bsg_pr_err("%s: '%s' (%zu bytes) exceeds "
-                           "maximum (%zu bytes)\n",
-                           __func__,
-                           segname,
-                           seg_sz,
-                           cap);
-                return HB_MC_FAIL;
-        }
-
-        /* load initialized data */
-        hb_mc_eva_t eva = RV32_Addr_to_host(phdr->p_paddr); /* get the load eva */
-        size_t file_sz = RV32_Word_to_host(phdr->p_filesz); /* get the size of segdata */
-
-        rc = hb_mc_loader_eva_write(phdr, segdata, file_sz, eva, mc, map, tile);
-        if (rc != HB_MC_SUCCESS) {
-                bsg_pr_dbg("%s: write: failed to load segment %s: %s\n",
-                           __func__,
-                           segname,
-                           hb_mc_strerror(rc));
-                return rc;
-        }
-
-        /* load zeroed data */
-        size_t zeros_sz  = seg_sz - file_sz;  // zeros are the remainder of the segment
-        eva += file_sz; // increment eva by number of initialized bytes written
-
-        rc = hb_mc_loader_eva_memset(phdr, 0, zeros_sz, eva, mc, map, tile);
-        if (rc != HB_MC_SUCCESS) {
-                bsg_pr_dbg("%s: memset: failed to load segment %s: %s\n",
-                           __func__,
-                           segname,
-                           hb_mc_strerror(rc));
-                return rc;
-        }
-
-        return HB_MC_SUCCESS;
-}
-
-/**
- * Load a program segment.
- * @param[in] mc       A manycore instance.
- * @param[in] map      A EVA to NPA map.
- * @param[in] phdr     A program header for the data to be loaded.
- * @param[in] segdata  Program data to be loaded.
- * @param[in] tile     A manycore coordinate.
- * @return HB_MC_SUCCESS if successful. Otherwise an error code is returned.
- */
-static int hb_mc_loader_load_tiles_segment(hb_mc_manycore_t *mc,
-                                           const hb_mc_eva_map_t *map,
-                                           const Elf32_Phdr *phdr,
-                                           const unsigned char *segdata,
-                                           const hb_mc_coordinate_t *tiles,
-                                           uint32_t ntiles)
-{
-        int rc;
-
-        for (uint32_t i = 0; i < ntiles; i++) {
-                rc = hb_mc_loader_load_tile_segment(mc, map, phdr, segdata, tiles[i]);
-                if (rc != HB_MC_SUCCESS)
-                        return rc;
-        }
-        return HB_MC_SUCCESS;
-}
-
-/**
- * Load a tile's ICACHE.
- * @param[in] mc       A manycore instance.
- * @param[in] phdr     The program header to be loaded.
- * @param[in] segdata  The program data to be loaded.
- * @param[in] tile     A tile whose ICACHE needs to be initialized.
- * @return HB_MC_SUCCESS if succseful. Otherwise an error code is returned.
- */
-static int hb_mc_loader_load_tile_icache(hb_mc_manycore_t *mc,
-                                         const hb_mc_eva_map_t *map,
-                                         const Elf32_Phdr *phdr,
-                                         const unsigned char *segdata,
-                                         hb_mc_coordinate_t tile)
-{
-        int rc;
-
-        /* get the NPA of this tiles ICACHE */
-        hb_mc_npa_t icache_npa = hb_mc_npa(tile, HB_MC_TILE_EPA_ICACHE);
-
-        /* write min(icache size, segment size) bytes */
-        size_t sz = min_size_t(RV32_Word_to_host(phdr->p_filesz),
-                               hb_mc_tile_get_size_icache(mc, &tile));
-
-        bsg_pr_dbg("%s: writing %zu bytes to (%d,%d)'s icache @ EPA 0x%08" PRIx32 "\n",
-                   __func__, sz,
-                   hb_mc_coordinate_get_x(tile),
-                   hb_mc_coordinate_get_y(tile),
-                   hb_mc_npa_get_epa(&icache_npa)
-                   );
-
-        /*
-          The address space of the ICACHE is larger than the ICACHE itself.
-          Bits 12-23 actually indicate the tag data rather than a location.
-          Only bits 0-11 actually index the memory in the ICACHE.
-          It's important that bits 10-21 are zero.
-        */
-        if (((hb_mc_npa_get_epa(&icache_npa)) + sz - 1) & 0x00FFF000) {
-                bsg_pr_dbg("%s: Oops: ICACHE EPA 0x%08" PRIx32 " sets tag bits\n",
-                           __func__, hb_mc_npa_get_epa(&icache_npa));
-                return HB_MC_FAIL;
-        }
-
-        rc = hb_mc_manycore_write_mem(mc, &icache_npa, segdata, sz);
-        if (rc != HB_MC_SUCCESS) {
-                bsg_pr_dbg("%s: failed to write to (%d,%d)'s icache: %s\n",
-                           __func__,
-                           hb_mc_coordinate_get_x(tile),
-                           hb_mc_coordinate_get_y(tile),
-                           hb_mc_strerror(rc));
-                return rc;
-        }
-
-        return HB_MC_SUCCESS;
-}
-
-/**
- * Load tiles' ICACHE.
- * @param[in] mc       A manycore instance.
- * @param[in] phdr     The program header to be loaded.
- * @param[in] segdata  The program data to be loaded.
- * @param[in] tiles    Tiles whose ICACHE needs to be initialized.
- * @param[in] ntiles   Number of tiles.
- * @return HB_MC_SUCCESS if succseful. Otherwise an error code is returned.
- */
-static int hb_mc_loader_load_tiles_icache(hb_mc_manycore_t *mc,
-                                          const hb_mc_eva_map_t *map,
-                                          const Elf32_Phdr *phdr,
-                                          const unsigned char *segdata,
-                                          const hb_mc_coordinate_t *tiles,
-                                          uint32_t ntiles)
-{       int rc;
-
-        for (uint32_t i = 0; i < ntiles; i++) {
-                rc = hb_mc_loader_load_tile_icache(mc, map, phdr, segdata, tiles[i]);
-                if (rc != HB_MC_SUCCESS)
-                        return rc;
-        }
-        return HB_MC_SUCCESS;
-}
-
 /**
  * Validate that a buffer contains a valid ELF format
  * @param[in]  bin    A memory buffer containing a valid manycore binary
@@ -477,21 +226,15 @@ static int hb_mc_loader_elf_validate(const void *elf, size_t sz)
 }
 
 
+
 /**
  * Check is a segment should not be loaded.
- * This generally pertains to the program data the .data section (goes to DMEM).
  * @param[in] mc      A manycore instance.
  * @param[in] phdr    A program header.
- * @param[in] map     An EVA<->NPA map.
- * @param[in] tiles   Tiles being loaded.
- * @param[in] ntiles  Number of tiles being loaded.
- * @return true if the segment should only be loaded once.
+ * @return true if the segment should not be loaded.
  */
 static bool hb_mc_loader_segment_is_load_never(hb_mc_manycore *mc,
-                                               const Elf32_Phdr *phdr,
-                                               const hb_mc_eva_map_t *map,
-                                               const hb_mc_coordinate_t *tiles,
-                                               uint32_t ntiles)
+                                               const Elf32_Phdr *phdr)
 {
         switch (RV32_Word_to_host(phdr->p_type)) {
         case PT_LOAD:
@@ -506,16 +249,10 @@ static bool hb_mc_loader_segment_is_load_never(hb_mc_manycore *mc,
  * This generally pertains to the program data containing .text and .dram (goes to DRAM).
  * @param[in] mc      A manycore instance.
  * @param[in] phdr    A program header.
- * @param[in] map     An EVA<->NPA map.
- * @param[in] tiles   Tiles being loaded.
- * @param[in] ntiles  Number of tiles being loaded.
  * @return true if the segment should only be loaded once.
  */
 static bool hb_mc_loader_segment_is_load_once(hb_mc_manycore *mc,
-                                              const Elf32_Phdr *phdr,
-                                              const hb_mc_eva_map_t *map,
-                                              const hb_mc_coordinate_t *tiles,
-                                              uint32_t ntiles)
+                                              const Elf32_Phdr *phdr)
 {
         /* the correct thing to do is get the NPA and check if it maps to DRAM */
         /* but there's no function at the moment that maps NPAs to
@@ -529,16 +266,10 @@ static bool hb_mc_loader_segment_is_load_once(hb_mc_manycore *mc,
  * Check is a segment should be written ICACHE.
  * @param[in] mc      A manycore instance.
  * @param[in] phdr    A program header.
- * @param[in] map     An EVA<->NPA map.
- * @param[in] tiles   Tiles being loaded.
- * @param[in] ntiles  Number of tiles being loaded.
  * @return true if the segment is should be loaded ICACHE.
  */
 static bool hb_mc_loader_segment_is_load_icache(hb_mc_manycore *mc,
-                                                const Elf32_Phdr *phdr,
-                                                const hb_mc_eva_map_t *map,
-                                                const hb_mc_coordinate_t *tiles,
-                                                uint32_t ntiles)
+                                                const Elf32_Phdr *phdr)
 {
         Elf32_Word type, flags;
 
@@ -604,25 +335,97 @@ static int hb_mc_loader_get_segment(const void *bin, size_t sz, unsigned segidx,
 }
 
 /**
- * Load program segments onto tiles.
- * @param[in] bin     A binary object to load onto the tiles.
- * @param[in] sz      The size of the binary object.
+ * Perform register setup for a list of tiles.
+ * @param[in] mc         A manycore instance.
+ * @param[in] map        An EVA<->NPA map.
+ * @param[in] tiles      The list of tiles being loaded, with the origin at 0.
+ * @param[in] ntiles     Number of tiles being loaded.
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+static int hb_mc_loader_tiles_set_registers(hb_mc_manycore_t *mc,
+                                            const hb_mc_eva_map_t *map,
+                                            const hb_mc_coordinate_t *tiles,
+                                            uint32_t ntiles)
+{
+        int rc;
+
+        // freeze, then set the origin tile (we assume 0 is the origin) and DRAM enabled
+        hb_mc_tile_csr_write_t writes [] = {
+                { HB_MC_TILE_EPA_CSR_FREEZE, HB_MC_CSR_FREEZE },
+                { HB_MC_TILE_EPA_CSR_TILE_GROUP_ORIGIN_X, hb_mc_coordinate_get_x(tiles[0]) },
+                { HB_MC_TILE_EPA_CSR_TILE_GROUP_ORIGIN_Y, hb_mc_coordinate_get_y(tiles[0]) },
+                { HB_MC_TILE_EPA_CSR_DRAM_ENABLE, hb_mc_manycore_dram_is_enabled(mc) ? 1u : 0u },
+        };
+
+        rc = hb_mc_tiles_write_csrs(mc, tiles, ntiles, writes,
+                                    sizeof(writes)/sizeof(writes[0]));
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_dbg("%s: failed to write tile registers: %s\n",
+                           __func__, hb_mc_strerror(rc));
+                return rc;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Validate all victim cache tags.
  * @param[in] mc      A manycore instance.
  * @param[in] map     An EVA<->NPA map.
- * @param[in] tiles   Tiles to load.
- * @param[in] ntiles  The number of tiles to load.
- * @return HB_MC_SUCCESS if succseful. Otherwise an error code is returned.
+ * @param[in] tiles   The list of tiles to initialize.
+ * @param[in] ntiles  The number of tiles to initialize.
+ * @return HB_MC_SUCCESS if an error occured. Otherwise an error code is returned.
+ */
+static int hb_mc_loader_columns_validate_victim_cache(hb_mc_manycore_t *mc,
+                                                      const hb_mc_eva_map_t *map)
+{
+        return hb_mc_manycore_validate_vcache(mc);
+}
+
+struct hb_mc_loader_plan {
+        std::vector<hb_mc_loader_write_t> once; //!< writes to memory shared by all tiles (DRAM)
+        std::vector<hb_mc_loader_write_t> each; //!< writes to every tile's own memory (DMEM)
+        const unsigned char *icache_data;       //!< program text copied to every tile's ICACHE
+        size_t icache_sz;                       //!< bytes of #icache_data to copy
+        std::vector<uint32_t> zeros;            //!< source for the zero fills in #each
+};
+
+/* bytes sent to one tile before moving on to the next */
+#define HB_MC_LOADER_STREAM_CHUNK 256
+
+/**
+ * Plan how to load a binary object: where each segment goes and how
+ * much of it is zero-filled, which segments are loaded once and which
+ * once per tile, and what goes to the ICACHE.
+ * @param[in]  bin    A memory buffer containing a valid manycore binary
+ * @param[in]  sz     Size of #bin in bytes
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[out] oplan  Set to the load plan
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
  */
-static int hb_mc_loader_load_segments(const void *bin, size_t sz,
-                                      hb_mc_manycore_t *mc, const hb_mc_eva_map_t *map,
-                                      const hb_mc_coordinate_t *tiles, uint32_t ntiles)
+int hb_mc_loader_plan_create(const void *bin, size_t sz, hb_mc_manycore_t *mc,
+                             hb_mc_loader_plan_t **oplan)
 {
         const Elf32_Ehdr *ehdr = (const Elf32_Ehdr *)bin;
-        int rc, icache_segidx;
+        const Elf32_Phdr *icache_phdr = NULL;
+        const unsigned char *icache_data = NULL;
+        size_t zeros_sz = 0;
+        char segname[64];
+        int rc;
 
-        /////////////////////////////////////
-        // Load all segments to their EVAs //
-        /////////////////////////////////////
+        if (!oplan)
+                return HB_MC_INVALID;
+
+        // Validate ELF File
+        rc = hb_mc_loader_elf_validate(bin, sz);
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_dbg("%s: failed to validate binary\n", __func__);
+                return rc;
+        }
+
+        hb_mc_loader_plan_t *plan = new (std::nothrow) hb_mc_loader_plan_t();
+        if (!plan)
+                return HB_MC_NOMEM;
 
         /* for each program header */
         for (int segidx = 0; segidx < RV32_Half_to_host(ehdr->e_phnum); segidx++) {
@@ -632,174 +435,385 @@ static int hb_mc_loader_load_segments(const void *bin, size_t sz,
                 rc = hb_mc_loader_get_segment(bin, sz, segidx, &phdr, &segdata);
                 if (rc != HB_MC_SUCCESS) {
                         bsg_pr_dbg("%s: failed to get segment %d\n", __func__, segidx);
-                        return rc;
+                        goto fail;
                 }
 
-                /* check if program header should be loaded never, once, or for each tile */
-                if (hb_mc_loader_segment_is_load_never(mc, phdr, map, tiles, ntiles)) {
-                        // this segment should not be loaded
+                if (hb_mc_loader_segment_is_load_never(mc, phdr))
                         continue;
-                } else if (hb_mc_loader_segment_is_load_once(mc, phdr, map, tiles, ntiles)) {
-                        // this segment should be loaded only once (e.g. DRAM = .text + .dram)
-                        rc = hb_mc_loader_load_tile_segment(mc, map, phdr, segdata, tiles[0]);
-                        if (rc != HB_MC_SUCCESS) {
-                                return rc;
-                        }
-                } else { // this segment should be loaded once for each tile (e.g. DMEM = .data)
-                        rc = hb_mc_loader_load_tiles_segment(mc, map, phdr, segdata,
-                                                             tiles, ntiles);
-                        if (rc != HB_MC_SUCCESS)
-                                return rc;
+
+                hb_mc_loader_segment_to_string(phdr, segname, sizeof(segname));
+
+                size_t cap = hb_mc_loader_get_segment_capacity(mc, phdr);
+                size_t seg_sz = RV32_Word_to_host(phdr->p_memsz);
+                size_t file_sz = RV32_Word_to_host(phdr->p_filesz);
+                hb_mc_eva_t eva = RV32_Addr_to_host(phdr->p_paddr);
+
+                /* return error if the hardware lacks the capacity */
+                if (cap < seg_sz) {
+                        bsg_pr_err("%s: '%s' (%zu bytes) exceeds "
+                                   "maximum (%zu bytes)\n",
+                                   __func__, segname, seg_sz, cap);
+                        rc = HB_MC_FAIL;
+                        goto fail;
+                }
+
+                if (seg_sz < file_sz) {
+                        bsg_pr_dbg("%s: '%s' has more data (%zu bytes) than it occupies\n",
+                                   __func__, segname, file_sz);
+                        rc = HB_MC_INVALID;
+                        goto fail;
+                }
+
+                /*
+                  Segments in DRAM (e.g. .text + .dram) are loaded once;
+                  segments in DMEM (e.g. .data) are loaded once for each tile.
+                  Zeros are the remainder of the segment.
+                */
+                bool once = hb_mc_loader_segment_is_load_once(mc, phdr);
+                std::vector<hb_mc_loader_write_t> &writes = once ? plan->once : plan->each;
+
+                if (file_sz > 0)
+                        writes.push_back({eva, segdata, file_sz});
+
+                if (seg_sz > file_sz) {
+                        writes.push_back({eva + (hb_mc_eva_t)file_sz, NULL, seg_sz - file_sz});
+                        if (!once)
+                                zeros_sz = std::max(zeros_sz, seg_sz - file_sz);
                 }
 
+                bsg_pr_dbg("%s: planned %s: load %s\n", __func__, segname,
+                           once ? "once" : "for each tile");
+
                 /*
                   The first 1K words of program text needs to be written to icache
                   as well as once to DRAM.
-
-                  So when we find the segment with program text in it, we save it
-                  for further loading.
                 */
-                if (hb_mc_loader_segment_is_load_icache(mc, phdr, map, tiles, ntiles))
-                        icache_segidx = segidx;
+                if (hb_mc_loader_segment_is_load_icache(mc, phdr)) {
+                        icache_phdr = phdr;
+                        icache_data = segdata;
+                }
         }
 
-        const Elf32_Phdr *icache_phdr;
-        const unsigned char *icache_data;
+        if (!icache_phdr) {
+                bsg_pr_dbg("%s: binary has no program text\n", __func__);
+                rc = HB_MC_INVALID;
+                goto fail;
+        }
 
-        rc = hb_mc_loader_get_segment(bin, sz, icache_segidx, &icache_phdr, &icache_data);
-        if (rc != HB_MC_SUCCESS) {
-                bsg_pr_dbg("%s: while fetching ICACHE segment (segidx = %d): %s\n",
-                           __func__, icache_segidx, hb_mc_strerror(icache_segidx));
-                return rc;
+        /* write min(icache size, segment size) bytes */
+        plan->icache_data = icache_data;
+        plan->icache_sz = min_size_t(RV32_Word_to_host(icache_phdr->p_filesz),
+                                     hb_mc_config_get_icache_size(hb_mc_manycore_get_config(mc)));
+
+        /*
+          The address space of the ICACHE is larger than the ICACHE itself.
+          Bits 12-23 actually indicate the tag data rather than a location.
+          Only bits 0-11 actually index the memory in the ICACHE.
+          It's important that bits 10-21 are zero.
+        */
+        if ((HB_MC_TILE_EPA_ICACHE + plan->icache_sz - 1) & 0x00FFF000) {
+                bsg_pr_dbg("%s: Oops: ICACHE EPA 0x%08" PRIx32 " sets tag bits\n",
+                           __func__, (uint32_t)HB_MC_TILE_EPA_ICACHE);
+                rc = HB_MC_FAIL;
+                goto fail;
         }
 
-        /* init icache */
-        rc = hb_mc_loader_load_tiles_icache(mc, map, icache_phdr, icache_data, tiles, ntiles);
-        if (rc != HB_MC_SUCCESS)
-                return rc;
+        plan->zeros.assign((zeros_sz + sizeof(uint32_t) - 1) / sizeof(uint32_t), 0);
 
+        *oplan = plan;
         return HB_MC_SUCCESS;
+
+fail:
+        delete plan;
+        return rc;
 }
 
 /**
- * Perform register setup for a tile.
- * @param[in] mc         A manycore instance.
- * @param[in] map        An EVA<->NPA map.
- * @param[in] tile       A tile to setup.
- * @param[in] all_tiles  All tiles being loaded.
- * @param[in] ntiles     Number of tiles being loaded.
- * @return
+ * Free a load plan.
+ * @param[in]  plan   A load plan created with hb_mc_loader_plan_create()
  */
-static int hb_mc_loader_tile_set_registers(hb_mc_manycore_t *mc,
-                                           const hb_mc_eva_map_t *map,
-                                           hb_mc_coordinate_t tile,
-                                           const hb_mc_coordinate_t *all_tiles,
-                                           uint32_t ntiles)
+void hb_mc_loader_plan_destroy(hb_mc_loader_plan_t *plan)
 {
-        int rc;
+        delete plan;
+}
 
-        rc = hb_mc_tile_freeze(mc, &tile);
-        if (rc != HB_MC_SUCCESS) {
-                bsg_pr_dbg("%s: failed to freeze (%" PRId32 ",%" PRId32 "): %s\n",
-                           __func__,
-                           hb_mc_coordinate_get_x(tile),
-                           hb_mc_coordinate_get_y(tile),
-                           hb_mc_strerror(rc));
-                return rc;
-        }
+/**
+ * Get the writes a load plan makes once, to memory shared by all tiles (DRAM).
+ * @param[in]  plan   A load plan created with hb_mc_loader_plan_create()
+ * @param[out] writes Set to the writes, which are valid as long as #plan
+ * @param[out] n      Set to the number of writes
+ */
+void hb_mc_loader_plan_get_once(const hb_mc_loader_plan_t *plan,
+                                const hb_mc_loader_write_t **writes,
+                                size_t *n)
+{
+        *writes = plan->once.data();
+        *n = plan->once.size();
+}
 
-        /* set the origin tile */
-        rc = hb_mc_tile_set_origin(mc, &tile, &all_tiles[0]); // we assume 0 is the origin
+/**
+ * Get the writes a load plan makes to every tile's own memory (DMEM).
+ * @param[in]  plan   A load plan created with hb_mc_loader_plan_create()
+ * @param[out] writes Set to the writes, which are valid as long as #plan
+ * @param[out] n      Set to the number of writes
+ */
+void hb_mc_loader_plan_get_each(const hb_mc_loader_plan_t *plan,
+                                const hb_mc_loader_write_t **writes,
+                                size_t *n)
+{
+        *writes = plan->each.data();
+        *n = plan->each.size();
+}
 
-        if (rc != HB_MC_SUCCESS) {
-                bsg_pr_dbg("%s: failed to write (%d,%d)'s origin registers: %s\n",
-                           __func__,
-                           hb_mc_coordinate_get_x(tile),
-                           hb_mc_coordinate_get_y(tile),
-                           hb_mc_strerror(rc));
-                return rc;
-        }
+/**
+ * Get the program text a load plan copies to every tile's ICACHE.
+ * @param[in]  plan   A load plan created with hb_mc_loader_plan_create()
+ * @param[out] data   Set to the program text
+ * @param[out] sz     Set to the number of bytes in #data
+ */
+void hb_mc_loader_plan_get_icache(const hb_mc_loader_plan_t *plan,
+                                  const unsigned char **data,
+                                  size_t *sz)
+{
+        *data = plan->icache_data;
+        *sz = plan->icache_sz;
+}
 
-        /* set/clear DRAM enabled */
-        if (hb_mc_manycore_dram_is_enabled(mc)) {
-                rc = hb_mc_tile_set_dram_enabled(mc, &tile);
-        } else {
-                rc = hb_mc_tile_clear_dram_enabled(mc, &tile);
-        }
+/**
+ * Translate a planned write into NPA segments, as seen from a tile.
+ * @param[in]  mc     A manycore instance.
+ * @param[in]  map    An EVA<->NPA map.
+ * @param[in]  tile   The tile whose address space the write is in.
+ * @param[in]  write  A planned write.
+ * @param[in]  zeros  Zeros to write if #write has no data.
+ * @param[out] iov    NPA segments covering #write are appended to this list.
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+static int hb_mc_loader_write_to_npas(hb_mc_manycore_t *mc,
+                                      const hb_mc_eva_map_t *map,
+                                      const hb_mc_coordinate_t *tile,
+                                      const hb_mc_loader_write_t *write,
+                                      const uint32_t *zeros,
+                                      std::vector<hb_mc_npa_iovec_t> &iov)
+{
+        hb_mc_eva_t eva = write->eva;
+        size_t off = 0;
+        int rc;
 
-        if (rc != HB_MC_SUCCESS) {
-                char tile_str[32];
-                bsg_pr_dbg("%s: failed to %s DRAM-enabled for %s: %s\n",
-                           __func__,
-                           hb_mc_manycore_dram_is_enabled(mc) ? "set" : "clear",
-                           hb_mc_coordinate_to_string(tile, tile_str, sizeof(tile_str)),
-                           hb_mc_strerror(rc));
-                return rc;
+        while (off < write->sz) {
+                hb_mc_npa_iovec_t seg;
+                size_t npa_sz;
+
+                rc = hb_mc_eva_to_npa(mc, map, tile, &eva, &seg.npa, &npa_sz);
+                if (rc != HB_MC_SUCCESS) {
+                        bsg_pr_err("%s: failed to translate EVA 0x%08" PRIx32 " for tile (%d, %d)"
+                                   ": %s\n",
+                                   __func__, eva,
+                                   hb_mc_coordinate_get_x(*tile),
+                                   hb_mc_coordinate_get_y(*tile),
+                                   hb_mc_strerror(rc));
+                        return rc;
+                }
+
+                seg.sz = min_size_t(write->sz - off, npa_sz);
+                if (write->data)
+                        seg.data = const_cast<unsigned char *>(&write->data[off]);
+                else
+                        seg.data = const_cast<uint32_t *>(zeros);
+                iov.push_back(seg);
+
+                off += seg.sz;
+                eva += seg.sz;
         }
 
         return HB_MC_SUCCESS;
 }
 
 /**
- * Performance miscellaneous initialization on one tile.
- * @param[in] mc      A manycore instance.
- * @param[in] map     An EVA<->NPA map.
- * @param[in] tile    A tile to initialize
- * @param[in] tiles   The list of tiles being initialized.
- * @param[in] ntiles  The number of tiles being initialized.
- * @return HB_MC_SUCCESS if an error occured. Otherwise an error code is returned.
+ * Merge per-tile lists of NPA segments into one stream that visits
+ * every tile in turn, HB_MC_LOADER_STREAM_CHUNK bytes at a time.
+ * @param[in]  tile_iovs  A list of NPA segments for each tile.
+ * @param[out] iov        The stream is appended to this list.
  */
-static int hb_mc_loader_tile_initialize(hb_mc_manycore_t *mc,
+static void hb_mc_loader_interleave(const std::vector<std::vector<hb_mc_npa_iovec_t>> &tile_iovs,
+                                    std::vector<hb_mc_npa_iovec_t> &iov)
+{
+        struct cursor { size_t seg; size_t off; };
+        std::vector<cursor> cursors(tile_iovs.size(), cursor{0, 0});
+        bool more = true;
+
+        while (more) {
+                more = false;
+                for (size_t t = 0; t < tile_iovs.size(); t++) {
+                        const std::vector<hb_mc_npa_iovec_t> &segs = tile_iovs[t];
+                        cursor &c = cursors[t];
+                        if (c.seg == segs.size())
+                                continue;
+
+                        const hb_mc_npa_iovec_t &seg = segs[c.seg];
+                        hb_mc_npa_iovec_t chunk = seg;
+                        chunk.sz = min_size_t(seg.sz - c.off, HB_MC_LOADER_STREAM_CHUNK);
+                        hb_mc_npa_set_epa(&chunk.npa, hb_mc_npa_get_epa(&seg.npa) + c.off);
+                        chunk.data = static_cast<unsigned char *>(seg.data) + c.off;
+                        iov.push_back(chunk);
+
+                        c.off += chunk.sz;
+                        if (c.off == seg.sz) {
+                                c.seg++;
+                                c.off = 0;
+                        }
+                        more = more || c.seg < segs.size();
+                }
+        }
+}
+
+/**
+ * Write the segments that are loaded once (DRAM) over the network.
+ * @param[in]  plan   A load plan created with hb_mc_loader_plan_create()
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  map    An eva map for computing the eva to npa translation
+ * @param[in]  tile   The tile whose address space the segments are in
+ * @param[out] iov    NPA segments holding data are appended to this list.
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ *
+ * Zero fills are written immediately; data is left to the caller's stream.
+ */
+static int hb_mc_loader_write_once_mesh(const hb_mc_loader_plan_t *plan,
+                                        hb_mc_manycore_t *mc,
                                         const hb_mc_eva_map_t *map,
-                                        hb_mc_coordinate_t tile,
-                                        const hb_mc_coordinate_t *all_tiles,
-                                        uint32_t ntiles)
+                                        const hb_mc_coordinate_t *tile,
+                                        std::vector<hb_mc_npa_iovec_t> &iov)
 {
         int rc;
 
-        rc = hb_mc_loader_tile_set_registers(mc, map, tile, all_tiles, ntiles);
-        if (rc != HB_MC_SUCCESS)
-                return rc;
+        for (const hb_mc_loader_write_t &write : plan->once) {
+                if (write.data) {
+                        rc = hb_mc_loader_write_to_npas(mc, map, tile, &write, NULL, iov);
+                        if (rc != HB_MC_SUCCESS)
+                                return rc;
+                        continue;
+                }
+
+                /* large fills may go around the network (see hb_mc_manycore_eva_memset()) */
+                rc = hb_mc_manycore_eva_memset(mc, map, tile, &write.eva, 0, write.sz);
+                if (rc != HB_MC_SUCCESS) {
+                        bsg_pr_err("%s: failed to zero %zu bytes @ eva 0x%08" PRIx32 ": %s\n",
+                                   __func__, write.sz, write.eva, hb_mc_strerror(rc));
+                        return rc;
+                }
+        }
 
         return HB_MC_SUCCESS;
 }
 
+/* largest host buffer of zeros used to DMA a zero fill */
+#define HB_MC_LOADER_DMA_ZEROS_SZ (64 * 1024)
+
 /**
- * Validate all victim cache tags.
- * @param[in] mc      A manycore instance.
- * @param[in] map     An EVA<->NPA map.
- * @param[in] tiles   The list of tiles to initialize.
- * @param[in] ntiles  The number of tiles to initialize.
- * @return HB_MC_SUCCESS if an error occured. Otherwise an error code is returned.
+ * Write the segments that are loaded once (DRAM) via DMA.
+ * @param[in]  plan   A load plan created with hb_mc_loader_plan_create()
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  map    An eva map for computing the eva to npa translation
+ * @param[in]  tile   The tile whose address space the segments are in
+ * @return HB_MC_NOIMPL if any segment is not in DRAM and nothing was written.
+ * HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ *
+ * Data and zero fills are sent as one list of DMA segments, so the platform
+ * can copy them in parallel and the victim caches are invalidated once.
  */
-static int hb_mc_loader_columns_validate_victim_cache(hb_mc_manycore_t *mc,
-                                                      const hb_mc_eva_map_t *map)
+static int hb_mc_loader_write_once_dma(const hb_mc_loader_plan_t *plan,
+                                       hb_mc_manycore_t *mc,
+                                       const hb_mc_eva_map_t *map,
+                                       const hb_mc_coordinate_t *tile)
 {
-        return hb_mc_manycore_validate_vcache(mc);
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        std::vector<hb_mc_dma_segment_t> segs;
+        std::vector<unsigned char> zeros;
+        int rc;
+
+        for (const hb_mc_loader_write_t &write : plan->once) {
+                if (!write.data)
+                        zeros.resize(std::max(zeros.size(),
+                                              min_size_t(write.sz, HB_MC_LOADER_DMA_ZEROS_SZ)));
+        }
+
+        // translate everything first: DMA can only reach DRAM
+        for (const hb_mc_loader_write_t &write : plan->once) {
+                hb_mc_eva_t eva = write.eva;
+                size_t off = 0;
+
+                while (off < write.sz) {
+                        hb_mc_dma_segment_t seg;
+                        size_t npa_sz;
+
+                        rc = hb_mc_eva_to_npa(mc, map, tile, &eva, &seg.npa, &npa_sz);
+                        if (rc != HB_MC_SUCCESS) {
+                                bsg_pr_err("%s: failed to translate EVA 0x%08" PRIx32 ": %s\n",
+                                           __func__, eva, hb_mc_strerror(rc));
+                                return rc;
+                        }
+
+                        if (!hb_mc_config_is_dram_y(cfg, hb_mc_npa_get_y(&seg.npa)))
+                                return HB_MC_NOIMPL;
+
+                        seg.sz = min_size_t(write.sz - off, npa_sz);
+                        if (write.data) {
+                                seg.host = const_cast<unsigned char *>(&write.data[off]);
+                        } else {
+                                seg.sz = min_size_t(seg.sz, zeros.size());
+                                seg.host = zeros.data();
+                        }
+                        segs.push_back(seg);
+
+                        off += seg.sz;
+                        eva += seg.sz;
+                }
+        }
+
+        if (segs.empty())
+                return HB_MC_SUCCESS;
+
+        rc = hb_mc_manycore_dma_write_segments(mc, segs.data(), segs.size());
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to DMA %zu segments: %s\n",
+                           __func__, segs.size(), hb_mc_strerror(rc));
+                return rc;
+        }
+
+        return HB_MC_SUCCESS;
 }
 
 /**
- * Performance miscellaneous initialization of tiles.
- * @param[in] mc      A manycore instance.
- * @param[in] map     An EVA<->NPA map.
- * @param[in] tiles   The list of tiles to initialize.
- * @param[in] ntiles  The number of tiles to initialize.
- * @return HB_MC_SUCCESS if an error occured. Otherwise an error code is returned.
+ * Prepare sets of tiles to be loaded: set their registers and, in
+ * no-DRAM mode, validate the victim caches.
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  map    An eva map for computing the eva to npa translation
+ * @param[in]  sets   Sets of tiles to load, each with its origin first
+ * @param[in]  nsets  The number of sets in #sets
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
  */
-static int hb_mc_loader_tiles_initialize(hb_mc_manycore_t *mc,
-                                         const hb_mc_eva_map_t *map,
-                                         const hb_mc_coordinate_t *tiles,
-                                         uint32_t ntiles)
+static int hb_mc_loader_sets_prepare(hb_mc_manycore_t *mc,
+                                     const hb_mc_eva_map_t *map,
+                                     const hb_mc_loader_tile_set_t *sets,
+                                     size_t nsets)
 {
         int rc;
 
-        if (ntiles == 0)
+        if (!sets || nsets < 1)
                 return HB_MC_INVALID;
 
-        for (uint32_t i = 0; i < ntiles; i++) {
-                rc = hb_mc_loader_tile_initialize(mc, map, tiles[i], tiles, ntiles);
-                if (rc != HB_MC_SUCCESS)
+        for (size_t i = 0; i < nsets; i++) {
+                if (sets[i].ntiles < 1)
+                        return HB_MC_INVALID;
+        }
+
+        // Set CSRs
+        for (size_t i = 0; i < nsets; i++) {
+                rc = hb_mc_loader_tiles_set_registers(mc, map, sets[i].tiles, sets[i].ntiles);
+                if (rc != HB_MC_SUCCESS) {
+                        bsg_pr_dbg("%s: failed to initialize tiles\n", __func__);
                         return rc;
+                }
         }
 
         /* validate all vcache tags if we're in no-DRAM mode */
@@ -812,6 +826,83 @@ static int hb_mc_loader_tiles_initialize(hb_mc_manycore_t *mc,
         return HB_MC_SUCCESS;
 }
 
+/**
+ * Load a planned binary object into one or more sets of tiles and DRAM.
+ * @param[in]  plan   A load plan created with hb_mc_loader_plan_create()
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  map    An eva map for computing the eva to npa translation
+ * @param[in]  sets   Sets of tiles to load, each with its origin first
+ * @param[in]  nsets  The number of sets in #sets
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_loader_plan_load(const hb_mc_loader_plan_t *plan,
+                           hb_mc_manycore_t *mc,
+                           const hb_mc_eva_map_t *map,
+                           const hb_mc_loader_tile_set_t *sets,
+                           size_t nsets)
+{
+        int rc;
+
+        if (!plan)
+                return HB_MC_INVALID;
+
+        rc = hb_mc_loader_sets_prepare(mc, map, sets, nsets);
+        if (rc != HB_MC_SUCCESS)
+                return rc;
+
+        /* DRAM is shared: load it as seen from the first tile */
+        const hb_mc_coordinate_t *first = &sets[0].tiles[0];
+        std::vector<hb_mc_npa_iovec_t> iov;
+        bool once_done = false;
+
+        /* take the DMA backdoor to DRAM when there is one */
+        if (hb_mc_manycore_dram_is_enabled(mc) && hb_mc_manycore_supports_dma_write(mc)) {
+                rc = hb_mc_loader_write_once_dma(plan, mc, map, first);
+                if (rc != HB_MC_SUCCESS && rc != HB_MC_NOIMPL)
+                        return rc;
+                once_done = rc == HB_MC_SUCCESS;
+        }
+
+        if (!once_done) {
+                rc = hb_mc_loader_write_once_mesh(plan, mc, map, first, iov);
+                if (rc != HB_MC_SUCCESS)
+                        return rc;
+        }
+
+        /* every tile's DMEM and ICACHE */
+        std::vector<std::vector<hb_mc_npa_iovec_t>> tile_iovs;
+        for (size_t i = 0; i < nsets; i++) {
+                for (uint32_t t = 0; t < sets[i].ntiles; t++) {
+                        const hb_mc_coordinate_t *tile = &sets[i].tiles[t];
+                        tile_iovs.emplace_back();
+                        std::vector<hb_mc_npa_iovec_t> &tile_iov = tile_iovs.back();
+
+                        for (const hb_mc_loader_write_t &write : plan->each) {
+                                rc = hb_mc_loader_write_to_npas(mc, map, tile, &write,
+                                                                plan->zeros.data(), tile_iov);
+                                if (rc != HB_MC_SUCCESS)
+                                        return rc;
+                        }
+
+                        tile_iov.push_back({hb_mc_npa(*tile, HB_MC_TILE_EPA_ICACHE),
+                                            const_cast<unsigned char *>(plan->icache_data),
+                                            plan->icache_sz});
+                }
+        }
+
+        /* spread the stores over all tiles, rather than filling one tile at a time */
+        hb_mc_loader_interleave(tile_iovs, iov);
+
+        rc = hb_mc_manycore_write_mem_vec(mc, iov.data(), iov.size());
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to load segments: %s\n",
+                           __func__, hb_mc_strerror(rc));
+                return rc;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
 /**
  * Loads an ELF file into a list of tiles and DRAM
  * @param[in]  bin    A memory buffer containing a valid manycore binary
@@ -826,29 +917,204 @@ int hb_mc_loader_load(const void *bin, size_t sz, hb_mc_manycore_t *mc,
                       const hb_mc_eva_map_t *map,
                       const hb_mc_coordinate_t *tiles, uint32_t ntiles)
 {
+        hb_mc_loader_plan_t *plan;
         int rc;
 
         if (ntiles < 1)
                 return HB_MC_INVALID;
 
-        // Validate ELF File
-        rc = hb_mc_loader_elf_validate(bin, sz);
+        rc = hb_mc_loader_plan_create(bin, sz, mc, &plan);
         if (rc != HB_MC_SUCCESS) {
-                bsg_pr_dbg("%s: failed to validate binary\n", __func__);
+                bsg_pr_dbg("%s: failed to plan load\n", __func__);
                 return rc;
         }
 
-        // Set CSRs
-        rc = hb_mc_loader_tiles_initialize(mc, map, tiles, ntiles);
+        hb_mc_loader_tile_set_t set = { tiles, ntiles };
+        rc = hb_mc_loader_plan_load(plan, mc, map, &set, 1);
+        hb_mc_loader_plan_destroy(plan);
         if (rc != HB_MC_SUCCESS) {
-                bsg_pr_dbg("%s: failed to initialize tiles\n", __func__);
+                bsg_pr_dbg("%s: failed to load segments\n", __func__);
                 return rc;
         }
 
-        // Load segments
-        rc = hb_mc_loader_load_segments(bin, sz, mc, map, tiles, ntiles);
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Write the DRAM writes of a load image via DMA.
+ * @param[in]  image  A load image
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+static int hb_mc_loader_image_write_once_dma(const hb_mc_load_image_t *image,
+                                             hb_mc_manycore_t *mc)
+{
+        const hb_mc_load_image_npa_write_t *writes;
+        std::vector<hb_mc_dma_segment_t> segs;
+        std::vector<unsigned char> zeros;
+        size_t n;
+        int rc;
+
+        hb_mc_load_image_get_once(image, &writes, &n);
+        for (size_t i = 0; i < n; i++) {
+                if (writes[i].data_off == HB_MC_LOAD_IMAGE_ZEROS)
+                        zeros.resize(std::max(zeros.size(),
+                                              min_size_t(writes[i].sz, HB_MC_LOADER_DMA_ZEROS_SZ)));
+        }
+
+        for (size_t i = 0; i < n; i++) {
+                const hb_mc_load_image_npa_write_t *write = &writes[i];
+                const unsigned char *data = hb_mc_load_image_get_data(image, write->data_off);
+
+                for (size_t off = 0; off < write->sz; ) {
+                        hb_mc_dma_segment_t seg;
+                        seg.npa = hb_mc_npa_from_x_y(write->x, write->y, write->epa + off);
+                        seg.sz = write->sz - off;
+                        if (data) {
+                                seg.host = const_cast<unsigned char *>(&data[off]);
+                        } else {
+                                seg.sz = min_size_t(seg.sz, zeros.size());
+                                seg.host = zeros.data();
+                        }
+                        segs.push_back(seg);
+                        off += seg.sz;
+                }
+        }
+
+        if (segs.empty())
+                return HB_MC_SUCCESS;
+
+        rc = hb_mc_manycore_dma_write_segments(mc, segs.data(), segs.size());
         if (rc != HB_MC_SUCCESS) {
-                bsg_pr_dbg("%s: failed to load segments\n", __func__);
+                bsg_pr_err("%s: failed to DMA %zu segments: %s\n",
+                           __func__, segs.size(), hb_mc_strerror(rc));
+                return rc;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Translate the DRAM writes of a load image into NPA segments.
+ * @param[in]  image  A load image
+ * @param[in]  zeros  Zeros to write for zero fills
+ * @param[in]  zeros_sz The number of bytes in #zeros
+ * @param[out] iov    NPA segments covering the writes are appended to this list.
+ */
+static void hb_mc_loader_image_write_once_mesh(const hb_mc_load_image_t *image,
+                                               const unsigned char *zeros,
+                                               size_t zeros_sz,
+                                               std::vector<hb_mc_npa_iovec_t> &iov)
+{
+        const hb_mc_load_image_npa_write_t *writes;
+        size_t n;
+
+        hb_mc_load_image_get_once(image, &writes, &n);
+        for (size_t i = 0; i < n; i++) {
+                const hb_mc_load_image_npa_write_t *write = &writes[i];
+                const unsigned char *data = hb_mc_load_image_get_data(image, write->data_off);
+
+                for (size_t off = 0; off < write->sz; ) {
+                        hb_mc_npa_iovec_t seg;
+                        seg.npa = hb_mc_npa_from_x_y(write->x, write->y, write->epa + off);
+                        seg.sz = write->sz - off;
+                        if (data) {
+                                seg.data = const_cast<unsigned char *>(&data[off]);
+                        } else {
+                                seg.sz = min_size_t(seg.sz, zeros_sz);
+                                seg.data = const_cast<unsigned char *>(zeros);
+                        }
+                        iov.push_back(seg);
+                        off += seg.sz;
+                }
+        }
+}
+
+/**
+ * Load a load image into one or more sets of tiles and DRAM.
+ * @param[in]  image  A load image lowered for #mc
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  map    An eva map, used only to set up the tiles
+ * @param[in]  sets   Sets of tiles to load, each with its origin first
+ * @param[in]  nsets  The number of sets in #sets
+ * @return HB_MC_SUCCESS if succesful. HB_MC_INVALID if #image was lowered for another machine.
+ * Otherwise an error code is returned.
+ */
+int hb_mc_loader_load_image(const hb_mc_load_image_t *image,
+                            hb_mc_manycore_t *mc,
+                            const hb_mc_eva_map_t *map,
+                            const hb_mc_loader_tile_set_t *sets,
+                            size_t nsets)
+{
+        const hb_mc_load_image_npa_write_t *once;
+        const hb_mc_load_image_epa_write_t *each;
+        const unsigned char *icache_data;
+        size_t nonce, neach, icache_sz, zeros_sz = 0;
+        int rc;
+
+        if (!image)
+                return HB_MC_INVALID;
+
+        rc = hb_mc_load_image_check_machine(image, mc);
+        if (rc != HB_MC_SUCCESS)
+                return rc;
+
+        rc = hb_mc_loader_sets_prepare(mc, map, sets, nsets);
+        if (rc != HB_MC_SUCCESS)
+                return rc;
+
+        hb_mc_load_image_get_once(image, &once, &nonce);
+        hb_mc_load_image_get_each(image, &each, &neach);
+        hb_mc_load_image_get_icache(image, &icache_data, &icache_sz);
+
+        for (size_t i = 0; i < nonce; i++) {
+                if (once[i].data_off == HB_MC_LOAD_IMAGE_ZEROS)
+                        zeros_sz = std::max(zeros_sz, min_size_t(once[i].sz, HB_MC_LOADER_DMA_ZEROS_SZ));
+        }
+        for (size_t i = 0; i < neach; i++) {
+                if (each[i].data_off == HB_MC_LOAD_IMAGE_ZEROS)
+                        zeros_sz = std::max(zeros_sz, (size_t)each[i].sz);
+        }
+        std::vector<unsigned char> zeros(zeros_sz);
+        std::vector<hb_mc_npa_iovec_t> iov;
+
+        /* take the DMA backdoor to DRAM when there is one */
+        if (hb_mc_manycore_dram_is_enabled(mc) && hb_mc_manycore_supports_dma_write(mc)) {
+                rc = hb_mc_loader_image_write_once_dma(image, mc);
+                if (rc != HB_MC_SUCCESS)
+                        return rc;
+        } else {
+                hb_mc_loader_image_write_once_mesh(image, zeros.data(), zeros.size(), iov);
+        }
+
+        /* every tile's DMEM and ICACHE */
+        std::vector<std::vector<hb_mc_npa_iovec_t>> tile_iovs;
+        for (size_t i = 0; i < nsets; i++) {
+                for (uint32_t t = 0; t < sets[i].ntiles; t++) {
+                        hb_mc_coordinate_t tile = sets[i].tiles[t];
+                        tile_iovs.emplace_back();
+                        std::vector<hb_mc_npa_iovec_t> &tile_iov = tile_iovs.back();
+
+                        for (size_t w = 0; w < neach; w++) {
+                                const unsigned char *data = hb_mc_load_image_get_data(image, each[w].data_off);
+                                tile_iov.push_back({hb_mc_npa(tile, each[w].epa),
+                                                    const_cast<unsigned char *>(data ? data : zeros.data()),
+                                                    each[w].sz});
+                        }
+
+                        tile_iov.push_back({hb_mc_npa(tile, HB_MC_TILE_EPA_ICACHE),
+                                            const_cast<unsigned char *>(icache_data),
+                                            icache_sz});
+                }
+        }
+
+        /* spread the stores over all tiles, rather than filling one tile at a time */
+        hb_mc_loader_interleave(tile_iovs, iov);
+
+        rc = hb_mc_manycore_write_mem_vec(mc, iov.data(), iov.size());
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: failed to load segments: %s\n",
+                           __func__, hb_mc_strerror(rc));
                 return rc;
         }
 
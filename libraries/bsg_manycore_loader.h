@@ -32,6 +32,7 @@
 #include <bsg_manycore.h>
 #include <bsg_manycore_eva.h>
 #include <bsg_manycore_errno.h>
+#include <bsg_manycore_load_image.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -53,6 +54,117 @@ extern "C" {
                               const hb_mc_coordinate_t *tiles, 
                               uint32_t len);
 
+        /**
+         * A plan for loading a binary object: which segments go where,
+         * how much of each is zero-filled, which are loaded once (DRAM)
+         * and which once per tile (DMEM), and what goes to the ICACHE.
+         * Planning a binary once lets it be loaded onto many tiles
+         * without examining it again.
+         */
+        typedef struct hb_mc_loader_plan hb_mc_loader_plan_t;
+
+        /* A run of program data (or of zeros, if data is NULL) to be written at an EVA */
+        typedef struct hb_mc_loader_write {
+                hb_mc_eva_t eva;
+                const unsigned char *data;
+                size_t sz;
+        } hb_mc_loader_write_t;
+
+        /* A set of tiles to load, such as a tile group */
+        typedef struct hb_mc_loader_tile_set {
+                const hb_mc_coordinate_t *tiles; //!< tiles to load, with the origin of the set first
+                uint32_t ntiles;                 //!< the number of tiles in #tiles
+        } hb_mc_loader_tile_set_t;
+
+        /**
+         * Plan how to load a binary object
+         * @param[in]  bin    A memory buffer containing a valid manycore binary; it must outlive the plan
+         * @param[in]  sz     Size of #bin in bytes
+         * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+         * @param[out] plan   Set to the load plan; free it with hb_mc_loader_plan_destroy()
+         * @return HB_MC_SUCCESS if succesful. HB_MC_INVALID if #bin is not a valid manycore binary.
+         * Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_loader_plan_create(const void *bin, size_t sz,
+                                     hb_mc_manycore_t *mc,
+                                     hb_mc_loader_plan_t **plan);
+
+        /**
+         * Load a planned binary object into one or more sets of tiles and DRAM
+         * @param[in]  plan   A load plan created with hb_mc_loader_plan_create()
+         * @param[in]  mc     The manycore instance the plan was created for
+         * @param[in]  map    An eva map for computing the eva to npa translation
+         * @param[in]  sets   Sets of tiles to load, each with its origin first
+         * @param[in]  nsets  The number of sets in #sets
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * DRAM segments are loaded once, as seen from the first tile of the first set.
+         * Stores to all tiles are interleaved and completed with a single fence.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_loader_plan_load(const hb_mc_loader_plan_t *plan,
+                                   hb_mc_manycore_t *mc,
+                                   const hb_mc_eva_map_t *map,
+                                   const hb_mc_loader_tile_set_t *sets,
+                                   size_t nsets);
+
+        /**
+         * Free a load plan
+         * @param[in]  plan   A load plan created with hb_mc_loader_plan_create()
+         */
+        void hb_mc_loader_plan_destroy(hb_mc_loader_plan_t *plan);
+
+        /**
+         * Get the writes a load plan makes once, to memory shared by all tiles (DRAM)
+         * @param[in]  plan   A load plan created with hb_mc_loader_plan_create()
+         * @param[out] writes Set to the writes, which are valid as long as #plan
+         * @param[out] n      Set to the number of writes
+         */
+        void hb_mc_loader_plan_get_once(const hb_mc_loader_plan_t *plan,
+                                        const hb_mc_loader_write_t **writes,
+                                        size_t *n);
+
+        /**
+         * Get the writes a load plan makes to every tile's own memory (DMEM)
+         * @param[in]  plan   A load plan created with hb_mc_loader_plan_create()
+         * @param[out] writes Set to the writes, which are valid as long as #plan
+         * @param[out] n      Set to the number of writes
+         */
+        void hb_mc_loader_plan_get_each(const hb_mc_loader_plan_t *plan,
+                                        const hb_mc_loader_write_t **writes,
+                                        size_t *n);
+
+        /**
+         * Get the program text a load plan copies to every tile's ICACHE
+         * @param[in]  plan   A load plan created with hb_mc_loader_plan_create()
+         * @param[out] data   Set to the program text
+         * @param[out] sz     Set to the number of bytes in #data
+         */
+        void hb_mc_loader_plan_get_icache(const hb_mc_loader_plan_t *plan,
+                                          const unsigned char **data,
+                                          size_t *sz);
+
+        /**
+         * Load a load image into one or more sets of tiles and DRAM
+         * @param[in]  image  A load image lowered for #mc
+         * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  map    An eva map, used only to set up the tiles
+         * @param[in]  sets   Sets of tiles to load, each with its origin first
+         * @param[in]  nsets  The number of sets in #sets
+         * @return HB_MC_SUCCESS if succesful. HB_MC_INVALID if #image was lowered for another machine.
+         * Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * Like hb_mc_loader_plan_load(), but the addresses were translated
+         * when the image was lowered, so nothing is planned or translated.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_loader_load_image(const hb_mc_load_image_t *image,
+                                    hb_mc_manycore_t *mc,
+                                    const hb_mc_eva_map_t *map,
+                                    const hb_mc_loader_tile_set_t *sets,
+                                    size_t nsets);
+
         /**
          * Get an EVA for a symbol from a program data.
          * @param[in]  bin     A memory buffer containing a valid manycore binary.
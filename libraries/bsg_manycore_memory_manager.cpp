@@ -213,3 +213,24 @@ awsbwhal::MemoryManager::reserve(uint64_t base, size_t size)
         mFreeSize -= size;
         return true;
 }
+
+// Copy out the free and busy lists, e.g. to checkpoint the allocator
+void
+awsbwhal::MemoryManager::save(PairList &free_list, PairList &busy_list)
+{
+        std::lock_guard<std::mutex> lock(mMemManagerMutex);
+        free_list = mFreeBufferList;
+        busy_list = mBusyBufferList;
+}
+
+// Replace the free and busy lists with lists returned by save()
+void
+awsbwhal::MemoryManager::restore(const PairList &free_list, const PairList &busy_list)
+{
+        std::lock_guard<std::mutex> lock(mMemManagerMutex);
+        mFreeBufferList = free_list;
+        mBusyBufferList = busy_list;
+        mFreeSize = 0;
+        for (const auto &b : mFreeBufferList)
+                mFreeSize += b.second;
+}
@@ -50,6 +50,10 @@ namespace awsbwhal {
                 void reset();
                 std::pair<uint64_t, uint64_t>lookup(uint64_t buf);
                 bool reserve(uint64_t base, size_t size);
+                void save(std::list<std::pair<uint64_t, uint64_t> > &free_list,
+                          std::list<std::pair<uint64_t, uint64_t> > &busy_list);
+                void restore(const std::list<std::pair<uint64_t, uint64_t> > &free_list,
+                             const std::list<std::pair<uint64_t, uint64_t> > &busy_list);
 
                 uint64_t size() const {
                         return mSize;
@@ -132,3 +132,26 @@ int hb_mc_origin_eva_map_exit(hb_mc_eva_map_t *map)
 
         return HB_MC_SUCCESS;
 }
+
+/**
+ * Initialize an EVA map for tiles centered at an origin, without allocating.
+ * The map refers to #origin, which must outlive it, and must not be passed
+ * to hb_mc_origin_eva_map_exit().
+ * @param[in] map     An EVA<->NPA map to initialize.
+ * @param[in] origin  An origin tile around which the map is centered.
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_origin_eva_map_bind(hb_mc_eva_map_t *map, const hb_mc_coordinate_t *origin)
+{
+        /* check that the map and origin are not null */
+        if (!map || !origin)
+                return HB_MC_INVALID;
+
+        map->priv = (const void*)origin;
+        map->eva_to_npa = default_eva_to_npa;
+        map->npa_to_eva = default_npa_to_eva;
+        map->eva_size = default_eva_size;
+        map->eva_map_name = "eva_map @ origin";
+
+        return HB_MC_SUCCESS;
+}
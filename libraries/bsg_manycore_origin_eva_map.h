@@ -56,6 +56,17 @@ extern "C" {
         __attribute__((warn_unused_result))
         int hb_mc_origin_eva_map_exit(hb_mc_eva_map_t *map);
 
+        /**
+         * Initialize an EVA map for tiles centered at an origin, without allocating.
+         * The map refers to #origin, which must outlive it, and must not be passed
+         * to hb_mc_origin_eva_map_exit().
+         * @param[in] map     An EVA<->NPA map to initialize.
+         * @param[in] origin  An origin tile around which the map is centered.
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_origin_eva_map_bind(hb_mc_eva_map_t *map, const hb_mc_coordinate_t *origin);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,185 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore_packet_batch.h>
+#include <bsg_manycore_errno.h>
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * A request packet is four little-endian words:
+ *
+ *   word 0: x_dst | y_dst << 8 | x_src << 16 | y_src << 24
+ *   word 1: data
+ *   word 2: reg_id | op_ex << 8 | op << 16 | addr[7:0] << 24
+ *   word 3: addr[31:8] | reserved << 24
+ *
+ * so a batch to one tile differs only in words 1, 2 and 3 - the
+ * vectorized encoder builds four packets at a time as columns and
+ * transposes them into place.
+ *
+ * A response packet's payload sits at bytes 3-6, and its load ID at byte 2.
+ */
+
+/**
+ * Encode a batch of request packets to a strided series of NPAs.
+ * @param[out] pkts   A 16-byte aligned array of at least #count packets
+ * @param[in]  src    The requester's coordinate (usually the host)
+ * @param[in]  base   The NPA of the first packet - must be word aligned
+ * @param[in]  stride The number of bytes between consecutive EPAs - must be a multiple of 4
+ * @param[in]  data   The payload of each packet, or NULL for a zero payload
+ * @param[in]  count  The number of packets to encode
+ * @param[in]  op     The opcode of every packet
+ * @param[in]  op_ex  The byte mask (or cache opcode) of every packet
+ * @return HB_MC_SUCCESS if succesful. HB_MC_INVALID if an argument is invalid.
+ */
+int hb_mc_request_packet_batch_encode(hb_mc_packet_t *pkts,
+                                      hb_mc_coordinate_t src,
+                                      const hb_mc_npa_t *base,
+                                      hb_mc_epa_t stride,
+                                      const uint32_t *data,
+                                      size_t count,
+                                      hb_mc_packet_op_t op,
+                                      uint8_t op_ex)
+{
+        if (reinterpret_cast<uintptr_t>(pkts) & 0xF)
+                return HB_MC_INVALID;
+
+        if ((hb_mc_npa_get_epa(base) & 0x3) || (stride & 0x3))
+                return HB_MC_INVALID;
+
+        uint32_t addr = hb_mc_npa_get_epa(base) >> 2;
+        uint32_t addr_step = stride >> 2;
+        size_t i = 0;
+
+#ifdef __SSE2__
+        uint32_t w0 = (hb_mc_npa_get_x(base) & 0xFF)
+                | (hb_mc_npa_get_y(base) & 0xFF) << 8
+                | (hb_mc_coordinate_get_x(src) & 0xFF) << 16
+                | (hb_mc_coordinate_get_y(src) & 0xFF) << 24;
+        uint32_t w2 = static_cast<uint32_t>(op_ex) << 8
+                | static_cast<uint32_t>(op) << 16;
+
+        const __m128i vw0  = _mm_set1_epi32(w0);
+        const __m128i vw2  = _mm_set1_epi32(w2);
+        const __m128i vstep = _mm_set1_epi32(4 * addr_step);
+        __m128i vaddr = _mm_setr_epi32(addr,
+                                       addr + addr_step,
+                                       addr + 2 * addr_step,
+                                       addr + 3 * addr_step);
+        __m128i *out = reinterpret_cast<__m128i*>(pkts);
+
+        for (; i + 4 <= count; i += 4) {
+                __m128i vdata = data ?
+                        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&data[i])) :
+                        _mm_setzero_si128();
+                __m128i vaddr_lo = _mm_or_si128(vw2, _mm_slli_epi32(vaddr, 24));
+                __m128i vaddr_hi = _mm_srli_epi32(vaddr, 8);
+
+                // transpose the columns {w0, data, w2, w3} into four packets
+                __m128i t0 = _mm_unpacklo_epi32(vw0, vdata);
+                __m128i t1 = _mm_unpacklo_epi32(vaddr_lo, vaddr_hi);
+                __m128i t2 = _mm_unpackhi_epi32(vw0, vdata);
+                __m128i t3 = _mm_unpackhi_epi32(vaddr_lo, vaddr_hi);
+
+                _mm_store_si128(&out[i+0], _mm_unpacklo_epi64(t0, t1));
+                _mm_store_si128(&out[i+1], _mm_unpackhi_epi64(t0, t1));
+                _mm_store_si128(&out[i+2], _mm_unpacklo_epi64(t2, t3));
+                _mm_store_si128(&out[i+3], _mm_unpackhi_epi64(t2, t3));
+
+                vaddr = _mm_add_epi32(vaddr, vstep);
+        }
+#endif
+
+        for (; i < count; i++) {
+                hb_mc_request_packet_t *pkt = &pkts[i].request;
+                memset(pkt, 0, sizeof(*pkt));
+                hb_mc_request_packet_set_x_dst(pkt, hb_mc_npa_get_x(base));
+                hb_mc_request_packet_set_y_dst(pkt, hb_mc_npa_get_y(base));
+                hb_mc_request_packet_set_x_src(pkt, hb_mc_coordinate_get_x(src));
+                hb_mc_request_packet_set_y_src(pkt, hb_mc_coordinate_get_y(src));
+                hb_mc_request_packet_set_data(pkt, data ? data[i] : 0);
+                hb_mc_request_packet_set_mask(pkt, static_cast<hb_mc_packet_mask_t>(op_ex));
+                hb_mc_request_packet_set_op(pkt, op);
+                hb_mc_request_packet_set_addr(pkt, addr + i * addr_step);
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Decode a batch of response packets.
+ * @param[in]  pkts     A 16-byte aligned array of at least #count packets
+ * @param[in]  count    The number of packets to decode
+ * @param[out] data     An array of at least #count words to receive each payload
+ * @param[out] load_ids An array of at least #count bytes to receive each load ID, or NULL
+ */
+void hb_mc_response_packet_batch_decode(const hb_mc_packet_t *pkts,
+                                        size_t count,
+                                        uint32_t *data,
+                                        uint8_t *load_ids)
+{
+        size_t i = 0;
+
+#ifdef __SSE2__
+        const __m128i *in = reinterpret_cast<const __m128i*>(pkts);
+        const __m128i vbyte = _mm_set1_epi32(0xFF);
+
+        for (; i + 4 <= count; i += 4) {
+                __m128i p0 = _mm_load_si128(&in[i+0]);
+                __m128i p1 = _mm_load_si128(&in[i+1]);
+                __m128i p2 = _mm_load_si128(&in[i+2]);
+                __m128i p3 = _mm_load_si128(&in[i+3]);
+
+                // shift each payload down to word 0 and gather the four
+                __m128i d01 = _mm_unpacklo_epi32(_mm_srli_si128(p0, 3), _mm_srli_si128(p1, 3));
+                __m128i d23 = _mm_unpacklo_epi32(_mm_srli_si128(p2, 3), _mm_srli_si128(p3, 3));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(&data[i]),
+                                 _mm_unpacklo_epi64(d01, d23));
+
+                if (load_ids) {
+                        __m128i w01 = _mm_unpacklo_epi32(p0, p1);
+                        __m128i w23 = _mm_unpacklo_epi32(p2, p3);
+                        __m128i ids = _mm_and_si128(_mm_srli_epi32(_mm_unpacklo_epi64(w01, w23), 16), vbyte);
+                        ids = _mm_packus_epi16(_mm_packs_epi32(ids, ids), ids);
+                        uint32_t packed = _mm_cvtsi128_si32(ids);
+                        memcpy(&load_ids[i], &packed, sizeof(packed));
+                }
+        }
+#endif
+
+        for (; i < count; i++) {
+                data[i] = hb_mc_response_packet_get_data(&pkts[i].response);
+                if (load_ids)
+                        load_ids[i] = hb_mc_response_packet_get_load_id(&pkts[i].response);
+        }
+}
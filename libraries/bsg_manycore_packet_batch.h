@@ -0,0 +1,93 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef BSG_MANYCORE_PACKET_BATCH_H
+#define BSG_MANYCORE_PACKET_BATCH_H
+
+#include <bsg_manycore_features.h>
+#include <bsg_manycore_packet.h>
+#include <bsg_manycore_coordinate.h>
+#include <bsg_manycore_npa.h>
+#include <bsg_manycore_epa.h>
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+        /**
+         * Encode a batch of request packets to a strided series of NPAs.
+         * @param[out] pkts   A 16-byte aligned array of at least #count packets
+         * @param[in]  src    The requester's coordinate (usually the host)
+         * @param[in]  base   The NPA of the first packet - must be word aligned
+         * @param[in]  stride The number of bytes between consecutive EPAs - must be a multiple of 4
+         * @param[in]  data   The payload of each packet, or NULL for a zero payload
+         * @param[in]  count  The number of packets to encode
+         * @param[in]  op     The opcode of every packet
+         * @param[in]  op_ex  The byte mask (or cache opcode) of every packet
+         * @return HB_MC_SUCCESS if succesful. HB_MC_INVALID if an argument is invalid.
+         *
+         * Packet i is addressed to EPA base + i * stride on base's tile and carries data[i].
+         * The load ID of every packet is zero.
+         * Encoding is vectorized with SSE2 where available.
+         * The destination is not checked against the machine; the caller must do that.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_request_packet_batch_encode(hb_mc_packet_t *pkts,
+                                              hb_mc_coordinate_t src,
+                                              const hb_mc_npa_t *base,
+                                              hb_mc_epa_t stride,
+                                              const uint32_t *data,
+                                              size_t count,
+                                              hb_mc_packet_op_t op,
+                                              uint8_t op_ex);
+
+        /**
+         * Decode a batch of response packets.
+         * @param[in]  pkts     A 16-byte aligned array of at least #count packets
+         * @param[in]  count    The number of packets to decode
+         * @param[out] data     An array of at least #count words to receive each payload
+         * @param[out] load_ids An array of at least #count bytes to receive each load ID, or NULL
+         *
+         * Decoding is vectorized with SSE2 where available.
+         */
+        void hb_mc_response_packet_batch_decode(const hb_mc_packet_t *pkts,
+                                                size_t count,
+                                                uint32_t *data,
+                                                uint8_t *load_ids);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
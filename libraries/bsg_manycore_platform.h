@@ -70,6 +70,15 @@ extern "C" {
                                          unsigned int idx,
                                          hb_mc_config_raw_t *config);
 
+        /**
+         * Read the entire configuration ROM in a single burst
+         * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+         * @param[out] config An array of HB_MC_CONFIG_MAX configuration values
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_platform_get_config(hb_mc_manycore_t *mc,
+                                      hb_mc_config_raw_t config[HB_MC_CONFIG_MAX]);
+
         /**
          * Stall until the all requests (and responses) have reached their destination.
          * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
@@ -151,6 +160,33 @@ extern "C" {
          * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
          */
         int hb_mc_platform_log_disable(hb_mc_manycore_t *mc);
+
+        /**
+         * Save the state of the manycore hardware to a checkpoint
+         *
+         * Only simulation platforms can implement checkpoints. The
+         * network must be quiescent (see hb_mc_platform_fence()).
+         *
+         * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in] path  Path of the checkpoint file to write
+         * @return HB_MC_SUCCESS on success. HB_MC_NOIMPL if the platform cannot take checkpoints.
+         */
+        int hb_mc_platform_checkpoint_save(hb_mc_manycore_t *mc, const char *path);
+
+        /**
+         * Restore the state of the manycore hardware from a checkpoint
+         * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in] path  Path of a checkpoint file written by hb_mc_platform_checkpoint_save()
+         * @return HB_MC_SUCCESS on success. HB_MC_NOIMPL if the platform cannot take checkpoints.
+         */
+        int hb_mc_platform_checkpoint_restore(hb_mc_manycore_t *mc, const char *path);
+
+        /**
+         * Check that the platform can send atomic memory operations
+         * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+         * @return HB_MC_SUCCESS if it can. HB_MC_NOIMPL if the host adapter cannot carry atomic requests.
+         */
+        int hb_mc_platform_check_amo(hb_mc_manycore_t *mc);
 #ifdef __cplusplus
 }
 #endif
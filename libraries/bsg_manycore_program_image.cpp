@@ -0,0 +1,490 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore_program_image.h>
+#include <bsg_manycore_load_image.h>
+#include <bsg_manycore_printing.h>
+
+#include <cerrno>
+#include <algorithm>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include <elf.h>
+#include <endian.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef EM_RISCV
+#define EM_RISCV        243     /* RISC-V */
+#endif
+
+/* identifies a file: device, inode, size and modification time */
+typedef std::tuple<dev_t, ino_t, off_t, time_t, long> hb_mc_program_image_key_t;
+
+struct hb_mc_program_image {
+        unsigned refs;                    //!< references held; guarded by hb_mc_program_image_lock
+        bool mapped;                      //!< #data is mapped from a file (otherwise allocated)
+        bool registered;                  //!< listed in hb_mc_program_images under #key
+        hb_mc_program_image_key_t key;
+        const unsigned char *data;
+        size_t size;
+        std::vector<hb_mc_program_segment_t> segments;
+        std::unordered_map<std::string, hb_mc_eva_t> symbols;
+        hb_mc_load_image_t *load_image;   //!< set if #data is a load image rather than a binary
+};
+
+/* images opened from files, for sharing within the process */
+static std::mutex hb_mc_program_image_lock;
+static std::map<hb_mc_program_image_key_t, hb_mc_program_image_t*> hb_mc_program_images;
+
+/* is [off, off+len) within an object of sz bytes? */
+static bool hb_mc_program_image_in_bounds(size_t sz, size_t off, size_t len)
+{
+        return off <= sz && len <= sz - off;
+}
+
+/* check the ELF header: a 32-bit, little-endian RISC-V executable */
+static int hb_mc_program_image_check_header(const unsigned char *data, size_t sz)
+{
+        const Elf32_Ehdr *ehdr = (const Elf32_Ehdr *)data;
+
+        if (sz < sizeof(*ehdr)
+            || memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0
+            || ehdr->e_ident[EI_CLASS] != ELFCLASS32
+            || ehdr->e_ident[EI_DATA] != ELFDATA2LSB) {
+                bsg_pr_dbg("%s: not a 32-bit little endian ELF object\n", __func__);
+                return HB_MC_INVALID;
+        }
+
+        if (le16toh(ehdr->e_type) != ET_EXEC || le16toh(ehdr->e_machine) != EM_RISCV) {
+                bsg_pr_dbg("%s: not a RISC-V executable\n", __func__);
+                return HB_MC_INVALID;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/* index the program headers */
+static int hb_mc_program_image_index_segments(hb_mc_program_image_t *image)
+{
+        const Elf32_Ehdr *ehdr = (const Elf32_Ehdr *)image->data;
+        size_t phoff = le32toh(ehdr->e_phoff);
+        size_t phnum = le16toh(ehdr->e_phnum);
+
+        if (!hb_mc_program_image_in_bounds(image->size, phoff, phnum * sizeof(Elf32_Phdr))) {
+                bsg_pr_dbg("%s: program header table exceeds object size (%zu)\n",
+                           __func__, image->size);
+                return HB_MC_INVALID;
+        }
+
+        const Elf32_Phdr *phdrs = (const Elf32_Phdr *)&image->data[phoff];
+        image->segments.resize(phnum);
+
+        for (size_t i = 0; i < phnum; i++) {
+                const Elf32_Phdr *phdr = &phdrs[i];
+                hb_mc_program_segment_t *seg = &image->segments[i];
+                size_t off = le32toh(phdr->p_offset);
+
+                seg->type    = le32toh(phdr->p_type);
+                seg->flags   = le32toh(phdr->p_flags);
+                seg->eva     = le32toh(phdr->p_paddr);
+                seg->file_sz = le32toh(phdr->p_filesz);
+                seg->mem_sz  = le32toh(phdr->p_memsz);
+                seg->phdr    = phdr;
+
+                if (!hb_mc_program_image_in_bounds(image->size, off, seg->file_sz)) {
+                        bsg_pr_dbg("%s: segment %zu exceeds object size (%zu)\n",
+                                   __func__, i, image->size);
+                        return HB_MC_INVALID;
+                }
+                seg->data = &image->data[off];
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/* index the symbols of every symbol table */
+static int hb_mc_program_image_index_symbols(hb_mc_program_image_t *image)
+{
+        const Elf32_Ehdr *ehdr = (const Elf32_Ehdr *)image->data;
+        size_t shoff = le32toh(ehdr->e_shoff);
+        size_t shnum = le16toh(ehdr->e_shnum);
+
+        if (!hb_mc_program_image_in_bounds(image->size, shoff, shnum * sizeof(Elf32_Shdr))) {
+                bsg_pr_dbg("%s: section table exceeds object size (%zu)\n",
+                           __func__, image->size);
+                return HB_MC_INVALID;
+        }
+
+        const Elf32_Shdr *shdrs = (const Elf32_Shdr *)&image->data[shoff];
+
+        for (size_t i = 0; i < shnum; i++) {
+                const Elf32_Shdr *symtab = &shdrs[i];
+                if (le32toh(symtab->sh_type) != SHT_SYMTAB)
+                        continue;
+
+                size_t link = le32toh(symtab->sh_link);
+                size_t entsize = le32toh(symtab->sh_entsize);
+                size_t sym_off = le32toh(symtab->sh_offset);
+                size_t sym_sz = le32toh(symtab->sh_size);
+                if (link >= shnum || entsize < sizeof(Elf32_Sym)
+                    || !hb_mc_program_image_in_bounds(image->size, sym_off, sym_sz)) {
+                        bsg_pr_dbg("%s: symbol table %zu is malformed\n", __func__, i);
+                        return HB_MC_INVALID;
+                }
+
+                const Elf32_Shdr *strtab = &shdrs[link];
+                size_t str_off = le32toh(strtab->sh_offset);
+                size_t str_sz = le32toh(strtab->sh_size);
+                if (!hb_mc_program_image_in_bounds(image->size, str_off, str_sz)) {
+                        bsg_pr_dbg("%s: string table %zu exceeds object size (%zu)\n",
+                                   __func__, link, image->size);
+                        return HB_MC_INVALID;
+                }
+
+                const char *strs = (const char *)&image->data[str_off];
+                size_t n = sym_sz / entsize;
+                image->symbols.reserve(image->symbols.size() + n);
+
+                for (size_t s = 0; s < n; s++) {
+                        const Elf32_Sym *sym = (const Elf32_Sym *)&image->data[sym_off + s * entsize];
+                        size_t name = le32toh(sym->st_name);
+
+                        /* skip symbols with no name */
+                        if (name == 0)
+                                continue;
+
+                        if (name >= str_sz) {
+                                bsg_pr_dbg("%s: symbol %zu of table %zu has an out of bounds name\n",
+                                           __func__, s, i);
+                                return HB_MC_INVALID;
+                        }
+
+                        /* the first definition of a name wins */
+                        image->symbols.emplace(std::string(&strs[name], strnlen(&strs[name], str_sz - name)),
+                                               le32toh(sym->st_value));
+                }
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/* free an image that is no longer referenced */
+static void hb_mc_program_image_free(hb_mc_program_image_t *image)
+{
+        hb_mc_load_image_destroy(image->load_image);
+
+        if (image->mapped)
+                munmap((void *)image->data, image->size);
+        else
+                free((void *)image->data);
+
+        delete image;
+}
+
+/* validate and index an image whose data is set */
+static int hb_mc_program_image_index(hb_mc_program_image_t *image)
+{
+        int err;
+
+        /* load images are already indexed */
+        if (hb_mc_load_image_is_load_image(image->data, image->size))
+                return hb_mc_load_image_init(image->data, image->size, &image->load_image);
+
+        err = hb_mc_program_image_check_header(image->data, image->size);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        err = hb_mc_program_image_index_segments(image);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        return hb_mc_program_image_index_symbols(image);
+}
+
+/**
+ * Open a manycore binary as a program image.
+ * @param[in]  file_name Path of a manycore binary
+ * @param[out] image     Set to the image, with a reference held by the caller
+ * @return HB_MC_SUCCESS if succesful. HB_MC_INVALID if the file is not a valid manycore binary
+ * or load image. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_program_image_open(const char *file_name, hb_mc_program_image_t **image)
+{
+        struct stat st;
+        int fd, err;
+
+        if (!file_name || !image)
+                return HB_MC_INVALID;
+
+        if ((fd = open(file_name, O_RDONLY | O_CLOEXEC)) < 0) {
+                bsg_pr_err("failed to open '%s': %m\n", file_name);
+                return HB_MC_INVALID;
+        }
+
+        if (fstat(fd, &st) != 0) {
+                bsg_pr_err("could not stat '%s': %m\n", file_name);
+                close(fd);
+                return HB_MC_INVALID;
+        }
+
+        hb_mc_program_image_key_t key(st.st_dev, st.st_ino, st.st_size,
+                                      st.st_mtim.tv_sec, st.st_mtim.tv_nsec);
+
+        std::lock_guard<std::mutex> lock(hb_mc_program_image_lock);
+
+        // share the image if this file is already open
+        auto it = hb_mc_program_images.find(key);
+        if (it != hb_mc_program_images.end()) {
+                close(fd);
+                it->second->refs++;
+                *image = it->second;
+                return HB_MC_SUCCESS;
+        }
+
+        if (static_cast<size_t>(st.st_size) < std::min(sizeof(Elf32_Ehdr), sizeof(hb_mc_load_image_header_t))) {
+                bsg_pr_err("'%s' is not a valid manycore binary\n", file_name);
+                close(fd);
+                return HB_MC_INVALID;
+        }
+
+        void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+                bsg_pr_err("failed to map '%s': %m\n", file_name);
+                return HB_MC_NOMEM;
+        }
+
+        hb_mc_program_image_t *img = new (std::nothrow) hb_mc_program_image_t();
+        if (!img) {
+                munmap(data, st.st_size);
+                return HB_MC_NOMEM;
+        }
+
+        img->refs = 1;
+        img->mapped = true;
+        img->data = static_cast<const unsigned char *>(data);
+        img->size = st.st_size;
+        img->key = key;
+
+        err = hb_mc_program_image_index(img);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("'%s' is not a valid manycore binary\n", file_name);
+                hb_mc_program_image_free(img);
+                return err;
+        }
+
+        img->registered = true;
+        hb_mc_program_images[key] = img;
+
+        *image = img;
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Create a program image from a manycore binary in memory.
+ * @param[in]  bin   A memory buffer containing a valid manycore binary; it is copied
+ * @param[in]  sz    Size of #bin in bytes
+ * @param[out] image Set to the image, with a reference held by the caller
+ * @return HB_MC_SUCCESS if succesful. HB_MC_INVALID if #bin is not a valid manycore binary.
+ * Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_program_image_from_buffer(const void *bin, size_t sz, hb_mc_program_image_t **image)
+{
+        int err;
+
+        if (!bin || !image)
+                return HB_MC_INVALID;
+
+        unsigned char *copy = (unsigned char *)malloc(sz ? sz : 1);
+        if (!copy) {
+                bsg_pr_err("%s: failed to allocate space for program binary\n", __func__);
+                return HB_MC_NOMEM;
+        }
+        memcpy(copy, bin, sz);
+
+        hb_mc_program_image_t *img = new (std::nothrow) hb_mc_program_image_t();
+        if (!img) {
+                free(copy);
+                return HB_MC_NOMEM;
+        }
+
+        img->refs = 1;
+        img->data = copy;
+        img->size = sz;
+
+        err = hb_mc_program_image_index(img);
+        if (err != HB_MC_SUCCESS) {
+                bsg_pr_err("%s: binary is not a valid manycore binary\n", __func__);
+                hb_mc_program_image_free(img);
+                return err;
+        }
+
+        *image = img;
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Take another reference to a program image.
+ * @param[in]  image An image returned by hb_mc_program_image_open() or hb_mc_program_image_from_buffer()
+ * @return #image
+ */
+hb_mc_program_image_t *hb_mc_program_image_ref(hb_mc_program_image_t *image)
+{
+        std::lock_guard<std::mutex> lock(hb_mc_program_image_lock);
+        image->refs++;
+        return image;
+}
+
+/**
+ * Drop a reference to a program image, freeing it with the last reference.
+ * @param[in]  image An image returned by hb_mc_program_image_open() or hb_mc_program_image_from_buffer()
+ */
+void hb_mc_program_image_release(hb_mc_program_image_t *image)
+{
+        if (!image)
+                return;
+
+        {
+                std::lock_guard<std::mutex> lock(hb_mc_program_image_lock);
+                if (--image->refs > 0)
+                        return;
+
+                if (image->registered)
+                        hb_mc_program_images.erase(image->key);
+        }
+
+        hb_mc_program_image_free(image);
+}
+
+/**
+ * Get the binary of a program image.
+ * @param[in]  image An image returned by hb_mc_program_image_open() or hb_mc_program_image_from_buffer()
+ * @return the binary, which is valid for as long as a reference to #image is held
+ */
+const unsigned char *hb_mc_program_image_get_data(const hb_mc_program_image_t *image)
+{
+        return image->data;
+}
+
+/**
+ * Get the size of the binary of a program image.
+ * @param[in]  image An image returned by hb_mc_program_image_open() or hb_mc_program_image_from_buffer()
+ * @return the size of the binary in bytes
+ */
+size_t hb_mc_program_image_get_size(const hb_mc_program_image_t *image)
+{
+        return image->size;
+}
+
+/**
+ * Get the segments of a program image, in program header order.
+ * @param[in]  image    An image returned by hb_mc_program_image_open() or hb_mc_program_image_from_buffer()
+ * @param[out] segments Set to an array of the image's segments
+ * @param[out] n        Set to the number of segments
+ */
+void hb_mc_program_image_get_segments(const hb_mc_program_image_t *image,
+                                      const hb_mc_program_segment_t **segments,
+                                      size_t *n)
+{
+        *segments = image->segments.data();
+        *n = image->segments.size();
+}
+
+/**
+ * Get an EVA for a symbol of a program image.
+ * @param[in]  image   An image returned by hb_mc_program_image_open() or hb_mc_program_image_from_buffer()
+ * @param[in]  symbol  A program symbol
+ * @param[out] eva     An EVA that addresses #symbol
+ * @return HB_MC_SUCCESS if succesful. HB_MC_NOTFOUND if the image has no such symbol.
+ */
+int hb_mc_program_image_symbol_to_eva(const hb_mc_program_image_t *image,
+                                      const char *symbol,
+                                      hb_mc_eva_t *eva)
+{
+        if (!image || !symbol || !eva)
+                return HB_MC_INVALID;
+
+        if (image->load_image)
+                return hb_mc_load_image_symbol_to_eva(image->load_image, symbol, eva);
+
+        auto it = image->symbols.find(symbol);
+        if (it == image->symbols.end()) {
+                bsg_pr_dbg("%s: failed to find symbol '%s'\n", __func__, symbol);
+                return HB_MC_NOTFOUND;
+        }
+
+        *eva = it->second;
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Get the load image a program image holds.
+ * @param[in]  image An image returned by hb_mc_program_image_open() or hb_mc_program_image_from_buffer()
+ * @return the load image, or NULL if #image holds a manycore binary
+ */
+const struct hb_mc_load_image *hb_mc_program_image_get_load_image(const hb_mc_program_image_t *image)
+{
+        return image->load_image;
+}
+
+/**
+ * Call a function for each symbol of a program image, in no particular order.
+ * @param[in]  image An image returned by hb_mc_program_image_open() or hb_mc_program_image_from_buffer()
+ * @param[in]  fn    A function to call with each symbol
+ * @param[in]  arg   An argument passed to #fn
+ * @return HB_MC_SUCCESS if succesful. HB_MC_INVALID if #image holds a load image.
+ * Otherwise the first error returned by #fn.
+ */
+int hb_mc_program_image_foreach_symbol(const hb_mc_program_image_t *image,
+                                       hb_mc_program_image_symbol_fn_t fn,
+                                       void *arg)
+{
+        int err;
+
+        if (!image || !fn || image->load_image)
+                return HB_MC_INVALID;
+
+        for (const auto &sym : image->symbols) {
+                err = fn(sym.first.c_str(), sym.second, arg);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+        }
+
+        return HB_MC_SUCCESS;
+}
@@ -0,0 +1,179 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef BSG_MANYCORE_PROGRAM_IMAGE_H
+#define BSG_MANYCORE_PROGRAM_IMAGE_H
+
+#include <bsg_manycore_features.h>
+#include <bsg_manycore_eva.h>
+#include <bsg_manycore_errno.h>
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+/*
+ * Program images
+ *
+ * A program image is a validated, read-only manycore binary with its
+ * program headers and symbol tables already indexed. Images opened
+ * from a file are mapped rather than read, so every process loading
+ * the same binary shares its pages through the page cache. Within a
+ * process, opening a file that is already open (same inode, size and
+ * modification time) returns the existing image.
+ *
+ * Images are reference counted and may be shared between devices and
+ * threads. They are never modified after they are opened.
+ *
+ * A program image may also hold a load image (see
+ * bsg_manycore_load_image.h), a binary already lowered for one machine.
+ * Load images have no segments; their symbols are looked up in their
+ * own sorted table.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+        typedef struct hb_mc_program_image hb_mc_program_image_t;
+
+        struct hb_mc_load_image;
+
+        /* A program segment, as described by its program header */
+        typedef struct hb_mc_program_segment {
+                uint32_t    type;       //!< segment type (p_type), e.g. PT_LOAD
+                uint32_t    flags;      //!< segment permissions (p_flags), e.g. PF_X
+                hb_mc_eva_t eva;        //!< load address (p_paddr)
+                uint32_t    file_sz;    //!< bytes of #data
+                uint32_t    mem_sz;     //!< bytes occupied once loaded; the rest is zero-filled
+                const unsigned char *data; //!< segment contents, inside the image
+                const void *phdr;       //!< the program header (an Elf32_Phdr), inside the image
+        } hb_mc_program_segment_t;
+
+        /**
+         * Open a manycore binary as a program image.
+         * @param[in]  file_name Path of a manycore binary
+         * @param[out] image     Set to the image, with a reference held by the caller
+         * @return HB_MC_SUCCESS if succesful. HB_MC_INVALID if the file is not a valid manycore binary
+         * or load image. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_program_image_open(const char *file_name, hb_mc_program_image_t **image);
+
+        /**
+         * Create a program image from a manycore binary in memory.
+         * @param[in]  bin   A memory buffer containing a valid manycore binary; it is copied
+         * @param[in]  sz    Size of #bin in bytes
+         * @param[out] image Set to the image, with a reference held by the caller
+         * @return HB_MC_SUCCESS if succesful. HB_MC_INVALID if #bin is not a valid manycore binary.
+         * Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_program_image_from_buffer(const void *bin, size_t sz, hb_mc_program_image_t **image);
+
+        /**
+         * Take another reference to a program image.
+         * @param[in]  image An image returned by hb_mc_program_image_open() or hb_mc_program_image_from_buffer()
+         * @return #image
+         */
+        hb_mc_program_image_t *hb_mc_program_image_ref(hb_mc_program_image_t *image);
+
+        /**
+         * Drop a reference to a program image, freeing it with the last reference.
+         * @param[in]  image An image returned by hb_mc_program_image_open() or hb_mc_program_image_from_buffer()
+         */
+        void hb_mc_program_image_release(hb_mc_program_image_t *image);
+
+        /**
+         * Get the binary of a program image.
+         * @param[in]  image An image returned by hb_mc_program_image_open() or hb_mc_program_image_from_buffer()
+         * @return the binary, which is valid for as long as a reference to #image is held
+         */
+        const unsigned char *hb_mc_program_image_get_data(const hb_mc_program_image_t *image);
+
+        /**
+         * Get the size of the binary of a program image.
+         * @param[in]  image An image returned by hb_mc_program_image_open() or hb_mc_program_image_from_buffer()
+         * @return the size of the binary in bytes
+         */
+        size_t hb_mc_program_image_get_size(const hb_mc_program_image_t *image);
+
+        /**
+         * Get the segments of a program image, in program header order.
+         * @param[in]  image    An image returned by hb_mc_program_image_open() or hb_mc_program_image_from_buffer()
+         * @param[out] segments Set to an array of the image's segments
+         * @param[out] n        Set to the number of segments
+         */
+        void hb_mc_program_image_get_segments(const hb_mc_program_image_t *image,
+                                              const hb_mc_program_segment_t **segments,
+                                              size_t *n);
+
+        /**
+         * Get an EVA for a symbol of a program image.
+         * @param[in]  image   An image returned by hb_mc_program_image_open() or hb_mc_program_image_from_buffer()
+         * @param[in]  symbol  A program symbol
+         * @param[out] eva     An EVA that addresses #symbol
+         * @return HB_MC_SUCCESS if succesful. HB_MC_NOTFOUND if the image has no such symbol.
+         *
+         * If a name appears more than once, the first definition wins,
+         * as with hb_mc_loader_symbol_to_eva().
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_program_image_symbol_to_eva(const hb_mc_program_image_t *image,
+                                              const char *symbol,
+                                              hb_mc_eva_t *eva);
+
+        /**
+         * Get the load image a program image holds.
+         * @param[in]  image An image returned by hb_mc_program_image_open() or hb_mc_program_image_from_buffer()
+         * @return the load image, or NULL if #image holds a manycore binary
+         */
+        const struct hb_mc_load_image *hb_mc_program_image_get_load_image(const hb_mc_program_image_t *image);
+
+        /* Called for each symbol of a program image; stops the walk unless it returns HB_MC_SUCCESS */
+        typedef int (*hb_mc_program_image_symbol_fn_t)(const char *symbol, hb_mc_eva_t eva, void *arg);
+
+        /**
+         * Call a function for each symbol of a program image, in no particular order.
+         * @param[in]  image An image returned by hb_mc_program_image_open() or hb_mc_program_image_from_buffer()
+         * @param[in]  fn    A function to call with each symbol
+         * @param[in]  arg   An argument passed to #fn
+         * @return HB_MC_SUCCESS if succesful. HB_MC_INVALID if #image holds a load image.
+         * Otherwise the first error returned by #fn.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_program_image_foreach_symbol(const hb_mc_program_image_t *image,
+                                               hb_mc_program_image_symbol_fn_t fn,
+                                               void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
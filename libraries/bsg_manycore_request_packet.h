@@ -70,6 +70,7 @@ extern "C" {
         typedef enum __hb_mc_packet_op_t {
                 HB_MC_PACKET_OP_REMOTE_LOAD  = 0,
                 HB_MC_PACKET_OP_REMOTE_STORE = 1,
+                HB_MC_PACKET_OP_REMOTE_AMO   = 2, // SWAP, ADD, XOR, AND, OR, MIN, MAX, MINU, MAXU
                 HB_MC_PACKET_OP_CACHE_OP     = 3, // AFL, AINV, AFLINV
         } hb_mc_packet_op_t;
 
@@ -80,6 +81,18 @@ extern "C" {
                 HB_MC_PACKET_CACHE_OP_TAGFL  = 3, //!< flush tag
         } hb_mc_packet_cache_op_t;
 
+        typedef enum __hb_mc_packet_amo {
+                HB_MC_PACKET_AMO_SWAP = 0, //!< store the operand
+                HB_MC_PACKET_AMO_ADD  = 1, //!< add the operand
+                HB_MC_PACKET_AMO_XOR  = 2, //!< xor with the operand
+                HB_MC_PACKET_AMO_AND  = 3, //!< and with the operand
+                HB_MC_PACKET_AMO_OR   = 4, //!< or with the operand
+                HB_MC_PACKET_AMO_MIN  = 5, //!< signed minimum with the operand
+                HB_MC_PACKET_AMO_MAX  = 6, //!< signed maximum with the operand
+                HB_MC_PACKET_AMO_MINU = 7, //!< unsigned minimum with the operand
+                HB_MC_PACKET_AMO_MAXU = 8, //!< unsigned maximum with the operand
+        } hb_mc_packet_amo_t;
+
         typedef enum __hb_mc_packet_mask_t {
                 HB_MC_PACKET_REQUEST_MASK_BYTE  = 0x1,
                 HB_MC_PACKET_REQUEST_MASK_SHORT = 0x3,
@@ -154,6 +167,16 @@ extern "C" {
             return packet->op_ex;
         }
 
+        /**
+         * Get the atomic opcode of a request packet (valid if this is an AMO)
+         * @param[in] packet a request packet
+         * @return the extended atomic opcode
+         */
+        static inline uint8_t hb_mc_request_packet_get_amo(const hb_mc_request_packet_t *packet)
+        {
+                return packet->op_ex;
+        }
+
         /**
          * Get the opcode of a request packet
          * @param[in] packet a request packet
@@ -270,6 +293,17 @@ extern "C" {
                 packet->op_ex = op;
         }
 
+        /**
+         * Set the atomic opcode in a request packet
+         * @param[in] packet a request packet
+         * @param[in] amo    an atomic opcode
+         */
+        static inline void hb_mc_request_packet_set_amo(hb_mc_request_packet_t *packet,
+                                                        hb_mc_packet_amo_t amo)
+        {
+                packet->op_ex = amo;
+        }
+
         /**
          * Set the opcode in a request packet
          * @param[in] packet a request packet
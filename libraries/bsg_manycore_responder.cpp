@@ -28,11 +28,30 @@
 #include <bsg_manycore_responder.h>
 #include <bsg_manycore_errno.h>
 #include <list>
+#include <memory>
+#include <mutex>
 #include <stdint.h>
 
 typedef std::list<hb_mc_responder_t *> responder_list;
 
-static responder_list *responders = nullptr;
+// The responder list is never changed in place: hb_mc_responder_add()
+// and hb_mc_responder_del() publish a new list. Callbacks run on a
+// snapshot with the mutex released, so they may add or remove
+// responders; a responder removed by a callback can still receive the
+// packet being dispatched.
+static std::shared_ptr<const responder_list> responders;
+
+// Guards the responder list pointer, which may be changed from any thread.
+// std::mutex and std::shared_ptr are constant-initialized, so responders
+// registered by static constructors in other translation units can
+// safely take it.
+static std::mutex responders_mutex;
+
+static std::shared_ptr<const responder_list> hb_mc_responders_snapshot()
+{
+        std::lock_guard<std::mutex> lock(responders_mutex);
+        return responders;
+}
 
 int hb_mc_responder_init(hb_mc_responder_t *responder, hb_mc_manycore_t *mc)
 {
@@ -49,6 +68,7 @@ int hb_mc_responder_init(hb_mc_responder_t *responder, hb_mc_manycore_t *mc)
 
 int hb_mc_responders_init(hb_mc_manycore_t *mc)
 {
+        auto responders = hb_mc_responders_snapshot();
         if (responders == nullptr)
                 return HB_MC_SUCCESS; //  no responders
 
@@ -80,6 +100,7 @@ int hb_mc_responder_quit(hb_mc_responder_t *responder, hb_mc_manycore_t *mc)
 int hb_mc_responders_quit(hb_mc_manycore_t *mc)
 {
         int err;
+        auto responders = hb_mc_responders_snapshot();
 
         if (responders == nullptr)
                 return HB_MC_SUCCESS; // no responders
@@ -121,6 +142,7 @@ static int hb_mc_responder_respond(hb_mc_responder_t *responder,
 int hb_mc_responders_respond(hb_mc_manycore_t *mc, const hb_mc_request_packet_t *rqst)
 {
         int err;
+        auto responders = hb_mc_responders_snapshot();
 
         if (responders == nullptr)
                 return HB_MC_SUCCESS; // no responders
@@ -139,18 +161,24 @@ int hb_mc_responders_respond(hb_mc_manycore_t *mc, const hb_mc_request_packet_t
 
 int hb_mc_responder_add(hb_mc_responder_t *responder)
 {
-        if (responders == nullptr)
-                responders = new responder_list;
+        std::lock_guard<std::mutex> lock(responders_mutex);
+        auto next = responders == nullptr ?
+                std::make_shared<responder_list>() :
+                std::make_shared<responder_list>(*responders);
 
-        responders->push_front(responder);
+        next->push_front(responder);
+        responders = next;
         return HB_MC_SUCCESS;
 }
 
 int hb_mc_responder_del(hb_mc_responder_t *responder)
 {
+        std::lock_guard<std::mutex> lock(responders_mutex);
         if (responders == nullptr)
                 return HB_MC_FAIL;
 
-        responders->remove(responder);
+        auto next = std::make_shared<responder_list>(*responders);
+        next->remove(responder);
+        responders = next;
         return HB_MC_SUCCESS;
 }
@@ -135,6 +135,9 @@ extern "C" {
          * Remove a responder from the global list of responders.
          * @param[in] responder  A responder to remove. This ** MUST ** have been cleanuped up with hb_mc_responder_quit().
          * @return HB_MC_SUCCESS if succesful. An error code otherwise.
+         *
+         * Responder callbacks may add and remove responders. A responder removed
+         * by a callback may still receive the packet that is being dispatched.
          */
         __attribute__((warn_unused_result))
         int hb_mc_responder_del(hb_mc_responder_t *responder);
@@ -28,10 +28,13 @@
 #include <bsg_manycore_tile.h> 
 #include <bsg_manycore_epa.h>
 #include <bsg_manycore_loader.h>
+#include <bsg_manycore_platform.h>
 
 
 #ifdef __cplusplus
+#include <cinttypes>
 #include <cstdio>
+#include <vector>
 #else
 #include <stdio.h>
 #endif
@@ -178,4 +181,136 @@ int hb_mc_tile_set_origin_registers(hb_mc_manycore_t *mc,
         return HB_MC_SUCCESS; 
 }
 
+/**
+ * Write a sequence of CSRs on a list of tiles.
+ * Behavior is undefined if #mc is not initialized with hb_mc_manycore_init().
+ * @param[in] mc      A manycore instance initialized with hb_mc_manycore_init().
+ * @param[in] tiles   A list of tiles.
+ * @param[in] ntiles  The number of tiles in #tiles.
+ * @param[in] writes  The CSR stores to issue to every tile, in order.
+ * @param[in] nwrites The number of stores in #writes.
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_tiles_write_csrs(hb_mc_manycore_t *mc,
+                           const hb_mc_coordinate_t *tiles, uint32_t ntiles,
+                           const hb_mc_tile_csr_write_t *writes, uint32_t nwrites)
+{
+        int err = HB_MC_SUCCESS;
+
+        hb_mc_platform_start_bulk_transfer(mc);
+
+        // issue each store to every tile before the next one: requests from the
+        // host to a tile arrive in order, so a tile never sees writes[i+1] first
+        for (uint32_t w = 0; w < nwrites && err == HB_MC_SUCCESS; w++) {
+                for (uint32_t t = 0; t < ntiles; t++) {
+                        hb_mc_npa_t npa = hb_mc_npa(tiles[t], writes[w].csr);
+                        err = hb_mc_manycore_write32(mc, &npa, writes[w].val);
+                        if (err != HB_MC_SUCCESS) {
+                                bsg_pr_err("%s: failed to write CSR 0x%08" PRIx32 " of tile (%d,%d): %s\n",
+                                           __func__, writes[w].csr,
+                                           hb_mc_coordinate_get_x(tiles[t]),
+                                           hb_mc_coordinate_get_y(tiles[t]),
+                                           hb_mc_strerror(err));
+                                break;
+                        }
+                }
+        }
+
+        if (err == HB_MC_SUCCESS)
+                err = hb_mc_manycore_host_request_fence(mc, -1);
+
+        hb_mc_platform_finish_bulk_transfer(mc);
+        return err;
+}
+
+/**
+ * Write a sequence of CSRs on a rectangle of tiles.
+ * Behavior is undefined if #mc is not initialized with hb_mc_manycore_init().
+ * @param[in] mc      A manycore instance initialized with hb_mc_manycore_init().
+ * @param[in] origin  The top-left tile of the rectangle.
+ * @param[in] dim     The dimensions of the rectangle.
+ * @param[in] writes  The CSR stores to issue to every tile, in order.
+ * @param[in] nwrites The number of stores in #writes.
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_tile_rect_write_csrs(hb_mc_manycore_t *mc,
+                               const hb_mc_coordinate_t *origin,
+                               hb_mc_dimension_t dim,
+                               const hb_mc_tile_csr_write_t *writes, uint32_t nwrites)
+{
+        std::vector<hb_mc_coordinate_t> tiles;
+
+        for (hb_mc_idx_t y = 0; y < hb_mc_dimension_get_y(dim); y++)
+                for (hb_mc_idx_t x = 0; x < hb_mc_dimension_get_x(dim); x++)
+                        tiles.push_back(hb_mc_coordinate(hb_mc_coordinate_get_x(*origin) + x,
+                                                         hb_mc_coordinate_get_y(*origin) + y));
 
+        return hb_mc_tiles_write_csrs(mc, tiles.data(), tiles.size(), writes, nwrites);
+}
+
+/**
+ * Freeze a list of tiles with a single fence.
+ * Behavior is undefined if #mc is not initialized with hb_mc_manycore_init().
+ * @param[in] mc      A manycore instance initialized with hb_mc_manycore_init().
+ * @param[in] tiles   A list of tiles to freeze.
+ * @param[in] ntiles  The number of tiles in #tiles.
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_tiles_freeze(hb_mc_manycore_t *mc,
+                       const hb_mc_coordinate_t *tiles, uint32_t ntiles)
+{
+        hb_mc_tile_csr_write_t w = { HB_MC_TILE_EPA_CSR_FREEZE, HB_MC_CSR_FREEZE };
+        return hb_mc_tiles_write_csrs(mc, tiles, ntiles, &w, 1);
+}
+
+/**
+ * Unfreeze a list of tiles with a single fence.
+ * Behavior is undefined if #mc is not initialized with hb_mc_manycore_init().
+ * @param[in] mc      A manycore instance initialized with hb_mc_manycore_init().
+ * @param[in] tiles   A list of tiles to unfreeze.
+ * @param[in] ntiles  The number of tiles in #tiles.
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_tiles_unfreeze(hb_mc_manycore_t *mc,
+                         const hb_mc_coordinate_t *tiles, uint32_t ntiles)
+{
+        hb_mc_tile_csr_write_t w = { HB_MC_TILE_EPA_CSR_FREEZE, HB_MC_CSR_UNFREEZE };
+        return hb_mc_tiles_write_csrs(mc, tiles, ntiles, &w, 1);
+}
+
+/**
+ * Set the origin of a list of tiles with a single fence.
+ * Behavior is undefined if #mc is not initialized with hb_mc_manycore_init().
+ * @param[in] mc      A manycore instance initialized with hb_mc_manycore_init().
+ * @param[in] tiles   A list of tiles to set the origin of.
+ * @param[in] ntiles  The number of tiles in #tiles.
+ * @param[in] o       The origin tile
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_tiles_set_origin(hb_mc_manycore_t *mc,
+                           const hb_mc_coordinate_t *tiles, uint32_t ntiles,
+                           const hb_mc_coordinate_t *o)
+{
+        hb_mc_tile_csr_write_t w [] = {
+                { HB_MC_TILE_EPA_CSR_TILE_GROUP_ORIGIN_X, hb_mc_coordinate_get_x(*o) },
+                { HB_MC_TILE_EPA_CSR_TILE_GROUP_ORIGIN_Y, hb_mc_coordinate_get_y(*o) },
+        };
+        return hb_mc_tiles_write_csrs(mc, tiles, ntiles, w, 2);
+}
+
+/**
+ * Set or clear the DRAM enabled bit of a list of tiles with a single fence.
+ * Behavior is undefined if #mc is not initialized with hb_mc_manycore_init().
+ * @param[in] mc      A manycore instance initialized with hb_mc_manycore_init().
+ * @param[in] tiles   A list of tiles.
+ * @param[in] ntiles  The number of tiles in #tiles.
+ * @param[in] enabled Non-zero to set the bit, zero to clear it.
+ * @return HB_MC_SUCCESS if successful. Otherwise an error code is returned.
+ */
+int hb_mc_tiles_write_dram_enabled(hb_mc_manycore_t *mc,
+                                   const hb_mc_coordinate_t *tiles, uint32_t ntiles,
+                                   int enabled)
+{
+        hb_mc_tile_csr_write_t w = { HB_MC_TILE_EPA_CSR_DRAM_ENABLE, enabled ? 1u : 0u };
+        return hb_mc_tiles_write_csrs(mc, tiles, ntiles, &w, 1);
+}
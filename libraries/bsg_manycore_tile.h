@@ -160,6 +160,103 @@ extern "C" {
         __attribute__((warn_unused_result))
         int hb_mc_tile_clear_dram_enabled(hb_mc_manycore_t *mc, const hb_mc_coordinate_t *tile);
 
+        /**
+         * A CSR store to be issued to a set of tiles.
+         */
+        typedef struct hb_mc_tile_csr_write {
+                hb_mc_epa_t csr; //!< The CSR's EPA, e.g. HB_MC_TILE_EPA_CSR_FREEZE
+                uint32_t    val; //!< The value to store
+        } hb_mc_tile_csr_write_t;
+
+        /**
+         * Write a sequence of CSRs on a list of tiles.
+         * Behavior is undefined if #mc is not initialized with hb_mc_manycore_init().
+         * @param[in] mc      A manycore instance initialized with hb_mc_manycore_init().
+         * @param[in] tiles   A list of tiles.
+         * @param[in] ntiles  The number of tiles in #tiles.
+         * @param[in] writes  The CSR stores to issue to every tile, in order.
+         * @param[in] nwrites The number of stores in #writes.
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         *
+         * All stores are sent as one packet stream followed by a single fence.
+         * Every tile receives writes[i] before writes[i+1], so e.g. origin and
+         * DRAM-enable stores placed ahead of an unfreeze take effect first.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_tiles_write_csrs(hb_mc_manycore_t *mc,
+                                   const hb_mc_coordinate_t *tiles, uint32_t ntiles,
+                                   const hb_mc_tile_csr_write_t *writes, uint32_t nwrites);
+
+        /**
+         * Write a sequence of CSRs on a rectangle of tiles.
+         * Behavior is undefined if #mc is not initialized with hb_mc_manycore_init().
+         * @param[in] mc      A manycore instance initialized with hb_mc_manycore_init().
+         * @param[in] origin  The top-left tile of the rectangle.
+         * @param[in] dim     The dimensions of the rectangle.
+         * @param[in] writes  The CSR stores to issue to every tile, in order.
+         * @param[in] nwrites The number of stores in #writes.
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         *
+         * See hb_mc_tiles_write_csrs().
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_tile_rect_write_csrs(hb_mc_manycore_t *mc,
+                                       const hb_mc_coordinate_t *origin,
+                                       hb_mc_dimension_t dim,
+                                       const hb_mc_tile_csr_write_t *writes, uint32_t nwrites);
+
+        /**
+         * Freeze a list of tiles with a single fence.
+         * Behavior is undefined if #mc is not initialized with hb_mc_manycore_init().
+         * @param[in] mc      A manycore instance initialized with hb_mc_manycore_init().
+         * @param[in] tiles   A list of tiles to freeze.
+         * @param[in] ntiles  The number of tiles in #tiles.
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_tiles_freeze(hb_mc_manycore_t *mc,
+                               const hb_mc_coordinate_t *tiles, uint32_t ntiles);
+
+        /**
+         * Unfreeze a list of tiles with a single fence.
+         * Behavior is undefined if #mc is not initialized with hb_mc_manycore_init().
+         * @param[in] mc      A manycore instance initialized with hb_mc_manycore_init().
+         * @param[in] tiles   A list of tiles to unfreeze.
+         * @param[in] ntiles  The number of tiles in #tiles.
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_tiles_unfreeze(hb_mc_manycore_t *mc,
+                                 const hb_mc_coordinate_t *tiles, uint32_t ntiles);
+
+        /**
+         * Set the origin of a list of tiles with a single fence.
+         * Behavior is undefined if #mc is not initialized with hb_mc_manycore_init().
+         * @param[in] mc      A manycore instance initialized with hb_mc_manycore_init().
+         * @param[in] tiles   A list of tiles to set the origin of.
+         * @param[in] ntiles  The number of tiles in #tiles.
+         * @param[in] o       The origin tile
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_tiles_set_origin(hb_mc_manycore_t *mc,
+                                   const hb_mc_coordinate_t *tiles, uint32_t ntiles,
+                                   const hb_mc_coordinate_t *o);
+
+        /**
+         * Set or clear the DRAM enabled bit of a list of tiles with a single fence.
+         * Behavior is undefined if #mc is not initialized with hb_mc_manycore_init().
+         * @param[in] mc      A manycore instance initialized with hb_mc_manycore_init().
+         * @param[in] tiles   A list of tiles.
+         * @param[in] ntiles  The number of tiles in #tiles.
+         * @param[in] enabled Non-zero to set the bit, zero to clear it.
+         * @return HB_MC_SUCCESS if successful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_tiles_write_dram_enabled(hb_mc_manycore_t *mc,
+                                           const hb_mc_coordinate_t *tiles, uint32_t ntiles,
+                                           int enabled);
+
         /****************************************************************************************/
         /* TODO: these should actually check if there's a vanilla core at the given tile.       */
         /* At the moment that would mean checking the coordinates according to a static config. */
@@ -28,7 +28,9 @@
 #include <bsg_manycore_responder.h>
 #include <bsg_manycore_request_packet_id.h>
 #include <bsg_manycore_printing.h>
+#include <bsg_manycore_branch_trace.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 enum hb_mc_trace_epa_indx {
         BRANCH_TRACE_EPA_INDX, 
@@ -39,6 +41,12 @@ enum hb_mc_trace_epa_indx {
 typedef struct {
         FILE* f;
         const char* type;
+        // if set, records go to this binary trace instead of f
+        hb_mc_branch_trace_writer_t *writer;
+        // read the cycle counter once every cycle_period records
+        unsigned long cycle_period;
+        unsigned long cycle_age;
+        uint64_t cycle;
 } trace_config_t;
 
 static hb_mc_request_packet_id_t ids [] = {
@@ -47,7 +55,8 @@ static hb_mc_request_packet_id_t ids [] = {
 };
 
 static trace_config_t trace_config [] = {
-        {.f = stderr, .type = "branch"},
+        {.f = stderr, .type = "branch", .writer = nullptr,
+         .cycle_period = 1, .cycle_age = 0, .cycle = 0},
 };
 
 static int init(hb_mc_responder_t *responder,
@@ -55,15 +64,48 @@ static int init(hb_mc_responder_t *responder,
 {
         bsg_pr_dbg("hello from %s\n", __FILE__);
         responder->responder_data = trace_config;
+
+        const char *period = getenv(HB_MC_BRANCH_TRACE_CYCLE_PERIOD_ENV);
+        if (period && *period) {
+                char *end;
+                unsigned long n = strtoul(period, &end, 0);
+                if (*end != '\0') {
+                        bsg_pr_err("%s: bad %s '%s'\n", __func__,
+                                   HB_MC_BRANCH_TRACE_CYCLE_PERIOD_ENV, period);
+                        return HB_MC_INVALID;
+                }
+                for (int i = 0; i < HB_MC_NUM_TRACE_EPAS; i++)
+                        trace_config[i].cycle_period = n;
+        }
+
+        const char *path = getenv(HB_MC_BRANCH_TRACE_ENV);
+        if (path && *path) {
+                int err = hb_mc_branch_trace_writer_open(path,
+                                                         &trace_config[BRANCH_TRACE_EPA_INDX].writer);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+        }
+
         return 0;
 }
 
 static int quit(hb_mc_responder_t *responder,
                 hb_mc_manycore_t *mc)
 {
+        int err = HB_MC_SUCCESS;
+
         bsg_pr_dbg("goodbye from %s\n", __FILE__);
+        for (int i = 0; i < HB_MC_NUM_TRACE_EPAS; i++) {
+                if (trace_config[i].writer == nullptr)
+                        continue;
+
+                if (hb_mc_branch_trace_writer_close(trace_config[i].writer) != HB_MC_SUCCESS)
+                        err = HB_MC_FAIL;
+                trace_config[i].writer = nullptr;
+        }
+
         responder->responder_data = nullptr;
-        return 0;
+        return err;
 }
 
 static int respond(hb_mc_responder_t *responder,
@@ -76,7 +118,20 @@ static int respond(hb_mc_responder_t *responder,
 
         for(int i=0; i<HB_MC_NUM_TRACE_EPAS; i++) {
                 if(hb_mc_request_packet_is_match(rqst, &responder->ids[i])) {
-                        trace_config_t config = ((trace_config_t*) responder->responder_data)[i];
+                        trace_config_t &config = ((trace_config_t*) responder->responder_data)[i];
+                        if (config.writer != nullptr) {
+                                hb_mc_branch_trace_record_t record;
+                                if (config.cycle_period != 0 && config.cycle_age++ % config.cycle_period == 0) {
+                                        int err = hb_mc_manycore_get_cycle(mc, &config.cycle);
+                                        if (err != HB_MC_SUCCESS)
+                                                return err;
+                                }
+                                record.cycle = config.cycle;
+                                record.x = src_x;
+                                record.y = src_y;
+                                record.data = data;
+                                return hb_mc_branch_trace_writer_append(config.writer, &record);
+                        }
                         fprintf(config.f, 
                                 "hbmc_%s_trace x=%d y=%d data=%x\n", 
                                 config.type, src_x, src_y, (int)data);
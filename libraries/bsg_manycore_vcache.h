@@ -145,6 +145,48 @@ hb_mc_epa_t hb_mc_vcache_num_caches(const hb_mc_manycore_t *mc)
         return hb_mc_config_get_num_dram_coordinates(cfg);
 }
 
+/**
+ * Count the cache lines that a range of DRAM touches
+ * @param[in]  mc     An initialized manycore struct
+ * @param[in]  npa    Start of the range
+ * @param[in]  sz     Size of the range in bytes
+ * @return The number of lines, including partially covered lines at either end.
+ */
+static
+size_t hb_mc_vcache_num_lines(const hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, size_t sz)
+{
+        if (sz == 0)
+                return 0;
+
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        size_t bsize = hb_mc_config_get_vcache_block_size(cfg);
+        size_t epa = hb_mc_npa_get_epa(npa);
+
+        return (epa + sz - 1) / bsize - epa / bsize + 1;
+}
+
+/**
+ * Decide how to keep the victim caches coherent around a DMA transfer
+ * @param[in]  mc     An initialized manycore struct
+ * @param[in]  lines  The number of cache lines that per-line maintenance would touch
+ * @return One if flushing and invalidating the whole cache is cheaper - Zero otherwise.
+ *
+ * Per-line maintenance costs one packet per line; whole-cache maintenance
+ * costs one packet per way of each set of each cache, twice.
+ */
+static
+int hb_mc_vcache_whole_cache_is_cheaper(hb_mc_manycore_t *mc, size_t lines)
+{
+        if (!hb_mc_manycore_has_cache(mc))
+                return 0;
+
+        size_t ways = (size_t)hb_mc_vcache_num_ways(mc)
+                * hb_mc_vcache_num_sets(mc)
+                * hb_mc_vcache_num_caches(mc);
+
+        return lines > 2 * ways;
+}
+
 static
 hb_mc_epa_t hb_mc_vcache_tag_epa(const hb_mc_manycore *mc, uint32_t tag)
 {
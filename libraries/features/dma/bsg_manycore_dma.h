@@ -49,4 +49,56 @@ int hb_mc_dma_write(hb_mc_manycore_t *mc,
                     const hb_mc_npa_t *npa,
                     const void *data, size_t sz);
 
+/**
+ * Get a host pointer to manycore DRAM via C++ backdoor
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  npa    A valid hb_mc_npa_t - must be an L2 cache coordinate
+ * @param[in]  sz     The number of bytes that will be accessed through the pointer
+ * @param[out] ptr    Set to the host address of #npa in the DRAM backing store
+ * @return HB_MC_INVALID if the #sz bytes at #npa are not contiguous in the backing store.
+ * HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ */
+int hb_mc_dma_map(hb_mc_manycore_t *mc,
+                  const hb_mc_npa_t *npa,
+                  size_t sz, void **ptr);
+
+/**
+ * Write a list of segments out to manycore DRAM via C++ backdoor
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  segs   Segments to write; host is the source of each
+ * @param[in]  nsegs  The number of segments in #segs
+ * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ */
+int hb_mc_dma_write_segments(hb_mc_manycore_t *mc,
+                             const hb_mc_dma_segment_t *segs,
+                             size_t nsegs);
+
+/**
+ * Read a list of segments from manycore DRAM via C++ backdoor
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  segs   Segments to read; host is the destination of each
+ * @param[in]  nsegs  The number of segments in #segs
+ * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ */
+int hb_mc_dma_read_segments(hb_mc_manycore_t *mc,
+                            const hb_mc_dma_segment_t *segs,
+                            size_t nsegs);
+
+
+/**
+ * Save the contents of manycore DRAM held by the C++ backdoor to a file
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  path   The file to write
+ * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ */
+int hb_mc_dma_checkpoint_save(hb_mc_manycore_t *mc, const char *path);
+
+/**
+ * Restore the contents of manycore DRAM held by the C++ backdoor from a file
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  path   A file written by hb_mc_dma_checkpoint_save()
+ * @return HB_MC_NOTFOUND if the file cannot be restored on this machine. HB_MC_SUCCESS otherwise.
+ */
+int hb_mc_dma_checkpoint_restore(hb_mc_manycore_t *mc, const char *path);
+
 #endif
@@ -58,3 +58,109 @@ int __attribute__((weak)) hb_mc_dma_read(hb_mc_manycore_t *mc,
                         __func__);
         return HB_MC_NOIMPL;
 }
+
+
+/**
+ * Get a host pointer to manycore DRAM
+ *
+ * NOTE: This method is declared with __attribute__((weak)) so that
+ * only platforms whose DRAM lives in host memory need to define it.
+ *
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  npa    A valid hb_mc_npa_t - must be an L2 cache coordinate
+ * @param[in]  sz     The number of bytes that will be accessed through the pointer
+ * @param[out] ptr    Set to the host address of #npa
+ * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ */
+int __attribute__((weak)) hb_mc_dma_map(hb_mc_manycore_t *mc,
+                  const hb_mc_npa_t *npa,
+                  size_t sz, void **ptr)
+{
+        dma_pr_err(mc, "%s: This function is not supported on this platform\n",
+                        __func__);
+        return HB_MC_NOIMPL;
+}
+
+
+/**
+ * Write a list of segments out to manycore DRAM via DMA
+ *
+ * NOTE: This method is declared with __attribute__((weak)). Platforms
+ * that can do better than one hb_mc_dma_write() per segment should
+ * define it.
+ *
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  segs   Segments to write; host is the source of each
+ * @param[in]  nsegs  The number of segments in #segs
+ * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ */
+int __attribute__((weak)) hb_mc_dma_write_segments(hb_mc_manycore_t *mc,
+                                                   const hb_mc_dma_segment_t *segs,
+                                                   size_t nsegs)
+{
+        for (size_t i = 0; i < nsegs; i++) {
+                int err = hb_mc_dma_write(mc, &segs[i].npa, segs[i].host, segs[i].sz);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+        }
+        return HB_MC_SUCCESS;
+}
+
+
+/**
+ * Read a list of segments from manycore DRAM via DMA
+ *
+ * NOTE: This method is declared with __attribute__((weak)). Platforms
+ * that can do better than one hb_mc_dma_read() per segment should
+ * define it.
+ *
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  segs   Segments to read; host is the destination of each
+ * @param[in]  nsegs  The number of segments in #segs
+ * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ */
+int __attribute__((weak)) hb_mc_dma_read_segments(hb_mc_manycore_t *mc,
+                                                  const hb_mc_dma_segment_t *segs,
+                                                  size_t nsegs)
+{
+        for (size_t i = 0; i < nsegs; i++) {
+                int err = hb_mc_dma_read(mc, &segs[i].npa, segs[i].host, segs[i].sz);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+        }
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Save the contents of manycore DRAM held by the host to a file
+ *
+ * NOTE: This method is declared with __attribute__((weak)) so that
+ * only platforms whose DRAM lives in host memory need to define it.
+ *
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  path   The file to write
+ * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ */
+int __attribute__((weak)) hb_mc_dma_checkpoint_save(hb_mc_manycore_t *mc, const char *path)
+{
+        dma_pr_err(mc, "%s: This function is not supported on this platform\n",
+                        __func__);
+        return HB_MC_NOIMPL;
+}
+
+/**
+ * Restore the contents of manycore DRAM held by the host from a file
+ *
+ * NOTE: This method is declared with __attribute__((weak)) so that
+ * only platforms whose DRAM lives in host memory need to define it.
+ *
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  path   A file written by hb_mc_dma_checkpoint_save()
+ * @return HB_MC_NOTFOUND if the file cannot be restored on this machine. HB_MC_SUCCESS otherwise.
+ */
+int __attribute__((weak)) hb_mc_dma_checkpoint_restore(hb_mc_manycore_t *mc, const char *path)
+{
+        dma_pr_err(mc, "%s: This function is not supported on this platform\n",
+                        __func__);
+        return HB_MC_NOIMPL;
+}
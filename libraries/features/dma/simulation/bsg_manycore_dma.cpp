@@ -2,6 +2,13 @@
 #include <bsg_mem_dma.hpp>
 #include <bsg_manycore_vcache.h>
 #include <bsg_manycore_printing.h>
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <thread>
+#include <vector>
 /* these are convenience macros that are only good for one line prints */
 #define dma_pr_dbg(mc, fmt, ...)                   \
         bsg_pr_dbg("%s: " fmt, mc->name, ##__VA_ARGS__)
@@ -17,16 +24,50 @@
 
 using namespace bsg_mem_dma;
 
+/**
+ * Get the number of low address bits that the physical channel mapping
+ * leaves in place: cache addresses that agree above these bits map to
+ * a contiguous run of channel addresses.
+ * @param[in]  memsys A memory system description
+ * @return The number of contiguous low bits.
+ */
+static unsigned hb_mc_dma_contiguous_bits(const hb_mc_memsys_t *memsys)
+{
+        if (memsys->id != HB_MC_MEMSYS_ID_DRAMSIM3)
+                return 8 * sizeof(address_t) - 1;
+
+        // dramsim3 packs the fields as ro,bg,ba,co,byte_offset from
+        // the MSB: the identity holds for as long as each field comes
+        // from the bits right above the previous one.
+        const hb_mc_dram_pa_bitfield *fields[] = {
+                &memsys->dram_byte_offset,
+                &memsys->dram_co,
+                &memsys->dram_ba,
+                &memsys->dram_bg,
+                &memsys->dram_ro,
+        };
+
+        unsigned bits = 0;
+        for (const hb_mc_dram_pa_bitfield *f : fields) {
+                if (f->bitidx != bits)
+                        break;
+                bits += f->bits;
+        }
+        return bits;
+}
+
 /**
  * Given an NPA that maps to DRAM, return a buffer that holds the data for that address.
  * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
  * @param[in]  npa    A valid hb_mc_npa_t - must be an L2 cache coordinate
  * @param[in]  sz     The number of bytes to write to manycore hardware - used for sanity check
  * @param[out] buffer The valid buffer
+ * @param[out] contiguous  If not nullptr, set to the number of bytes at #buffer that are
+ *                         contiguous in the channel
  * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
  */
 static int hb_mc_dma_npa_to_buffer(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, size_t sz,
-                                        unsigned char **buffer)
+                                        unsigned char **buffer, size_t *contiguous = nullptr)
 {
         /*
           Our system supports having multiple caches per memory channel.
@@ -60,8 +101,6 @@ static int hb_mc_dma_npa_to_buffer(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa,
           Use the backdoor to our non-synthesizable memory.
         */
         Memory *memory = bsg_mem_dma_get_memory(id);
-        parameter_t bank_size = memory->_data.size()/caches_per_channel;
-
         hb_mc_epa_t epa = hb_mc_npa_get_epa(npa);
         char npa_str[256];
 
@@ -72,6 +111,8 @@ static int hb_mc_dma_npa_to_buffer(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa,
                 return HB_MC_FAIL;
         }
 
+        parameter_t bank_size = memory->_data.size()/caches_per_channel;
+
         // this is the address that comes out of cache_to_test_dram_tx
         address_t cache_addr = bank*bank_size + epa;
         address_t addr = hb_mc_memsys_map_to_physical_channel_address(&cfg->memsys, cache_addr);
@@ -80,6 +121,22 @@ static int hb_mc_dma_npa_to_buffer(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa,
         dma_pr_dbg(mc, "%s: Mapped %s to Channel %2lu, Address 0x%08lx\n",
                         __func__, hb_mc_npa_to_string(npa, npa_str, sizeof(npa_str)), id, addr);
 
+        if (epa >= bank_size) {
+                dma_pr_err(mc, "%s: %s is past the end of its bank\n",
+                                __func__, hb_mc_npa_to_string(npa, npa_str, sizeof(npa_str)));
+                return HB_MC_INVALID;
+        }
+
+        if (contiguous != nullptr) {
+                // the bytes after a granule, or after the end of the
+                // bank, belong to another address in the backing store
+                address_t granule = (address_t)1 << hb_mc_dma_contiguous_bits(&cfg->memsys);
+                *contiguous = std::min<address_t>(granule - (cache_addr & (granule - 1)),
+                                                  bank_size - epa);
+                // hb_mc_dma_map() refuses a larger range
+                sz = std::min(sz, *contiguous);
+        }
+
         /*
           Don't overflow memory if you can help it.
         */
@@ -90,6 +147,40 @@ static int hb_mc_dma_npa_to_buffer(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa,
         return HB_MC_SUCCESS;
 }
 
+/**
+ * Get a host pointer to manycore DRAM via C++ backdoor
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  npa    A valid hb_mc_npa_t - must be an L2 cache coordinate
+ * @param[in]  sz     The number of bytes that will be accessed through the pointer
+ * @param[out] ptr    Set to the host address of #npa in the DRAM backing store
+ * @return HB_MC_INVALID if the #sz bytes at #npa are not contiguous in the backing store.
+ * HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ */
+int hb_mc_dma_map(hb_mc_manycore_t *mc,
+                  const hb_mc_npa_t *npa,
+                  size_t sz, void **ptr)
+{
+        unsigned char *membuffer;
+        size_t contiguous;
+        int err = hb_mc_dma_npa_to_buffer(mc, npa, sz, &membuffer, &contiguous);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        // a memory system that permutes addresses (DRAMSim3) only keeps
+        // small granules of a bank together in the backing store
+        if (sz > contiguous) {
+                char npa_str[256];
+                dma_pr_err(mc, "%s: %zu bytes at %s are not contiguous in host memory "
+                           "(at most %zu are)\n", __func__, sz,
+                           hb_mc_npa_to_string(npa, npa_str, sizeof(npa_str)), contiguous);
+                return HB_MC_INVALID;
+        }
+
+        *ptr = membuffer;
+
+        return HB_MC_SUCCESS;
+}
+
 /**
  * Write memory out to manycore DRAM via C++ backdoor
  * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
@@ -145,3 +236,268 @@ int hb_mc_dma_read(hb_mc_manycore_t *mc,
         return HB_MC_SUCCESS;
 }
 
+
+
+/*
+ * Segment lists are planned before any data moves. Each segment is
+ * split where its DRAM channel address stops being contiguous, and
+ * runs that are adjacent on both the host and the channel are merged.
+ * Large plans are divided by bytes among worker threads.
+ */
+
+// plans with fewer bytes than this are copied on the calling thread
+#define HB_MC_DMA_PARALLEL_MIN_BYTES (1 << 20)
+// most threads a single plan will use
+#define HB_MC_DMA_MAX_THREADS 8
+
+typedef struct hb_mc_dma_run {
+        unsigned char *dram; //!< host address in the DRAM backing store
+        unsigned char *host; //!< host address in the user's buffer
+        size_t sz;
+} hb_mc_dma_run_t;
+
+typedef struct hb_mc_dma_bank {
+        Memory *memory;      //!< channel backing store; nullptr until first use
+        address_t base;      //!< address of the bank within the channel
+} hb_mc_dma_bank_t;
+
+/**
+ * Convert a segment list into runs of contiguous memory
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  segs   Segments of the transfer
+ * @param[in]  nsegs  The number of segments in #segs
+ * @param[in]  emit   Called with each run, in segment order
+ * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ */
+template <typename EmitFunction>
+static int hb_mc_dma_plan(hb_mc_manycore_t *mc,
+                          const hb_mc_dma_segment_t *segs, size_t nsegs,
+                          EmitFunction emit)
+{
+        // see hb_mc_dma_npa_to_buffer() for how banks are laid out
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        unsigned long caches = hb_mc_vcache_num_caches(mc);
+        unsigned long channels = hb_mc_config_get_dram_channels(cfg);
+        unsigned long caches_per_channel = caches/channels;
+        address_t granule = (address_t)1 << hb_mc_dma_contiguous_bits(&cfg->memsys);
+        int identity = cfg->memsys.id != HB_MC_MEMSYS_ID_DRAMSIM3;
+
+        std::vector<hb_mc_dma_bank_t> banks(caches, hb_mc_dma_bank_t{nullptr, 0});
+        hb_mc_dma_run_t run = {nullptr, nullptr, 0};
+
+        for (size_t i = 0; i < nsegs; i++) {
+                const hb_mc_dma_segment_t *seg = &segs[i];
+                hb_mc_idx_t cache_id = hb_mc_config_get_dram_id(cfg, hb_mc_npa_get_xy(&seg->npa));
+                if (cache_id >= caches) {
+                        char npa_str[256];
+                        dma_pr_err(mc, "%s: %s is not a DRAM address\n", __func__,
+                                   hb_mc_npa_to_string(&seg->npa, npa_str, sizeof(npa_str)));
+                        return HB_MC_FAIL;
+                }
+
+                hb_mc_dma_bank_t &bank = banks[cache_id];
+                if (bank.memory == nullptr) {
+                        parameter_t id = cache_id / caches_per_channel;
+                        bank.memory = bsg_mem_dma_get_memory(id);
+                        if (bank.memory == nullptr) {
+                                dma_pr_err(mc, "%s: Could not get the memory for channel %lu\n",
+                                           __func__, (unsigned long)id);
+                                return HB_MC_FAIL;
+                        }
+                        bank.base = (cache_id % caches_per_channel)
+                                * (bank.memory->_data.size()/caches_per_channel);
+                }
+
+                address_t cache_addr = bank.base + hb_mc_npa_get_epa(&seg->npa);
+                unsigned char *host = reinterpret_cast<unsigned char*>(seg->host);
+                size_t sz = seg->sz;
+
+                while (sz > 0) {
+                        size_t xfer_sz = std::min<address_t>(sz, granule - (cache_addr & (granule - 1)));
+                        address_t addr = identity ? cache_addr
+                                : hb_mc_memsys_map_to_physical_channel_address(&cfg->memsys, cache_addr);
+                        assert(addr + xfer_sz <= bank.memory->_data.size());
+                        unsigned char *dram = bank.memory->_data.data() + addr;
+
+                        if (run.dram + run.sz == dram && run.host + run.sz == host) {
+                                run.sz += xfer_sz;
+                        } else {
+                                if (run.sz > 0)
+                                        emit(run);
+                                run = hb_mc_dma_run_t{dram, host, xfer_sz};
+                        }
+
+                        cache_addr += xfer_sz;
+                        host += xfer_sz;
+                        sz -= xfer_sz;
+                }
+        }
+
+        if (run.sz > 0)
+                emit(run);
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Copy part of a plan
+ * @param[in]  runs   Runs produced by hb_mc_dma_plan()
+ * @param[in]  first  Index of the first run to copy
+ * @param[in]  skip   Bytes of the first run to leave out
+ * @param[in]  bytes  The number of bytes to copy
+ * @param[in]  write  Non-zero to copy host to DRAM, zero for DRAM to host
+ */
+static void hb_mc_dma_copy(const hb_mc_dma_run_t *runs, size_t first,
+                           size_t skip, size_t bytes, int write)
+{
+        for (size_t i = first; bytes > 0; i++, skip = 0) {
+                size_t sz = std::min(runs[i].sz - skip, bytes);
+                if (write)
+                        memcpy(runs[i].dram + skip, runs[i].host + skip, sz);
+                else
+                        memcpy(runs[i].host + skip, runs[i].dram + skip, sz);
+                bytes -= sz;
+        }
+}
+
+/**
+ * Copy every run of a plan on #nthreads threads
+ * @param[in]  runs     Runs produced by hb_mc_dma_plan()
+ * @param[in]  bytes    The total number of bytes in #runs
+ * @param[in]  nthreads The number of threads to copy with, including the caller
+ * @param[in]  write    Non-zero to copy host to DRAM, zero for DRAM to host
+ */
+static void hb_mc_dma_execute(const std::vector<hb_mc_dma_run_t> &runs,
+                              size_t bytes, unsigned nthreads, int write)
+{
+        // Give each thread an equal share of the bytes, cutting runs
+        // where a share ends, so that a single large run is still
+        // copied in parallel. The calling thread takes the last share.
+        std::vector<std::thread> workers;
+        size_t share = bytes / nthreads;
+        size_t first = 0, skip = 0;
+        for (unsigned t = 0; t + 1 < nthreads; t++) {
+                try {
+                        workers.emplace_back(hb_mc_dma_copy, runs.data(), first, skip, share, write);
+                } catch (const std::system_error &) {
+                        hb_mc_dma_copy(runs.data(), first, skip, share, write);
+                }
+                // advance past this share
+                for (size_t left = share; left > 0; ) {
+                        size_t sz = std::min(runs[first].sz - skip, left);
+                        left -= sz;
+                        skip += sz;
+                        if (skip == runs[first].sz) {
+                                first++;
+                                skip = 0;
+                        }
+                }
+                bytes -= share;
+        }
+        hb_mc_dma_copy(runs.data(), first, skip, bytes, write);
+
+        for (std::thread &worker : workers)
+                worker.join();
+}
+
+/**
+ * Move a list of segments between the host and manycore DRAM
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  segs   Segments of the transfer
+ * @param[in]  nsegs  The number of segments in #segs
+ * @param[in]  write  Non-zero to copy host to DRAM, zero for DRAM to host
+ * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ */
+static int hb_mc_dma_transfer(hb_mc_manycore_t *mc,
+                              const hb_mc_dma_segment_t *segs, size_t nsegs,
+                              int write)
+{
+        size_t bytes = 0;
+        for (size_t i = 0; i < nsegs; i++)
+                bytes += segs[i].sz;
+
+        // Small transfers are copied as they are planned
+        unsigned nthreads = std::min<unsigned>(std::thread::hardware_concurrency(),
+                                               HB_MC_DMA_MAX_THREADS);
+        if (bytes < HB_MC_DMA_PARALLEL_MIN_BYTES || nthreads < 2) {
+                return hb_mc_dma_plan(mc, segs, nsegs, [write](const hb_mc_dma_run_t &run) {
+                                hb_mc_dma_copy(&run, 0, 0, run.sz, write);
+                        });
+        }
+
+        std::vector<hb_mc_dma_run_t> runs;
+        int err = hb_mc_dma_plan(mc, segs, nsegs, [&runs](const hb_mc_dma_run_t &run) {
+                        runs.push_back(run);
+                });
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        dma_pr_dbg(mc, "%s: planned %zu segments as %zu runs (%zu bytes)\n",
+                   __func__, nsegs, runs.size(), bytes);
+
+        hb_mc_dma_execute(runs, bytes, nthreads, write);
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Write a list of segments out to manycore DRAM via C++ backdoor
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  segs   Segments to write; host is the source of each
+ * @param[in]  nsegs  The number of segments in #segs
+ * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ */
+int hb_mc_dma_write_segments(hb_mc_manycore_t *mc,
+                             const hb_mc_dma_segment_t *segs,
+                             size_t nsegs)
+{
+        return hb_mc_dma_transfer(mc, segs, nsegs, 1);
+}
+
+/**
+ * Read a list of segments from manycore DRAM via C++ backdoor
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  segs   Segments to read; host is the destination of each
+ * @param[in]  nsegs  The number of segments in #segs
+ * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ */
+int hb_mc_dma_read_segments(hb_mc_manycore_t *mc,
+                            const hb_mc_dma_segment_t *segs,
+                            size_t nsegs)
+{
+        return hb_mc_dma_transfer(mc, segs, nsegs, 0);
+}
+
+/**
+ * Save the contents of manycore DRAM held by the C++ backdoor to a file
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  path   The file to write
+ * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ */
+int hb_mc_dma_checkpoint_save(hb_mc_manycore_t *mc, const char *path)
+{
+        if (bsg_mem_dma_save(path) != 0) {
+                dma_pr_err(mc, "%s: Failed to save DRAM to '%s': %s\n",
+                           __func__, path, strerror(errno));
+                return HB_MC_FAIL;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Restore the contents of manycore DRAM held by the C++ backdoor from a file
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  path   A file written by hb_mc_dma_checkpoint_save()
+ * @return HB_MC_NOTFOUND if the file cannot be restored on this machine. HB_MC_SUCCESS otherwise.
+ */
+int hb_mc_dma_checkpoint_restore(hb_mc_manycore_t *mc, const char *path)
+{
+        if (bsg_mem_dma_restore(path) != 0) {
+                dma_pr_err(mc, "%s: Failed to restore DRAM from '%s': %s\n",
+                           __func__, path, strerror(errno));
+                return HB_MC_NOTFOUND;
+        }
+
+        return HB_MC_SUCCESS;
+}
@@ -0,0 +1,299 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "bsg_mem_dma.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace bsg_mem_dma;
+
+static std::map<parameter_t, Memory*> memories;
+
+Store::~Store()
+{
+        if (_base != nullptr)
+                munmap(_base, _size);
+}
+
+int Store::init(size_t size, const char *image)
+{
+        // MAP_NORESERVE: don't charge the whole channel against swap up front
+        void *base = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (base == MAP_FAILED)
+                return -1;
+
+        _base = static_cast<byte_t*>(base);
+        _size = size;
+
+        if (image == nullptr)
+                return 0;
+
+        int fd = open(image, O_RDONLY);
+        if (fd < 0)
+                return errno == ENOENT ? 0 : -1; // no image: start from zero
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+                close(fd);
+                return -1;
+        }
+
+        // the tail of the last page past the end of the file reads as zero
+        size_t len = static_cast<size_t>(st.st_size) < size ? st.st_size : size;
+        if (len != 0 &&
+            mmap(_base, len, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_FIXED | MAP_NORESERVE, fd, 0) == MAP_FAILED) {
+                int e = errno;
+                close(fd);
+                errno = e;
+                return -1;
+        }
+
+        close(fd);
+        return 0;
+}
+
+int Store::clear()
+{
+        // replacing the mapping drops committed pages and any image
+        void *base = mmap(_base, _size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+        return base == MAP_FAILED ? -1 : 0;
+}
+
+Memory *bsg_mem_dma::bsg_mem_dma_get_memory(parameter_t id)
+{
+        auto it = memories.find(id);
+        return it == memories.end() ? nullptr : it->second;
+}
+
+/*
+ * Checkpoint format, in host byte order:
+ *
+ *   uint64_t magic, channels
+ *   per channel: uint64_t id, size
+ *                runs of { uint64_t offset, length; byte_t data[length] }
+ *                ending with a run of length zero
+ *
+ * Runs cover the pages that are not zero.
+ */
+static const uint64_t checkpoint_magic = 0x31414d44474d4248ull; // "HBMGDMA1"
+
+static bool page_is_zero(const byte_t *page, size_t sz)
+{
+        const uint64_t *w = reinterpret_cast<const uint64_t*>(page);
+        for (size_t i = 0; i < sz / sizeof(*w); i++)
+                if (w[i] != 0)
+                        return false;
+        return true;
+}
+
+static bool write_u64s(FILE *f, uint64_t a, uint64_t b)
+{
+        uint64_t v[2] = {a, b};
+        return fwrite(v, sizeof(v), 1, f) == 1;
+}
+
+static bool read_u64s(FILE *f, uint64_t *a, uint64_t *b)
+{
+        uint64_t v[2];
+        if (fread(v, sizeof(v), 1, f) != 1)
+                return false;
+        *a = v[0];
+        *b = v[1];
+        return true;
+}
+
+static bool save_store(FILE *f, const Store &store)
+{
+        const size_t page = sysconf(_SC_PAGESIZE);
+        size_t off = 0;
+
+        while (off < store.size()) {
+                size_t sz = store.size() - off < page ? store.size() - off : page;
+                if (page_is_zero(store.data() + off, sz)) {
+                        off += sz;
+                        continue;
+                }
+
+                // extend the run over every following page that is not zero
+                size_t end = off + sz;
+                while (end < store.size()) {
+                        size_t next = store.size() - end < page ? store.size() - end : page;
+                        if (page_is_zero(store.data() + end, next))
+                                break;
+                        end += next;
+                }
+
+                if (!write_u64s(f, off, end - off) ||
+                    fwrite(store.data() + off, 1, end - off, f) != end - off)
+                        return false;
+
+                off = end;
+        }
+
+        return write_u64s(f, 0, 0);
+}
+
+static bool restore_store(FILE *f, Store &store)
+{
+        if (store.clear() != 0)
+                return false;
+
+        for (;;) {
+                uint64_t off, len;
+                if (!read_u64s(f, &off, &len))
+                        return false;
+
+                if (len == 0)
+                        return true;
+
+                if (off > store.size() || len > store.size() - off) {
+                        errno = EINVAL;
+                        return false;
+                }
+
+                if (fread(store.data() + off, 1, len, f) != len)
+                        return false;
+        }
+}
+
+int bsg_mem_dma::bsg_mem_dma_save(const char *path)
+{
+        FILE *f = fopen(path, "wb");
+        if (f == nullptr)
+                return -1;
+
+        bool ok = write_u64s(f, checkpoint_magic, memories.size());
+        for (auto it = memories.begin(); ok && it != memories.end(); it++) {
+                ok = write_u64s(f, it->first, it->second->_data.size()) &&
+                        save_store(f, it->second->_data);
+        }
+
+        // fclose() flushes, so it can fail too
+        if (!ok) {
+                int e = errno;
+                fclose(f);
+                errno = e;
+                return -1;
+        }
+
+        return fclose(f) == 0 ? 0 : -1;
+}
+
+int bsg_mem_dma::bsg_mem_dma_restore(const char *path)
+{
+        FILE *f = fopen(path, "rb");
+        if (f == nullptr)
+                return -1;
+
+        uint64_t magic, channels;
+        bool ok = read_u64s(f, &magic, &channels);
+        if (ok && (magic != checkpoint_magic || channels != memories.size())) {
+                errno = EINVAL;
+                ok = false;
+        }
+
+        for (uint64_t i = 0; ok && i < channels; i++) {
+                uint64_t id, size;
+                if (!read_u64s(f, &id, &size)) {
+                        ok = false;
+                        break;
+                }
+
+                Memory *memory = bsg_mem_dma_get_memory(id);
+                if (memory == nullptr || memory->_data.size() != size) {
+                        errno = EINVAL;
+                        ok = false;
+                        break;
+                }
+
+                ok = restore_store(f, memory->_data);
+        }
+
+        // a short read leaves errno alone
+        if (!ok && feof(f))
+                errno = EINVAL;
+
+        int e = errno;
+        fclose(f);
+        errno = e;
+        return ok ? 0 : -1;
+}
+
+/*
+ * DPI interface to bsg_nonsynth_mem_1rw_sync_mask_write_byte_dma.
+ * Contents start at zero (or the channel's image), whatever
+ * init_mem_p asks for: filling the channel would commit every page.
+ */
+extern "C" void *bsg_mem_dma_init(parameter_t id,
+                                  parameter_t channel_addr_width_fp,
+                                  parameter_t data_width_p,
+                                  parameter_t mem_els_p,
+                                  parameter_t init_mem_p)
+{
+        auto it = memories.find(id);
+        if (it != memories.end())
+                return it->second;
+
+        Memory *memory = new Memory(id);
+        size_t size = mem_els_p * (data_width_p / 8);
+
+        char path[4096], *image = nullptr;
+        const char *dir = getenv(BSG_MEM_DMA_IMAGE_DIR_ENV);
+        if (dir && *dir) {
+                snprintf(path, sizeof(path), "%s/channel%lu.bin", dir, (unsigned long)id);
+                image = path;
+        }
+
+        if (memory->_data.init(size, image) != 0) {
+                fprintf(stderr, "%s: failed to create %zu byte memory for channel %lu: %s\n",
+                        __func__, size, (unsigned long)id, strerror(errno));
+                delete memory;
+                exit(1);
+        }
+
+        memories[id] = memory;
+        return memory;
+}
+
+extern "C" unsigned char bsg_mem_dma_get(void *handle, address_t addr)
+{
+        return static_cast<Memory*>(handle)->get(addr);
+}
+
+extern "C" void bsg_mem_dma_set(void *handle, address_t addr, unsigned char val)
+{
+        static_cast<Memory*>(handle)->set(addr, val);
+}
@@ -0,0 +1,125 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Backing store for the simulated DRAM channels.
+//
+// This is a drop-in for BaseJump STL's bsg_mem/bsg_mem_dma: it
+// exports the same DPI functions to the non-synthesizable DMA
+// memories and the same bsg_mem_dma::Memory backdoor to the runtime.
+// Instead of a std::vector per channel (which commits the whole
+// channel on construction), each channel reserves virtual address
+// space and the kernel commits pages on first write. Untouched pages
+// read as zero.
+//
+// If BSG_MANYCORE_DRAM_IMAGE_DIR is set, channel N is initialized by
+// mapping <dir>/channelN.bin copy-on-write over the start of the
+// channel, so a prepared DRAM image is loaded without reading it.
+// The image file is never modified.
+//
+// bsg_mem_dma_save() and bsg_mem_dma_restore() checkpoint every
+// channel, writing only the pages that are not zero.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#define BSG_MEM_DMA_IMAGE_DIR_ENV "BSG_MANYCORE_DRAM_IMAGE_DIR"
+
+namespace bsg_mem_dma {
+        typedef uint64_t address_t;
+        typedef uint64_t parameter_t;
+        typedef unsigned char byte_t;
+
+        /*
+         * A contiguous span of lazily committed memory. Supports the
+         * subset of std::vector<byte_t> that backdoor users rely on.
+         */
+        class Store {
+        public:
+                Store() : _base(nullptr), _size(0) {}
+                ~Store();
+
+                Store(const Store &) = delete;
+                Store &operator=(const Store &) = delete;
+
+                /**
+                 * Reserve the store.
+                 * @param[in] size   Size of the store in bytes
+                 * @param[in] image  A file to map over the start of the store, or nullptr
+                 * @return 0 on success, -1 on failure (errno is set)
+                 */
+                int init(size_t size, const char *image);
+
+                /**
+                 * Zero the store and release its pages.
+                 * @return 0 on success, -1 on failure (errno is set)
+                 */
+                int clear();
+
+                size_t size() const { return _size; }
+                byte_t *data() { return _base; }
+                const byte_t *data() const { return _base; }
+                byte_t &operator[](address_t addr) { return _base[addr]; }
+                const byte_t &operator[](address_t addr) const { return _base[addr]; }
+
+        private:
+                byte_t *_base;
+                size_t  _size;
+        };
+
+        class Memory {
+        public:
+                Memory(parameter_t id) : _id(id) {}
+
+                byte_t get(address_t addr) const { return _data[addr]; }
+                void set(address_t addr, byte_t val) { _data[addr] = val; }
+
+                parameter_t _id;
+                Store _data;
+        };
+
+        /**
+         * Get the memory of a DRAM channel
+         * @param[in] id  The channel
+         * @return The channel's memory, or nullptr if the hardware has not created it.
+         */
+        Memory *bsg_mem_dma_get_memory(parameter_t id);
+
+        /**
+         * Save the contents of every channel to a file
+         * @param[in] path  The file to write
+         * @return 0 on success, -1 on failure (errno is set)
+         */
+        int bsg_mem_dma_save(const char *path);
+
+        /**
+         * Restore the contents of every channel from a file written by bsg_mem_dma_save()
+         * @param[in] path  The file to read
+         * @return 0 on success, -1 on failure (errno is set). Fails with
+         * EINVAL if the channels differ from those that were saved.
+         */
+        int bsg_mem_dma_restore(const char *path);
+}
@@ -61,10 +61,11 @@ libraries.clean: dmamem.clean
 
 # Rules for building Simulation "DMA library"
 $(LIBRARIES_PATH)/features/dma/simulation/libdmamem.so: CXXFLAGS += -std=c++11 -D_GNU_SOURCE -Wall -fPIC -shared
-$(LIBRARIES_PATH)/features/dma/simulation/libdmamem.so: CXXFLAGS += -I$(BASEJUMP_STL_DIR)/bsg_mem
-$(LIBRARIES_PATH)/features/dma/simulation/libdmamem.so: CXXFLAGS += -DBASEJUMP_STL_DIR="$(BASEJUMP_STL_DIR)"
+$(LIBRARIES_PATH)/features/dma/simulation/libdmamem.so: CXXFLAGS += -I$(LIBRARIES_PATH)/features/dma/simulation
 $(LIBRARIES_PATH)/features/dma/simulation/libdmamem.so: CXX=g++
-$(LIBRARIES_PATH)/features/dma/simulation/libdmamem.so: $(BASEJUMP_STL_DIR)/bsg_mem/bsg_mem_dma.cpp
+# bsg_mem_dma.cpp replaces $(BASEJUMP_STL_DIR)/bsg_mem/bsg_mem_dma.cpp with
+# sparse, lazily committed channel memories (see bsg_mem_dma.hpp)
+$(LIBRARIES_PATH)/features/dma/simulation/libdmamem.so: $(LIBRARIES_PATH)/features/dma/simulation/bsg_mem_dma.cpp
 	$(CXX) $(CXXFLAGS) $(INCLUDES) $^ -Wl,-soname,$(notdir $@) -o $@
 
 endif # ifndef(_BSG_F1_TESTBENCHES_LIB_DMA_MEM_MK)
@@ -36,9 +36,15 @@ LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_config.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_cuda.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_elf.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_eva.cpp
+LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_io.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_loader.cpp
+LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_load_image.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_memory_manager.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_origin_eva_map.cpp
+LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_packet_batch.cpp
+LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_branch_trace.cpp
+LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_cache_tracker.cpp
+LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_program_image.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_print_int_responder.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_printing.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_request_packet_id.cpp
@@ -53,7 +59,9 @@ LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_config.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_cuda.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_elf.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_eva.h
+LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_io.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_loader.h
+LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_load_image.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_memory_manager.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_origin_eva_map.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_printing.h
@@ -68,6 +76,10 @@ LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_coordinate.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_npa.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_epa.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_packet.h
+LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_packet_batch.h
+LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_branch_trace.h
+LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_cache_tracker.h
+LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_program_image.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_response_packet.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_request_packet.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_fifo.h
@@ -93,6 +105,8 @@ LIB_OBJECTS += $(patsubst %c,%o,$(LIB_CSOURCES))
 # I don't like these, but they'll have to do for now.
 $(BSG_PLATFORM_PATH)/libbsg_manycore_runtime.so.1.0: LDFLAGS := 
 $(BSG_PLATFORM_PATH)/libbsg_manycore_runtime.so.1.0: INCLUDES := 
+# The I/O thread (bsg_manycore_io.cpp) uses std::thread
+$(BSG_PLATFORM_PATH)/libbsg_manycore_runtime.so.1.0: LDFLAGS += -pthread
 
 include $(BSG_PLATFORM_PATH)/library.mk
 
@@ -141,6 +141,40 @@ int hb_mc_mmio_read(hb_mc_mmio_t mmio, uintptr_t offset,
         return HB_MC_SUCCESS;
 }
 
+/**
+ * Read consecutive 32-bit words from manycore hardware starting at a given AXI Address
+ * @param[in]  mmio   An MMIO pointer instance initialized with hb_mc_mmio_init()
+ * @param[in]  offset An offset into the manycore's MMIO address space
+ * @param[out] words  An array of nwords words to be set to the data read
+ * @param[in]  nwords Number of words to read
+ * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ */
+int hb_mc_mmio_read_words(hb_mc_mmio_t mmio, uintptr_t offset,
+                          uint32_t *words, size_t nwords)
+{
+        unsigned char *addr = reinterpret_cast<unsigned char *>(mmio.p);
+        volatile uint32_t *src;
+
+        if (addr == nullptr) {
+                mmio_pr_err((mmio), "%s: Failed: MMIO not initialized", __func__);
+                return HB_MC_UNINITIALIZED;
+        }
+
+        if (offset % 4) {
+                mmio_pr_err((mmio), "%s: Failed: 0x%" PRIxPTR " "
+                            "is not aligned to 4 byte boundary\n",
+                            __func__, offset);
+                return HB_MC_UNALIGNED;
+        }
+
+        // Check once, then issue back-to-back loads from the BAR
+        src = reinterpret_cast<volatile uint32_t *>(&addr[offset]);
+        for (size_t i = 0; i < nwords; i++)
+                words[i] = src[i];
+
+        return HB_MC_SUCCESS;
+}
+
 /**
  * Write data to manycore hardware at a given AXI Address
  * @param[in]  mmio     An MMIO pointer instance initialized with hb_mc_mmio_init()
@@ -154,6 +154,17 @@ extern "C" {
                 return hb_mc_mmio_read(mmio, offset, (void*)vp, 4);
         }
 
+        /**
+         * Read consecutive 32-bit words from manycore hardware starting at a given AXI Address
+         * @param[in]  mmio   MMIO pointer initialized with hb_mc_mmio_init()
+         * @param[in]  offset An offset into the manycore's MMIO address space
+         * @param[out] words  An array of nwords words to be set to the data read
+         * @param[in]  nwords Number of words to read
+         * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+         */
+        int hb_mc_mmio_read_words(hb_mc_mmio_t mmio, uintptr_t offset,
+                                  uint32_t *words, size_t nwords);
+
         /**
          * Write one byte to manycore hardware at a given AXI Address
          * @param[in]  mmio   MMIO pointer initialized with hb_mc_mmio_init()
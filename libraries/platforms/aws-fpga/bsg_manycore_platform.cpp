@@ -6,8 +6,11 @@
 #include <bsg_manycore_profiler.hpp>
 #include <bsg_manycore_tracer.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <set>
+#include <string>
 
 /* these are convenience macros that are only good for one line prints */
 #define platform_pr_dbg(m, fmt, ...)                    \
@@ -33,8 +36,13 @@ typedef struct hb_mc_platform_t {
         hb_mc_mmio_t      mmio;  //!< pointer to memory mapped io (F1-specific)
         hb_mc_profiler_t  prof;  //!< Profiler Implementation
         hb_mc_tracer_t    tracer; //!< Tracer Implementation
+        bool prof_valid;         //!< Has prof been constructed?
+        bool tracer_valid;       //!< Has tracer been constructed?
 } hb_mc_platform_t;
 
+// Root of the design hierarchy for the profiler and tracer
+static const std::string hb_mc_platform_hierarchy = "tb.card.fpga.CL";
+
 
 // ****************************************************************************
 // FIFO INTERFACE
@@ -86,39 +94,37 @@ static int hb_mc_platform_drain(hb_mc_manycore_t *mc,
         uint32_t occupancy;
         int rc;
 
-        for (int drains = 0; drains < 20; drains++) {
-                /* first check how many unread packets are currently in the FIFO */
-                rc = hb_mc_platform_rx_fifo_get_occupancy(pl, type, &occupancy);
-                if (rc != HB_MC_SUCCESS)
-                        return rc;
-
-                /* break if occupancy is zero */
-                if (occupancy == 0)
-                        break;
-
-                /* Read stale packets from fifo */
-                for (unsigned i = 0; i < occupancy; i++){
-                        rc = hb_mc_platform_receive(mc, (hb_mc_packet_t*) &recv, type, -1);
-                        if (rc != HB_MC_SUCCESS) {
-                                platform_pr_err(pl, "%s: Failed to read packet from %s fifo\n",
-                                                __func__, typestr);
-                                return HB_MC_FAIL;
-                        }
+        /* check how many unread packets are currently in the FIFO */
+        rc = hb_mc_platform_rx_fifo_get_occupancy(pl, type, &occupancy);
+        if (rc != HB_MC_SUCCESS)
+                return rc;
 
-                        platform_pr_dbg(pl,
-                                        "%s: packet drained from %s fifo: "
-                                        "src (%d,%d), "
-                                        "dst (%d,%d), "
-                                        "addr: 0x%08x, "
-                                        "data: 0x%08x\n",
-                                        __func__, typestr,
-                                        recv.x_src, recv.y_src,
-                                        recv.x_dst, recv.y_dst,
-                                        recv.addr,
-                                        recv.data);
+        /* Read exactly that many stale packets from fifo */
+        for (unsigned i = 0; i < occupancy; i++){
+                rc = hb_mc_platform_receive(mc, (hb_mc_packet_t*) &recv, type, -1);
+                if (rc != HB_MC_SUCCESS) {
+                        platform_pr_err(pl, "%s: Failed to read packet from %s fifo\n",
+                                        __func__, typestr);
+                        return HB_MC_FAIL;
                 }
+
+                platform_pr_dbg(pl,
+                                "%s: packet drained from %s fifo: "
+                                "src (%d,%d), "
+                                "dst (%d,%d), "
+                                "addr: 0x%08x, "
+                                "data: 0x%08x\n",
+                                __func__, typestr,
+                                recv.x_src, recv.y_src,
+                                recv.x_dst, recv.y_dst,
+                                recv.addr,
+                                recv.data);
         }
 
+        /* An empty FIFO needs no second look */
+        if (occupancy == 0)
+                return HB_MC_SUCCESS;
+
         /* recheck occupancy to make sure all packets are drained. */
         rc = hb_mc_platform_rx_fifo_get_occupancy(pl, type, &occupancy);
         if (rc != HB_MC_SUCCESS)
@@ -127,7 +133,7 @@ static int hb_mc_platform_drain(hb_mc_manycore_t *mc,
         /* fail if new packets have arrived */
         if (occupancy > 0){
                 platform_pr_err(pl, "%s: Failed to drain %s fifo: new packets generated\n",
-                                __func__, type);
+                                __func__, typestr);
                 return HB_MC_FAIL;
         }
 
@@ -332,6 +338,28 @@ int hb_mc_platform_get_config_at(hb_mc_manycore_t *mc,
         return HB_MC_SUCCESS;
 }
 
+/**
+ * Read the entire configuration ROM in a single burst
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[out] config An array of HB_MC_CONFIG_MAX configuration values
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_get_config(hb_mc_manycore_t *mc,
+                              hb_mc_config_raw_t config[HB_MC_CONFIG_MAX])
+{
+        int err;
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+
+        err = hb_mc_mmio_read_words(pl->mmio, HB_MC_MMIO_ROM_BASE,
+                                    config, HB_MC_CONFIG_MAX);
+        if (err != HB_MC_SUCCESS) {
+                platform_pr_err(pl, "%s: Failed to read ROM\n", __func__);
+                return err;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
 /**
  * Read the number of remaining manycore network credits
  * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
@@ -378,9 +406,11 @@ void hb_mc_platform_cleanup(hb_mc_manycore_t *mc)
 {
         hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform); 
 
-        hb_mc_tracer_cleanup(&(pl->tracer));
+        if (pl->tracer_valid)
+                hb_mc_tracer_cleanup(&(pl->tracer));
 
-        hb_mc_profiler_cleanup(&(pl->prof));
+        if (pl->prof_valid)
+                hb_mc_profiler_cleanup(&(pl->prof));
 
         hb_mc_platform_fifos_cleanup(mc, pl);
 
@@ -414,9 +444,6 @@ int hb_mc_platform_init(hb_mc_manycore_t *mc,
                 return HB_MC_INITIALIZED_TWICE;
 
         int r = HB_MC_FAIL, err;
-        std::string hierarchy = "tb.card.fpga.CL";
-        hb_mc_idx_t x, y;
-        hb_mc_config_raw_t rd;
 
         hb_mc_platform_t *pl = new hb_mc_platform_t();
 
@@ -455,40 +482,32 @@ int hb_mc_platform_init(hb_mc_manycore_t *mc,
                 return err;
         }
 
-        std::string profiler = hierarchy + ".network.manycore_wrapper.manycore";
-        hb_mc_platform_get_config_at(mc, HB_MC_CONFIG_DEVICE_DIM_X, &rd);
-        x = rd;
-        hb_mc_platform_get_config_at(mc, HB_MC_CONFIG_DEVICE_DIM_Y, &rd);
-        y = rd;
-        err = hb_mc_profiler_init(&(pl->prof), x, y, profiler);
-        // This feature MIGHT not be implemented, so if it doesn't
-        // work, just ignore.
-        if (err != HB_MC_SUCCESS && err != HB_MC_NOIMPL){
-                hb_mc_platform_fifos_cleanup(mc, pl);
-                mc->platform = nullptr;
-                hb_mc_mmio_cleanup(&pl->mmio, &pl->handle);
-                active_ids.erase(active_ids.find(pl->id));
-                delete pl;
-                return err;
-        }
-
-        err = hb_mc_tracer_init(&(pl->tracer), hierarchy);
-        // This feature MIGHT not be implemented, so if it doesn't
-        // work, just ignore.
-        if (err != HB_MC_SUCCESS && err != HB_MC_NOIMPL){
-                hb_mc_profiler_cleanup(&(pl->prof));
-                hb_mc_platform_fifos_cleanup(mc, pl);
-                mc->platform = nullptr;
-                hb_mc_mmio_cleanup(&pl->mmio, &pl->handle);
-                active_ids.erase(active_ids.find(pl->id));
-                delete pl;
-                return err;
-        }
+        // The profiler and tracer are constructed on first use. See
+        // hb_mc_platform_get_profiler() and hb_mc_platform_get_tracer()
+        pl->prof_valid = false;
+        pl->tracer_valid = false;
 
         return HB_MC_SUCCESS;
 }
 
 
+/*
+ * Every poll of a fence is an MMIO read across PCIe, so the wait
+ * between polls doubles (up to HB_MC_PLATFORM_FENCE_BACKOFF_MAX_NS)
+ * while the network is still busy.
+ */
+#define HB_MC_PLATFORM_FENCE_BACKOFF_MIN_NS 250
+#define HB_MC_PLATFORM_FENCE_BACKOFF_MAX_NS 16000
+
+static void hb_mc_platform_fence_backoff(uint64_t *ns)
+{
+        auto until = std::chrono::steady_clock::now() + std::chrono::nanoseconds(*ns);
+        while (std::chrono::steady_clock::now() < until)
+                ;
+
+        *ns = std::min<uint64_t>(*ns << 1, HB_MC_PLATFORM_FENCE_BACKOFF_MAX_NS);
+}
+
 /**
  * Stall until the all requests (and responses) have reached their destination.
  * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
@@ -500,13 +519,14 @@ int hb_mc_platform_fence(hb_mc_manycore_t *mc,
 {
         uint32_t max_vacancy;
         uint32_t max_credits;
+        uint64_t backoff;
 
         int vacancy;
         int credits;
         int err;
 
         const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
-        const hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform); 
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform); 
 
         if (timeout != -1) {
                 platform_pr_err(pl, "%s: Only a timeout value of -1 is supported\n",
@@ -517,14 +537,30 @@ int hb_mc_platform_fence(hb_mc_manycore_t *mc,
         max_vacancy = hb_mc_config_get_transmit_vacancy_max(cfg);
         max_credits = hb_mc_config_get_io_endpoint_max_out_credits(cfg);
 
-        // wait until out credts are fully resumed, and the tx fifo vacancy equals to host credits
-        while ((vacancy != max_vacancy) | (credits != max_credits)) {
+        // wait until the tx fifo vacancy equals to host credits. Only
+        // the host fills the fifo, so it stays empty from then on.
+        backoff = HB_MC_PLATFORM_FENCE_BACKOFF_MIN_NS;
+        for (;;) {
                 err = hb_mc_platform_get_transmit_vacancy(mc, HB_MC_FIFO_TX_REQ, &vacancy);
                 if (err != HB_MC_SUCCESS)
                         return err;
+                if (vacancy == max_vacancy)
+                        break;
+                hb_mc_platform_fence_backoff(&backoff);
+        }
+
+        // the next transmits need not read the vacancy register
+        pl->transmit_vacancy = vacancy;
+
+        // wait until out credits are fully resumed
+        backoff = HB_MC_PLATFORM_FENCE_BACKOFF_MIN_NS;
+        for (;;) {
                 err = hb_mc_platform_get_credits(mc, &credits, -1);
                 if (err != HB_MC_SUCCESS)
                         return err;
+                if (credits == max_credits)
+                        break;
+                hb_mc_platform_fence_backoff(&backoff);
         }
 
         return HB_MC_SUCCESS;
@@ -572,6 +608,58 @@ int hb_mc_platform_get_cycle(hb_mc_manycore_t *mc, uint64_t *time)
         return HB_MC_SUCCESS;
 }
 
+/**
+ * Get the profiler, constructing it on first use
+ * @param[in]  mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @param[out] prof  The profiler of this platform
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+static int hb_mc_platform_get_profiler(hb_mc_manycore_t *mc, hb_mc_profiler_t *prof)
+{
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        std::string profiler = hb_mc_platform_hierarchy + ".network.manycore_wrapper.manycore";
+        hb_mc_config_raw_t rd;
+        hb_mc_idx_t x, y;
+        int err;
+
+        if (!pl->prof_valid) {
+                hb_mc_platform_get_config_at(mc, HB_MC_CONFIG_DEVICE_DIM_X, &rd);
+                x = rd;
+                hb_mc_platform_get_config_at(mc, HB_MC_CONFIG_DEVICE_DIM_Y, &rd);
+                y = rd;
+                err = hb_mc_profiler_init(&(pl->prof), x, y, profiler);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+                pl->prof_valid = true;
+        }
+
+        *prof = pl->prof;
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Get the tracer, constructing it on first use
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[out] tracer The tracer of this platform
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+static int hb_mc_platform_get_tracer(hb_mc_manycore_t *mc, hb_mc_tracer_t *tracer)
+{
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        std::string hierarchy = hb_mc_platform_hierarchy;
+        int err;
+
+        if (!pl->tracer_valid) {
+                err = hb_mc_tracer_init(&(pl->tracer), hierarchy);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+                pl->tracer_valid = true;
+        }
+
+        *tracer = pl->tracer;
+        return HB_MC_SUCCESS;
+}
+
 /**
  * Get the number of instructions executed for a certain class of instructions
  * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
@@ -580,9 +668,13 @@ int hb_mc_platform_get_cycle(hb_mc_manycore_t *mc, uint64_t *time)
  * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_platform_get_icount(hb_mc_manycore_t *mc, bsg_instr_type_e itype, int *count){
-        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        hb_mc_profiler_t prof;
+        int err;
+
+        if ((err = hb_mc_platform_get_profiler(mc, &prof)) != HB_MC_SUCCESS)
+                return err;
 
-        return hb_mc_profiler_get_icount(pl->prof, itype, count);
+        return hb_mc_profiler_get_icount(prof, itype, count);
 }
 
 /**
@@ -591,8 +683,13 @@ int hb_mc_platform_get_icount(hb_mc_manycore_t *mc, bsg_instr_type_e itype, int
  * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_platform_trace_enable(hb_mc_manycore_t *mc){
-        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
-        return hb_mc_tracer_trace_enable(pl->tracer);
+        hb_mc_tracer_t tracer;
+        int err;
+
+        if ((err = hb_mc_platform_get_tracer(mc, &tracer)) != HB_MC_SUCCESS)
+                return err;
+
+        return hb_mc_tracer_trace_enable(tracer);
 }
 
 /**
@@ -601,8 +698,13 @@ int hb_mc_platform_trace_enable(hb_mc_manycore_t *mc){
  * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_platform_trace_disable(hb_mc_manycore_t *mc){
-        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
-        return hb_mc_tracer_trace_disable(pl->tracer);
+        hb_mc_tracer_t tracer;
+        int err;
+
+        if ((err = hb_mc_platform_get_tracer(mc, &tracer)) != HB_MC_SUCCESS)
+                return err;
+
+        return hb_mc_tracer_trace_disable(tracer);
 }
 
 /**
@@ -611,8 +713,13 @@ int hb_mc_platform_trace_disable(hb_mc_manycore_t *mc){
  * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_platform_log_enable(hb_mc_manycore_t *mc){
-        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
-        return hb_mc_tracer_log_enable(pl->tracer);
+        hb_mc_tracer_t tracer;
+        int err;
+
+        if ((err = hb_mc_platform_get_tracer(mc, &tracer)) != HB_MC_SUCCESS)
+                return err;
+
+        return hb_mc_tracer_log_enable(tracer);
 }
 
 /**
@@ -621,6 +728,42 @@ int hb_mc_platform_log_enable(hb_mc_manycore_t *mc){
  * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_platform_log_disable(hb_mc_manycore_t *mc){
-        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
-        return hb_mc_tracer_log_disable(pl->tracer);
+        hb_mc_tracer_t tracer;
+        int err;
+
+        if ((err = hb_mc_platform_get_tracer(mc, &tracer)) != HB_MC_SUCCESS)
+                return err;
+
+        return hb_mc_tracer_log_disable(tracer);
+}
+
+
+/**
+ * Save the state of the manycore hardware to a checkpoint
+ * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in] path  Path of the checkpoint file to write
+ * @return HB_MC_NOIMPL. This platform does not support checkpoints.
+ */
+int hb_mc_platform_checkpoint_save(hb_mc_manycore_t *mc, const char *path){
+        return HB_MC_NOIMPL;
+}
+
+/**
+ * Restore the state of the manycore hardware from a checkpoint
+ * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in] path  Path of a checkpoint file
+ * @return HB_MC_NOIMPL. This platform does not support checkpoints.
+ */
+int hb_mc_platform_checkpoint_restore(hb_mc_manycore_t *mc, const char *path){
+        return HB_MC_NOIMPL;
+}
+
+/**
+ * Check that the platform can send atomic memory operations
+ * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @return HB_MC_NOIMPL. The host endpoint (bsg_manycore_endpoint_to_fifos)
+ * only forwards loads and stores from the host.
+ */
+int hb_mc_platform_check_amo(hb_mc_manycore_t *mc){
+        return HB_MC_NOIMPL;
 }
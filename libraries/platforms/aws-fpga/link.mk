@@ -33,6 +33,8 @@ RED=\033[0;31m
 NC=\033[0m
 
 LDFLAGS += -lbsg_manycore_runtime -lm
+# Tests such as test_manycore_io start threads of their own
+LDFLAGS += -pthread
 
 $(UNIFIED_TESTS): %: test_loader
 test_loader: LD=$(CC)
@@ -124,6 +124,31 @@ int hb_mc_mmio_read(hb_mc_mmio_t mmio, uintptr_t offset,
         return HB_MC_SUCCESS;
 }
 
+/**
+ * Read consecutive 32-bit words from manycore hardware starting at a given AXI Address
+ * @param[in]  mmio   MMIO pointer initialized with hb_mc_mmio_init()
+ * @param[in]  offset An offset into the manycore's MMIO address space
+ * @param[out] words  An array of nwords words to be set to the data read
+ * @param[in]  nwords Number of words to read
+ * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ */
+int hb_mc_mmio_read_words(hb_mc_mmio_t mmio, uintptr_t offset,
+                          uint32_t *words, size_t nwords)
+{
+        int err;
+        pci_bar_handle_t handle = mmio.handle;
+
+        for (size_t i = 0; i < nwords; i++) {
+                err = fpga_pci_peek(handle, offset + i * sizeof(uint32_t), &words[i]);
+                if (err != 0) {
+                        mmio_pr_err(mmio, "%s: Failed: %s\n", __func__, FPGA_ERR2STR(err));
+                        return HB_MC_FAIL;
+                }
+        }
+
+        return HB_MC_SUCCESS;
+}
+
 /**
  * Write data to manycore hardware at a given AXI Address
  * @param[in]  mmio   MMIO pointer initialized with hb_mc_mmio_init()
@@ -57,6 +57,8 @@ include $(BSG_PLATFORM_PATH)/msg_config.mk
 # libbsg_manycore_runtime will be compiled in $(BSG_PLATFORM_PATH)
 LDFLAGS    += -lbsg_manycore_runtime -lm
 LDFLAGS    += -L$(BSG_PLATFORM_PATH) -Wl,-rpath=$(BSG_PLATFORM_PATH)
+# Tests such as test_manycore_io start threads of their own
+LDFLAGS    += -pthread
 
 VCS_LDFLAGS    += $(foreach def,$(LDFLAGS),-LDFLAGS "$(def)")
 VCS_VFLAGS     += -M -L -ntb_opts tb_timescale=1ps/1ps -lca -v2005
@@ -58,6 +58,23 @@ void SimulationWrapper::eval(){
         svSetScope(prev);
 }
 
+// VCS owns simulation time, so the host cannot run ahead of it. Step
+// once and report an event so that callers keep polling every cycle.
+bool SimulationWrapper::eval_until_event(uint64_t max_evals){
+        eval();
+        return true;
+}
+
+// Checkpoints are only implemented for Verilator. VCS checkpoints
+// ($save/$restart) are owned by the simulator, not the host.
+bool SimulationWrapper::save(const std::string &path){
+        return false;
+}
+
+bool SimulationWrapper::restore(const std::string &path){
+        return false;
+}
+
 SimulationWrapper::~SimulationWrapper(){
         this->top = nullptr;
 }
@@ -39,8 +39,10 @@
 #include <bsg_nonsynth_dpi_clock_gen.hpp>
 
 #include <cstring>
+#include <algorithm>
 #include <set>
 #include <map>
+#include <string>
 #include <xmmintrin.h>
 
 /* these are convenience macros that are only good for one line prints */
@@ -56,6 +58,10 @@
 #define manycore_pr_info(mc, fmt, ...)                          \
         bsg_pr_info("%s: " fmt, mc->name, ##__VA_ARGS__)
 
+// Upper bound on the number of evaluations between two polls of the
+// DPI interface while the host is waiting on the manycore.
+#define HB_MC_PLATFORM_POLL_BATCH_MAX 4096
+
 typedef struct hb_mc_platform_t {
         SimulationWrapper *top;
         bsg_nonsynth_dpi::dpi_manycore<HB_MC_CONFIG_MAX> *dpi;
@@ -63,8 +69,40 @@ typedef struct hb_mc_platform_t {
         bsg_nonsynth_dpi::dpi_cycle_counter<uint64_t> *ctr;
         hb_mc_profiler_t prof;
         hb_mc_tracer_t tracer;
+        bool prof_valid;     //!< Has prof been constructed?
+        bool tracer_valid;   //!< Has tracer been constructed?
+        std::string hierarchy; //!< Root of the simulation hierarchy
+        uint64_t poll_batch; //!< evaluations between polls while waiting
 } hb_mc_platform_t;
 
+/**
+ * Advance the simulation before the next poll of the DPI interface
+ * @param[in] platform  An initialized platform
+ * @param[in] last      The result of the previous poll
+ *
+ * The DPI interface can only be accessed in a window after a clock
+ * edge, so the first poll and windowing errors advance by a single
+ * evaluation. Otherwise the host is waiting on the manycore and the
+ * simulation runs ahead until a packet crosses the host interface.
+ * The batch doubles for every uneventful wait (e.g. a long kernel)
+ * and collapses back to one evaluation as soon as traffic resumes.
+ */
+static void hb_mc_platform_step(hb_mc_platform_t *platform, int last)
+{
+        SimulationWrapper *top = platform->top;
+
+        if (last == BSG_NONSYNTH_DPI_NOT_WINDOW) {
+                top->eval();
+                return;
+        }
+
+        if (top->eval_until_event(platform->poll_batch))
+                platform->poll_batch = 1;
+        else
+                platform->poll_batch = std::min<uint64_t>(platform->poll_batch << 1,
+                                                          HB_MC_PLATFORM_POLL_BATCH_MAX);
+}
+
 /* read all unread packets from a fifo (rx only) */
 int hb_mc_platform_drain(hb_mc_manycore_t *mc, hb_mc_fifo_rx_t type)
 {
@@ -72,21 +110,24 @@ int hb_mc_platform_drain(hb_mc_manycore_t *mc, hb_mc_fifo_rx_t type)
         int err, drains = 0;
         hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform); 
         SimulationWrapper *top = platform->top;
-        __m128i *pkt;
+        __m128i pkt;
 
         hb_mc_config_raw_t cap;
         // Configuration hasn't been initialized yet...
         hb_mc_platform_get_config_at(mc, HB_MC_CONFIG_IO_REMOTE_LOAD_CAP, &cap);
 
+        // The DPI FIFOs do not expose their occupancy, so poll until
+        // the FIFO reports that it is empty. More than cap stale
+        // packets means the FIFO is still being refilled.
         do {
                 top->eval();
 
                 switch(type){
                 case HB_MC_FIFO_RX_REQ:
-                        err = platform->dpi->rx_req(*pkt);
+                        err = platform->dpi->rx_req(pkt);
                         break;
                 case HB_MC_FIFO_RX_RSP:
-                        err = platform->dpi->rx_rsp(*pkt);
+                        err = platform->dpi->rx_rsp(pkt);
                         break;
                 default:
                         manycore_pr_err(mc, "%s: Unknown packet type\n", __func__);
@@ -100,7 +141,7 @@ int hb_mc_platform_drain(hb_mc_manycore_t *mc, hb_mc_fifo_rx_t type)
                   || err == BSG_NONSYNTH_DPI_SUCCESS) // Still got a packet
                  && (drains <= cap)); // Still haven't drained the FIFO capacity
         
-        if(drains == cap){
+        if(drains > cap){
                 manycore_pr_err(mc, "%s: Failed to drain fifo %s\n", __func__,
                                 hb_mc_fifo_rx_to_string(type));
                 return HB_MC_FAIL;
@@ -150,9 +191,11 @@ void hb_mc_platform_cleanup(hb_mc_manycore_t *mc)
 {
         hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform); 
 
-        hb_mc_tracer_cleanup(&(platform->tracer));
+        if (platform->tracer_valid)
+                hb_mc_tracer_cleanup(&(platform->tracer));
 
-        hb_mc_profiler_cleanup(&(platform->prof));
+        if (platform->prof_valid)
+                hb_mc_profiler_cleanup(&(platform->prof));
 
         hb_mc_platform_dpi_cleanup(platform);
 
@@ -184,8 +227,6 @@ int hb_mc_platform_init(hb_mc_manycore_t *mc, hb_mc_manycore_id_t id)
         
         hb_mc_platform_t *platform = new hb_mc_platform_t;
         std::string hierarchy;
-        hb_mc_idx_t x, y;
-        hb_mc_config_raw_t rd;
 
         // check if mc is already initialized
         if (mc->platform)
@@ -204,6 +245,9 @@ int hb_mc_platform_init(hb_mc_manycore_t *mc, hb_mc_manycore_id_t id)
 
         active_ids.insert(id);
         platform->id = id;
+        platform->poll_batch = 1;
+        platform->prof_valid = false;
+        platform->tracer_valid = false;
 
         // Instantiate the top-level platform simulation and put it in
         // the map. If it has already been instantiated, don't
@@ -224,40 +268,19 @@ int hb_mc_platform_init(hb_mc_manycore_t *mc, hb_mc_manycore_id_t id)
                 return err;
         }
 
-        std::string profiler = hierarchy;
-        profiler += ".network.manycore";
-        hb_mc_platform_get_config_at(mc, HB_MC_CONFIG_DEVICE_DIM_X, &rd);
-        x = rd;
-        hb_mc_platform_get_config_at(mc, HB_MC_CONFIG_DEVICE_DIM_Y, &rd);
-        y = rd;
-        err = hb_mc_profiler_init(&(platform->prof), x, y, profiler);
-        if (err != HB_MC_SUCCESS){
-                hb_mc_platform_dpi_cleanup(platform);
-                delete platform;
-                return err;
-        }
-
-        err = hb_mc_tracer_init(&(platform->tracer), hierarchy);
-        if (err != HB_MC_SUCCESS){
-                hb_mc_profiler_cleanup(&(platform->prof));
-                hb_mc_platform_dpi_cleanup(platform);
-                delete platform;
-                return err;
-        }
+        // The profiler and tracer are constructed on first use. See
+        // hb_mc_platform_get_profiler() and hb_mc_platform_get_tracer()
+        platform->hierarchy = hierarchy;
 
         err = hb_mc_platform_drain(mc, HB_MC_FIFO_RX_REQ);
         if (err != HB_MC_SUCCESS){
-                hb_mc_tracer_cleanup(&(platform->tracer));
-                hb_mc_profiler_cleanup(&(platform->prof));
                 hb_mc_platform_dpi_cleanup(platform);
                 delete platform;
                 return err;
         }
 
-        hb_mc_platform_drain(mc, HB_MC_FIFO_RX_RSP);
+        err = hb_mc_platform_drain(mc, HB_MC_FIFO_RX_RSP);
         if (err != HB_MC_SUCCESS){
-                hb_mc_tracer_cleanup(&(platform->tracer));
-                hb_mc_profiler_cleanup(&(platform->prof));
                 hb_mc_platform_dpi_cleanup(platform);
                 delete platform;
                 return err;
@@ -281,7 +304,6 @@ int hb_mc_platform_transmit(hb_mc_manycore_t *mc,
                             long timeout)
 {
         hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform); 
-        SimulationWrapper *top = platform->top;
         __m128i *pkt = reinterpret_cast<__m128i*>(packet);
         const char *typestr = hb_mc_fifo_tx_to_string(type);
 
@@ -298,8 +320,9 @@ int hb_mc_platform_transmit(hb_mc_manycore_t *mc,
         }
 
 
+        err = BSG_NONSYNTH_DPI_NOT_WINDOW;
         do {
-                top->eval();
+                hb_mc_platform_step(platform, err);
                 err = platform->dpi->tx_req(*pkt);
         } while (err != BSG_NONSYNTH_DPI_SUCCESS &&
                  (err == BSG_NONSYNTH_DPI_NO_CREDITS || 
@@ -330,7 +353,6 @@ int hb_mc_platform_receive(hb_mc_manycore_t *mc,
 
         int err;
         hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform); 
-        SimulationWrapper *top = platform->top;
         __m128i *pkt = reinterpret_cast<__m128i*>(packet);
 
         if (timeout != -1) {
@@ -339,8 +361,9 @@ int hb_mc_platform_receive(hb_mc_manycore_t *mc,
                 return HB_MC_INVALID;
         }
 
+        err = BSG_NONSYNTH_DPI_NOT_WINDOW;
         do {
-                top->eval();
+                hb_mc_platform_step(platform, err);
 
                 switch(type){
                 case HB_MC_FIFO_RX_REQ:
@@ -388,6 +411,21 @@ int hb_mc_platform_get_config_at(hb_mc_manycore_t *mc,
         return HB_MC_INVALID;
 }
 
+/**
+ * Read the entire configuration ROM in a single burst
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[out] config An array of HB_MC_CONFIG_MAX configuration values
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_get_config(hb_mc_manycore_t *mc,
+                              hb_mc_config_raw_t config[HB_MC_CONFIG_MAX])
+{
+        hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+
+        std::copy(platform->dpi->config, platform->dpi->config + HB_MC_CONFIG_MAX, config);
+        return HB_MC_SUCCESS;
+}
+
 /**
  * Read the number of remaining credits of host
  * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
@@ -447,10 +485,15 @@ int hb_mc_platform_fence(hb_mc_manycore_t *mc, long timeout)
                 return HB_MC_NOIMPL;
         }
 
-        do {
+        err = hb_mc_platform_get_credits(mc, &credits, timeout);
+        platform->dpi->tx_is_vacant(isvacant);
+        while (err == HB_MC_SUCCESS && !(credits == max_credits && isvacant)) {
+                // Credits only return (and the TX FIFO only drains)
+                // when packets cross the host interface
+                hb_mc_platform_step(platform, BSG_NONSYNTH_DPI_NO_CREDITS);
                 err = hb_mc_platform_get_credits(mc, &credits, timeout);
                 platform->dpi->tx_is_vacant(isvacant);
-        } while(err == HB_MC_SUCCESS && !(credits == max_credits && isvacant));
+        }
 
         return err;
 }
@@ -492,6 +535,57 @@ int hb_mc_platform_get_cycle(hb_mc_manycore_t *mc, uint64_t *time)
         return HB_MC_SUCCESS;
 }
 
+/**
+ * Get the profiler, constructing it on first use
+ * @param[in]  mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @param[out] prof  The profiler of this platform
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+static int hb_mc_platform_get_profiler(hb_mc_manycore_t *mc, hb_mc_profiler_t *prof)
+{
+        hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        std::string profiler = platform->hierarchy + ".network.manycore";
+        hb_mc_config_raw_t rd;
+        hb_mc_idx_t x, y;
+        int err;
+
+        if (!platform->prof_valid) {
+                hb_mc_platform_get_config_at(mc, HB_MC_CONFIG_DEVICE_DIM_X, &rd);
+                x = rd;
+                hb_mc_platform_get_config_at(mc, HB_MC_CONFIG_DEVICE_DIM_Y, &rd);
+                y = rd;
+                err = hb_mc_profiler_init(&(platform->prof), x, y, profiler);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+                platform->prof_valid = true;
+        }
+
+        *prof = platform->prof;
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Get the tracer, constructing it on first use
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[out] tracer The tracer of this platform
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+static int hb_mc_platform_get_tracer(hb_mc_manycore_t *mc, hb_mc_tracer_t *tracer)
+{
+        hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        int err;
+
+        if (!platform->tracer_valid) {
+                err = hb_mc_tracer_init(&(platform->tracer), platform->hierarchy);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+                platform->tracer_valid = true;
+        }
+
+        *tracer = platform->tracer;
+        return HB_MC_SUCCESS;
+}
+
 /**
  * Get the number of instructions executed for a certain class of instructions
  * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
@@ -500,10 +594,13 @@ int hb_mc_platform_get_cycle(hb_mc_manycore_t *mc, uint64_t *time)
  * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_platform_get_icount(hb_mc_manycore_t *mc, bsg_instr_type_e itype, int *count){
-         hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        hb_mc_profiler_t prof;
+        int err;
 
-         return hb_mc_profiler_get_icount(platform->prof, itype, count);
+        if ((err = hb_mc_platform_get_profiler(mc, &prof)) != HB_MC_SUCCESS)
+                return err;
 
+        return hb_mc_profiler_get_icount(prof, itype, count);
 }
 
 /**
@@ -512,8 +609,13 @@ int hb_mc_platform_get_icount(hb_mc_manycore_t *mc, bsg_instr_type_e itype, int
  * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_platform_trace_enable(hb_mc_manycore_t *mc){
-        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
-        return hb_mc_tracer_trace_enable(pl->tracer);
+        hb_mc_tracer_t tracer;
+        int err;
+
+        if ((err = hb_mc_platform_get_tracer(mc, &tracer)) != HB_MC_SUCCESS)
+                return err;
+
+        return hb_mc_tracer_trace_enable(tracer);
 }
 
 /**
@@ -522,8 +624,13 @@ int hb_mc_platform_trace_enable(hb_mc_manycore_t *mc){
  * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_platform_trace_disable(hb_mc_manycore_t *mc){
-        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
-        return hb_mc_tracer_trace_disable(pl->tracer);
+        hb_mc_tracer_t tracer;
+        int err;
+
+        if ((err = hb_mc_platform_get_tracer(mc, &tracer)) != HB_MC_SUCCESS)
+                return err;
+
+        return hb_mc_tracer_trace_disable(tracer);
 }
 
 /**
@@ -532,8 +639,13 @@ int hb_mc_platform_trace_disable(hb_mc_manycore_t *mc){
  * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_platform_log_enable(hb_mc_manycore_t *mc){
-        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
-        return hb_mc_tracer_log_enable(pl->tracer);
+        hb_mc_tracer_t tracer;
+        int err;
+
+        if ((err = hb_mc_platform_get_tracer(mc, &tracer)) != HB_MC_SUCCESS)
+                return err;
+
+        return hb_mc_tracer_log_enable(tracer);
 }
 
 /**
@@ -542,6 +654,65 @@ int hb_mc_platform_log_enable(hb_mc_manycore_t *mc){
  * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_platform_log_disable(hb_mc_manycore_t *mc){
-        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
-        return hb_mc_tracer_log_disable(pl->tracer);
+        hb_mc_tracer_t tracer;
+        int err;
+
+        if ((err = hb_mc_platform_get_tracer(mc, &tracer)) != HB_MC_SUCCESS)
+                return err;
+
+        return hb_mc_tracer_log_disable(tracer);
+}
+
+/**
+ * Save the state of the simulation to a checkpoint
+ * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in] path  Path of the checkpoint file to write
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_checkpoint_save(hb_mc_manycore_t *mc, const char *path){
+        hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        int err;
+
+        // Packets in flight would be saved with the model, but the
+        // host would have forgotten that it was waiting on them.
+        err = hb_mc_platform_fence(mc, -1);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        if (!platform->top->save(path)) {
+                manycore_pr_err(mc, "%s: Failed to save checkpoint to '%s'\n",
+                                __func__, path);
+                return HB_MC_NOIMPL;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Restore the state of the simulation from a checkpoint
+ * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in] path  Path of a checkpoint file written by hb_mc_platform_checkpoint_save()
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_checkpoint_restore(hb_mc_manycore_t *mc, const char *path){
+        hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+
+        if (!platform->top->restore(path)) {
+                manycore_pr_err(mc, "%s: Failed to restore checkpoint from '%s'\n",
+                                __func__, path);
+                return HB_MC_NOTFOUND;
+        }
+
+        platform->poll_batch = 1;
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Check that the platform can send atomic memory operations
+ * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @return HB_MC_SUCCESS. The DPI host endpoint carries atomic requests.
+ */
+int hb_mc_platform_check_amo(hb_mc_manycore_t *mc){
+        return HB_MC_SUCCESS;
 }
@@ -37,6 +37,9 @@
 #include <bsg_manycore_simulator.hpp>
 #include <bsg_nonsynth_dpi_clock_gen.hpp>
 #include <verilated.h>
+#ifdef BSG_VERILATOR_SAVABLE
+#include <verilated_save.h>
+#endif
 #include <Vmanycore_tb_top.h>
 
 SimulationWrapper::SimulationWrapper(){
@@ -66,8 +69,75 @@ void SimulationWrapper::eval(){
         Vmanycore_tb_top *top = reinterpret_cast<Vmanycore_tb_top *>(this->top);
         bsg_nonsynth_dpi::bsg_timekeeper::next();
         top->eval();
+        evals++;
 }
 
+bool SimulationWrapper::eval_until_event(uint64_t max_evals){
+        Vmanycore_tb_top *top = reinterpret_cast<Vmanycore_tb_top *>(this->top);
+        uint64_t n = 0;
+        do {
+                bsg_nonsynth_dpi::bsg_timekeeper::next();
+                top->eval();
+                n++;
+        } while (!top->host_event_o && n < max_evals);
+
+        evals += n;
+        return top->host_event_o;
+}
+
+// Checkpoints require the model to be verilated with --savable, which
+// link.mk does when BSG_VERILATOR_SAVABLE=1.
+#ifdef BSG_VERILATOR_SAVABLE
+bool SimulationWrapper::save(const std::string &path){
+        Vmanycore_tb_top *top = reinterpret_cast<Vmanycore_tb_top *>(this->top);
+        VerilatedSave os;
+
+        os.open(path.c_str());
+        if (!os.isOpen())
+                return false;
+
+        os << evals;
+        os << *top;
+        os.close();
+        return true;
+}
+
+bool SimulationWrapper::restore(const std::string &path){
+        Vmanycore_tb_top *top = reinterpret_cast<Vmanycore_tb_top *>(this->top);
+        VerilatedRestore os;
+        uint64_t saved;
+
+        os.open(path.c_str());
+        if (!os.isOpen())
+                return false;
+
+        os >> saved;
+        if (saved < evals) {
+                os.close();
+                return false;
+        }
+
+        // The clock generators live outside of the model, and the
+        // timekeeper is deterministic. Replay the edges the model
+        // has not seen yet (without evaluating it) so that every
+        // clock has the phase it had when the checkpoint was taken.
+        for (; evals < saved; evals++)
+                bsg_nonsynth_dpi::bsg_timekeeper::next();
+
+        os >> *top;
+        os.close();
+        return true;
+}
+#else
+bool SimulationWrapper::save(const std::string &path){
+        return false;
+}
+
+bool SimulationWrapper::restore(const std::string &path){
+        return false;
+}
+#endif
+
 std::string SimulationWrapper::getRoot(){
         return *root;
 }
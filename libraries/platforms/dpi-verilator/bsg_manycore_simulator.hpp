@@ -30,6 +30,7 @@
 #ifndef __BSG_MANYCORE_SIMULATOR_HPP
 #define __BSG_MANYCORE_SIMULATOR_HPP
 #include <string>
+#include <cstdint>
 
 class SimulationWrapper{
         // This is the generic pointer for implementation-specific
@@ -38,6 +39,9 @@ class SimulationWrapper{
         // for DPI.
         void *top = nullptr;
         std::string *root;
+        // Number of evaluations since construction. Used to bring the
+        // clock generators back in step with a restored checkpoint.
+        uint64_t evals = 0;
 public:
         SimulationWrapper();
         ~SimulationWrapper();
@@ -57,5 +61,24 @@ public:
         // Cause time to proceed. 
         // eval() wraps the Vmanycore_tb_top->eval() function.
         void eval();
+
+        // Cause time to proceed until a packet crosses the host
+        // interface, or until max_evals evaluations have elapsed.
+        //
+        // The event is observed inside the model (host_event_o in
+        // dpi_top.sv) so no DPI calls are made while waiting.
+        // Returns true if an event was observed. Simulators that
+        // cannot observe the event evaluate once and return true.
+        bool eval_until_event(uint64_t max_evals);
+
+        // Save the complete simulation state to a file. Returns false
+        // if the simulator does not support checkpoints or the file
+        // cannot be written.
+        bool save(const std::string &path);
+
+        // Restore the simulation state from a file written by
+        // save(). Returns false if the simulator does not support
+        // checkpoints, or the file cannot be read.
+        bool restore(const std::string &path);
 };
 #endif // __BSG_MANYCORE_SIMULATOR_HPP
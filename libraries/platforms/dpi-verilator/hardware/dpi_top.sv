@@ -6,7 +6,11 @@ module manycore_tb_top
   import bsg_bladerunner_pkg::*;
   import bsg_bladerunner_mem_cfg_pkg::*;
   import bsg_manycore_endpoint_to_fifos_pkg::*;
-     ();
+   (
+    // Asserted whenever a packet crosses the host link (see
+    // SimulationWrapper::eval_until_event)
+    output logic host_event_o
+    );
 
    // Uncomment this to enable VCD Dumping
    /*
@@ -181,6 +185,16 @@ module manycore_tb_top
       ,.my_y_i(host_y_cord_li)
       );
 
+   // Host Event Monitor: the host runtime polls the DPI FIFOs while
+   // it waits on the manycore. Between polls the simulation can be
+   // advanced in batches until a packet enters or leaves the host
+   // interface, because only then can a poll result (RX valid, TX
+   // credits, or TX vacancy) change.
+   assign host_event_o = (host_link_sif_li.fwd.v & host_link_sif_lo.fwd.ready_and_rev)
+                       | (host_link_sif_li.rev.v & host_link_sif_lo.rev.ready_and_rev)
+                       | (host_link_sif_lo.fwd.v & host_link_sif_li.fwd.ready_and_rev)
+                       | (host_link_sif_lo.rev.v & host_link_sif_li.rev.ready_and_rev);
+
    bsg_print_stat_snoop
      #(
        .data_width_p(data_width_p)
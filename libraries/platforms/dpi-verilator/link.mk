@@ -55,8 +55,17 @@ include $(LIBRARIES_PATH)/libraries.mk
 
 
 
+# Set BSG_VERILATOR_SAVABLE=1 to build a machine that can take
+# checkpoints (see SimulationWrapper::save()). --savable slows down
+# both verilation and simulation, so it is off by default. The machine
+# must be rebuilt from clean after changing it.
+BSG_VERILATOR_SAVABLE ?= 0
+
 # Generic Verilator source files that are compiiled into libmachine.so
 LIBMACHINE_CXXSRCS := verilated.cpp verilated_vcd_c.cpp verilated_dpi.cpp
+ifeq ($(BSG_VERILATOR_SAVABLE),1)
+LIBMACHINE_CXXSRCS += verilated_save.cpp
+endif
 LIBMACHINE_OBJS += $(LIBMACHINE_CXXSRCS:%.cpp=%.o)
 LIBMACHINE_OBJECTS = $(LIBMACHINE_OBJS:%.o=$(MACHINES_PATH)/%.o)
 
@@ -84,6 +93,9 @@ $(BSG_PLATFORM_PATH)/bsg_manycore_simulator.o: INCLUDES += -I$(BASEJUMP_STL_DIR)
 $(BSG_PLATFORM_PATH)/bsg_manycore_simulator.o: INCLUDES += -I$(VERILATOR_ROOT)/include
 $(BSG_PLATFORM_PATH)/bsg_manycore_simulator.o: INCLUDES += -I$(VERILATOR_ROOT)/include/vltstd
 $(BSG_PLATFORM_PATH)/bsg_manycore_simulator.o: CXXFLAGS := -std=c++11 -fPIC $(INCLUDES)
+ifeq ($(BSG_VERILATOR_SAVABLE),1)
+$(BSG_PLATFORM_PATH)/bsg_manycore_simulator.o: CXXFLAGS += -DBSG_VERILATOR_SAVABLE
+endif
 $(BSG_PLATFORM_PATH)/bsg_manycore_simulator.o: $(BSG_MACHINE_PATH)/V$(BSG_DESIGN_TOP)__ALL.a
 
 # Verilator compilation is a little funky. Compiling the HDL generates
@@ -97,6 +109,11 @@ VERILATOR_VDEFINES  += $(foreach def,$(VDEFINES),+define+"$(def)")
 VERILATOR_VFLAGS = $(VERILATOR_VINCLUDES) $(VERILATOR_VDEFINES)
 VERILATOR_VFLAGS += -Wno-widthconcat -Wno-unoptflat -Wno-lint
 VERILATOR_VFLAGS += --assert
+# --savable generates the serializers used by SimulationWrapper::save()
+# and restore() to checkpoint the simulation.
+ifeq ($(BSG_VERILATOR_SAVABLE),1)
+VERILATOR_VFLAGS += --savable
+endif
 # These enable verilator tracing
 # VERILATOR_VFLAGS += --trace --trace-structs
 $(BSG_MACHINE_PATH)/V$(BSG_DESIGN_TOP).mk: $(VHEADERS) $(VSOURCES) 
@@ -121,6 +138,8 @@ $(BSG_MACHINE_PATH)/libmachine.so: $(BSG_MACHINE_PATH)/V$(BSG_DESIGN_TOP)__ALL.a
 LDFLAGS    += -lmachine -L$(BSG_MACHINE_PATH) -Wl,-rpath=$(BSG_MACHINE_PATH) 
 LDFLAGS    += -lbsg_manycore_runtime -L$(BSG_PLATFORM_PATH) -Wl,-rpath=$(BSG_PLATFORM_PATH)
 LDFLAGS    += -lm
+# Tests such as test_manycore_io start threads of their own
+LDFLAGS    += -pthread
 
 INCLUDES   += -I$(LIBRARIES_PATH)
 INCLUDES   += -I$(BSG_MACHINE_PATH)
@@ -0,0 +1,644 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/*
+ * hammerblade: a Python extension module over the CUDA-Lite API
+ * (bsg_manycore_cuda.h).
+ *
+ * Host buffers are taken through the buffer protocol, so NumPy arrays,
+ * torch CPU tensors, bytearrays and array.array objects are copied to
+ * and from the device directly, without intermediate copies. Buffers
+ * must be C-contiguous. The GIL is released for every device call.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <pythread.h>
+
+#include <bsg_manycore.h>
+#include <bsg_manycore_cuda.h>
+#include <bsg_manycore_errno.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+static PyObject *hb_error;
+
+typedef struct {
+        PyObject_HEAD
+        hb_mc_device_t device;
+        int initialized;         /* read and written only under the lock */
+        PyThread_type_lock lock; /* serializes device calls made without the GIL */
+} hb_device_object;
+
+/*
+ * Run a statement under the device lock, without the GIL. Calls on one
+ * device are serialized by the lock, so other Python threads keep
+ * running meanwhile.
+ */
+#define HB_DEVICE_LOCKED(self, stmt)                                    \
+        do {                                                            \
+                Py_BEGIN_ALLOW_THREADS                                  \
+                PyThread_acquire_lock((self)->lock, WAIT_LOCK);         \
+                stmt;                                                   \
+                PyThread_release_lock((self)->lock);                    \
+                Py_END_ALLOW_THREADS                                    \
+        } while (0)
+
+/*
+ * Run a device call under the device lock. The device is checked under
+ * the same lock, so finish() on another thread cannot release it while
+ * the call runs; a finished device fails with HB_MC_UNINITIALIZED.
+ */
+#define HB_DEVICE_CALL(self, err, call)                                 \
+        HB_DEVICE_LOCKED(self, (err) = (self)->initialized ? (call) : HB_MC_UNINITIALIZED)
+
+static PyObject *hb_raise(const char *call, int err)
+{
+        PyErr_Format(hb_error, "%s: %s", call, hb_mc_strerror(err));
+        return NULL;
+}
+
+/*
+ * Fail early for a device that was never initialized. Whether the device
+ * is still initialized is only known under the lock, see HB_DEVICE_CALL.
+ */
+static int hb_device_check(hb_device_object *self)
+{
+        if (self->lock == NULL) {
+                PyErr_SetString(hb_error, "device is not initialized");
+                return -1;
+        }
+        return 0;
+}
+
+/* check a value parsed with "k" (which does not check for overflow) */
+static int hb_check_u32(unsigned long v, const char *what)
+{
+        if (v > UINT32_MAX) {
+                PyErr_Format(PyExc_OverflowError, "%s does not fit in 32 bits", what);
+                return -1;
+        }
+        return 0;
+}
+
+static int hb_parse_dim(PyObject *obj, hb_mc_dimension_t *dim)
+{
+        unsigned long x, y;
+        if (!PyArg_ParseTuple(obj, "kk", &x, &y))
+                return 0;
+        if (hb_check_u32(x, "x") || hb_check_u32(y, "y"))
+                return 0;
+        *dim = hb_mc_dimension(x, y);
+        return 1;
+}
+
+static int hb_parse_dim_converter(PyObject *obj, void *dim)
+{
+        if (!PyTuple_Check(obj)) {
+                PyErr_SetString(PyExc_TypeError, "dimensions must be an (x, y) tuple");
+                return 0;
+        }
+        return hb_parse_dim(obj, (hb_mc_dimension_t *)dim);
+}
+
+/* initialize the device; called with the lock held */
+static int hb_device_init_locked(hb_device_object *self, const char *name, hb_mc_manycore_id_t id)
+{
+        int err;
+
+        if (self->initialized)
+                return HB_MC_INITIALIZED_TWICE;
+
+        err = hb_mc_device_init(&self->device, name, id);
+        if (err == HB_MC_SUCCESS)
+                self->initialized = 1;
+        return err;
+}
+
+/* finish the device; called with the lock held */
+static int hb_device_finish_locked(hb_device_object *self)
+{
+        self->initialized = 0;
+        return hb_mc_device_finish(&self->device);
+}
+
+/* Device.__init__(name="hammerblade", id=0) */
+static int hb_device_init(hb_device_object *self, PyObject *args, PyObject *kwds)
+{
+        static char *kwlist[] = {"name", "id", NULL};
+        const char *name = "hammerblade";
+        unsigned long id = 0;
+        int err;
+
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "|sk", kwlist, &name, &id))
+                return -1;
+        if (hb_check_u32(id, "id"))
+                return -1;
+
+        if (self->lock == NULL) {
+                self->lock = PyThread_allocate_lock();
+                if (self->lock == NULL) {
+                        PyErr_NoMemory();
+                        return -1;
+                }
+        }
+
+        HB_DEVICE_LOCKED(self, err = hb_device_init_locked(self, name, id));
+        if (err == HB_MC_INITIALIZED_TWICE) {
+                PyErr_SetString(hb_error, "device is already initialized");
+                return -1;
+        } else if (err != HB_MC_SUCCESS) {
+                hb_raise("hb_mc_device_init", err);
+                return -1;
+        }
+
+        return 0;
+}
+
+static void hb_device_dealloc(hb_device_object *self)
+{
+        /* no other reference is left, so no call can be in progress */
+        if (self->initialized)
+                hb_mc_device_finish(&self->device);
+
+        if (self->lock != NULL)
+                PyThread_free_lock(self->lock);
+
+        Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+/* Device.program_init(path, alloc_name="default_allocator", id=0) */
+static PyObject *hb_device_program_init(hb_device_object *self, PyObject *args, PyObject *kwds)
+{
+        static char *kwlist[] = {"path", "alloc_name", "id", NULL};
+        const char *path, *alloc_name = "default_allocator";
+        int id = 0, err;
+
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "s|si", kwlist, &path, &alloc_name, &id))
+                return NULL;
+        if (hb_device_check(self))
+                return NULL;
+
+        HB_DEVICE_CALL(self, err, hb_mc_device_program_init(&self->device, path, alloc_name, id));
+        if (err != HB_MC_SUCCESS)
+                return hb_raise("hb_mc_device_program_init", err);
+
+        Py_RETURN_NONE;
+}
+
+/* Device.malloc(size) -> eva */
+static PyObject *hb_device_malloc(hb_device_object *self, PyObject *args)
+{
+        unsigned long size;
+        hb_mc_eva_t eva;
+        int err;
+
+        if (!PyArg_ParseTuple(args, "k", &size))
+                return NULL;
+        if (hb_check_u32(size, "size") || hb_device_check(self))
+                return NULL;
+
+        HB_DEVICE_CALL(self, err, hb_mc_device_malloc(&self->device, size, &eva));
+        if (err != HB_MC_SUCCESS)
+                return hb_raise("hb_mc_device_malloc", err);
+
+        return PyLong_FromUnsignedLong(eva);
+}
+
+/* Device.free(eva) */
+static PyObject *hb_device_free(hb_device_object *self, PyObject *args)
+{
+        unsigned long eva;
+        int err;
+
+        if (!PyArg_ParseTuple(args, "k", &eva))
+                return NULL;
+        if (hb_check_u32(eva, "eva") || hb_device_check(self))
+                return NULL;
+
+        HB_DEVICE_CALL(self, err, hb_mc_device_free(&self->device, eva));
+        if (err != HB_MC_SUCCESS)
+                return hb_raise("hb_mc_device_free", err);
+
+        Py_RETURN_NONE;
+}
+
+static int hb_check_size(Py_ssize_t size)
+{
+        if (size < 0) {
+                PyErr_SetString(PyExc_ValueError, "size must be non-negative");
+                return -1;
+        }
+        if ((size_t)size > UINT32_MAX) {
+                PyErr_SetString(PyExc_ValueError, "size is larger than 4 GiB");
+                return -1;
+        }
+        return 0;
+}
+
+/*
+ * Device.memcpy(dst, src, kind, count=None)
+ *
+ * MEMCPY_TO_DEVICE:        dst is an EVA, src a buffer
+ * MEMCPY_TO_HOST:          dst a writable buffer, src an EVA
+ * MEMCPY_DEVICE_TO_DEVICE: dst and src are EVAs; count is required
+ *
+ * For host transfers count defaults to, and may not exceed, the buffer size.
+ */
+static PyObject *hb_device_memcpy(hb_device_object *self, PyObject *args, PyObject *kwds)
+{
+        static char *kwlist[] = {"dst", "src", "kind", "count", NULL};
+        PyObject *dst, *src, *count_obj = Py_None;
+        int kind, err;
+        Py_buffer view;
+        Py_ssize_t count = -1;
+        unsigned long eva, src_eva;
+
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "OOi|O", kwlist, &dst, &src, &kind, &count_obj))
+                return NULL;
+        if (hb_device_check(self))
+                return NULL;
+
+        if (count_obj != Py_None) {
+                count = PyLong_AsSsize_t(count_obj);
+                if (count < 0) {
+                        if (!PyErr_Occurred())
+                                PyErr_SetString(PyExc_ValueError, "count must be non-negative");
+                        return NULL;
+                }
+        }
+
+        switch (kind) {
+        case HB_MC_MEMCPY_TO_DEVICE:
+                eva = PyLong_AsUnsignedLong(dst);
+                if (PyErr_Occurred() || hb_check_u32(eva, "eva"))
+                        return NULL;
+                if (PyObject_GetBuffer(src, &view, PyBUF_C_CONTIGUOUS) < 0)
+                        return NULL;
+                break;
+        case HB_MC_MEMCPY_TO_HOST:
+                eva = PyLong_AsUnsignedLong(src);
+                if (PyErr_Occurred() || hb_check_u32(eva, "eva"))
+                        return NULL;
+                if (PyObject_GetBuffer(dst, &view, PyBUF_C_CONTIGUOUS | PyBUF_WRITABLE) < 0)
+                        return NULL;
+                break;
+        case HB_MC_MEMCPY_DEVICE_TO_DEVICE:
+                eva = PyLong_AsUnsignedLong(dst);
+                src_eva = PyLong_AsUnsignedLong(src);
+                if (PyErr_Occurred() || hb_check_u32(eva, "dst") || hb_check_u32(src_eva, "src"))
+                        return NULL;
+                if (count < 0) {
+                        PyErr_SetString(PyExc_ValueError, "count is required for device to device copies");
+                        return NULL;
+                }
+                if (hb_check_size(count))
+                        return NULL;
+
+                HB_DEVICE_CALL(self, err, hb_mc_device_memcpy_device_to_device(&self->device, eva,
+                                                                               src_eva, count));
+                if (err != HB_MC_SUCCESS)
+                        return hb_raise("hb_mc_device_memcpy_device_to_device", err);
+                Py_RETURN_NONE;
+        default:
+                PyErr_SetString(PyExc_ValueError, "invalid memcpy kind");
+                return NULL;
+        }
+
+        if (count < 0)
+                count = view.len;
+
+        if (count > view.len || hb_check_size(count)) {
+                if (!PyErr_Occurred())
+                        PyErr_SetString(PyExc_ValueError, "count is larger than the buffer");
+                PyBuffer_Release(&view);
+                return NULL;
+        }
+
+        if (kind == HB_MC_MEMCPY_TO_DEVICE)
+                HB_DEVICE_CALL(self, err, hb_mc_device_memcpy_to_device(&self->device, eva,
+                                                                        view.buf, count));
+        else
+                HB_DEVICE_CALL(self, err, hb_mc_device_memcpy_to_host(&self->device, view.buf,
+                                                                      eva, count));
+
+        PyBuffer_Release(&view);
+
+        if (err != HB_MC_SUCCESS)
+                return hb_raise("hb_mc_device_memcpy", err);
+
+        Py_RETURN_NONE;
+}
+
+/* Device.memset(eva, val, size) */
+static PyObject *hb_device_memset(hb_device_object *self, PyObject *args)
+{
+        unsigned long eva_arg;
+        hb_mc_eva_t eva;
+        unsigned char val;
+        Py_ssize_t size;
+        int err;
+
+        if (!PyArg_ParseTuple(args, "kbn", &eva_arg, &val, &size))
+                return NULL;
+        if (hb_check_u32(eva_arg, "eva") || hb_check_size(size) || hb_device_check(self))
+                return NULL;
+        eva = eva_arg;
+
+        HB_DEVICE_CALL(self, err, hb_mc_device_memset(&self->device, &eva, val, size));
+        if (err != HB_MC_SUCCESS)
+                return hb_raise("hb_mc_device_memset", err);
+
+        Py_RETURN_NONE;
+}
+
+/*
+ * Device.dma(kind, jobs)
+ *
+ * jobs is a sequence of (eva, buffer) pairs. With MEMCPY_TO_DEVICE each
+ * buffer is written to its EVA; with MEMCPY_TO_HOST each (writable)
+ * buffer is filled from its EVA. All jobs are issued in one call.
+ */
+static PyObject *hb_device_dma(hb_device_object *self, PyObject *args)
+{
+        PyObject *jobs_obj, *seq;
+        Py_buffer *views = NULL;
+        hb_mc_dma_htod_t *htod = NULL;
+        hb_mc_dma_dtoh_t *dtoh = NULL;
+        Py_ssize_t n, acquired = 0;
+        PyObject *result = NULL;
+        int kind, err;
+
+        if (!PyArg_ParseTuple(args, "iO", &kind, &jobs_obj))
+                return NULL;
+        if (hb_device_check(self))
+                return NULL;
+
+        if (kind != HB_MC_MEMCPY_TO_DEVICE && kind != HB_MC_MEMCPY_TO_HOST) {
+                PyErr_SetString(PyExc_ValueError, "dma kind must be MEMCPY_TO_DEVICE or MEMCPY_TO_HOST");
+                return NULL;
+        }
+
+        seq = PySequence_Fast(jobs_obj, "jobs must be a sequence of (eva, buffer) pairs");
+        if (seq == NULL)
+                return NULL;
+
+        n = PySequence_Fast_GET_SIZE(seq);
+        views = PyMem_New(Py_buffer, n);
+        if (kind == HB_MC_MEMCPY_TO_DEVICE)
+                htod = PyMem_New(hb_mc_dma_htod_t, n);
+        else
+                dtoh = PyMem_New(hb_mc_dma_dtoh_t, n);
+
+        if (views == NULL || (htod == NULL && dtoh == NULL)) {
+                PyErr_NoMemory();
+                goto done;
+        }
+
+        for (; acquired < n; acquired++) {
+                PyObject *job = PySequence_Fast_GET_ITEM(seq, acquired);
+                unsigned long eva;
+                PyObject *buf;
+                int flags = PyBUF_C_CONTIGUOUS;
+
+                if (!PyArg_ParseTuple(job, "kO", &eva, &buf) || hb_check_u32(eva, "eva"))
+                        goto done;
+
+                if (kind == HB_MC_MEMCPY_TO_HOST)
+                        flags |= PyBUF_WRITABLE;
+
+                if (PyObject_GetBuffer(buf, &views[acquired], flags) < 0)
+                        goto done;
+
+                if (hb_check_size(views[acquired].len)) {
+                        acquired++; // release this view too
+                        goto done;
+                }
+
+                if (kind == HB_MC_MEMCPY_TO_DEVICE) {
+                        htod[acquired].d_addr = eva;
+                        htod[acquired].h_addr = views[acquired].buf;
+                        htod[acquired].size = views[acquired].len;
+                } else {
+                        dtoh[acquired].d_addr = eva;
+                        dtoh[acquired].h_addr = views[acquired].buf;
+                        dtoh[acquired].size = views[acquired].len;
+                }
+        }
+
+        if (kind == HB_MC_MEMCPY_TO_DEVICE)
+                HB_DEVICE_CALL(self, err, hb_mc_device_dma_to_device(&self->device, htod, n));
+        else
+                HB_DEVICE_CALL(self, err, hb_mc_device_dma_to_host(&self->device, dtoh, n));
+
+        if (err != HB_MC_SUCCESS) {
+                hb_raise("hb_mc_device_dma", err);
+                goto done;
+        }
+
+        Py_INCREF(Py_None);
+        result = Py_None;
+
+done:
+        while (acquired-- > 0)
+                PyBuffer_Release(&views[acquired]);
+        PyMem_Free(views);
+        PyMem_Free(htod);
+        PyMem_Free(dtoh);
+        Py_DECREF(seq);
+        return result;
+}
+
+/* Device.kernel_enqueue(grid_dim, tg_dim, name, args) */
+static PyObject *hb_device_kernel_enqueue(hb_device_object *self, PyObject *args)
+{
+        hb_mc_dimension_t grid_dim, tg_dim;
+        const char *name;
+        PyObject *argv_obj, *seq;
+        uint32_t *argv;
+        Py_ssize_t argc, i;
+        int err;
+
+        if (!PyArg_ParseTuple(args, "O&O&sO",
+                              hb_parse_dim_converter, &grid_dim,
+                              hb_parse_dim_converter, &tg_dim,
+                              &name, &argv_obj))
+                return NULL;
+        if (hb_device_check(self))
+                return NULL;
+
+        seq = PySequence_Fast(argv_obj, "args must be a sequence of integers");
+        if (seq == NULL)
+                return NULL;
+
+        argc = PySequence_Fast_GET_SIZE(seq);
+        argv = PyMem_New(uint32_t, argc > 0 ? argc : 1);
+        if (argv == NULL) {
+                Py_DECREF(seq);
+                return PyErr_NoMemory();
+        }
+
+        for (i = 0; i < argc; i++) {
+                /* kernel arguments are raw 32-bit words: wrap negative values */
+                argv[i] = PyLong_AsUnsignedLongMask(PySequence_Fast_GET_ITEM(seq, i));
+                if (PyErr_Occurred()) {
+                        PyMem_Free(argv);
+                        Py_DECREF(seq);
+                        return NULL;
+                }
+        }
+        Py_DECREF(seq);
+
+        HB_DEVICE_CALL(self, err, hb_mc_kernel_enqueue(&self->device, grid_dim, tg_dim,
+                                                       name, argc, argv));
+        PyMem_Free(argv);
+
+        if (err != HB_MC_SUCCESS)
+                return hb_raise("hb_mc_kernel_enqueue", err);
+
+        Py_RETURN_NONE;
+}
+
+/* Device.execute(): launch all enqueued tile groups and wait for them to finish */
+static PyObject *hb_device_execute(hb_device_object *self, PyObject *Py_UNUSED(ignored))
+{
+        int err;
+
+        if (hb_device_check(self))
+                return NULL;
+
+        HB_DEVICE_CALL(self, err, hb_mc_device_tile_groups_execute(&self->device));
+        if (err != HB_MC_SUCCESS)
+                return hb_raise("hb_mc_device_tile_groups_execute", err);
+
+        Py_RETURN_NONE;
+}
+
+/* Device.finish(): release the device; called automatically when the Device is collected */
+static PyObject *hb_device_finish(hb_device_object *self, PyObject *Py_UNUSED(ignored))
+{
+        int err;
+
+        if (hb_device_check(self))
+                return NULL;
+
+        HB_DEVICE_CALL(self, err, hb_device_finish_locked(self));
+        if (err == HB_MC_UNINITIALIZED) {
+                PyErr_SetString(hb_error, "device is not initialized");
+                return NULL;
+        } else if (err != HB_MC_SUCCESS)
+                return hb_raise("hb_mc_device_finish", err);
+
+        Py_RETURN_NONE;
+}
+
+static PyMethodDef hb_device_methods[] = {
+        {"program_init",   (PyCFunction)(void(*)(void))hb_device_program_init, METH_VARARGS | METH_KEYWORDS,
+         "program_init(path, alloc_name='default_allocator', id=0)\n\nLoad a RISC-V binary onto the device."},
+        {"malloc",         (PyCFunction)hb_device_malloc,         METH_VARARGS,
+         "malloc(size) -> eva\n\nAllocate device memory."},
+        {"free",           (PyCFunction)hb_device_free,           METH_VARARGS,
+         "free(eva)\n\nFree device memory."},
+        {"memcpy",         (PyCFunction)(void(*)(void))hb_device_memcpy, METH_VARARGS | METH_KEYWORDS,
+         "memcpy(dst, src, kind, count=None)\n\nCopy between a host buffer and device memory, or within device memory."},
+        {"memset",         (PyCFunction)hb_device_memset,         METH_VARARGS,
+         "memset(eva, val, size)\n\nSet device memory to a byte value."},
+        {"dma",            (PyCFunction)hb_device_dma,            METH_VARARGS,
+         "dma(kind, jobs)\n\nDMA a sequence of (eva, buffer) pairs to or from device DRAM."},
+        {"kernel_enqueue", (PyCFunction)hb_device_kernel_enqueue, METH_VARARGS,
+         "kernel_enqueue(grid_dim, tg_dim, name, args)\n\nEnqueue a grid of tile groups running a kernel."},
+        {"execute",        (PyCFunction)hb_device_execute,        METH_NOARGS,
+         "execute()\n\nRun all enqueued tile groups to completion."},
+        {"finish",         (PyCFunction)hb_device_finish,         METH_NOARGS,
+         "finish()\n\nRelease the device."},
+        {NULL, NULL, 0, NULL}
+};
+
+static PyTypeObject hb_device_type = {
+        PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name      = "hammerblade.Device",
+        .tp_doc       = "Device(name='hammerblade', id=0)\n\nA HammerBlade manycore device (hb_mc_device_t).",
+        .tp_basicsize = sizeof(hb_device_object),
+        .tp_flags     = Py_TPFLAGS_DEFAULT,
+        .tp_new       = PyType_GenericNew,
+        .tp_init      = (initproc)hb_device_init,
+        .tp_dealloc   = (destructor)hb_device_dealloc,
+        .tp_methods   = hb_device_methods,
+};
+
+/* hammerblade.device_init(name='hammerblade', id=0) -> Device */
+static PyObject *hb_module_device_init(PyObject *module, PyObject *args, PyObject *kwds)
+{
+        return PyObject_Call((PyObject *)&hb_device_type, args, kwds);
+}
+
+static PyMethodDef hb_module_methods[] = {
+        {"device_init", (PyCFunction)(void(*)(void))hb_module_device_init, METH_VARARGS | METH_KEYWORDS,
+         "device_init(name='hammerblade', id=0) -> Device\n\nInitialize a device."},
+        {NULL, NULL, 0, NULL}
+};
+
+static struct PyModuleDef hb_module = {
+        PyModuleDef_HEAD_INIT,
+        .m_name    = "hammerblade",
+        .m_doc     = "Python bindings for the BSG Manycore CUDA-Lite API.",
+        .m_size    = -1,
+        .m_methods = hb_module_methods,
+};
+
+PyMODINIT_FUNC PyInit_hammerblade(void)
+{
+        PyObject *m;
+
+        if (PyType_Ready(&hb_device_type) < 0)
+                return NULL;
+
+        m = PyModule_Create(&hb_module);
+        if (m == NULL)
+                return NULL;
+
+        hb_error = PyErr_NewException("hammerblade.Error", PyExc_RuntimeError, NULL);
+        Py_XINCREF(hb_error);
+        if (PyModule_AddObject(m, "Error", hb_error) < 0)
+                goto fail;
+
+        Py_INCREF(&hb_device_type);
+        if (PyModule_AddObject(m, "Device", (PyObject *)&hb_device_type) < 0)
+                goto fail;
+
+        if (PyModule_AddIntConstant(m, "MEMCPY_TO_DEVICE", HB_MC_MEMCPY_TO_DEVICE) < 0 ||
+            PyModule_AddIntConstant(m, "MEMCPY_TO_HOST", HB_MC_MEMCPY_TO_HOST) < 0 ||
+            PyModule_AddIntConstant(m, "MEMCPY_DEVICE_TO_DEVICE", HB_MC_MEMCPY_DEVICE_TO_DEVICE) < 0)
+                goto fail;
+
+        return m;
+
+fail:
+        Py_DECREF(m);
+        return NULL;
+}
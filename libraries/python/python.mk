@@ -0,0 +1,52 @@
+# Copyright (c) 2020, University of Washington All rights reserved.
+# 
+# Redistribution and use in source and binary forms, with or without modification,
+# are permitted provided that the following conditions are met:
+# 
+# Redistributions of source code must retain the above copyright notice, this list
+# of conditions and the following disclaimer.
+# 
+# Redistributions in binary form must reproduce the above copyright notice, this
+# list of conditions and the following disclaimer in the documentation and/or
+# other materials provided with the distribution.
+# 
+# Neither the name of the copyright holder nor the names of its contributors may
+# be used to endorse or promote products derived from this software without
+# specific prior written permission.
+# 
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+# ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+# WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+# ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+# (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+# LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+# ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# This Makefile fragment builds the hammerblade Python extension module
+# (hammerblade.c) in the current directory. It links against
+# libbsg_manycore_runtime.so, so a Python interpreter that imports it
+# (standalone on F1, or embedded in a simulation test_loader) talks to
+# the same runtime as the rest of the process.
+#
+# HB_PYTHON_CONFIG: python-config of the interpreter the module is built for
+# HB_PYTHON_MODULE: file name of the built module
+
+ifndef __BSG_PYTHON_MK
+__BSG_PYTHON_MK := 1
+
+HB_PYTHON_CONFIG ?= python3.6-config
+HB_PYTHON_MODULE := hammerblade$(shell $(HB_PYTHON_CONFIG) --extension-suffix)
+
+$(HB_PYTHON_MODULE): $(LIBRARIES_PATH)/python/hammerblade.c $(BSG_PLATFORM_PATH)/libbsg_manycore_runtime.so
+	$(CC) -std=c99 -g -Wall -shared -fPIC -D_BSD_SOURCE \
+		$(shell $(HB_PYTHON_CONFIG) --includes) -I$(LIBRARIES_PATH) $< -o $@ \
+		-L$(BSG_PLATFORM_PATH) -Wl,-rpath=$(BSG_PLATFORM_PATH) -lbsg_manycore_runtime
+
+.PHONY: python.clean
+python.clean:
+	rm -f $(HB_PYTHON_MODULE)
+
+endif
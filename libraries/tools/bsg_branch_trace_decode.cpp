@@ -0,0 +1,139 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Decode a binary branch trace written by the trace responder (see
+// bsg_manycore_branch_trace.h).
+//
+// By default prints a histogram of branches by PC, most frequent
+// first. With -t, prints every record as a text line in the format
+// the trace responder prints when no binary trace is requested.
+
+#include <bsg_manycore_branch_trace.h>
+#include <bsg_manycore_errno.h>
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <unistd.h>
+#include <vector>
+
+typedef struct {
+        uint64_t taken;
+        uint64_t not_taken;
+} branch_count_t;
+
+static void usage(const char *prog)
+{
+        fprintf(stderr,
+                "Usage: %s [-t] [-x X -y Y] trace\n"
+                "  -t     dump records as text instead of a per-PC histogram\n"
+                "  -x X   only include records from tiles in column X\n"
+                "  -y Y   only include records from tiles in row Y\n",
+                prog);
+}
+
+int main(int argc, char **argv)
+{
+        bool text = false;
+        long x = -1, y = -1;
+        int opt;
+
+        while ((opt = getopt(argc, argv, "tx:y:h")) != -1) {
+                switch (opt) {
+                case 't':
+                        text = true;
+                        break;
+                case 'x':
+                        x = strtol(optarg, nullptr, 0);
+                        break;
+                case 'y':
+                        y = strtol(optarg, nullptr, 0);
+                        break;
+                default:
+                        usage(argv[0]);
+                        return opt == 'h' ? 0 : 1;
+                }
+        }
+
+        if (optind != argc - 1) {
+                usage(argv[0]);
+                return 1;
+        }
+
+        hb_mc_branch_trace_reader_t *reader;
+        int err = hb_mc_branch_trace_reader_open(argv[optind], &reader);
+        if (err != HB_MC_SUCCESS)
+                return 1;
+
+        std::map<uint32_t, branch_count_t> histogram;
+        hb_mc_branch_trace_record_t record;
+        uint64_t records = 0;
+
+        while ((err = hb_mc_branch_trace_reader_next(reader, &record)) == HB_MC_SUCCESS) {
+                if ((x >= 0 && record.x != x) || (y >= 0 && record.y != y))
+                        continue;
+
+                records++;
+                if (text) {
+                        printf("hbmc_branch_trace cycle=%" PRIu64 " x=%d y=%d data=%x\n",
+                               record.cycle, record.x, record.y, record.data);
+                        continue;
+                }
+
+                branch_count_t &count = histogram[hb_mc_branch_trace_data_get_pc(record.data)];
+                if (hb_mc_branch_trace_data_get_taken(record.data))
+                        count.taken++;
+                else
+                        count.not_taken++;
+        }
+
+        hb_mc_branch_trace_reader_close(reader);
+        if (err != HB_MC_NOTFOUND)
+                return 1;
+
+        if (text)
+                return 0;
+
+        std::vector<std::pair<uint32_t, branch_count_t>> by_count(histogram.begin(), histogram.end());
+        std::stable_sort(by_count.begin(), by_count.end(),
+                         [](const std::pair<uint32_t, branch_count_t> &a,
+                            const std::pair<uint32_t, branch_count_t> &b) {
+                                 return a.second.taken + a.second.not_taken
+                                         > b.second.taken + b.second.not_taken;
+                         });
+
+        printf("%-10s %12s %12s %12s %8s\n", "pc", "total", "taken", "not_taken", "taken%");
+        for (const auto &kv : by_count) {
+                uint64_t total = kv.second.taken + kv.second.not_taken;
+                printf("0x%08" PRIx32 " %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %7.2f%%\n",
+                       kv.first, total, kv.second.taken, kv.second.not_taken,
+                       100.0 * kv.second.taken / total);
+        }
+        printf("# %" PRIu64 " branches at %zu PCs\n", records, by_count.size());
+
+        return 0;
+}
@@ -0,0 +1,230 @@
+// Copyright (c) 2020, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Lower a manycore binary into a load image for one machine (see
+// bsg_manycore_load_image.h), so that processes starting it load it
+// without parsing the binary.
+//
+// The machine is described by its ASCII configuration ROM,
+// $(BSG_MACHINE_PATH)/bsg_bladerunner_configuration.rom. No device is
+// opened. With -n, the image is lowered for no-DRAM mode.
+
+#include <bsg_manycore.h>
+#include <bsg_manycore_config.h>
+#include <bsg_manycore_cuda.h>
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_platform.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+/*
+ * The tool is linked without a platform (see tools.mk). These stand in
+ * for the platform interface, which lowering never calls. They are
+ * declared with __attribute__((weak)) so that a platform linked in
+ * later takes their place.
+ */
+void __attribute__((weak)) hb_mc_platform_cleanup(hb_mc_manycore_t *mc) {}
+
+int __attribute__((weak)) hb_mc_platform_init(hb_mc_manycore_t *mc, hb_mc_manycore_id_t id)
+{
+        return HB_MC_NOIMPL;
+}
+
+int __attribute__((weak)) hb_mc_platform_transmit(hb_mc_manycore_t *mc, hb_mc_packet_t *packet,
+                                                  hb_mc_fifo_tx_t type, long timeout)
+{
+        return HB_MC_NOIMPL;
+}
+
+int __attribute__((weak)) hb_mc_platform_receive(hb_mc_manycore_t *mc, hb_mc_packet_t *packet,
+                                                 hb_mc_fifo_rx_t type, long timeout)
+{
+        return HB_MC_NOIMPL;
+}
+
+int __attribute__((weak)) hb_mc_platform_get_config_at(hb_mc_manycore_t *mc, unsigned int idx,
+                                                       hb_mc_config_raw_t *config)
+{
+        return HB_MC_NOIMPL;
+}
+
+int __attribute__((weak)) hb_mc_platform_get_config(hb_mc_manycore_t *mc,
+                                                    hb_mc_config_raw_t config[HB_MC_CONFIG_MAX])
+{
+        return HB_MC_NOIMPL;
+}
+
+int __attribute__((weak)) hb_mc_platform_fence(hb_mc_manycore_t *mc, long timeout)
+{
+        return HB_MC_NOIMPL;
+}
+
+int __attribute__((weak)) hb_mc_platform_start_bulk_transfer(hb_mc_manycore_t *mc)
+{
+        return HB_MC_NOIMPL;
+}
+
+int __attribute__((weak)) hb_mc_platform_finish_bulk_transfer(hb_mc_manycore_t *mc)
+{
+        return HB_MC_NOIMPL;
+}
+
+int __attribute__((weak)) hb_mc_platform_get_cycle(hb_mc_manycore_t *mc, uint64_t *time)
+{
+        return HB_MC_NOIMPL;
+}
+
+int __attribute__((weak)) hb_mc_platform_get_icount(hb_mc_manycore_t *mc, bsg_instr_type_e itype, int *count)
+{
+        return HB_MC_NOIMPL;
+}
+
+int __attribute__((weak)) hb_mc_platform_trace_enable(hb_mc_manycore_t *mc)
+{
+        return HB_MC_NOIMPL;
+}
+
+int __attribute__((weak)) hb_mc_platform_trace_disable(hb_mc_manycore_t *mc)
+{
+        return HB_MC_NOIMPL;
+}
+
+int __attribute__((weak)) hb_mc_platform_log_enable(hb_mc_manycore_t *mc)
+{
+        return HB_MC_NOIMPL;
+}
+
+int __attribute__((weak)) hb_mc_platform_log_disable(hb_mc_manycore_t *mc)
+{
+        return HB_MC_NOIMPL;
+}
+
+int __attribute__((weak)) hb_mc_platform_checkpoint_save(hb_mc_manycore_t *mc, const char *path)
+{
+        return HB_MC_NOIMPL;
+}
+
+int __attribute__((weak)) hb_mc_platform_checkpoint_restore(hb_mc_manycore_t *mc, const char *path)
+{
+        return HB_MC_NOIMPL;
+}
+
+int __attribute__((weak)) hb_mc_platform_check_amo(hb_mc_manycore_t *mc)
+{
+        return HB_MC_NOIMPL;
+}
+
+static void usage(const char *prog)
+{
+        fprintf(stderr,
+                "Usage: %s [-n] rom binary image\n"
+                "  -n     lower for a machine running in no-DRAM mode\n"
+                "  rom    the machine's bsg_bladerunner_configuration.rom\n",
+                prog);
+}
+
+/* read a ROM with one word per line, written as 32 binary digits */
+static int read_rom(const char *path, hb_mc_config_raw_t raw[HB_MC_CONFIG_MAX])
+{
+        FILE *f = fopen(path, "r");
+        char line[128];
+        size_t n = 0;
+
+        if (!f) {
+                fprintf(stderr, "failed to open '%s': %m\n", path);
+                return HB_MC_FAIL;
+        }
+
+        while (n < HB_MC_CONFIG_MAX && fgets(line, sizeof(line), f)) {
+                char *end;
+                line[strcspn(line, "\r\n")] = '\0';
+                if (line[0] == '\0')
+                        continue;
+
+                raw[n++] = strtoul(line, &end, 2);
+                if (*end != '\0') {
+                        fprintf(stderr, "'%s': line %zu is not a binary word\n", path, n);
+                        fclose(f);
+                        return HB_MC_INVALID;
+                }
+        }
+        fclose(f);
+
+        if (n != HB_MC_CONFIG_MAX) {
+                fprintf(stderr, "'%s': expected %d words, found %zu\n",
+                        path, HB_MC_CONFIG_MAX, n);
+                return HB_MC_INVALID;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+        bool no_dram = false;
+        int opt;
+
+        while ((opt = getopt(argc, argv, "nh")) != -1) {
+                switch (opt) {
+                case 'n':
+                        no_dram = true;
+                        break;
+                default:
+                        usage(argv[0]);
+                        return opt == 'h' ? 0 : 1;
+                }
+        }
+
+        if (optind != argc - 3) {
+                usage(argv[0]);
+                return 1;
+        }
+
+        hb_mc_config_raw_t raw[HB_MC_CONFIG_MAX];
+        if (read_rom(argv[optind], raw) != HB_MC_SUCCESS)
+                return 1;
+
+        // Only the configuration and DRAM mode are used to lower a binary
+        hb_mc_manycore_t mc = HB_MC_MANYCORE_INIT;
+        mc.name = "bsg_load_image_gen";
+        mc.dram_enabled = no_dram ? 0 : 1;
+
+        int err = hb_mc_config_init(raw, &mc.config);
+        if (err != HB_MC_SUCCESS) {
+                fprintf(stderr, "'%s' is not a valid configuration: %s\n",
+                        argv[optind], hb_mc_strerror(err));
+                return 1;
+        }
+
+        err = hb_mc_device_program_lower(&mc, argv[optind + 1], argv[optind + 2]);
+        if (err != HB_MC_SUCCESS)
+                return 1;
+
+        return 0;
+}
@@ -0,0 +1,65 @@
+# Copyright (c) 2020, University of Washington All rights reserved.
+# 
+# Redistribution and use in source and binary forms, with or without modification,
+# are permitted provided that the following conditions are met:
+# 
+# Redistributions of source code must retain the above copyright notice, this list
+# of conditions and the following disclaimer.
+# 
+# Redistributions in binary form must reproduce the above copyright notice, this
+# list of conditions and the following disclaimer in the documentation and/or
+# other materials provided with the distribution.
+# 
+# Neither the name of the copyright holder nor the names of its contributors may
+# be used to endorse or promote products derived from this software without
+# specific prior written permission.
+# 
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+# ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+# WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+# ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+# (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+# LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+# ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# This Makefile fragment builds host-side tools for inspecting runtime
+# output offline. The tools don't talk to hardware, so they are built
+# from the library sources and objects they need rather than linked
+# against libbsg_manycore_runtime.so, which carries a platform: on the
+# simulation platforms it leaves the simulator's hooks to be defined by
+# the simulation executable.
+#
+# bsg_branch_trace_decode: decodes binary branch traces, written when
+# BSG_MANYCORE_BRANCH_TRACE names an output file
+#
+# bsg_load_image_gen: lowers a binary into a load image for a machine,
+# given its configuration ROM. Lowering uses the runtime's own loader
+# and address map, so this one links the platform-independent library
+# objects (LIB_OBJECTS) and the DMA feature's noimpl variant. It never
+# opens a device: it defines the platform interface in
+# bsg_manycore_platform.h as stubs that return HB_MC_NOIMPL.
+
+ifndef __BSG_TOOLS_MK
+__BSG_TOOLS_MK := 1
+
+HB_TOOLS := bsg_branch_trace_decode bsg_load_image_gen
+
+bsg_branch_trace_decode: $(LIBRARIES_PATH)/tools/bsg_branch_trace_decode.cpp
+bsg_branch_trace_decode: $(LIBRARIES_PATH)/bsg_manycore_branch_trace.cpp
+bsg_branch_trace_decode: $(LIBRARIES_PATH)/bsg_manycore_printing.cpp
+	$(CXX) -std=c++11 -g -O2 -Wall -D_GNU_SOURCE -D_BSD_SOURCE -D_XOPEN_SOURCE=500 -I$(LIBRARIES_PATH) $^ -o $@ -pthread
+
+bsg_load_image_gen: $(LIBRARIES_PATH)/tools/bsg_load_image_gen.cpp
+bsg_load_image_gen: $(LIBRARIES_PATH)/features/dma/noimpl/bsg_manycore_dma.cpp
+bsg_load_image_gen: $(LIB_OBJECTS)
+	$(CXX) -std=c++11 -g -O2 -Wall -D_GNU_SOURCE -D_BSD_SOURCE -I$(LIBRARIES_PATH) -I$(LIBRARIES_PATH)/features/dma \
+		-I$(AWS_FPGA_REPO_DIR)/SDAccel/userspace/include $^ -o $@ -pthread
+
+.PHONY: tools.clean
+tools.clean:
+	rm -f $(HB_TOOLS)
+
+endif